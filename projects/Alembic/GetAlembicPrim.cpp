@@ -132,7 +132,7 @@ get_xformed_prims(
                 auto pos = Imath::V4d(p[0], p[1], p[2], 1) * mat;
                 p = zeno::vec3f((float)pos.x, (float)pos.y, (float)pos.z);
             }
-            prims->arr.push_back(prim);
+            prims->arr().push_back(prim);
         }
     }
     return prims;
@@ -181,7 +181,7 @@ struct AllAlembicPrim : INode {
         } else {
             abctree->visitPrims([&] (auto const &p) {
                 auto np = std::static_pointer_cast<PrimitiveObject>(p->clone());
-                prims->arr.push_back(np);
+                prims->arr().push_back(np);
             });
         }
         auto outprim = zeno::primMerge(prims->getRaw<PrimitiveObject>());
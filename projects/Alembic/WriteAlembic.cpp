@@ -4,6 +4,7 @@
 #include <zeno/utils/logger.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/extra/GlobalState.h>
 #include <Alembic/AbcGeom/All.h>
@@ -41,6 +42,8 @@ struct WriteAlembic : INode {
             meshyObj = OPolyMesh( OObject( archive, 1 ), "mesh" );
         }
         auto prim = get_input<PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = primExpandInstances(prim.get());
         if (frame_start <= frameid && frameid <= frame_end) {
             // Create a PolyMesh class.
             OPolyMeshSchema &mesh = meshyObj.getSchema();
@@ -205,6 +208,8 @@ struct WriteAlembic2 : INode {
             meshyObj = OPolyMesh( OObject( archive, 1 ), "mesh" );
         }
         auto prim = get_input<PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = primExpandInstances(prim.get());
         if (frame_start <= frameid && frameid <= frame_end) {
             // Create a PolyMesh class.
             OPolyMeshSchema &mesh = meshyObj.getSchema();
@@ -219,21 +219,19 @@ static std::shared_ptr<PrimitiveObject> readMp3(std::string path) {
             set_output("var_H", std::make_shared<NumericObject>((float)var_H));
 
 
-            auto output_H = std::make_shared<ListObject>();
-            for (int i = 0; i < 43 - H.size(); i++) {
-                output_H->arr.emplace_back(std::make_shared<NumericObject>((float)0));
-            }
+            std::vector<float> output_H(43 - H.size(), 0.0f);
             for (const auto & h: H) {
-                output_H->arr.emplace_back(std::make_shared<NumericObject>((float)h));
+                output_H.push_back((float)h);
             }
-            set_output("H", output_H);
+            set_output("H", std::make_shared<ListObject>(std::move(output_H)));
 
-            auto output_E = std::make_shared<ListObject>();
+            std::vector<float> output_E;
+            output_E.reserve(spectrums.size());
             for (const auto& spectrum: spectrums) {
                 double e = spectrum.real() * spectrum.real() + spectrum.imag() * spectrum.imag();
-                output_E->arr.emplace_back(std::make_shared<NumericObject>((float)e));
+                output_E.push_back((float)e);
             }
-            set_output("E", output_E);
+            set_output("E", std::make_shared<ListObject>(std::move(output_E)));
         }
     };
 
@@ -36,6 +36,7 @@ struct PointsToZSParticles : INode {
 
         // prim attrib tags
         std::vector<zs::PropertyTag> auxVertAttribs{};
+        inParticles->verts.expand_attrs();
         for (auto &&[key, arr] : inParticles->verts.attrs) {
                 const auto checkDuplication = [&tags](const std::string &name) {
                     for (std::size_t i = 0; i != tags.size(); ++i)
@@ -4,8 +4,15 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/ListObject.h>
 #include <zeno/utils/logger.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_compact.h>
+#include <zeno/para/parallel_radix_sort.h>
+#include <zeno/para/thread_pool.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -199,43 +206,272 @@ bool calcUVForPath(std::string path, zeno::PrimitiveObject* outprim)
     return calcUV(shapes, outprim);
 }
 
-bool calcUVForData(zeno::PrimitiveObject* inprim, zeno::PrimitiveObject* outprim)
+// triangles of one output mesh reference the vertex range [vertBegin, vertEnd)
+// of the position buffer handed to xatlas, islands never straddle two meshes
+struct UVBatch {
+    uint32_t vertBegin, vertEnd;
+    uint32_t triBegin, triEnd;
+};
+
+// result of an unwrap, keyed by the topology it was computed for; a deforming
+// mesh only has to gather its new positions through vertSrc
+struct UVUnwrapCache {
+    uint64_t topoHash = 0;
+    size_t nverts = 0;
+    size_t ntris = 0;
+    std::vector<int> vertSrc;
+    std::vector<zeno::vec3f> uv;
+    std::vector<zeno::vec3i> tris;
+};
+
+uint64_t topologyHash(zeno::PrimitiveObject *prim)
 {
-    std::vector<float> v;
-    for (auto p :inprim->verts)
-    {
-        v.push_back(p[0]);
-        v.push_back(p[1]);
-        v.push_back(p[2]);
+    constexpr size_t blockSize = 65536;
+    size_t ntris = prim->tris.size();
+    size_t nblocks = (ntris + blockSize - 1) / blockSize;
+    std::vector<uint64_t> blockHash(nblocks);
+    zeno::parallel_for(nblocks, [&] (size_t k) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t i = k * blockSize; i < std::min(ntris, (k + 1) * blockSize); i++) {
+            auto const &ind = prim->tris[i];
+            for (int j = 0; j < 3; j++)
+                h = (h ^ (uint32_t)ind[j]) * 0x100000001b3ull;
+        }
+        blockHash[k] = h;
+    });
+    uint64_t h = prim->verts.size() * 0x9e3779b97f4a7c15ull ^ ntris;
+    for (size_t k = 0; k < nblocks; k++)
+        h = (h ^ blockHash[k]) * 0x9e3779b97f4a7c15ull + (h >> 29);
+    return h;
+}
+
+void fillFromCache(zeno::PrimitiveObject *inprim, zeno::PrimitiveObject *outprim, UVUnwrapCache const &cache)
+{
+    outprim->verts.resize(cache.vertSrc.size());
+    zeno::parallel_for(cache.vertSrc.size(), [&] (size_t i) {
+        outprim->verts[i] = inprim->verts[cache.vertSrc[i]];
+    });
+    outprim->tris.values = cache.tris;
+    outprim->add_attr<zeno::vec3f>("uv") = cache.uv;
+}
+
+// unwraps the triangles of inprim without copying them through tinyobj:
+// connected islands are grouped into a few meshes of similar size, which
+// xatlas segments into charts concurrently, and all charts are packed into
+// one atlas so the texel density stays uniform across islands
+bool calcUVForData(zeno::PrimitiveObject* inprim, zeno::PrimitiveObject* outprim, UVUnwrapCache &cache)
+{
+    size_t nverts = inprim->verts.size();
+    size_t ntris = inprim->tris.size();
+    zeno::log_info("total vertices: {}", nverts);
+    zeno::log_info("total faces: {}", ntris);
+    if (ntris == 0) {
+        zeno::log_error("no triangles to unwrap");
+        return false;
     }
-    std::vector<float> f;
-    for (auto p :inprim->tris)
-    {
-        f.push_back(p[0]);
-        f.push_back(p[1]);
-        f.push_back(p[2]);
+
+    uint64_t topoHash = topologyHash(inprim);
+    if (cache.topoHash == topoHash && cache.nverts == nverts && cache.ntris == ntris && !cache.vertSrc.empty()) {
+        zeno::log_info("topology unchanged, reusing charts");
+        fillFromCache(inprim, outprim, cache);
+        return true;
     }
-    zeno::log_info("total vertices: {}", inprim->verts.size());
-    zeno::log_info("total faces: {}", inprim->tris.size());
 
-    std::string err;    
-    tinyobj::shape_t shape;
+    // islands by union-find over the triangle edges
+    std::vector<int> parent(nverts);
+    for (size_t i = 0; i < nverts; i++)
+        parent[i] = (int)i;
+    auto find = [&] (int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    };
+    std::vector<uint8_t> used(nverts);
+    for (size_t i = 0; i < ntris; i++) {
+        auto const &ind = inprim->tris[i];
+        for (int j = 0; j < 3; j++) {
+            if (ind[j] < 0 || (size_t)ind[j] >= nverts) {
+                zeno::log_error("triangle {} has vertex index {} out of range", i, ind[j]);
+                return false;
+            }
+            used[ind[j]] = 1;
+        }
+        int a = find(ind[0]), b = find(ind[1]), c = find(ind[2]);
+        parent[b] = a;
+        parent[c] = a;
+    }
 
-    bool ret = TranformZenodata(shape, v, f, err);
-    if (ret) {
-        std::vector<tinyobj::shape_t> shapes;
-        shapes.push_back(shape);
-        return calcUV(shapes, outprim);
+    // islands numbered by their first vertex, so an already grouped mesh
+    // (the usual case for merged pieces) ends up with ascending ids
+    std::vector<int> island(nverts, -1);
+    std::vector<int> rootIsland(nverts, -1);
+    int nislands = 0;
+    for (size_t i = 0; i < nverts; i++) {
+        if (!used[i])
+            continue;
+        int r = find((int)i);
+        if (rootIsland[r] < 0)
+            rootIsland[r] = nislands++;
+        island[i] = rootIsland[r];
     }
-    else{
-        zeno::log_info("shapes: {}", err.c_str());
-        return false;
+    std::vector<int> triIsland(ntris);
+    zeno::parallel_for(ntris, [&] (size_t i) {
+        triIsland[i] = island[inprim->tris[i][0]];
+    });
+
+    bool grouped = true;
+    for (size_t i = 1, last = 0; i < nverts && grouped; i++) {
+        if (!used[i])
+            continue;
+        grouped = island[i] >= island[last];
+        last = i;
+    }
+    for (size_t i = 1; i < ntris && grouped; i++)
+        grouped = triIsland[i] >= triIsland[i - 1];
+
+    // positions and indices as xatlas will read them: straight from the prim
+    // when islands are contiguous already, else reordered island by island
+    std::vector<int> vertOrder;
+    std::vector<zeno::vec3f> sortedPos;
+    std::vector<uint32_t> sortedInd;
+    const float *posData = reinterpret_cast<const float *>(inprim->verts.data());
+    const uint32_t *indData = reinterpret_cast<const uint32_t *>(inprim->tris.data());
+    std::vector<uint32_t> islandVertBegin(nislands + 1, 0), islandVertEnd(nislands, 0);
+    std::vector<uint32_t> islandTris(nislands + 1, 0);
+    for (size_t i = 0; i < ntris; i++)
+        islandTris[triIsland[i] + 1]++;
+    for (int k = 0; k < nislands; k++)
+        islandTris[k + 1] += islandTris[k];
+
+    if (grouped) {
+        for (size_t i = nverts; i-- > 0;)
+            if (used[i])
+                islandVertBegin[island[i]] = (uint32_t)i;
+        for (size_t i = 0; i < nverts; i++)
+            if (used[i])
+                islandVertEnd[island[i]] = (uint32_t)i + 1;
+    } else {
+        vertOrder = zeno::parallel_compact_indices(nverts, [&] (int i) {
+            return used[i] != 0;
+        });
+        zeno::parallel_radix_sort(vertOrder, [&] (int i) {
+            return (uint32_t)island[i];
+        });
+        std::vector<int> newId(nverts);
+        sortedPos.resize(vertOrder.size());
+        zeno::parallel_for(vertOrder.size(), [&] (size_t k) {
+            newId[vertOrder[k]] = (int)k;
+            sortedPos[k] = inprim->verts[vertOrder[k]];
+        });
+        for (size_t k = vertOrder.size(); k-- > 0;)
+            islandVertBegin[island[vertOrder[k]]] = (uint32_t)k;
+        for (size_t k = 0; k < vertOrder.size(); k++)
+            islandVertEnd[island[vertOrder[k]]] = (uint32_t)k + 1;
+
+        std::vector<int> triOrder(ntris);
+        zeno::parallel_for(ntris, [&] (size_t i) {
+            triOrder[i] = (int)i;
+        });
+        zeno::parallel_radix_sort(triOrder, [&] (int i) {
+            return (uint32_t)triIsland[i];
+        });
+        sortedInd.resize(ntris * 3);
+        zeno::parallel_for(ntris, [&] (size_t k) {
+            auto const &ind = inprim->tris[triOrder[k]];
+            for (int j = 0; j < 3; j++)
+                sortedInd[k * 3 + j] = (uint32_t)newId[ind[j]];
+        });
+        posData = reinterpret_cast<const float *>(sortedPos.data());
+        indData = sortedInd.data();
+    }
+
+    // a few meshes per thread is enough for xatlas to keep all of them busy,
+    // more would only add per-mesh overhead on scans with many tiny fragments
+    std::vector<UVBatch> batches;
+    size_t targetTris = std::max<size_t>(1, ntris / (zeno::thread_pool_size() * 4));
+    for (int k = 0; k < nislands;) {
+        UVBatch batch{islandVertBegin[k], islandVertEnd[k], islandTris[k], islandTris[k]};
+        for (; k < nislands && batch.triEnd - batch.triBegin < targetTris; k++) {
+            batch.vertEnd = islandVertEnd[k];
+            batch.triEnd = islandTris[k + 1];
+        }
+        batches.push_back(batch);
+    }
+    zeno::log_info("islands: {}, meshes: {}", nislands, batches.size());
+
+    xatlas::Atlas *atlas = xatlas::Create();
+    Stopwatch stopwatch;
+    xatlas::SetProgressCallback(atlas, ProgressCallback, &stopwatch);
+    for (size_t b = 0; b < batches.size(); b++) {
+        auto const &batch = batches[b];
+        xatlas::MeshDecl meshDecl;
+        meshDecl.vertexCount = batch.vertEnd - batch.vertBegin;
+        meshDecl.vertexPositionData = posData + (size_t)batch.vertBegin * 3;
+        meshDecl.vertexPositionStride = sizeof(float) * 3;
+        meshDecl.indexCount = (batch.triEnd - batch.triBegin) * 3;
+        meshDecl.indexData = indData + (size_t)batch.triBegin * 3;
+        meshDecl.indexFormat = xatlas::IndexFormat::UInt32;
+        meshDecl.indexOffset = -(int32_t)batch.vertBegin;
+        xatlas::AddMeshError error = xatlas::AddMesh(atlas, meshDecl, (uint32_t)batches.size());
+        if (error != xatlas::AddMeshError::Success) {
+            xatlas::Destroy(atlas);
+            zeno::log_error("Error adding mesh {}: {}", b, xatlas::StringForEnum(error));
+            return false;
+        }
     }
+    xatlas::AddMeshJoin(atlas);
+    zeno::log_info("Generating atlas");
+    xatlas::Generate(atlas);
+    zeno::log_info("charts {}", atlas->chartCount);
+    zeno::log_info("atlases {}", atlas->atlasCount);
+    for (uint32_t i = 0; i < atlas->atlasCount; i++)
+        zeno::log_info("{}: {}% utilization", i, atlas->utilization[i] * 100.0f);
+    zeno::log_info("{}x{} resolution", atlas->width, atlas->height);
+
+    std::vector<size_t> vertOffset(atlas->meshCount + 1), triOffset(atlas->meshCount + 1);
+    for (uint32_t m = 0; m < atlas->meshCount; m++) {
+        vertOffset[m + 1] = vertOffset[m] + atlas->meshes[m].vertexCount;
+        triOffset[m + 1] = triOffset[m] + atlas->meshes[m].indexCount / 3;
+    }
+    cache.vertSrc.resize(vertOffset[atlas->meshCount]);
+    cache.uv.resize(vertOffset[atlas->meshCount]);
+    cache.tris.resize(triOffset[atlas->meshCount]);
+    float invWidth = atlas->width ? 1.0f / atlas->width : 0.0f;
+    float invHeight = atlas->height ? 1.0f / atlas->height : 0.0f;
+    for (uint32_t m = 0; m < atlas->meshCount; m++) {
+        const xatlas::Mesh &mesh = atlas->meshes[m];
+        uint32_t vertBegin = batches[m].vertBegin;
+        zeno::parallel_for((size_t)mesh.vertexCount, [&] (size_t v) {
+            const xatlas::Vertex &vertex = mesh.vertexArray[v];
+            uint32_t k = vertBegin + vertex.xref;
+            cache.vertSrc[vertOffset[m] + v] = grouped ? (int)k : vertOrder[k];
+            cache.uv[vertOffset[m] + v] = zeno::vec3f(vertex.uv[0] * invWidth, vertex.uv[1] * invHeight, 0);
+        });
+        int firstVertex = (int)vertOffset[m];
+        zeno::parallel_for((size_t)mesh.indexCount / 3, [&] (size_t f) {
+            cache.tris[triOffset[m] + f] = zeno::vec3i(
+                firstVertex + (int)mesh.indexArray[f * 3],
+                firstVertex + (int)mesh.indexArray[f * 3 + 1],
+                firstVertex + (int)mesh.indexArray[f * 3 + 2]);
+        });
+    }
+    xatlas::Destroy(atlas);
+
+    cache.topoHash = topoHash;
+    cache.nverts = nverts;
+    cache.ntris = ntris;
+    fillFromCache(inprim, outprim, cache);
+
+    zeno::log_info("output: vertices {}", outprim->verts.size());
+    zeno::log_info("output: indices {}", outprim->tris.size());
     return true;
 }
 
 struct CalcGeometryUV : zeno::INode{
-    
+    UVUnwrapCache cache;
+
     virtual void apply() override {
         auto outprim = new zeno::PrimitiveObject;
 
@@ -249,7 +485,7 @@ struct CalcGeometryUV : zeno::INode{
         else
         {
             auto prim = get_input<zeno::PrimitiveObject>("prim");
-            ret = calcUVForData(prim.get(), outprim);                
+            ret = calcUVForData(prim.get(), outprim, cache);                
         }
 
         if(ret == false){
@@ -1,5 +1,6 @@
 #include <zeno/zeno.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/string.h>
 #include <zeno/utils/vec.h>
@@ -51,6 +52,8 @@ struct ExportUVObjPrimitive :  zeno::INode  {
     virtual void apply() override {
         auto path = get_input<zeno::StringObject>("path")->get();
         auto prim = get_input<zeno::PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = zeno::primExpandInstances(prim.get());
         auto &pos = prim->attr<zeno::vec3f>("pos");
         auto &uvs = prim->attr<zeno::vec3f>("uv");
         writeobj(pos, uvs, prim->tris, path.c_str());
@@ -1,20 +1,742 @@
 #include <zeno/zeno.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/string.h>
 #include <zeno/utils/vec.h>
+#include <zeno/utils/log.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_reduce.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cstring>
+#include <functional>
+#include <map>
 #include <cstdlib>
 #include <cassert>
 #include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#include <zeno/utils/fuck_win.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #undef tinyply
 #define tinyply _zeno_primplyio_tinyply
 #define TINYPLY_IMPLEMENTATION
 #include "primplyio_tinyply.h"
 
+namespace {
+
+// binary PLY goes through the code below instead of tinyply: the elements are
+// decoded straight from the mapped file (or from a bounded window refilled
+// from the stream for files too large to map) into the attribute arrays, in
+// parallel blocks of records; ascii files still use tinyply
+
+enum class PlyType : uint8_t {
+    Invalid, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64,
+};
+
+PlyType parsePlyType(std::string const &name) {
+    if (name == "char" || name == "int8") return PlyType::Int8;
+    if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+    if (name == "short" || name == "int16") return PlyType::Int16;
+    if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+    if (name == "int" || name == "int32") return PlyType::Int32;
+    if (name == "uint" || name == "uint32") return PlyType::UInt32;
+    if (name == "float" || name == "float32") return PlyType::Float32;
+    if (name == "double" || name == "float64") return PlyType::Float64;
+    throw std::runtime_error("unknown ply property type " + name);
+}
+
+size_t plyTypeSize(PlyType type) {
+    switch (type) {
+    case PlyType::Int8: case PlyType::UInt8: return 1;
+    case PlyType::Int16: case PlyType::UInt16: return 2;
+    case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+    case PlyType::Float64: return 8;
+    default: return 0;
+    }
+}
+
+template <class F>
+void dispatchPlyType(PlyType type, F &&f) {
+    switch (type) {
+    case PlyType::Int8: f(int8_t{}); break;
+    case PlyType::UInt8: f(uint8_t{}); break;
+    case PlyType::Int16: f(int16_t{}); break;
+    case PlyType::UInt16: f(uint16_t{}); break;
+    case PlyType::Int32: f(int32_t{}); break;
+    case PlyType::UInt32: f(uint32_t{}); break;
+    case PlyType::Float32: f(float{}); break;
+    case PlyType::Float64: f(double{}); break;
+    default: throw std::runtime_error("invalid ply property type");
+    }
+}
+
+template <class T, bool Swap>
+T loadPlyScalar(const char *p) {
+    T val;
+    if constexpr (Swap) {
+        char bytes[sizeof(T)];
+        std::reverse_copy(p, p + sizeof(T), bytes);
+        std::memcpy(&val, bytes, sizeof(T));
+    } else {
+        std::memcpy(&val, p, sizeof(T));
+    }
+    return val;
+}
+
+size_t loadPlyCount(const char *p, PlyType type, bool swap) {
+    size_t ret = 0;
+    dispatchPlyType(type, [&] (auto tag) {
+        using T = decltype(tag);
+        ret = swap ? (size_t)loadPlyScalar<T, true>(p) : (size_t)loadPlyScalar<T, false>(p);
+    });
+    return ret;
+}
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::Invalid;
+    PlyType countType = PlyType::Invalid;  // only set for list properties
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> props;
+
+    bool hasLists() const {
+        return std::any_of(props.begin(), props.end(), [] (auto const &prop) {
+            return prop.countType != PlyType::Invalid;
+        });
+    }
+
+    // record size and property offsets, assuming every list has listLen items
+    size_t stride(size_t listLen = 0) const {
+        size_t ret = 0;
+        for (auto const &prop: props)
+            ret += prop.countType == PlyType::Invalid ? plyTypeSize(prop.type)
+                : plyTypeSize(prop.countType) + listLen * plyTypeSize(prop.type);
+        return ret;
+    }
+
+    size_t offsetOf(size_t k, size_t listLen = 0) const {
+        size_t ret = 0;
+        for (size_t j = 0; j < k; j++)
+            ret += props[j].countType == PlyType::Invalid ? plyTypeSize(props[j].type)
+                : plyTypeSize(props[j].countType) + listLen * plyTypeSize(props[j].type);
+        return ret;
+    }
+};
+
+struct PlyHeader {
+    enum Format { Ascii, BinaryLittleEndian, BinaryBigEndian } format = Ascii;
+    std::vector<PlyElement> elements;
+    size_t dataOffset = 0;
+};
+
+PlyHeader parsePlyHeader(std::string const &path) {
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin)
+        throw std::runtime_error("failed to open " + path);
+    PlyHeader header;
+    std::string line;
+    std::getline(fin, line);
+    if (line.rfind("ply", 0) != 0)
+        throw std::runtime_error("not a ply file: " + path);
+    while (std::getline(fin, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::istringstream ss(line);
+        std::string word;
+        ss >> word;
+        if (word == "format") {
+            std::string fmt;
+            ss >> fmt;
+            header.format = fmt == "binary_little_endian" ? PlyHeader::BinaryLittleEndian
+                : fmt == "binary_big_endian" ? PlyHeader::BinaryBigEndian : PlyHeader::Ascii;
+        } else if (word == "element") {
+            PlyElement elem;
+            ss >> elem.name >> elem.count;
+            header.elements.push_back(std::move(elem));
+        } else if (word == "property") {
+            if (header.elements.empty())
+                throw std::runtime_error("ply property outside of an element");
+            PlyProperty prop;
+            std::string type;
+            ss >> type;
+            if (type == "list") {
+                std::string countType, itemType;
+                ss >> countType >> itemType;
+                prop.countType = parsePlyType(countType);
+                prop.type = parsePlyType(itemType);
+            } else {
+                prop.type = parsePlyType(type);
+            }
+            ss >> prop.name;
+            header.elements.back().props.push_back(std::move(prop));
+        } else if (word == "end_header") {
+            header.dataOffset = (size_t)fin.tellg();
+            return header;
+        }
+    }
+    throw std::runtime_error("ply header has no end_header: " + path);
+}
+
+// byte source of the element data: the whole file mapped at once, or, in
+// streaming mode, a window buffer that is refilled on every fetch
+class PlyInput {
+public:
+    PlyInput(std::string const &path, bool streaming) : m_streaming(streaming) {
+        if (m_streaming) {
+            m_stream.open(path, std::ios::binary | std::ios::ate);
+            if (!m_stream)
+                throw std::runtime_error("failed to open " + path);
+            m_size = (size_t)m_stream.tellg();
+            return;
+        }
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("failed to open " + path);
+        LARGE_INTEGER size;
+        GetFileSizeEx(m_file, &size);
+        m_size = (size_t)size.QuadPart;
+        if (m_size) {
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping)
+                m_map = (const char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0)
+            throw std::runtime_error("failed to open " + path);
+        struct stat st;
+        fstat(m_fd, &st);
+        m_size = (size_t)st.st_size;
+        if (m_size) {
+            void *ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+            if (ptr != MAP_FAILED) {
+                madvise(ptr, m_size, MADV_SEQUENTIAL);
+                m_map = (const char *)ptr;
+            }
+        }
+#endif
+        if (m_size && !m_map) {
+            close();
+            throw std::runtime_error("failed to map " + path);
+        }
+    }
+
+    PlyInput(PlyInput const &) = delete;
+    PlyInput &operator=(PlyInput const &) = delete;
+
+    ~PlyInput() {
+        close();
+    }
+
+    bool streaming() const {
+        return m_streaming;
+    }
+
+    const char *fetch(size_t offset, size_t size) {
+        if (offset + size > m_size)
+            throw std::runtime_error("ply file is truncated");
+        if (!m_streaming)
+            return m_map + offset;
+        m_buffer.resize(size);
+        m_stream.seekg((std::streamoff)offset);
+        if (!m_stream.read(m_buffer.data(), (std::streamsize)size))
+            throw std::runtime_error("failed to read ply data");
+        return m_buffer.data();
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    void close() {
+#ifdef _WIN32
+        if (m_map)
+            UnmapViewOfFile(m_map);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_map)
+            munmap((void *)m_map, m_size);
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_map = nullptr;
+    }
+
+    bool m_streaming;
+    size_t m_size = 0;
+    const char *m_map = nullptr;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    std::ifstream m_stream;
+    std::vector<char> m_buffer;
+};
+
+// a run of consecutive records, either of fixed size or located by offsets
+struct PlyRecords {
+    const char *base;
+    size_t first;
+    size_t count;
+    size_t stride;
+    const size_t *offsets;
+
+    const char *operator[](size_t i) const {
+        return offsets ? base + offsets[i] : base + i * stride;
+    }
+};
+
+// size of the record at rec, or 0 if it does not fit in the avail bytes
+size_t plyRecordSize(PlyElement const &elem, const char *rec, size_t avail, bool swap) {
+    size_t size = 0;
+    for (auto const &prop: elem.props) {
+        if (prop.countType == PlyType::Invalid) {
+            size += plyTypeSize(prop.type);
+        } else {
+            if (size + plyTypeSize(prop.countType) > avail)
+                return 0;
+            size_t len = loadPlyCount(rec + size, prop.countType, swap);
+            size += plyTypeSize(prop.countType) + len * plyTypeSize(prop.type);
+        }
+    }
+    return size <= avail ? size : 0;
+}
+
+// feeds the records of elem, starting at byte offset, to visit(PlyRecords)
+// in windows of about chunkBytes (the whole element when mapped), returns the
+// offset just past the element. a window whose lists all have the length of
+// its first record's is visited at a fixed stride after a parallel check,
+// otherwise its records are located by a serial walk
+template <class Visit>
+size_t visitPlyElement(PlyInput &input, PlyElement const &elem, size_t offset,
+                       size_t chunkBytes, bool swap, Visit &&visit) {
+    std::vector<std::pair<size_t, PlyType>> lists;
+    std::vector<size_t> offsets;
+    size_t want = chunkBytes;
+    for (size_t b = 0; b < elem.count;) {
+        size_t remain = input.size() - std::min(input.size(), offset);
+        size_t window = std::min(want, remain);
+        const char *base = input.fetch(offset, window);
+        size_t firstSize = plyRecordSize(elem, base, window, swap);
+        if (!firstSize) {
+            if (window == remain)
+                throw std::runtime_error("ply file is truncated");
+            want *= 2;
+            continue;
+        }
+        want = chunkBytes;
+
+        size_t stride = firstSize;
+        size_t n = std::min(elem.count - b, window / stride);
+        size_t mismatches = 0;
+        if (elem.hasLists()) {
+            size_t listBytes = 0;
+            for (auto const &prop: elem.props)
+                if (prop.countType != PlyType::Invalid)
+                    listBytes += plyTypeSize(prop.type);
+            size_t listLen = (firstSize - elem.stride(0)) / listBytes;
+            lists.clear();
+            for (size_t k = 0; k < elem.props.size(); k++)
+                if (elem.props[k].countType != PlyType::Invalid)
+                    lists.emplace_back(elem.offsetOf(k, listLen), elem.props[k].countType);
+            mismatches = zeno::parallel_reduce((size_t)0, n, (size_t)0, std::plus<size_t>(), [&] (size_t i) -> size_t {
+                for (auto const &[listOffset, countType]: lists)
+                    if (loadPlyCount(base + i * stride + listOffset, countType, swap) != listLen)
+                        return 1;
+                return 0;
+            });
+        }
+        if (!mismatches) {
+            visit(PlyRecords{base, b, n, stride, nullptr});
+            b += n;
+            offset += n * stride;
+            continue;
+        }
+
+        offsets.clear();
+        size_t pos = 0;
+        while (b + offsets.size() < elem.count) {
+            size_t size = plyRecordSize(elem, base + pos, window - pos, swap);
+            if (!size)
+                break;
+            offsets.push_back(pos);
+            pos += size;
+        }
+        visit(PlyRecords{base, b, offsets.size(), 0, offsets.data()});
+        b += offsets.size();
+        offset += pos;
+    }
+    return offset;
+}
+
+// one scalar property decoded into every stride-th float or int of dst
+struct PlyColumn {
+    size_t offset;
+    PlyType type;
+    float *fdst;
+    int *idst;
+    size_t dstStride;
+    float scale;
+};
+
+template <bool Swap>
+void decodePlyColumns(PlyRecords const &recs, std::vector<PlyColumn> const &cols) {
+    constexpr size_t blockSize = 4096;
+    size_t nblocks = (recs.count + blockSize - 1) / blockSize;
+    // column by column inside a block, so the records stay in cache
+    zeno::parallel_for(nblocks, [&] (size_t k) {
+        size_t b = k * blockSize, e = std::min(recs.count, b + blockSize);
+        for (auto const &col: cols) {
+            dispatchPlyType(col.type, [&] (auto tag) {
+                using T = decltype(tag);
+                if (col.fdst) {
+                    float *dst = col.fdst + (recs.first + b) * col.dstStride;
+                    for (size_t i = b; i < e; i++, dst += col.dstStride)
+                        *dst = (float)loadPlyScalar<T, Swap>(recs[i] + col.offset) * col.scale;
+                } else {
+                    int *dst = col.idst + (recs.first + b) * col.dstStride;
+                    for (size_t i = b; i < e; i++, dst += col.dstStride)
+                        *dst = (int)loadPlyScalar<T, Swap>(recs[i] + col.offset);
+                }
+            });
+        }
+    });
+}
+
+void decodePlyColumns(PlyRecords const &recs, std::vector<PlyColumn> const &cols, bool swap) {
+    if (swap)
+        decodePlyColumns<true>(recs, cols);
+    else
+        decodePlyColumns<false>(recs, cols);
+}
+
+// per-vertex properties become attributes: x y z the positions, nx ny nz the
+// "nrm", red green blue the "clr" (8-bit colors rescaled to [0, 1]), any other
+// <name>_x <name>_y <name>_z triple a vec3f, and the rest float or int
+// attributes after their type. properties from the first list on are skipped,
+// their offsets would differ between records
+std::vector<PlyColumn> plyVertexColumns(zeno::PrimitiveObject *prim, PlyElement const &elem) {
+    prim->verts.resize(elem.count);
+    std::map<std::string, size_t> index;
+    for (size_t k = 0; k < elem.props.size(); k++)
+        index[elem.props[k].name] = k;
+    std::vector<uint8_t> taken(elem.props.size());
+    for (size_t k = 0; k < elem.props.size(); k++) {
+        if (elem.props[k].countType != PlyType::Invalid) {
+            zeno::log_warn("ReadPlyPrimitive: vertex properties from {} on are ignored", elem.props[k].name);
+            std::fill(taken.begin() + k, taken.end(), 1);
+            break;
+        }
+    }
+    std::vector<std::pair<std::string, std::array<size_t, 3>>> vec3s;
+    auto tryVec3 = [&] (std::string const &attr, std::string const &x, std::string const &y, std::string const &z) {
+        auto ix = index.find(x), iy = index.find(y), iz = index.find(z);
+        if (ix == index.end() || iy == index.end() || iz == index.end())
+            return;
+        std::array<size_t, 3> ks{ix->second, iy->second, iz->second};
+        for (auto k: ks)
+            if (taken[k])
+                return;
+        for (auto k: ks)
+            taken[k] = 1;
+        vec3s.emplace_back(attr, ks);
+    };
+    tryVec3("pos", "x", "y", "z");
+    tryVec3("nrm", "nx", "ny", "nz");
+    tryVec3("clr", "red", "green", "blue");
+    for (auto const &prop: elem.props) {
+        auto const &name = prop.name;
+        if (name.size() > 2 && name.compare(name.size() - 2, 2, "_x") == 0) {
+            auto stem = name.substr(0, name.size() - 2);
+            tryVec3(stem, stem + "_x", stem + "_y", stem + "_z");
+        }
+    }
+
+    std::vector<PlyColumn> cols;
+    for (auto const &[attr, ks]: vec3s) {
+        auto &arr = attr == "pos" ? prim->verts.values : prim->verts.add_attr<zeno::vec3f>(attr);
+        for (int c = 0; c < 3; c++) {
+            auto const &prop = elem.props[ks[c]];
+            float scale = attr == "clr" && prop.type == PlyType::UInt8 ? 1.0f / 255.0f
+                : attr == "clr" && prop.type == PlyType::UInt16 ? 1.0f / 65535.0f : 1.0f;
+            cols.push_back({elem.offsetOf(ks[c]), prop.type, reinterpret_cast<float *>(arr.data()) + c, nullptr, 3, scale});
+        }
+    }
+    for (size_t k = 0; k < elem.props.size(); k++) {
+        auto const &prop = elem.props[k];
+        if (taken[k])
+            continue;
+        if (prop.type == PlyType::Float32 || prop.type == PlyType::Float64) {
+            auto &arr = prim->verts.add_attr<float>(prop.name);
+            cols.push_back({elem.offsetOf(k), prop.type, arr.data(), nullptr, 1, 1.0f});
+        } else {
+            auto &arr = prim->verts.add_attr<int>(prop.name);
+            cols.push_back({elem.offsetOf(k), prop.type, nullptr, arr.data(), 1, 1.0f});
+        }
+    }
+    return cols;
+}
+
+void readPlyFaces(PlyInput &input, zeno::PrimitiveObject *prim, PlyElement const &elem, size_t &offset, size_t chunkBytes, bool swap) {
+    auto it = std::find_if(elem.props.begin(), elem.props.end(), [] (auto const &prop) {
+        return prop.countType != PlyType::Invalid
+            && (prop.name == "vertex_indices" || prop.name == "vertex_index");
+    });
+    if (it == elem.props.end()) {
+        zeno::log_warn("ReadPlyPrimitive: face element has no vertex_indices");
+        offset = visitPlyElement(input, elem, offset, chunkBytes, swap, [] (PlyRecords const &) {});
+        return;
+    }
+    size_t k = it - elem.props.begin();
+    auto const &prop = *it;
+    size_t countSize = plyTypeSize(prop.countType);
+    size_t itemSize = plyTypeSize(prop.type);
+
+    // faces are collected as polygons and moved to tris if all are triangles
+    std::vector<int> lens(elem.count);
+    std::vector<int> loops;
+    bool allTris = true;
+    offset = visitPlyElement(input, elem, offset, chunkBytes, swap, [&] (PlyRecords const &recs) {
+        // the list may follow other lists, so locate it per record
+        auto listAt = [&] (const char *rec) {
+            size_t pos = 0;
+            for (size_t j = 0; j < k; j++) {
+                auto const &p = elem.props[j];
+                pos += p.countType == PlyType::Invalid ? plyTypeSize(p.type)
+                    : plyTypeSize(p.countType) + loadPlyCount(rec + pos, p.countType, swap) * plyTypeSize(p.type);
+            }
+            return rec + pos;
+        };
+        std::vector<size_t> loopBase(recs.count);
+        zeno::parallel_for(recs.count, [&] (size_t i) {
+            lens[recs.first + i] = (int)loadPlyCount(listAt(recs[i]), prop.countType, swap);
+        });
+        size_t base = loops.size();
+        size_t total = zeno::parallel_exclusive_scan_sum(lens.begin() + recs.first,
+            lens.begin() + (recs.first + recs.count), loopBase.begin(), [] (int len) { return (size_t)len; });
+        loops.resize(base + total);
+        dispatchPlyType(prop.type, [&] (auto tag) {
+            using T = decltype(tag);
+            zeno::parallel_for(recs.count, [&] (size_t i) {
+                const char *items = listAt(recs[i]) + countSize;
+                int *dst = loops.data() + base + loopBase[i];
+                int len = lens[recs.first + i];
+                for (int j = 0; j < len; j++)
+                    dst[j] = swap ? (int)loadPlyScalar<T, true>(items + j * itemSize)
+                        : (int)loadPlyScalar<T, false>(items + j * itemSize);
+            });
+        });
+        if (allTris && std::any_of(lens.begin() + recs.first, lens.begin() + (recs.first + recs.count),
+                                   [] (int len) { return len != 3; }))
+            allTris = false;
+    });
+
+    if (allTris) {
+        prim->tris.resize(elem.count);
+        zeno::parallel_for(elem.count, [&] (size_t i) {
+            prim->tris[i] = zeno::vec3i(loops[i * 3], loops[i * 3 + 1], loops[i * 3 + 2]);
+        });
+    } else {
+        prim->polys.resize(elem.count);
+        prim->loops.values = std::move(loops);
+        std::vector<int> bases(elem.count);
+        zeno::parallel_exclusive_scan_sum(lens.begin(), lens.end(), bases.begin(), [] (int len) { return len; });
+        zeno::parallel_for(elem.count, [&] (size_t i) {
+            prim->polys[i] = zeno::vec2i(bases[i], lens[i]);
+        });
+    }
+}
+
+void readPlyBinary(zeno::PrimitiveObject *prim, std::string const &path, PlyHeader const &header,
+                   bool streaming, size_t chunkBytes) {
+    PlyInput input(path, streaming);
+    if (!streaming)
+        chunkBytes = input.size();
+    bool swap = header.format == PlyHeader::BinaryBigEndian;
+    size_t offset = header.dataOffset;
+    for (auto const &elem: header.elements) {
+        if (elem.name == "vertex") {
+            auto cols = plyVertexColumns(prim, elem);
+            offset = visitPlyElement(input, elem, offset, chunkBytes, swap, [&] (PlyRecords const &recs) {
+                decodePlyColumns(recs, cols, swap);
+            });
+        } else if (elem.name == "face") {
+            readPlyFaces(input, prim, elem, offset, chunkBytes, swap);
+        } else {
+            offset = visitPlyElement(input, elem, offset, chunkBytes, swap, [] (PlyRecords const &) {});
+        }
+    }
+}
+
+// vertex layout written by the binary writer, the inverse of plyVertexColumns
+struct PlyOutColumn {
+    std::string header;
+    const char *src;
+    size_t srcStride;
+    size_t srcSize;
+    bool toColor;
+};
+
+std::vector<PlyOutColumn> plyOutColumns(zeno::PrimitiveObject *prim) {
+    std::vector<PlyOutColumn> cols;
+    auto addVec3 = [&] (std::vector<zeno::vec3f> const &arr, const char *x, const char *y, const char *z, bool color) {
+        const char *names[3] = {x, y, z};
+        for (int c = 0; c < 3; c++) {
+            cols.push_back({std::string("property ") + (color ? "uchar " : "float ") + names[c],
+                            reinterpret_cast<const char *>(reinterpret_cast<const float *>(arr.data()) + c),
+                            sizeof(zeno::vec3f), color ? (size_t)1 : sizeof(float), color});
+        }
+    };
+    addVec3(prim->verts.values, "x", "y", "z", false);
+    prim->verts.foreach_attr<zeno::AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using T = std::decay_t<decltype(arr[0])>;
+        if constexpr (std::is_same_v<T, zeno::vec3f>) {
+            if (key == "nrm")
+                addVec3(arr, "nx", "ny", "nz", false);
+            else if (key == "clr")
+                addVec3(arr, "red", "green", "blue", true);
+            else
+                addVec3(arr, (key + "_x").c_str(), (key + "_y").c_str(), (key + "_z").c_str(), false);
+        } else if constexpr (std::is_same_v<T, float>) {
+            cols.push_back({"property float " + key, reinterpret_cast<const char *>(arr.data()), sizeof(float), 4, false});
+        } else if constexpr (std::is_same_v<T, int>) {
+            cols.push_back({"property int " + key, reinterpret_cast<const char *>(arr.data()), sizeof(int), 4, false});
+        } else {
+            zeno::log_warn("WritePlyPrimitive: attribute {} of unsupported type skipped", key);
+        }
+    });
+    return cols;
+}
+
+void writePlyBinary(zeno::PrimitiveObject *prim, std::string const &path, size_t chunkBytes) {
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp)
+        throw std::runtime_error("failed to open " + path);
+
+    auto cols = plyOutColumns(prim);
+    size_t nverts = prim->verts.size();
+    size_t nfaces = prim->tris.size() + prim->quads.size() + prim->polys.size();
+    std::string header = "ply\nformat binary_little_endian 1.0\ncomment written by zeno\n";
+    header += "element vertex " + std::to_string(nverts) + "\n";
+    size_t stride = 0;
+    for (auto const &col: cols) {
+        header += col.header + "\n";
+        stride += col.srcSize;
+    }
+    // uchar list counts, unless some polygon is longer than that
+    int maxLen = prim->quads.size() ? 4 : 3;
+    for (auto const &poly: prim->polys)
+        maxLen = std::max(maxLen, poly[1]);
+    size_t countSize = maxLen > 255 ? 4 : 1;
+    header += "element face " + std::to_string(nfaces) + "\n";
+    header += countSize == 1 ? "property list uchar int vertex_indices\n" : "property list int int vertex_indices\n";
+    header += "end_header\n";
+    fwrite(header.data(), 1, header.size(), fp);
+
+    // records are packed in parallel into a bounded buffer, written chunk by chunk
+    std::vector<char> buffer;
+    size_t perChunk = std::max<size_t>(1, chunkBytes / stride);
+    for (size_t b = 0; b < nverts; b += perChunk) {
+        size_t n = std::min(perChunk, nverts - b);
+        buffer.resize(n * stride);
+        zeno::parallel_for(n, [&] (size_t i) {
+            char *dst = buffer.data() + i * stride;
+            for (auto const &col: cols) {
+                const char *src = col.src + (b + i) * col.srcStride;
+                if (col.toColor) {
+                    float val;
+                    std::memcpy(&val, src, sizeof(float));
+                    *dst = (char)(uint8_t)std::clamp(val * 255.0f + 0.5f, 0.0f, 255.0f);
+                } else {
+                    std::memcpy(dst, src, col.srcSize);
+                }
+                dst += col.srcSize;
+            }
+        });
+        fwrite(buffer.data(), 1, buffer.size(), fp);
+    }
+
+    // faces: tris and quads at a fixed record size, polys after a scan
+    auto putCount = [&] (char *dst, int len) {
+        if (countSize == 1) {
+            *dst = (char)(uint8_t)len;
+        } else {
+            int32_t count = len;
+            std::memcpy(dst, &count, 4);
+        }
+    };
+    auto writeFixed = [&] (size_t count, int len, auto const &getIndex) {
+        size_t recSize = countSize + 4 * len;
+        size_t perChunk = std::max<size_t>(1, chunkBytes / recSize);
+        for (size_t b = 0; b < count; b += perChunk) {
+            size_t n = std::min(perChunk, count - b);
+            buffer.resize(n * recSize);
+            zeno::parallel_for(n, [&] (size_t i) {
+                char *dst = buffer.data() + i * recSize;
+                putCount(dst, len);
+                for (int j = 0; j < len; j++) {
+                    int32_t idx = getIndex(b + i, j);
+                    std::memcpy(dst + countSize + 4 * j, &idx, 4);
+                }
+            });
+            fwrite(buffer.data(), 1, buffer.size(), fp);
+        }
+    };
+    writeFixed(prim->tris.size(), 3, [&] (size_t i, int j) { return prim->tris[i][j]; });
+    writeFixed(prim->quads.size(), 4, [&] (size_t i, int j) { return prim->quads[i][j]; });
+
+    std::vector<size_t> recOffset;
+    size_t polysPerChunk = std::max<size_t>(1, chunkBytes / (countSize + 4 * 8));
+    for (size_t b = 0; b < prim->polys.size(); b += polysPerChunk) {
+        size_t n = std::min(polysPerChunk, prim->polys.size() - b);
+        recOffset.resize(n);
+        size_t total = zeno::parallel_exclusive_scan_sum(prim->polys.begin() + b, prim->polys.begin() + (b + n),
+            recOffset.begin(), [&] (zeno::vec2i const &poly) { return countSize + 4 * (size_t)poly[1]; });
+        buffer.resize(total);
+        zeno::parallel_for(n, [&] (size_t i) {
+            auto [base, len] = prim->polys[b + i];
+            char *dst = buffer.data() + recOffset[i];
+            putCount(dst, len);
+            std::memcpy(dst + countSize, prim->loops.data() + base, 4 * (size_t)len);
+        });
+        fwrite(buffer.data(), 1, buffer.size(), fp);
+    }
+
+    bool failed = ferror(fp);
+    fclose(fp);
+    if (failed)
+        throw std::runtime_error("failed to write " + path);
+}
+
+}
+
 
 static void readply(
     std::vector<zeno::vec3f> &verts,
@@ -87,11 +809,18 @@ static void readply(
 struct ReadPlyPrimitive : zeno::INode {
     virtual void apply() override {
         auto path = get_input<zeno::StringObject>("path")->get();
+        auto streaming = get_input2<std::string>("mode") == "stream";
+        auto chunkMB = std::max(1, get_input2<int>("chunkMB"));
         auto prim = std::make_shared<zeno::PrimitiveObject>();
-        auto &pos = prim->verts;
-        auto &tris = prim->tris;
-        readply(pos, tris, path);
-        prim->resize(pos.size());
+        auto header = parsePlyHeader(path);
+        if (header.format == PlyHeader::Ascii) {
+            auto &pos = prim->verts;
+            auto &tris = prim->tris;
+            readply(pos, tris, path);
+            prim->resize(pos.size());
+        } else {
+            readPlyBinary(prim.get(), path, header, streaming, (size_t)chunkMB << 20);
+        }
         set_output("prim", std::move(prim));
     }
 };
@@ -105,6 +834,8 @@ ZENDEFNODE(
                 "readpath",
                 "path",
             },
+            {"enum mmap stream", "mode", "mmap"},
+            {"int", "chunkMB", "256"},
         },
         // outpus
         {
@@ -147,11 +878,17 @@ static void writeply(
 
 struct WritePlyPrimitive : zeno::INode {
     virtual void apply() override {
-        std::cerr << "write\n";
         auto path = get_input<zeno::StringObject>("path")->get();
         auto prim = get_input<zeno::PrimitiveObject>("prim");
-        auto &pos = prim->attr<zeno::vec3f>("pos");
-        writeply(pos, prim->tris, path.c_str());
+        if (prim->inst)
+            prim = zeno::primExpandInstances(prim.get());
+        if (get_input2<std::string>("format") == "ascii") {
+            auto &pos = prim->attr<zeno::vec3f>("pos");
+            writeply(pos, prim->tris, path.c_str());
+        } else {
+            auto chunkMB = std::max(1, get_input2<int>("chunkMB"));
+            writePlyBinary(prim.get(), path + ".ply", (size_t)chunkMB << 20);
+        }
     }
 };
 
@@ -165,6 +902,8 @@ ZENDEFNODE(
                 "path",
             },
             "prim",
+            {"enum ascii binary", "format", "ascii"},
+            {"int", "chunkMB", "256"},
         },
         // outpus
         {
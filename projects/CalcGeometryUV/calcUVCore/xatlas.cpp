@@ -3130,8 +3130,9 @@ public:
 	TaskScheduler() : m_shutdown(false)
 	{
 		m_threadIndex = 0;
+		const uint32_t workerCount = std::thread::hardware_concurrency() <= 1 ? 1 : std::thread::hardware_concurrency() - 1;
 		// Max with current task scheduler usage is 1 per thread + 1 deep nesting, but allow for some slop.
-		m_maxGroups = std::thread::hardware_concurrency() * 4;
+		m_maxGroups = (workerCount + 1) * 4;
 		m_groups = XA_ALLOC_ARRAY(MemTag::Default, TaskGroup, m_maxGroups);
 		for (uint32_t i = 0; i < m_maxGroups; i++) {
 			new (&m_groups[i]) TaskGroup();
@@ -3139,7 +3140,7 @@ public:
 			m_groups[i].ref = 0;
 			m_groups[i].userData = nullptr;
 		}
-		m_workers.resize(std::thread::hardware_concurrency() <= 1 ? 1 : std::thread::hardware_concurrency() - 1);
+		m_workers.resize(workerCount);
 		for (uint32_t i = 0; i < m_workers.size(); i++) {
 			new (&m_workers[i]) Worker();
 			m_workers[i].wakeup = false;
@@ -3424,7 +3425,8 @@ public:
 	ThreadLocal()
 	{
 #if XA_MULTITHREADED
-		const uint32_t n = std::thread::hardware_concurrency();
+		// the scheduler always starts at least one worker besides the main thread
+		const uint32_t n = max(2u, std::thread::hardware_concurrency());
 #else
 		const uint32_t n = 1;
 #endif
@@ -3436,7 +3438,8 @@ public:
 	~ThreadLocal()
 	{
 #if XA_MULTITHREADED
-		const uint32_t n = std::thread::hardware_concurrency();
+		// the scheduler always starts at least one worker besides the main thread
+		const uint32_t n = max(2u, std::thread::hardware_concurrency());
 #else
 		const uint32_t n = 1;
 #endif
@@ -491,6 +491,7 @@ struct ToZSTetrahedra : INode {
         std::vector<zs::PropertyTag> auxElmAttribs{};
 
         if (include_customed_properties) {
+            prim->verts.expand_attrs();
             for (auto &&[key, arr] : prim->verts.attrs) {
                 const auto checkDuplication = [&tags](const std::string &name) {
                     for (std::size_t i = 0; i != tags.size(); ++i)
@@ -513,6 +514,7 @@ struct ToZSTetrahedra : INode {
                     [](...) { throw std::runtime_error("what the heck is this type of attribute!"); })(arr);
             }
 
+            prim->quads.expand_attrs();
             for (auto &&[key, arr] : prim->quads.attrs) {
                 const auto checkDuplication = [&eleTags](const std::string &name) {
                     for (std::size_t i = 0; i != eleTags.size(); ++i)
@@ -743,6 +745,7 @@ struct ToZSTriMesh : INode {
         std::vector<zs::PropertyTag> auxElmAttribs{};
 
         if (include_customed_properties) {
+            prim->verts.expand_attrs();
             for (auto &&[key, arr] : prim->verts.attrs) {
                 const auto checkDuplication = [&tags](const std::string &name) {
                     for (std::size_t i = 0; i != tags.size(); ++i)
@@ -764,6 +767,7 @@ struct ToZSTriMesh : INode {
                     [&k, &auxVertAttribs](const std::vector<int> &vals) {},
                     [](...) { throw std::runtime_error("what the heck is this type of attribute!"); })(arr);
             }
+            prim->tris.expand_attrs();
             for (auto &&[key, arr] : prim->tris.attrs) {
                 const auto checkDuplication = [&eleTags](const std::string &name) {
                     for (std::size_t i = 0; i != eleTags.size(); ++i)
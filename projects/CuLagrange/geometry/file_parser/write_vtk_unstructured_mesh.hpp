@@ -247,6 +247,7 @@ namespace zeno {
         // }
 
         if(out_customed_nodal_attributes) {
+            prim->verts.expand_attrs();
             int numberoffielddata = 0;
             for(auto &&[key,attr] : prim->verts.attrs) {
                 if(key == "pos"/* || key == "nrm" || key == "clr"*/)
@@ -299,6 +300,7 @@ namespace zeno {
             // }
 
             if(out_customed_cell_attributes) {
+                prim->quads.expand_attrs();
                 int numberoffielddata = 0;
                 for(auto &&[key,attr] : prim->quads.attrs) {
                     // if(key == "nrm" || key == "clr")
@@ -347,6 +349,7 @@ namespace zeno {
             // }
 
             if(out_customed_cell_attributes) {
+                prim->tris.expand_attrs();
                 int numberoffielddata = 0;
                 for(auto &&[key,attr] : prim->tris.attrs) {
                     // if(key == "nrm" || key == "clr")
@@ -250,7 +250,7 @@ struct SurfaceToSprings : INode {
             set_output("prim", build_springs(ompPol, *get_input<PrimitiveObject>("prim")));
         } else if (has_input<ListObject>("prim")) {
             auto list = std::make_shared<ListObject>();
-            auto &ret = list->arr;
+            auto &ret = list->arr();
             auto &objSharedPtrLists = *get_input<zeno::ListObject>("prim");
             for (auto &&objSharedPtr : objSharedPtrLists.get()) {
                 if (auto ptr = dynamic_cast<PrimitiveObject *>(objSharedPtr.get()); ptr != nullptr)
@@ -330,6 +330,7 @@ struct ToZSSprings : INode {
 
         // prim attrib tags
         std::vector<zs::PropertyTag> auxAttribs{};
+        prim->verts.expand_attrs();
         for (auto &&[key, arr] : prim->verts.attrs) {
             const auto checkDuplication = [&tags](const std::string &name) {
                 for (std::size_t i = 0; i != tags.size(); ++i)
@@ -900,6 +901,7 @@ struct ToZSParticles : INode {
 
         // prim attrib tags
         std::vector<zs::PropertyTag> auxAttribs{};
+        inParticles->verts.expand_attrs();
         for (auto &&[key, arr] : inParticles->verts.attrs) {
             const auto checkDuplication = [&tags](const std::string &name) {
                 for (std::size_t i = 0; i != tags.size(); ++i)
@@ -970,7 +970,7 @@ struct ConstructBendingSprings : INode {
                            addAngleBendingSprings(cudaPol, *get_input<ZenoParticles>("ZSSurfPrim"), stiffness));
         } else if (has_input<ListObject>("ZSSurfPrim")) {
             auto list = std::make_shared<ListObject>();
-            auto &ret = list->arr;
+            auto &ret = list->arr();
             auto &objSharedPtrLists = *get_input<zeno::ListObject>("ZSSurfPrim");
             if (typeStr == "vertex")
                 for (auto &&objSharedPtr : objSharedPtrLists.get()) {
@@ -1575,7 +1575,7 @@ struct RetrievePrimitiveFromZSParticles : INode {
         if (has_input<ListObject>("ZSParticles")) {
             auto list = std::make_shared<ListObject>();
             for (auto &&ptr : parObjPtrs)
-                list->arr.push_back(ptr->prim);
+                list->arr().push_back(ptr->prim);
             set_output("prim", list);
         } else
             set_output("prim", parObjPtrs[0]->prim);
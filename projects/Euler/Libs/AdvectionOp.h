@@ -148,6 +148,10 @@ public:
     const T& lowest_int_e_by_rho;
 
     Array<T, dim + 2, dim> eps;
+    // sweep 8^3 tiles over component-split copies of q/uf, skipping the tiles
+    // without gas; only for the x-fastest 3d grid, others use the cell loops
+    bool tiled = true;
+    static constexpr int tile_size = 8;
 
     // Helper Functions:
 
@@ -224,6 +228,30 @@ public:
             }
         };
 
+        auto clamp_q = [&](Array<T, dim + 2, 1>& q) {
+            // clamp the density and the internal energy
+            // 1. clamp the density smaller than a threshold value (if needed)
+            if (q(0) < lowest_rho) {
+                // Logging::warn("clamped density");
+                // fix the artifical internal enerygy increase (kinematic energy
+                // decrease)
+                if (q(0) > 0) {
+                    T artificial_kinematic_energy_decrease = 0.5 * (q.template tail<dim>() * q.template tail<dim>()).sum() * ((T)1 / q(0) - (T)1 / lowest_rho);
+                    q(1) -= artificial_kinematic_energy_decrease;
+                }
+                q(0) = lowest_rho;
+            }
+            // 2. calculate the internal energy, devide by rho(to get temperature),
+            // if lower than a value, clamp to it the corresponding d_int_e should
+            // be added to the total energy
+            T int_E = (q(1) - 0.5 * (q.template tail<dim>() * q.template tail<dim>()).sum() / q(0));
+            if (int_E - q(0) * lowest_int_e_by_rho < 0) {
+                // Logging::warn("clamped energy");
+                T delta_E = q(0) * lowest_int_e_by_rho - int_E;
+                q(1) += delta_E;
+            }
+        };
+
         auto flux_based_update = [&](const Vector<int, dim>& I) {
             if (field_helper.cell_type[field_helper.grid[I].idx] == CellType::GAS) {
                 auto RK_coeffs = ZenEulerGas::Math::TimeIntegration::TVDRK3<T, int>(substep);
@@ -237,34 +265,11 @@ public:
                     div_flux += inv_dx * (field_helper.flux[idx_r].col(d) - field_helper.flux[idx].col(d));
                 }
                 field_helper.q[idx] = RK_coeffs(0) * field_helper.q_backup[idx] + RK_coeffs(1) * field_helper.q[idx] - RK_coeffs(2) * dt * div_flux;
-
-                // clamp the density and the internal energy
-                // 1. clamp the density smaller than a threshold value (if needed)
-                if (field_helper.q[idx](0) < lowest_rho) {
-                    // Logging::warn("clamped density");
-                    // fix the artifical internal enerygy increase (kinematic energy
-                    // decrease)
-                    if (field_helper.q[idx](0) > 0) {
-                        T artificial_kinematic_energy_decrease = 0.5 * (field_helper.q[idx].template tail<dim>() * field_helper.q[idx].template tail<dim>()).sum() * ((T)1 / field_helper.q[idx](0) - (T)1 / lowest_rho);
-                        field_helper.q[idx](1) -= artificial_kinematic_energy_decrease;
-                    }
-                    field_helper.q[idx](0) = lowest_rho;
-                }
-                // 2. calculate the internal energy, devide by rho(to get temperature),
-                // if lower than a value, clamp to it the corresponding d_int_e should
-                // be added to the total energy
-                T int_E = (field_helper.q[idx](1) - 0.5 * (field_helper.q[idx].template tail<dim>() * field_helper.q[idx].template tail<dim>()).sum() / field_helper.q[idx](0));
-                if (int_E - field_helper.q[idx](0) * lowest_int_e_by_rho < 0) {
-                    // Logging::warn("clamped energy");
-                    T delta_E = field_helper.q[idx](0) * lowest_int_e_by_rho - int_E;
-                    field_helper.q[idx](1) += delta_E;
-                }
+                clamp_q(field_helper.q[idx]);
             }
         };
 
-        field_helper.iterateGridSerial(get_eps);
-        field_helper.iterateGridParallel(get_flux, 1);
-        {
+        auto override_moving_flux = [&]() {
             // calculate flux for moving bound
             for (const auto& it_mark : field_helper.moving_Yf_interfaces_override) {
                 auto [I, d, normal, inteface_normal_vel] = it_mark;
@@ -331,9 +336,237 @@ public:
                 Array<T, dim + 2, 1> temp_flux = mixed_bc_flux(Q, U, cell_types, eps.col(d), (T)0);
                 field_helper.flux[idx].col(d) = temp_flux;
             }
+        };
+
+        if constexpr (dim == 3 && XFastestSweep) {
+            if (tiled) {
+                tiled_update(dt, substep, get_flux, override_moving_flux, clamp_q);
+                return;
+            }
         }
+        field_helper.iterateGridSerial(get_eps);
+        field_helper.iterateGridParallel(get_flux, 1);
+        override_moving_flux();
         field_helper.iterateGridParallel(flux_based_update);
     };
+
+    // Tiled sweep, same result as the cell loops above:
+    // 1. copy q/uf into the component-split scratch and reduce eps on the way
+    // 2. skip the tiles without gas, tiles with a non gas cell within the
+    //    2-cell stencil halo are marked as boundary tiles
+    // 3. faces whose stencil is not all gas get the mixed bc flux of get_flux
+    //    plus the moving bound override, as before
+    // 4. per tile and direction the WENO fluxes of all faces are computed in
+    //    contiguous x rows, boundary tiles then patch in the mixed bc faces;
+    //    divergence and the RK combine follow while the tile is in cache
+    template <class FluxOp, class OverrideOp, class ClampOp>
+    void tiled_update(const T& dt, const int& substep, const FluxOp& get_flux,
+        const OverrideOp& override_moving_flux, const ClampOp& clamp_q)
+    {
+        using IV = Vector<int, dim>;
+        using QArray = Array<T, dim + 2, 1>;
+        using EArray = Array<T, dim + 2, dim>;
+        constexpr int nq = dim + 2;
+        auto& grid = field_helper.grid;
+        const int ghost = grid.ghost_layer;
+        const IV ext = (grid.bbmax - grid.bbmin + 2 * ghost).matrix();
+        const size_t N = grid.gridNum();
+        const size_t stride[3] = { 1, (size_t)ext(0), (size_t)ext(0) * ext(1) };
+        auto linear = [&](int i, int j, int k) {
+            return (size_t)(i - grid.bbmin(0) + ghost) + (size_t)(j - grid.bbmin(1) + ghost) * stride[1] + (size_t)(k - grid.bbmin(2) + ghost) * stride[2];
+        };
+
+        // 1.gather
+        auto& q_soa = field_helper.q_soa;
+        auto& u_soa = field_helper.u_soa;
+        auto& gas_mask = field_helper.gas_mask;
+        q_soa.resize(nq * N);
+        u_soa.resize(dim * N);
+        gas_mask.resize(N);
+        eps = tbb::parallel_reduce(
+            tbb::blocked_range<int>(0, ext(2)), EArray(1e-6 * EArray::Ones()),
+            [&](const tbb::blocked_range<int>& r, EArray e) {
+                for (int k = r.begin(); k < r.end(); k++)
+                    for (int j = 0; j < ext(1); j++)
+                        for (int i = 0; i < ext(0); i++) {
+                            size_t s = i + j * stride[1] + k * stride[2];
+                            StorageIndex idx = grid.grid[s].idx;
+                            const QArray& q = field_helper.q[idx];
+                            const Vector<T, dim>& u = field_helper.uf[idx];
+                            for (int c = 0; c < nq; c++)
+                                q_soa[c * N + s] = q(c);
+                            for (int d = 0; d < dim; d++)
+                                u_soa[d * N + s] = u(d);
+                            bool gas = field_helper.cell_type[idx] == CellType::GAS;
+                            gas_mask[s] = gas;
+                            bool in_bbox = i >= ghost && i < ext(0) - ghost && j >= ghost && j < ext(1) - ghost && k >= ghost && k < ext(2) - ghost;
+                            if (in_bbox && gas)
+                                for (int d = 0; d < dim; d++)
+                                    e.col(d) = e.col(d).max(1e-6 * u(d) * u(d) * q * q);
+                        }
+                return e;
+            },
+            [](const EArray& a, const EArray& b) -> EArray { return a.max(b); });
+        // the stencil of the face on the low side of s along d
+        auto pure_gas_face = [&](size_t s, int d) {
+            size_t st = stride[d];
+            return gas_mask[s - 2 * st] && gas_mask[s - st] && gas_mask[s] && gas_mask[s + st];
+        };
+
+        // 2.active tile mask
+        enum TileState : char { INACTIVE,
+            BOUNDARY,
+            INTERIOR };
+        IV ntiles;
+        for (int d = 0; d < dim; d++)
+            ntiles(d) = (grid.bbmax(d) - grid.bbmin(d) + tile_size - 1) / tile_size;
+        const size_t tile_num = (size_t)ntiles(0) * ntiles(1) * ntiles(2);
+        const size_t tile_stride[3] = { 1, (size_t)ntiles(0), (size_t)ntiles(0) * ntiles(1) };
+        auto tile_coord = [&](size_t t) {
+            return IV{ (int)(t % ntiles(0)), (int)(t / ntiles(0) % ntiles(1)), (int)(t / ntiles(0) / ntiles(1)) };
+        };
+        // the ghost layer past bbmax belongs to the last tile when extended
+        auto tile_box = [&](const IV& tc, IV& tmin, IV& tmax, bool extended = false) {
+            for (int d = 0; d < dim; d++) {
+                tmin(d) = grid.bbmin(d) + tc(d) * tile_size;
+                tmax(d) = std::min(tmin(d) + tile_size, grid.bbmax(d));
+                if (extended && tmax(d) == grid.bbmax(d))
+                    tmax(d)++;
+            }
+        };
+        std::vector<char> tile_state(tile_num);
+        tbb::parallel_for<size_t>(0, tile_num, [&](size_t t) {
+            IV tmin, tmax;
+            tile_box(tile_coord(t), tmin, tmax);
+            bool any_gas = false, all_gas = true;
+            for (int k = tmin(2) - 2; k < tmax(2) + 2; k++)
+                for (int j = tmin(1) - 2; j < tmax(1) + 2; j++) {
+                    size_t s0 = linear(0, j, k);
+                    bool row_inside = j >= tmin(1) && j < tmax(1) && k >= tmin(2) && k < tmax(2);
+                    for (int i = tmin(0) - 2; i < tmax(0) + 2; i++) {
+                        bool gas = gas_mask[s0 + i];
+                        all_gas = all_gas && gas;
+                        any_gas = any_gas || (gas && row_inside && i >= tmin(0) && i < tmax(0));
+                    }
+                }
+            tile_state[t] = !any_gas ? INACTIVE : (all_gas ? INTERIOR : BOUNDARY);
+        });
+
+        // 3.mixed bc fluxes, on the faces of boundary tiles and on the low
+        // faces of the tiles next to them, each cell visited by its own tile
+        std::vector<size_t> flux_tiles, active_tiles;
+        for (size_t t = 0; t < tile_num; t++) {
+            if (tile_state[t] != INACTIVE)
+                active_tiles.push_back(t);
+            if (tile_state[t] == INTERIOR)
+                continue;
+            IV tc = tile_coord(t);
+            bool need_flux = tile_state[t] == BOUNDARY;
+            for (int d = 0; d < dim; d++)
+                if (tc(d) > 0 && tile_state[t - tile_stride[d]] != INACTIVE)
+                    need_flux = true;
+            if (need_flux)
+                flux_tiles.push_back(t);
+        }
+        tbb::parallel_for<size_t>(0, flux_tiles.size(), [&](size_t n) {
+            IV tmin, tmax;
+            tile_box(tile_coord(flux_tiles[n]), tmin, tmax, true);
+            for (int k = tmin(2); k < tmax(2); k++)
+                for (int j = tmin(1); j < tmax(1); j++)
+                    for (int i = tmin(0); i < tmax(0); i++) {
+                        size_t s = linear(i, j, k);
+                        bool pure = true;
+                        for (int d = 0; d < dim; d++)
+                            pure = pure && pure_gas_face(s, d);
+                        if (!pure)
+                            get_flux(IV{ i, j, k });
+                    }
+        });
+        override_moving_flux();
+
+        // 4.fused flux, divergence and RK update
+        auto RK_coeffs = ZenEulerGas::Math::TimeIntegration::TVDRK3<T, int>(substep);
+        const T rk_dt = RK_coeffs(2) * dt;
+        constexpr int face_num = (tile_size + 1) * tile_size * tile_size;
+        constexpr int cell_num = tile_size * tile_size * tile_size;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, active_tiles.size()), [&](const tbb::blocked_range<size_t>& r) {
+            std::vector<T> face_flux(face_num), div_flux(nq * cell_num);
+            std::vector<size_t> mixed_faces;
+            for (size_t n = r.begin(); n < r.end(); n++) {
+                const bool boundary = tile_state[active_tiles[n]] == BOUNDARY;
+                IV tmin, tmax;
+                tile_box(tile_coord(active_tiles[n]), tmin, tmax);
+                const IV tn = tmax - tmin;
+                std::fill(div_flux.begin(), div_flux.end(), (T)0);
+                for (int d = 0; d < dim; d++) {
+                    // the low faces of the tile cells, plus one layer past the top in d
+                    const IV fn = tn + IV::Unit(d);
+                    const size_t st = stride[d];
+                    const size_t fst = d == 0 ? 1 : (d == 1 ? fn(0) : fn(0) * fn(1));
+                    const T* U = u_soa.data() + d * N;
+                    mixed_faces.clear();
+                    if (boundary)
+                        for (int k = 0; k < fn(2); k++)
+                            for (int j = 0; j < fn(1); j++)
+                                for (int i = 0; i < fn(0); i++)
+                                    if (!pure_gas_face(linear(tmin(0) + i, tmin(1) + j, tmin(2) + k), d))
+                                        mixed_faces.push_back((k * fn(1) + j) * fn(0) + i);
+                    for (int c = 0; c < nq; c++) {
+                        const T* Qc = q_soa.data() + c * N;
+                        const T e = eps(c, d);
+                        for (int k = 0; k < fn(2); k++)
+                            for (int j = 0; j < fn(1); j++) {
+                                const size_t s0 = linear(tmin(0), tmin(1) + j, tmin(2) + k);
+                                T* F = face_flux.data() + (k * fn(1) + j) * fn(0);
+                                const T* U1 = U + s0 - 2 * st;
+                                const T* U2 = U + s0 - st;
+                                const T* U3 = U + s0;
+                                const T* U4 = U + s0 + st;
+                                const T* Q1 = Qc + s0 - 2 * st;
+                                const T* Q2 = Qc + s0 - st;
+                                const T* Q3 = Qc + s0;
+                                const T* Q4 = Qc + s0 + st;
+                                for (int i = 0; i < fn(0); i++) {
+                                    // WENO2_LLF on scalars, branch free so that the row vectorizes
+                                    T alpha = std::max(std::abs(U2[i]), std::abs(U3[i]));
+                                    F[i] = (T)0.5 * (ZenEulerGas::Math::RPSolver::WENO2<T, T, T>((U1[i] + alpha) * Q1[i], (U2[i] + alpha) * Q2[i], (U3[i] + alpha) * Q3[i], e) + ZenEulerGas::Math::RPSolver::WENO2<T, T, T>((U4[i] - alpha) * Q4[i], (U3[i] - alpha) * Q3[i], (U2[i] - alpha) * Q2[i], e));
+                                }
+                            }
+                        for (size_t f : mixed_faces) {
+                            int i = f % fn(0), j = f / fn(0) % fn(1), k = f / fn(0) / fn(1);
+                            face_flux[f] = field_helper.flux[grid.grid[linear(tmin(0) + i, tmin(1) + j, tmin(2) + k)].idx](c, d);
+                        }
+                        T* D = div_flux.data() + c * cell_num;
+                        for (int k = 0; k < tn(2); k++)
+                            for (int j = 0; j < tn(1); j++) {
+                                const T* F = face_flux.data() + (k * fn(1) + j) * fn(0);
+                                T* Dr = D + (k * tn(1) + j) * tn(0);
+                                for (int i = 0; i < tn(0); i++)
+                                    Dr[i] += inv_dx * (F[i + fst] - F[i]);
+                            }
+                    }
+                }
+                for (int k = 0; k < tn(2); k++)
+                    for (int j = 0; j < tn(1); j++) {
+                        const size_t s0 = linear(tmin(0), tmin(1) + j, tmin(2) + k);
+                        const int cell0 = (k * tn(1) + j) * tn(0);
+                        for (int i = 0; i < tn(0); i++) {
+                            const size_t s = s0 + i;
+                            if (!gas_mask[s])
+                                continue;
+                            const int cell = cell0 + i;
+                            StorageIndex idx = grid.grid[s].idx;
+                            const QArray& q_old = field_helper.q_backup[idx];
+                            QArray q_new;
+                            for (int c = 0; c < nq; c++)
+                                q_new(c) = RK_coeffs(0) * q_old(c) + RK_coeffs(1) * q_soa[c * N + s] - rk_dt * div_flux[c * cell_num + cell];
+                            clamp_q(q_new);
+                            field_helper.q[idx] = q_new;
+                        }
+                    }
+            }
+        });
+    }
 };
 } // namespace ZenEulerGas
 
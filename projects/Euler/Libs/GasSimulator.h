@@ -27,6 +27,8 @@ struct solverControl {
     T cg_converge_cretiria = 1e-7;
     int cg_it_limit = 500;
     bool output_vtk = false;
+    // tiled advection sweeps, off falls back to the per cell loops
+    bool tiled_advection = true;
     // calculating dt
     T dt_min = 5e-10;
     T dt_max = 5e-2;
@@ -70,6 +72,7 @@ public:
     T cg_converge_cretiria = 1e-7;
     int cg_it_limit = 500;
     bool output_vtk = false;
+    bool tiled_advection = true;
     // calculating dt
     T dt_min = 5e-10;
     T dt_max = 5e-2;
@@ -129,6 +132,7 @@ public:
         _sc.cg_converge_cretiria = cg_converge_cretiria;
         _sc.cg_it_limit = cg_it_limit;
         _sc.output_vtk = output_vtk;
+        _sc.tiled_advection = tiled_advection;
         _sc.dt_min = dt_min;
         _sc.dt_max = dt_max;
         _sc.CFL = CFL;
@@ -154,6 +158,7 @@ public:
         cg_converge_cretiria = _sc.cg_converge_cretiria;
         cg_it_limit = _sc.cg_it_limit;
         output_vtk = _sc.output_vtk;
+        tiled_advection = _sc.tiled_advection;
         dt_min = _sc.dt_min;
         dt_max = _sc.dt_max;
         CFL = _sc.CFL;
@@ -253,6 +258,7 @@ public:
         AdvectionOp<T, dim, StorageIndex, XFastestSweep> flux_based_adv{
             {}, field_helper, (T)1 / dx, lowest_rho, lowest_int_e_by_rho
         };
+        flux_based_adv.tiled = tiled_advection;
 
         flux_based_adv(dt, substep);
         convert_q_to_primitives();
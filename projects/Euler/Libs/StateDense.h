@@ -87,6 +87,10 @@ public:
 
     // source term, added to the qs after advection+projection directly
     Field<QArray> source;
+    // advection scratch: the stage q and uf split by component, in the linear
+    // order of the grid, so that tiled sweeps read contiguous x rows
+    Field<T> q_soa, u_soa;
+    Field<char> gas_mask;
     void set_ambient(const Array<T, dim + 2, 1> q_amb_)
     {
         std::fill(q.begin(), q.end(), q_amb_);
@@ -10,6 +10,7 @@
 #include "Libs/StateDense.h"
 #include "Libs/TVDRK.h"
 #include "Libs/WENO.h"
+#include <chrono>
 #include <omp.h>
 #include <stdio.h>
 #include <zeno/MeshObject.h>
@@ -589,4 +590,90 @@ ZENDEFNODE(CompressibleProjection,
                {"CompressibleFlow"},
            });
 
+struct CompressibleBenchmark : zeno::INode {
+  virtual void apply() override {
+    auto caseName = get_input2<std::string>("case");
+    int res = std::max(get_input2<int>("res"), 8);
+    int steps = std::max(get_input2<int>("steps"), 1);
+    bool tiled = get_input2<bool>("tiled");
+
+    // shocktube: Sod problem along x in a res x res/4 x res/4 tube
+    // blast: a high pressure sphere in the middle of a quiet res^3 box
+    bool tube = caseName == "shocktube";
+    int nx = res, ny = tube ? std::max(res / 4, 8) : res, nz = ny;
+    double gamma = 1.4;
+    double dx = 1.0 / nx;
+    auto state = [&](double rho, double p) {
+      ZenEulerGas::Array<double, 5, 1> q;
+      q << rho, p / (gamma - 1), 0, 0, 0;
+      return q;
+    };
+    auto q_amb = tube ? state(0.125, 0.1) : state(1, 0.1);
+    ZenEulerGas::Array<int, 3, 1> ibmin(0, 0, 0), ibmax(nx, ny, nz);
+    ZenEulerGas::FieldHelperDenseDouble3 gas(q_amb, ibmin, ibmax, dx);
+    gas.iterateGridParallel([&](const ZenEulerGas::Vector<int, 3> &I) {
+      int idx = gas.grid[I].idx;
+      if (tube) {
+        if (I(0) < nx / 2)
+          gas.q[idx] = state(1, 1);
+      } else {
+        ZenEulerGas::Vector<double, 3> x =
+            (I.cast<double>().array() + 0.5).matrix() * dx;
+        ZenEulerGas::Vector<double, 3> c(0.5, 0.5 * ny * dx, 0.5 * nz * dx);
+        if ((x - c).norm() < 0.1)
+          gas.q[idx] = state(1, 10);
+      }
+    });
+
+    ZenEulerGas::zenCompressSim sim(dx, ibmin, ibmax, q_amb, gas, gamma);
+    sim.tiled_advection = tiled;
+    sim.initialize();
+
+    using clock = std::chrono::steady_clock;
+    double adv_time = 0, total_time = 0;
+    for (int step = 0; step < steps; step++) {
+      auto t0 = clock::now();
+      double dt = sim.calculate_dt();
+      for (int substep = 0; substep < 3; substep++) {
+        auto t1 = clock::now();
+        sim.advection(dt, substep);
+        adv_time += std::chrono::duration<double>(clock::now() - t1).count();
+        sim.projection(dt, substep);
+      }
+      sim.mark_dof();
+      sim.convert_q_to_primitives();
+      sim.backup();
+      total_time += std::chrono::duration<double>(clock::now() - t0).count();
+    }
+
+    double cells = (double)nx * ny * nz;
+    double updates = cells * steps / total_time;
+    double adv_updates = cells * steps * 3 / adv_time;
+    printf("%s %dx%dx%d, %d steps, %s advection:\n", caseName.c_str(), nx,
+           ny, nz, steps, tiled ? "tiled" : "cell loop");
+    printf("  total %.3fs, %.3g cell updates/s\n", total_time, updates);
+    printf("  advection %.3fs, %.3g cell updates/s per RK stage\n", adv_time,
+           adv_updates);
+
+    set_output2("cellUpdatesPerSec", (float)updates);
+    set_output2("advectionCellUpdatesPerSec", (float)adv_updates);
+  }
+};
+ZENDEFNODE(CompressibleBenchmark, {
+                                      {
+                                          {"enum shocktube blast", "case",
+                                           "shocktube"},
+                                          {"int", "res", "64"},
+                                          {"int", "steps", "5"},
+                                          {"bool", "tiled", "1"},
+                                      },
+                                      {
+                                          {"float", "cellUpdatesPerSec"},
+                                          {"float",
+                                           "advectionCellUpdatesPerSec"},
+                                      },
+                                      {},
+                                      {"CompressibleFlow"},
+                                  });
+
 } // namespace zeno
@@ -156,43 +156,49 @@ m_MinTimeStamp = std::min(m_MinTimeStamp, timeStamp); \
     }
 
     void update(float animationTime) {
+        m_LocalTransform = localTransform(animationTime);
+    }
+
+    aiMatrix4x4 localTransform(float animationTime) const {
         aiMatrix4x4 translation = interpolatePosition(animationTime);
         aiMatrix4x4 rotation = interpolateRotation(animationTime);
         aiMatrix4x4 scale = interpolateScaling(animationTime);
 
-        m_LocalTransform = translation * rotation * scale;
+        return translation * rotation * scale;
     }
 
-    void _getIndexWarn(float animationTime){
+    void _getIndexWarn(float animationTime) const {
         zeno::log_warn("Failed to get index, time {}", animationTime);
     }
 
-    int getPositionIndex(float animationTime) {
-        for (int index = 0; index < m_NumPositions - 1; ++index) {
-            if (animationTime <= m_Positions[index + 1].timeStamp)
-                return index;
+    // index of the first key segment [index, index + 1] ending at or after
+    // animationTime, keys are sorted by time so this is a binary search
+    template <class Key>
+    int getKeyIndex(std::vector<Key> const &keys, float animationTime) const {
+        if (keys.size() < 2) {
+            _getIndexWarn(animationTime);
+            return 0;
         }
-        _getIndexWarn(animationTime);
-        return 0;
-    }
-    int getRotationIndex(float animationTime) {
-        for (int index = 0; index < m_NumRotations - 1; ++index) {
-            if (animationTime <= m_Rotations[index + 1].timeStamp)
-                return index;
+        auto it = std::lower_bound(keys.begin() + 1, keys.end(), animationTime,
+                                   [] (Key const &key, float t) { return key.timeStamp < t; });
+        if (it == keys.end()) {
+            _getIndexWarn(animationTime);
+            return 0;
         }
-        _getIndexWarn(animationTime);
-        return 0;
+        return int(it - keys.begin()) - 1;
     }
-    int getScaleIndex(float animationTime) {
-        for (int index = 0; index < m_NumScalings - 1; ++index) {
-            if (animationTime <= m_Scales[index + 1].timeStamp)
-                return index;
-        }
-        _getIndexWarn(animationTime);
-        return 0;
+
+    int getPositionIndex(float animationTime) const {
+        return getKeyIndex(m_Positions, animationTime);
+    }
+    int getRotationIndex(float animationTime) const {
+        return getKeyIndex(m_Rotations, animationTime);
+    }
+    int getScaleIndex(float animationTime) const {
+        return getKeyIndex(m_Scales, animationTime);
     }
 
-    aiMatrix4x4 interpolatePosition(float animationTime) {
+    aiMatrix4x4 interpolatePosition(float animationTime) const {
         aiMatrix4x4 result;
 
         if (1 == m_NumPositions) {
@@ -212,7 +218,7 @@ m_MinTimeStamp = std::min(m_MinTimeStamp, timeStamp); \
         return result;
     }
 
-    aiMatrix4x4 interpolateRotation(float animationTime) {
+    aiMatrix4x4 interpolateRotation(float animationTime) const {
         aiMatrix4x4 result;
 
         if (1 == m_NumRotations) {
@@ -233,7 +239,7 @@ m_MinTimeStamp = std::min(m_MinTimeStamp, timeStamp); \
         return result;
     }
 
-    aiMatrix4x4 interpolateScaling(float animationTime) {
+    aiMatrix4x4 interpolateScaling(float animationTime) const {
         aiMatrix4x4 result;
         if (1 == m_NumScalings) {
             aiMatrix4x4::Scaling(m_Scales[0].scale, result);
@@ -252,7 +258,7 @@ m_MinTimeStamp = std::min(m_MinTimeStamp, timeStamp); \
         return result;
     }
 
-    float getScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) {
+    float getScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const {
         // e.g. last: 1, next: 2, time: 1.5  -> (1.5-1)/(2-1)=0.5
         float midWayLength = animationTime - lastTimeStamp;
         float framesDiff = nextTimeStamp - lastTimeStamp;
@@ -12,90 +12,332 @@
 
 #include "Definition.h"
 
-#include <glm/vec4.hpp>
-#include <glm/mat4x4.hpp>
+#include <zeno/para/parallel_for.h>
 
+#include <algorithm>
 #include <unordered_map>
 
 namespace {
 
+// Everything of the animation that does not depend on the frame, built once
+// per FBXData and kept by the EvalFBXAnim node: the node tree flattened so that
+// parents come before children, the key channels of each animated node, the
+// skinning influences of the vertices and the static part of the output prims
 struct EvalAnim{
-    float m_CurrentFrame;
-    float m_DeltaTime;
-
-    SFBXEvalOption m_evalOption;
-    NodeTree m_RootNode;
-    SFBXData m_FbxData;
+    struct SNode {
+        std::string name;
+        int parent;
+        aiMatrix4x4 transformation;
+        int animBone;       // into m_AnimBones, -1 if not animated
+        int boneSlot;       // into m_BoneMatrices, -1 if the node has no bone offset
+        aiMatrix4x4 offset;
+    };
+
+    float m_CurrentFrame = 0.0f;
+
+    std::shared_ptr<NodeTree> m_NodeTreeSrc;
+    std::shared_ptr<BoneTree> m_BoneTreeSrc;
+    std::shared_ptr<AnimInfo> m_AnimInfoSrc;
+    float m_GlobalScale = 1.0f;
     AnimInfo m_animInfo;
 
-    std::unordered_map<std::string, aiMatrix4x4> m_Transforms;
-    std::unordered_map<std::string, aiMatrix4x4> m_LazyTransforms;
-    std::unordered_map<std::string, SBoneOffset> m_BoneOffset;
-    std::unordered_map<std::string, SAnimBone> m_AnimBones;
+    std::vector<SNode> m_Nodes;
+    std::vector<SAnimBone> m_AnimBones;
+    std::vector<aiMatrix4x4> m_Globals;
+
+    // one skinning matrix per bone name, the names only referenced by vertices
+    // keep the identity like the missing entries of a name lookup would
+    std::vector<std::string> m_BoneNames;
+    std::unordered_map<std::string, int> m_BoneSlots;
+    std::vector<aiMatrix4x4> m_BoneMatrices;
+
+    // influences of vertex i are [m_InflStart[i], m_InflStart[i + 1])
+    std::vector<aiVector3D> m_RestPositions;
+    std::vector<int> m_InflStart;
+    std::vector<int> m_InflBone;
+    std::vector<float> m_InflWeight;
+    std::vector<std::string> m_InflName;
+    int m_MaxInfluence = 0;
+
+    std::shared_ptr<zeno::PrimitiveObject> m_PrimTemplate;
+
+    // cameras among the nodes without bone offset
+    std::vector<std::pair<int, std::string>> m_CameraNodes;
+
+    std::vector<std::shared_ptr<zeno::PrimitiveObject>> m_BsOrigin;
+    std::vector<std::vector<zeno::vec3f>> m_BsDeltaPositions;
+    std::vector<std::vector<zeno::vec3f>> m_BsDeltaNormals;
+
+    // frame independent as well, built on the first writeData request
+    std::shared_ptr<SFBXData> m_WriteData;
+    std::vector<std::vector<float>> m_JointIndices;
+    std::vector<std::vector<float>> m_JointWeights;
+
+    bool isBuiltFrom(std::shared_ptr<NodeTree> const& nodeTree,
+                     std::shared_ptr<BoneTree> const& boneTree,
+                     std::shared_ptr<AnimInfo> const& animInfo,
+                     float globalScale) const {
+        return m_NodeTreeSrc == nodeTree && m_BoneTreeSrc == boneTree &&
+               m_AnimInfoSrc == animInfo && m_GlobalScale == globalScale;
+    }
 
-    std::vector<SVertex> m_Vertices;
-    std::vector<unsigned int> m_IndicesTris;
-    std::vector<unsigned int> m_IndicesLoops;
-    std::vector<zeno::vec2i> m_IndicesPolys;
+    int boneSlot(std::string const& name){
+        auto [it, isNew] = m_BoneSlots.try_emplace(name, (int)m_BoneNames.size());
+        if(isNew)
+            m_BoneNames.push_back(name);
+        return it->second;
+    }
 
-    std::unordered_map<std::string, int> m_JointCorrespondingIndex;
+    void flattenNodes(const NodeTree *node, int parent, std::shared_ptr<FBXData> const& fbxData){
+        int index = m_Nodes.size();
+        SNode n;
+        n.name = node->name;
+        n.parent = parent;
+        n.transformation = node->transformation;
+        n.animBone = -1;
+        n.boneSlot = -1;
+
+        auto& animBoneMap = m_BoneTreeSrc->AnimBoneMap;
+        if (auto it = animBoneMap.find(n.name); it != animBoneMap.end()) {
+            n.animBone = m_AnimBones.size();
+            m_AnimBones.push_back(it->second);
+        }
+        auto& boneOffset = fbxData->iBoneOffset.value;
+        if (auto it = boneOffset.find(n.name); it != boneOffset.end()) {
+            n.boneSlot = boneSlot(it->second.name);
+            n.offset = it->second.offset;
+        }else if(fbxData->iCamera.value.find(n.name) != fbxData->iCamera.value.end()){
+            m_CameraNodes.emplace_back(index, n.name);
+        }
+        m_Nodes.push_back(std::move(n));
+
+        for (int i = 0; i < node->childrenCount; i++)
+            flattenNodes(&node->children[i], index, fbxData);
+    }
 
     void initAnim(std::shared_ptr<NodeTree>& nodeTree,
                   std::shared_ptr<BoneTree>& boneTree,
                   std::shared_ptr<FBXData>& fbxData,
-                  std::shared_ptr<AnimInfo>& animInfo){
+                  std::shared_ptr<AnimInfo>& animInfo,
+                  float globalScale){
+        m_NodeTreeSrc = nodeTree;
+        m_BoneTreeSrc = boneTree;
+        m_AnimInfoSrc = animInfo;
+        m_GlobalScale = globalScale;
         m_animInfo = *animInfo;
 
-        m_Vertices = fbxData->iVertices.value;
-        m_IndicesTris = fbxData->iIndices.valueTri;
-        m_IndicesPolys = fbxData->iIndices.valuePolys;
-        m_IndicesLoops = fbxData->iIndices.valueLoops;
+        flattenNodes(nodeTree.get(), -1, fbxData);
+        m_Globals.resize(m_Nodes.size());
+
+        auto& vertices = fbxData->iVertices.value;
+        m_RestPositions.resize(vertices.size());
+        m_InflStart.resize(vertices.size() + 1);
+        for(unsigned int i=0; i<vertices.size(); i++){
+            m_RestPositions[i] = vertices[i].position;
+            m_InflStart[i] = m_InflBone.size();
+            for(auto& b: vertices[i].boneWeights){
+                m_InflBone.push_back(boneSlot(b.first));
+                m_InflWeight.push_back(b.second);
+                m_InflName.push_back(b.first);
+            }
+            m_MaxInfluence = std::max(m_MaxInfluence, (int)vertices[i].boneWeights.size());
+        }
+        m_InflStart[vertices.size()] = m_InflBone.size();
+        m_BoneMatrices.resize(m_BoneNames.size());
+
+        buildPrimTemplate(fbxData);
+        buildBlendShapes(fbxData);
+    }
+
+    void buildPrimTemplate(std::shared_ptr<FBXData>& fbxData){
+        auto& vertices = fbxData->iVertices.value;
+        auto& indicesTris = fbxData->iIndices.valueTri;
+        auto& indicesLoops = fbxData->iIndices.valueLoops;
+        auto& indicesPolys = fbxData->iIndices.valuePolys;
+        bool isTris = indicesLoops.size() == 0;
+        std::cout << "mesh size loops " << indicesLoops.size() << " tris " << indicesTris.size() << " is tris " << isTris <<"\n";
+
+        m_PrimTemplate = std::make_shared<zeno::PrimitiveObject>();
+        auto& prim = m_PrimTemplate;
+        prim->verts.resize(vertices.size());
+        auto &uv = prim->verts.add_attr<zeno::vec3f>("uv");
+        auto &norm = prim->verts.add_attr<zeno::vec3f>("nrm");
+        prim->verts.add_attr<zeno::vec3f>("posb");
+        auto &clr0 = prim->verts.add_attr<zeno::vec3f>("clr0");
+        zeno::parallel_for(vertices.size(), [&] (size_t i) {
+            auto& uvw = vertices[i].texCoord;
+            auto& nor = vertices[i].normal;
+            auto& vco = vertices[i].vectexColor;
+            uv[i] = zeno::vec3f(uvw.x, uvw.y, uvw.z);
+            norm[i] = zeno::vec3f(nor.x, nor.y, nor.z);
+            clr0[i] = zeno::vec3f(vco.r, vco.g, vco.b);
+        });
+
+        if(isTris) {
+            prim->tris.resize(indicesTris.size() / 3);
+            auto &uv0 = prim->tris.add_attr<zeno::vec3f>("uv0");
+            auto &uv1 = prim->tris.add_attr<zeno::vec3f>("uv1");
+            auto &uv2 = prim->tris.add_attr<zeno::vec3f>("uv2");
+            zeno::parallel_for(prim->tris.size(), [&] (size_t i) {
+                unsigned int _i1 = indicesTris[i * 3];
+                unsigned int _i2 = indicesTris[i * 3 + 1];
+                unsigned int _i3 = indicesTris[i * 3 + 2];
+                prim->tris[i] = zeno::vec3i(_i1, _i2, _i3);
+                uv0[i] = zeno::vec3f(vertices[_i1].texCoord[0], vertices[_i1].texCoord[1], 0);
+                uv1[i] = zeno::vec3f(vertices[_i2].texCoord[0], vertices[_i2].texCoord[1], 0);
+                uv2[i] = zeno::vec3f(vertices[_i3].texCoord[0], vertices[_i3].texCoord[1], 0);
+            });
+        }else{
+            prim->loops.values.assign(indicesLoops.begin(), indicesLoops.end());
+            prim->polys.values.assign(indicesPolys.begin(), indicesPolys.end());
+            // TODO add uv attr to loops
+            prim->tris.add_attr<zeno::vec3f>("uv0");
+            prim->tris.add_attr<zeno::vec3f>("uv1");
+            prim->tris.add_attr<zeno::vec3f>("uv2");
+        }
+    }
+
+    void buildBlendShapes(std::shared_ptr<FBXData>& fbxData){
+        auto& meshName = fbxData->iMeshName.value_relName;
+        auto& bsValue = fbxData->iBlendSData.value;
+        float gScale = m_GlobalScale;
+
+        for(auto const& [bsName, bss]: bsValue){
+            std::cout << "BlendShape Key " << bsName << "\n";
+            for(int i=0; i< bss.size(); i++){
+                auto& bs = bss[i];
+                auto bsprim = std::make_shared<zeno::PrimitiveObject>();
+                bsprim->verts.resize(bs.size());
+                auto &nrmAttr = bsprim->verts.add_attr<zeno::vec3f>("nrm");
+                auto &dnrmAttr = bsprim->verts.add_attr<zeno::vec3f>("dnrm");
+                auto &dposAttr = bsprim->verts.add_attr<zeno::vec3f>("dpos");
+                zeno::parallel_for(bs.size(), [&] (size_t j) { // Mesh Vert
+                    auto& vdata = bs[j];
+                    auto& pos = vdata.position;
+                    auto& nrm = vdata.normal;
+                    auto& dpos = vdata.deltaPosition;
+                    auto& dnrm = vdata.deltaNormal;
+                    bsprim->verts[j] = zeno::vec3f(pos.x * gScale, pos.y * gScale, pos.z * gScale);
+                    nrmAttr[j] = zeno::vec3f(nrm.x, nrm.y, nrm.z);
+                    dposAttr[j] = zeno::vec3f(dpos.x * gScale, dpos.y * gScale, dpos.z * gScale);
+                    dnrmAttr[j] = zeno::vec3f(dnrm.x, dnrm.y, dnrm.z);
+                });
+                m_BsOrigin.push_back(std::move(bsprim));
+            }
+        }
+
+        // the deltas of the animated mesh, only weighted per frame
+        if(auto it = bsValue.find(meshName); it != bsValue.end()){
+            for(auto& v: it->second){ // Anim Mesh & Same as BlendShape WeightsAndValues
+                auto& dpos = m_BsDeltaPositions.emplace_back(v.size());
+                auto& dnrm = m_BsDeltaNormals.emplace_back(v.size());
+                zeno::parallel_for(v.size(), [&] (size_t j) { // Mesh Vert
+                    auto& vpos = v[j].deltaPosition;
+                    auto& vnor = v[j].deltaNormal;
+                    dpos[j] = zeno::vec3f(vpos.x*gScale, vpos.y*gScale, vpos.z*gScale);
+                    dnrm[j] = zeno::vec3f(vnor.x, vnor.y, vnor.z);
+                });
+            }
+        }
+    }
 
-        m_RootNode = *nodeTree;
-        m_AnimBones = boneTree->AnimBoneMap;
-        m_BoneOffset = fbxData->iBoneOffset.value;
+    // the joint data of all the key frames, same for every frame
+    void buildWriteData(){
+        m_WriteData = std::make_shared<SFBXData>();
+        auto& data = *m_WriteData;
+        std::unordered_map<std::string, int> jointCorrespondingIndex;
+        std::vector<std::string> paths(m_Nodes.size());
+        for(size_t i = 0; i < m_Nodes.size(); i++){
+            auto& n = m_Nodes[i];
+            paths[i] = n.parent < 0 ? n.name : paths[n.parent] + "/" + n.name;
+            data.joints.push_back(paths[i]);
+            data.jointNames.push_back(n.name);
+            jointCorrespondingIndex[n.name] = data.joints.size()-1;
+
+            aiMatrix4x4 parentTransform = n.parent < 0 ? aiMatrix4x4() : data.restTransforms[n.parent];
+            data.restTransforms.push_back(parentTransform * n.transformation);
+            data.bindTransforms.push_back(n.transformation);
+        }
+        data.jointIndices_elementSize = m_MaxInfluence;
+
+        for(float s = m_animInfo.minTimeStamp; s<=m_animInfo.maxTimeStamp; s+=1.0f){
+            auto& rotations = data.rotations_timeSamples[s];
+            auto& translations = data.translations_timeSamples[s];
+            auto& scales = data.scales_timeSamples[s];
+            for(auto& n: m_Nodes){
+                aiVector3t<float> trans{0.0f,0.0f,0.0f};
+                aiQuaterniont<float> rotate;
+                aiVector3t<float> scale{1.0f,1.0f,1.0f};
+                if(n.animBone >= 0)
+                    m_AnimBones[n.animBone].localTransform(s).Decompose(scale, rotate, trans);
+                rotations.emplace_back(rotate.x,rotate.y,rotate.z,rotate.w);
+                translations.emplace_back(trans.x,trans.y,trans.z);
+                scales.emplace_back(scale.x,scale.y,scale.z);
+            }
+        }
 
-        m_CurrentFrame = 0.0f;
+        // vertices with less influences are padded with joint index 0, weight 0
+        size_t nv = m_RestPositions.size();
+        m_JointIndices.assign(m_MaxInfluence, std::vector<float>(nv, 0.0f));
+        m_JointWeights.assign(m_MaxInfluence, std::vector<float>(nv, 0.0f));
+        for(size_t i = 0; i < nv; i++){
+            for(int k = m_InflStart[i]; k < m_InflStart[i+1]; k++){
+                int z = k - m_InflStart[i];
+                m_JointIndices[z][i] = (float)jointCorrespondingIndex[m_InflName[k]];
+                m_JointWeights[z][i] = m_InflWeight[k];
+            }
+        }
     }
 
-    void updateAnimation(int fi, std::shared_ptr<zeno::PrimitiveObject>& prim, float fps) {
+    void updateAnimation(int fi, float fps, SFBXEvalOption const& evalOption) {
         // TODO Use the actual frame number
         float dt = fi / fps;
-        m_DeltaTime = dt;
-        m_CurrentFrame += m_animInfo.tick * dt;
-        m_CurrentFrame = fmod(m_CurrentFrame, m_animInfo.duration);
+        m_CurrentFrame = fmod(m_animInfo.tick * dt, m_animInfo.duration);
 
         //zeno::log_info("Update: F {} D {} C {}", fi, dt, m_CurrentFrame);
-        //std::cout << "FBX: CurrentFrame " << m_CurrentFrame << " Duration "
-        //          << m_animInfo.duration << " DeltaTime " << m_DeltaTime << std::endl;
 
-        if(m_evalOption.writeData){
-            expandBoneTransform(&m_RootNode, "", aiMatrix4x4());
-            calculateMaxBoneInfluence();
+        if(evalOption.writeData && !m_WriteData)
+            buildWriteData();
 
-            for(float s = m_animInfo.minTimeStamp; s<=m_animInfo.maxTimeStamp; s+=1.0f){
-                //std::cout << "FBX: Calculate Anim Transform Time " << s << std::endl;
-                calculateAnimTransform(&m_RootNode, s);
+        calculateBoneTransform(evalOption);
+    }
+
+    // parents are evaluated before their children, so one linear pass will do
+    void calculateBoneTransform(SFBXEvalOption const& evalOption) {
+        std::fill(m_BoneMatrices.begin(), m_BoneMatrices.end(), aiMatrix4x4());
+        for(size_t i = 0; i < m_Nodes.size(); i++){
+            auto& n = m_Nodes[i];
+            aiMatrix4x4 nodeTransform = n.transformation;
+
+            // Any object that just has the key-anim is a bone
+            if (n.animBone >= 0) {
+                nodeTransform = m_AnimBones[n.animBone].localTransform(m_CurrentFrame);
+
+                if(evalOption.printAnimData) {
+                    std::cout << "FBX: Anim Node Name " << n.name << std::endl;
+                    Helper::printAiMatrix(nodeTransform);
+                }
             }
-        }
+            m_Globals[i] = n.parent < 0 ? nodeTransform : m_Globals[n.parent] * nodeTransform;
 
-        calculateBoneTransform(&m_RootNode, aiMatrix4x4());
-        calculateFinal(prim);
+            if (n.boneSlot >= 0)
+                m_BoneMatrices[n.boneSlot] = m_Globals[i] * n.offset;
+        }
     }
 
     void decomposeAnimation(std::shared_ptr<zeno::DictObject> &t,
                             std::shared_ptr<zeno::DictObject> &r,
                             std::shared_ptr<zeno::DictObject> &s){
 
-        for(auto& m:m_Transforms){
-            //zeno::log_info("A {}", m.first);
+        // only the bones of the node tree, not the names only known to vertices
+        for(auto& n: m_Nodes){
+            if(n.boneSlot < 0)
+                continue;
+            int b = n.boneSlot;
             aiVector3t<float> trans;
             aiQuaterniont<float> rotate;
             aiVector3t<float> scale;
-            m.second.Decompose(scale, rotate, trans);
-            //zeno::log_info("    T {: f} {: f} {: f}", trans.x, trans.y, trans.z);
-            //zeno::log_info("    R {: f} {: f} {: f} {: f}", rotate.x, rotate.y, rotate.z, rotate.w);
-            //zeno::log_info("    S {: f} {: f} {: f}", scale.x, scale.y, scale.z);
+            m_BoneMatrices[b].Decompose(scale, rotate, trans);
 
             auto nt = std::make_shared<zeno::NumericObject>();
             nt->value = zeno::vec3f(trans.x, trans.y, trans.z);
@@ -106,233 +348,81 @@ struct EvalAnim{
             auto ns = std::make_shared<zeno::NumericObject>();
             ns->value = zeno::vec3f(scale.x, scale.y, scale.z);
 
-            t->lut[m.first] = nt;
-            r->lut[m.first] = nr;
-            s->lut[m.first] = ns;
+            t->lut[m_BoneNames[b]] = nt;
+            r->lut[m_BoneNames[b]] = nr;
+            s->lut[m_BoneNames[b]] = ns;
         }
     }
 
-    void calculateMaxBoneInfluence(){
-        for(unsigned int i=0; i<m_Vertices.size(); i++) {
-            int s = m_Vertices[i].boneWeights.size();
-            m_FbxData.jointIndices_elementSize = std::max(s, m_FbxData.jointIndices_elementSize);
-        }
-        //std::cout << "FBX: MaxJointInfluence " << m_FbxData.jointIndices_elementSize << std::endl;
-    }
-
-    void calculateAnimTransform(const NodeTree *node, float timeCode){
-        std::string nodeName = node->name;
-        aiVector3t<float> trans{0.0f,0.0f,0.0f};
-        aiQuaterniont<float> rotate;
-        aiVector3t<float> scale{1.0f,1.0f,1.0f};
-
-        if (m_AnimBones.find(nodeName) != m_AnimBones.end()) {
-            auto& bone = m_AnimBones[nodeName];
-            bone.update(timeCode);
-            bone.m_LocalTransform.Decompose(scale, rotate, trans);
-        }
-
-        m_FbxData.rotations_timeSamples[timeCode].emplace_back(rotate.x,rotate.y,rotate.z,rotate.w);
-        m_FbxData.translations_timeSamples[timeCode].emplace_back(trans.x,trans.y,trans.z);
-        m_FbxData.scales_timeSamples[timeCode].emplace_back(scale.x,scale.y,scale.z);
-
-        for (int i = 0; i < node->childrenCount; i++)
-            calculateAnimTransform(&node->children[i], timeCode);
-    }
-
-    void expandBoneTransform(const NodeTree *node, std::string pPath, aiMatrix4x4 parentTransform) {
-        std::string nodeName = node->name;
-        std::string cName;
-        pPath.empty() ? cName = nodeName : cName = pPath + "/" + nodeName;
-        aiMatrix4x4 nodeTransform = node->transformation;
-
-        m_FbxData.joints.push_back(cName);
-        m_FbxData.jointNames.push_back(nodeName);
-        m_JointCorrespondingIndex[nodeName] = m_FbxData.joints.size()-1;
-        //std::cout << "FBX: Bone name " << nodeName << " " << cName << " " << m_FbxData.joints.size() << std::endl;
-
-        aiMatrix4x4 globalTransformation = parentTransform * nodeTransform;
-        m_FbxData.restTransforms.push_back(globalTransformation);
-        m_FbxData.bindTransforms.push_back(nodeTransform);
-
-        if (m_BoneOffset.find(nodeName) != m_BoneOffset.end()) {  // found
-            std::string boneName = m_BoneOffset[nodeName].name;
-            aiMatrix4x4 boneOffset = m_BoneOffset[nodeName].offset;
-            m_Transforms[boneName] = globalTransformation * boneOffset;
-        }
-
-        for (int i = 0; i < node->childrenCount; i++)
-            expandBoneTransform(&node->children[i], cName, globalTransformation);
-    }
-
-    void calculateBoneTransform(const NodeTree *node, aiMatrix4x4 parentTransform) {
-        std::string nodeName = node->name;
-        aiMatrix4x4 nodeTransform = node->transformation;
-
-        //zeno::log_info("***** {}", nodeName);
-        // Any object that just has the key-anim is a bone
-        if (m_AnimBones.find(nodeName) != m_AnimBones.end()) {
-            auto& bone = m_AnimBones[nodeName];
-
-            bone.update(m_CurrentFrame);
-            nodeTransform = bone.m_LocalTransform;
-
-            if(m_evalOption.printAnimData) {
-                std::cout << "FBX: Anim Node Name " << nodeName << std::endl;
-                Helper::printAiMatrix(nodeTransform);
-            }
-        }
-        aiMatrix4x4 globalTransformation = parentTransform * nodeTransform;
-
-        // XXX Lazy Transform
-        if (m_BoneOffset.find(nodeName) != m_BoneOffset.end()) {  // found
-            std::string boneName = m_BoneOffset[nodeName].name;
-            aiMatrix4x4 boneOffset = m_BoneOffset[nodeName].offset;
-            //std::cout << "FBX: Bone Node Name " << nodeName << std::endl;
-            //Helper::printAiMatrix(boneOffset);
-
-            m_Transforms[boneName] = globalTransformation * boneOffset;
-        }else{
-            // The child is already applied the parent transformation by the tree struct.
-            m_LazyTransforms[nodeName] = globalTransformation;
-            //std::cout << "FBX: Lazy Node Name " << nodeName << std::endl;
-        }
-
-        for (int i = 0; i < node->childrenCount; i++)
-            calculateBoneTransform(&node->children[i], globalTransformation);
-    }
-
     void updateCameraAndLight(std::shared_ptr<FBXData>& fbxData,
                               std::shared_ptr<ICamera>& iCamera,
                               std::shared_ptr<ILight>& iLight)
     {
-        float s = m_evalOption.globalScale;
-        for(auto& m: m_LazyTransforms){
-            if(fbxData->iCamera.value.find(m.first) != fbxData->iCamera.value.end()){
-                //zeno::log_info("----- LT Camera {}", m.first);
-                //Helper::printAiMatrix(m.second, true);
+        float s = m_GlobalScale;
+        for(auto const& [i, name]: m_CameraNodes){
+            SCamera cam = fbxData->iCamera.value.at(name);
 
-                SCamera cam = fbxData->iCamera.value.at(m.first);
+            aiVector3t<float> trans;
+            aiQuaterniont<float> rotate;
+            aiVector3t<float> scale;
+            m_Globals[i].Decompose(scale, rotate, trans);
+            cam.pos = zeno::vec3f(trans.x*s, trans.y*s, trans.z*s);
+            aiMatrix3x3 r = rotate.GetMatrix().Transpose();
+            cam.view = zeno::vec3f(r.a1, r.a2, r.a3);
+            cam.up = zeno::vec3f(r.b1, r.b2, r.b3);
 
-                aiVector3t<float> trans;
-                aiQuaterniont<float> rotate;
-                aiVector3t<float> scale;
-                m.second.Decompose(scale, rotate, trans);
-                cam.pos = zeno::vec3f(trans.x*s, trans.y*s, trans.z*s);
-                aiMatrix3x3 r = rotate.GetMatrix().Transpose();
-                cam.view = zeno::vec3f(r.a1, r.a2, r.a3);
-                cam.up = zeno::vec3f(r.b1, r.b2, r.b3);
-
-                iCamera->value[m.first] = cam;
-            }else if(fbxData->iLight.value.find(m.first) != fbxData->iLight.value.end()){
-                //zeno::log_info("+++++ LT Light {}", m.first);
-                //Helper::printAiMatrix(m.second, true);
-            }
+            iCamera->value[name] = cam;
         }
     }
 
-    void calculateFinal(std::shared_ptr<zeno::PrimitiveObject>& prim){
-        auto &ver = prim->verts;
-        auto &trisInd = prim->tris;
-        auto &polys = prim->polys;
-        auto &loops = prim->loops;
-        auto &uv = prim->verts.add_attr<zeno::vec3f>("uv");
-        auto &norm = prim->verts.add_attr<zeno::vec3f>("nrm");
-        auto &posb = prim->verts.add_attr<zeno::vec3f>("posb");
-        auto &clr0 = prim->verts.add_attr<zeno::vec3f>("clr0");
-        bool isTris = false;
-        if(m_IndicesLoops.size() == 0){
-            isTris = true;
-        }else{
-            isTris = false;
-        }
-        std::cout << "mesh size loops " << m_IndicesLoops.size() << " tris " << m_IndicesTris.size() << " is tris " << isTris <<"\n";
-        for(int i=0;i<m_FbxData.jointIndices_elementSize;i++){
-            prim->verts.add_attr<float>("jointIndice_" + std::to_string(i));
-            prim->verts.add_attr<float>("jointWeight_" + std::to_string(i));
+    std::shared_ptr<zeno::PrimitiveObject> calculateFinal(bool writeData){
+        auto prim = std::make_shared<zeno::PrimitiveObject>(*m_PrimTemplate);
+        int jie = writeData ? m_MaxInfluence : 0;
+        for(int i=0;i<jie;i++){
+            prim->verts.add_attr<float>("jointIndice_" + std::to_string(i)) = m_JointIndices[i];
+            prim->verts.add_attr<float>("jointWeight_" + std::to_string(i)) = m_JointWeights[i];
         }
-        int jie = m_FbxData.jointIndices_elementSize;
         prim->userData().set2("jointIndicesElementSize", std::move(jie));
-        float s = m_evalOption.globalScale;
-
-        for(unsigned int i=0; i<m_Vertices.size(); i++){
-            auto& bwe = m_Vertices[i].boneWeights;
-            auto& pos = m_Vertices[i].position;
-            auto& uvw = m_Vertices[i].texCoord;
-            auto& nor = m_Vertices[i].normal;
-            auto& vco = m_Vertices[i].vectexColor;
-
-            glm::vec4 tpos(0.0f, 0.0f, 0.0f, 0.0f);
-
-            bool infd = false;
-            int bCount = 0;
-            for(auto& b: bwe){
-                if(jie){
-                    float bIndex = (float)m_JointCorrespondingIndex[b.first];
-                    prim->verts.attr<float>("jointIndice_" + std::to_string(bCount)).push_back(bIndex);
-                    prim->verts.attr<float>("jointWeight_" + std::to_string(bCount)).push_back(b.second);
-                }
-                //std::cout << "FBX: Vert " << i << " name " << b.first << " bIndex " << bIndex << std::endl;
-                infd = true;
-                auto& tr = m_Transforms[b.first];
-                glm::mat4 trans = glm::mat4(tr.a1,tr.b1,tr.c1,tr.d1,
-                                            tr.a2,tr.b2,tr.c2,tr.d2,
-                                            tr.a3,tr.b3,tr.c3,tr.d3,
-                                            tr.a4,tr.b4,tr.c4,tr.d4);
-                glm::vec4 lpos = trans * glm::vec4(pos.x, pos.y, pos.z, 1.0f);
-                tpos += lpos * b.second;
-                bCount += 1;
+        float s = m_GlobalScale;
+
+        zeno::parallel_for(m_RestPositions.size(), [&] (size_t i) {
+            auto& pos = m_RestPositions[i];
+            float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
+            for(int k = m_InflStart[i]; k < m_InflStart[i+1]; k++){
+                auto& tr = m_BoneMatrices[m_InflBone[k]];
+                float bw = m_InflWeight[k];
+                x += (tr.a1 * pos.x + tr.a2 * pos.y + tr.a3 * pos.z + tr.a4) * bw;
+                y += (tr.b1 * pos.x + tr.b2 * pos.y + tr.b3 * pos.z + tr.b4) * bw;
+                z += (tr.c1 * pos.x + tr.c2 * pos.y + tr.c3 * pos.z + tr.c4) * bw;
+                w += (tr.d1 * pos.x + tr.d2 * pos.y + tr.d3 * pos.z + tr.d4) * bw;
             }
-            // Supplement, joint index supplement 0, weight 0
-            for(int z=bCount; z<m_FbxData.jointIndices_elementSize; z++){
-                prim->verts.attr<float>("jointIndice_" + std::to_string(bCount)).push_back(0);
-                prim->verts.attr<float>("jointWeight_" + std::to_string(bCount)).push_back(0.0f);
+            if(m_InflStart[i] == m_InflStart[i+1]){
+                x = pos.x; y = pos.y; z = pos.z; w = 1.0f;
             }
-            if(! infd)
-                tpos = glm::vec4(pos.x, pos.y, pos.z, 1.0f);
-
-            glm::vec3 fpos = glm::vec3(tpos.x/tpos.w, tpos.y/tpos.w, tpos.z/tpos.w);
-
-            ver.emplace_back(fpos.x*s, fpos.y*s, fpos.z*s);
-            posb.emplace_back(0.0f, 0.0f, 0.0f);
-            uv.emplace_back(uvw.x, uvw.y, uvw.z);
-            norm.emplace_back(nor.x, nor.y, nor.z);
-            clr0.emplace_back(vco.r, vco.g, vco.b);
-        }
-
-        if(isTris) {
-            for (unsigned int i = 0; i < m_IndicesTris.size(); i += 3) {
-                zeno::vec3i incs(m_IndicesTris[i], m_IndicesTris[i + 1], m_IndicesTris[i + 2]);
-                trisInd.push_back(incs);
-            }
-        }else{
-            for (unsigned int i = 0; i < m_IndicesLoops.size(); i ++) {
-                loops.emplace_back(m_IndicesLoops[i]);
-            }
-            for (unsigned int i = 0; i < m_IndicesPolys.size(); i ++) {
-                polys.emplace_back(m_IndicesPolys[i]);
-            }
-        }
-
-        auto &uv0 = prim->tris.add_attr<zeno::vec3f>("uv0");
-        auto &uv1 = prim->tris.add_attr<zeno::vec3f>("uv1");
-        auto &uv2 = prim->tris.add_attr<zeno::vec3f>("uv2");
-        if(isTris) {
-            for (unsigned int i = 0; i < trisInd.size(); i++) {
-                unsigned int _i1 = trisInd[i][0];
-                unsigned int _i2 = trisInd[i][1];
-                unsigned int _i3 = trisInd[i][2];
-                uv0[i] = zeno::vec3f(m_Vertices[_i1].texCoord[0], m_Vertices[_i1].texCoord[1], 0);
-                uv1[i] = zeno::vec3f(m_Vertices[_i2].texCoord[0], m_Vertices[_i2].texCoord[1], 0);
-                uv2[i] = zeno::vec3f(m_Vertices[_i3].texCoord[0], m_Vertices[_i3].texCoord[1], 0);
-            }
-        }else{
-            // TODO add uv attr to loops
-        }
+            prim->verts[i] = zeno::vec3f(x/w*s, y/w*s, z/w*s);
+        });
+        return prim;
     }
 };
 
 struct EvalFBXAnim : zeno::INode {
+    // the evaluator of the FBXData last seen, rebuilt when another one comes
+    std::shared_ptr<EvalAnim> m_Anim;
+    std::weak_ptr<FBXData> m_AnimData;
+
+    std::shared_ptr<EvalAnim> getEvalAnim(std::shared_ptr<FBXData>& fbxData,
+                                          std::shared_ptr<NodeTree>& nodeTree,
+                                          std::shared_ptr<BoneTree>& boneTree,
+                                          std::shared_ptr<AnimInfo>& animInfo,
+                                          float globalScale){
+        if(m_Anim && m_AnimData.lock() == fbxData &&
+                m_Anim->isBuiltFrom(nodeTree, boneTree, animInfo, globalScale))
+            return m_Anim;
+        m_Anim = std::make_shared<EvalAnim>();
+        m_Anim->initAnim(nodeTree, boneTree, fbxData, animInfo, globalScale);
+        m_AnimData = fbxData;
+        return m_Anim;
+    }
 
     virtual void apply() override {
         int frameid;
@@ -367,7 +457,6 @@ struct EvalFBXAnim : zeno::INode {
         //zeno::log_info("FBX: Eval Option InterAnimData {} WriteData {} UnitScale {}",
         //               evalOption.interAnimData, evalOption.writeData, evalOption.globalScale);
 
-        auto prim = std::make_shared<zeno::PrimitiveObject>();
         auto transDict = std::make_shared<zeno::DictObject>();
         auto quatDict = std::make_shared<zeno::DictObject>();
         auto scaleDict = std::make_shared<zeno::DictObject>();
@@ -376,12 +465,11 @@ struct EvalFBXAnim : zeno::INode {
         auto matName = std::make_shared<zeno::StringObject>();
         auto outMeshName = std::make_shared<zeno::StringObject>();
 
-        EvalAnim anim;
-        anim.m_evalOption = evalOption;
-        anim.initAnim(nodeTree, boneTree, fbxData, animInfo);
-        anim.updateAnimation(frameid, prim, fps);
-        anim.updateCameraAndLight(fbxData, iCamera, iLight);
-        anim.decomposeAnimation(transDict, quatDict, scaleDict);
+        auto anim = getEvalAnim(fbxData, nodeTree, boneTree, animInfo, evalOption.globalScale);
+        anim->updateAnimation(frameid, fps, evalOption);
+        auto prim = anim->calculateFinal(evalOption.writeData);
+        anim->updateCameraAndLight(fbxData, iCamera, iLight);
+        anim->decomposeAnimation(transDict, quatDict, scaleDict);
 
         auto bsPrims = std::make_shared<zeno::ListObject>();
         auto bsPrimsOrigin = std::make_shared<zeno::ListObject>();
@@ -391,83 +479,50 @@ struct EvalFBXAnim : zeno::INode {
         outMeshName->set(meshName);
 
         auto& kmValue = fbxData->iKeyMorph.value;
-        auto& bsValue = fbxData->iBlendSData.value;
-        float gScale = evalOption.globalScale;
 
-        for(auto const& [bsName, bss]: bsValue){
-            std::cout << "BlendShape Key " << bsName << "\n";
-            for(int i=0; i< bss.size(); i++){
-                auto bsprim = std::make_shared<zeno::PrimitiveObject>();
-                auto &verAttr = bsprim->verts;
-                auto &indAttr = bsprim->tris;
-                auto &nrmAttr = bsprim->verts.add_attr<zeno::vec3f>("nrm");
-                auto &dnrmAttr = bsprim->verts.add_attr<zeno::vec3f>("dnrm");
-                auto &dposAttr = bsprim->verts.add_attr<zeno::vec3f>("dpos");
-                auto& bs = bss[i];
-                for(unsigned int j=0; j<bs.size(); j++){ // Mesh Vert
-                    auto& vdata = bs[j];
-                    auto& pos = vdata.position;
-                    auto& nrm = vdata.normal;
-                    auto& dpos = vdata.deltaPosition;
-                    auto& dnrm = vdata.deltaNormal;
-                    verAttr.emplace_back(pos.x * gScale, pos.y * gScale, pos.z * gScale);
-                    nrmAttr.emplace_back(nrm.x, nrm.y, nrm.z);
-                    dposAttr.emplace_back(dpos.x * gScale, dpos.y * gScale, dpos.z * gScale);
-                    dnrmAttr.emplace_back(dnrm.x, dnrm.y, dnrm.z);
-                }
-
-                bsPrimsOrigin->arr.emplace_back(bsprim);
-            }
+        for(auto const& bsprim: anim->m_BsOrigin){
+            bsPrimsOrigin->arr().push_back(std::make_shared<zeno::PrimitiveObject>(*bsprim));
         }
 
         // TODO FBXData Write BlendShape
-        if(bsValue.find(meshName) != bsValue.end()){
-            auto& b = bsValue[meshName];
-
+        if(fbxData->iBlendSData.value.count(meshName)){
             if(kmValue.find(meshName) != kmValue.end()){
                 auto& k = kmValue[meshName];
+                // Find keyMorph index, the first key segment ending after the current frame
+                // Animation must occur between at least two frames
                 unsigned int ki = 0;
-                unsigned int kin;
-                for(unsigned int i=0; i<k.size()-1; i++){  // Find keyMorph index
-                    if(anim.m_CurrentFrame < k[i+1].m_Time){ // Animation must occur between at least two frames
-                        ki = i;
-                    }
+                unsigned int kin = 0;
+                if(k.size() >= 2){
+                    auto it = std::upper_bound(k.begin() + 1, k.end(), anim->m_CurrentFrame,
+                                               [] (float t, SKeyMorph const& key) { return t < key.m_Time; });
+                    ki = it == k.end() ? 0 : (it - k.begin()) - 1;
+                    kin = ki+1;
                 }
-                kin = ki+1;
 
                 auto& kd = k[ki];
                 auto& kdn = k[kin];
-                float factor = (anim.m_CurrentFrame - kd.m_Time) / (kdn.m_Time - kd.m_Time);
-                for(unsigned int i=0; i<b.size(); i++){ // Anim Mesh & Same as BlendShape WeightsAndValues
+                float factor = kin == ki ? 0.0f : (anim->m_CurrentFrame - kd.m_Time) / (kdn.m_Time - kd.m_Time);
+                for(unsigned int i=0; i<anim->m_BsDeltaPositions.size(); i++){ // Anim Mesh & Same as BlendShape WeightsAndValues
                     auto bsprim = std::make_shared<zeno::PrimitiveObject>();
-                    auto &ver = bsprim->verts;
-                    auto &ind = bsprim->tris;
-                    auto &norm = bsprim->verts.add_attr<zeno::vec3f>("nrm");
-                    auto &posb = bsprim->verts.add_attr<zeno::vec3f>("posb");
-                    auto &bsw = bsprim->verts.add_attr<float>("bsw");
                     double w = kd.m_Weights[i] * (1.0f - factor) + kdn.m_Weights[i] * factor;
-                    auto& v = b[i];
-                    for(unsigned int j=0; j<v.size(); j++){ // Mesh Vert
-                        auto& vpos = v[j].deltaPosition;
-                        //v[j].position;
-                        auto& vnor = v[j].deltaNormal;
-                        ver.emplace_back(vpos.x*gScale, vpos.y*gScale, vpos.z*gScale);
-                        posb.emplace_back(0.0f, 0.0f, 0.0f);
-                        bsw.emplace_back((float)w);
-                        norm.emplace_back(vnor.x, vnor.y, vnor.z);
-                    }
-
-                    bsPrims->arr.emplace_back(bsprim);
+                    bsprim->verts.values = anim->m_BsDeltaPositions[i];
+                    bsprim->verts.add_attr<zeno::vec3f>("nrm") = anim->m_BsDeltaNormals[i];
+                    bsprim->verts.add_attr<zeno::vec3f>("posb");
+                    auto &bsw = bsprim->verts.add_attr<float>("bsw");
+                    std::fill(bsw.begin(), bsw.end(), (float)w);
+
+                    bsPrims->arr().emplace_back(bsprim);
                 }
             }else{
                 zeno::log_info("BlendShape NotFound MorphKey {}", meshName);
             }
         }
 
-        //zeno::log_info("Frame {} Prims Num {} Mesh Name {}", anim.m_CurrentFrame, bsPrims->arr.size(), meshName);
+        //zeno::log_info("Frame {} Prims Num {} Mesh Name {}", anim->m_CurrentFrame, bsPrims->arr().size(), meshName);
 
         auto data2write = std::make_shared<SFBXData>();
-        *data2write = anim.m_FbxData;
+        if(evalOption.writeData)
+            *data2write = *anim->m_WriteData;
 
         set_output("prim", std::move(prim));
         set_output("bsPrims", std::move(bsPrims));
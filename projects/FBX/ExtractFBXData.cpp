@@ -100,13 +100,13 @@ struct ExtractMatTexList : zeno::INode {
         for(auto&p: tl){
             auto s = std::make_shared<zeno::StringObject>();
             s->value = p;
-            lo->arr.emplace_back(s);
+            lo->arr().emplace_back(s);
         }
 
-        //for(auto&l: lo->arr){
+        //for(auto&l: lo->arr()){
         //    zeno::log_info("Tex: {}", std::any_cast<std::string>(l));
         //}
-        //zeno::log_info(">>>>> Get TexLen {}", lo->arr.size());
+        //zeno::log_info(">>>>> Get TexLen {}", lo->arr().size());
 
         name->set(mat->matName);
 
@@ -170,7 +170,7 @@ struct ExtractMatData : zeno::INode {
         auto matName = std::make_shared<zeno::StringObject>();
 
         for(auto [k, v]: data->iFbxData.value){
-            datas->arr.push_back(v);
+            datas->arr().push_back(v);
         }
         matName->set(data->sMaterial.matName);
 
@@ -184,7 +184,7 @@ struct ExtractMatData : zeno::INode {
         for(auto&p: tl){
             auto s = std::make_shared<zeno::StringObject>();
             s->value = p;
-            texLists->arr.emplace_back(s);
+            texLists->arr().emplace_back(s);
         }
 
         set_output("datas", std::move(datas));
@@ -469,7 +469,7 @@ struct LiveMeshNode : INode {
                 std::cout << "Vertices Size " << vertices_size << " " << vertexCount_size << " " << vertexList_size << "\n";
                 GeneratePrimitiveObject(ingredient, prim);
 
-                prims->arr.emplace_back(prim);
+                prims->arr().emplace_back(prim);
             }
              */
 
@@ -565,7 +565,7 @@ struct LiveMeshNode : INode {
                     if(outDict) {
                         prims_dict->lut[key] = prim;
                     }else{
-                        prims_list->arr.emplace_back(prim);
+                        prims_list->arr().emplace_back(prim);
                     }
                 }
             }else{
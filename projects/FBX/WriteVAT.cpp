@@ -1,5 +1,6 @@
 #include <zeno/zeno.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/UserData.h>
 #include <zeno/extra/GlobalState.h>
@@ -320,7 +321,8 @@ struct WriteCustomVAT : INode {
             prims.resize(frameCount);
         }
         auto raw_prim = get_input<PrimitiveObject>("prim");
-        auto prim = std::dynamic_pointer_cast<PrimitiveObject>(raw_prim->clone());
+        auto prim = raw_prim->inst ? primExpandInstances(raw_prim.get())
+                                   : std::dynamic_pointer_cast<PrimitiveObject>(raw_prim->clone());
         if (frameStart <= frameid && frameid <= frameEnd) {
             prims[frameid - frameStart] = prim;
         }
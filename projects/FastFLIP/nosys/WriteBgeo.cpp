@@ -2,6 +2,7 @@
 #include <Partio.h>
 #include <zeno/ParticlesObject.h>
 #include <zeno/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/zeno.h>
 template <class T>
 static void outputBgeo(std::string path, const std::vector<T> &pos,
@@ -33,7 +34,9 @@ namespace zeno {
 struct WriteBgeo : zeno::INode {
   virtual void apply() override {
     auto path = get_param<std::string>("path");
-    if (auto p = dynamic_cast<PrimitiveObject *>(get_input("data").get())) {
+    if (auto p = std::dynamic_pointer_cast<PrimitiveObject>(get_input("data"))) {
+        if (p->inst)
+            p = primExpandInstances(p.get());
         outputBgeo(path, p->verts.attr<vec3f>("pos"), p->verts.attr<vec3f>("vel"));
     } else {
         auto data = get_input("data")->as<ParticlesObject>();
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace zeno {
+
+// lazy element-wise image expression, evaluated tile by tile when a sink pulls it
+struct CVImageExpr {
+    enum class Op {
+        Leaf,
+        Add,          // cv::add(lhs, rhs)
+        AddWeighted,  // cv::addWeighted(lhs, alpha, rhs, beta, gamma)
+        Subtract,     // cv::subtract(lhs, rhs)
+        MulScalar,    // cv::multiply(lhs, alpha, dst, scale)
+        Multiply,     // cv::multiply(lhs, rhs, dst, scale)
+        Divide,       // cv::divide(lhs, rhs, dst, scale)
+        BitwiseNot,   // cv::bitwise_not(lhs)
+    };
+
+    Op op = Op::Leaf;
+    std::shared_ptr<CVImageExpr> lhs, rhs;
+    double alpha = 1, beta = 1, gamma = 0, scale = 1;
+
+    int rows = 0, cols = 0, type = 0;
+
+private:
+    cv::Mat result;  // the leaf image, or the cached result once evaluated
+    std::mutex mtx;
+    std::atomic<int> consumers{0};  // number of expressions reading this one
+
+public:
+    explicit CVImageExpr(cv::Mat image)
+        : rows(image.rows), cols(image.cols), type(image.type()), result(std::move(image)) {
+    }
+
+    CVImageExpr(Op op, std::shared_ptr<CVImageExpr> lhs, std::shared_ptr<CVImageExpr> rhs = nullptr)
+        : op(op), lhs(std::move(lhs)), rhs(std::move(rhs)) {
+        rows = this->lhs->rows;
+        cols = this->lhs->cols;
+        type = this->lhs->type;
+        this->lhs->consumers++;
+        if (this->rhs) this->rhs->consumers++;
+    }
+
+    // element-wise ops only fuse when both operands agree on shape and type,
+    // otherwise the caller should fall back to the eager OpenCV call
+    static bool compatible(CVImageExpr const &a, CVImageExpr const &b) {
+        return a.rows == b.rows && a.cols == b.cols && a.type == b.type;
+    }
+
+    static std::size_t tileRows(int cols, int type) {
+        // aim at ~256 KiB per tile so that all temporaries of a tile stay in L2
+        std::size_t rowbytes = (std::size_t)cols * CV_ELEM_SIZE(type);
+        return std::max<std::size_t>(1, (256 << 10) / std::max<std::size_t>(1, rowbytes));
+    }
+
+    bool evaluated() {
+        std::lock_guard _(mtx);
+        return !result.empty();
+    }
+
+    cv::Mat const &evaluate() {
+        std::lock_guard _(mtx);
+        if (!result.empty() || op == Op::Leaf)
+            return result;
+        lhs->evaluateShared();
+        if (rhs) rhs->evaluateShared();
+        cv::Mat dst(rows, cols, type);
+        int nrows = (int)tileRows(cols, type);
+        int ntiles = (rows + nrows - 1) / nrows;
+        cv::parallel_for_(cv::Range(0, ntiles), [&] (cv::Range const &range) {
+            for (int t = range.start; t < range.end; t++) {
+                cv::Range band(t * nrows, std::min(rows, (t + 1) * nrows));
+                cv::Mat out = dst.rowRange(band);
+                evalTile(band, out);
+            }
+        });
+        result = std::move(dst);
+        return result;
+    }
+
+private:
+    // a node read by more than one expression is evaluated once in full
+    // before the tile pass, instead of once per consumer inside each tile
+    void evaluateShared() {
+        if (op == Op::Leaf)
+            return;
+        if (consumers > 1) {
+            evaluate();
+            return;
+        }
+        lhs->evaluateShared();
+        if (rhs) rhs->evaluateShared();
+    }
+
+    // reads of a leaf (or an already evaluated node) are zero-copy ROIs
+    void fetchTile(cv::Range band, cv::Mat &out) {
+        {
+            std::lock_guard _(mtx);
+            if (!result.empty()) {
+                out = result.rowRange(band);
+                return;
+            }
+        }
+        evalTile(band, out);
+    }
+
+    void evalTile(cv::Range band, cv::Mat &out) {
+        cv::Mat a, b;
+        lhs->fetchTile(band, a);
+        if (rhs) rhs->fetchTile(band, b);
+        // same OpenCV call as the eager node, only on a band of rows, so that
+        // saturation and rounding of every intermediate step are unchanged
+        switch (op) {
+        case Op::Add: cv::add(a, b, out); break;
+        case Op::AddWeighted: cv::addWeighted(a, alpha, b, beta, gamma, out); break;
+        case Op::Subtract: cv::subtract(a, b, out); break;
+        case Op::MulScalar: cv::multiply(a, (float)alpha, out, scale); break;
+        case Op::Multiply: cv::multiply(a, b, out, scale); break;
+        case Op::Divide: cv::divide(a, b, out, scale); break;
+        case Op::BitwiseNot: cv::bitwise_not(a, out); break;
+        default: break;
+        }
+    }
+};
+
+}
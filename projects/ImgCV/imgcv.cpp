@@ -7,26 +7,63 @@
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/utils/zeno_p.h>
+#include <atomic>
+#include <chrono>
+#include "CVImageExpr.h"
 
 namespace zeno {
 
 struct CVImageObject : IObjectClone<CVImageObject> {
     cv::Mat image;
+    // pending element-wise expression, folded into `image` by materialize()
+    std::shared_ptr<CVImageExpr> expr;
 
     CVImageObject() = default;
     explicit CVImageObject(cv::Mat image) : image(std::move(image)) {}
+    explicit CVImageObject(std::shared_ptr<CVImageExpr> expr) : expr(std::move(expr)) {}
 
     CVImageObject(CVImageObject &&) = default;
     CVImageObject &operator=(CVImageObject &&) = default;
 
-    CVImageObject(CVImageObject const &img) : image(img.image.clone()) {
+    CVImageObject(CVImageObject const &img)
+        : image(img.expr ? img.expr->evaluate().clone() : img.image.clone()) {
     }
 
     CVImageObject &operator=(CVImageObject const &img) {
         // notice that cv::Mat is shallow-copy, only .clone() will deep-copy
-        image = img.image.clone();
+        image = img.expr ? img.expr->evaluate().clone() : img.image.clone();
+        expr = nullptr;
+        sharedWithExpr = false;
         return *this;
     }
+
+    cv::Mat &materialize() {
+        if (expr) {
+            image = expr->evaluate();
+            expr = nullptr;
+            sharedWithExpr = true;
+        }
+        return image;
+    }
+
+    std::shared_ptr<CVImageExpr> toExpr() {
+        if (expr)
+            return expr;
+        sharedWithExpr = true;
+        return std::make_shared<CVImageExpr>(image);
+    }
+
+    // copy-on-write before in-place edits, pending expressions may still read our pixels
+    void unshare() {
+        materialize();
+        if (sharedWithExpr) {
+            image = image.clone();
+            sharedWithExpr = false;
+        }
+    }
+
+private:
+    bool sharedWithExpr = false;
 };
 
 namespace {
@@ -58,6 +95,21 @@ struct CVINode : INode {
         //}
     //}
 
+    std::shared_ptr<CVImageObject> get_input_cvimage(std::string const &name) {
+        auto image = get_input<CVImageObject>(name);
+        image->materialize();
+        return image;
+    }
+
+    // honors the "inplace" input: either the input object itself or a deep copy of it
+    std::shared_ptr<CVImageObject> get_inplace_image(std::string const &name) {
+        auto image = get_input_cvimage(name);
+        if (!get_input2<bool>("inplace"))
+            return std::make_shared<CVImageObject>(image->image.clone());
+        image->unshare();
+        return image;
+    }
+
     cv::Mat get_input_image(std::string const &name, bool inversed = false) {
         //if (has_input<NumericObject>(name)) {
             //auto num = get_input<NumericObject>(name);
@@ -70,7 +122,7 @@ struct CVINode : INode {
         //} else {
             if (inversed) {
                 cv::Mat newimg;
-                auto img = get_input<CVImageObject>(name)->image;
+                auto img = get_input_cvimage(name)->image;
                 bool is255 = has_input<NumericObject>("is255") && get_input2<bool>("is255");
                 if (is255) {
                     cv::bitwise_not(img, newimg);
@@ -79,10 +131,26 @@ struct CVINode : INode {
                 }
                 return std::move(newimg);
             } else {
-                return get_input<CVImageObject>(name)->image;
+                return get_input_cvimage(name)->image;
             }
         //}
     }
+
+    // lazy counterpart of get_input_image, returns null if the input can't be fused
+    std::shared_ptr<CVImageExpr> get_input_expr(std::string const &name, bool inversed = false) {
+        auto expr = get_input<CVImageObject>(name)->toExpr();
+        if (inversed) {
+            bool is255 = has_input<NumericObject>("is255") && get_input2<bool>("is255");
+            if (!is255)  // cv::invert is a matrix inversion, not element-wise
+                return nullptr;
+            return std::make_shared<CVImageExpr>(CVImageExpr::Op::BitwiseNot, std::move(expr));
+        }
+        return expr;
+    }
+
+    static bool fusible(std::shared_ptr<CVImageExpr> const &a, std::shared_ptr<CVImageExpr> const &b) {
+        return a && b && CVImageExpr::compatible(*a, *b);
+    }
 };
 
 struct CVImageRead : CVINode {
@@ -144,7 +212,7 @@ ZENDEFNODE(CVImageRead, {
 
 struct CVSepAlpha : CVINode {
     void apply() override {
-        auto image = get_input<CVImageObject>("imageRGBA");
+        auto image = get_input_cvimage("imageRGBA");
         auto imageRGB = std::make_shared<CVImageObject>();
         cv::cvtColor(image->image, imageRGB->image, cv::COLOR_BGRA2BGR);
         std::vector<cv::Mat> channels;
@@ -173,7 +241,7 @@ ZENDEFNODE(CVSepAlpha, {
 
 struct CVImageSepRGB : CVINode {
     void apply() override {
-        auto image = get_input<CVImageObject>("imageRGB");
+        auto image = get_input_cvimage("imageRGB");
         std::vector<cv::Mat> channels;
         cv::split(image->image, channels);
         auto imageB = std::make_shared<CVImageObject>(channels.at(0));
@@ -243,11 +311,26 @@ ZENDEFNODE(CVWaitKey, {
 
 struct CVImageAdd : CVINode {
     void apply() override {
-        auto image1 = get_input_image("image1");
-        auto image2 = get_input_image("image2");
         auto weight1 = get_input2<float>("weight1");
         auto weight2 = get_input2<float>("weight2");
         auto constant = get_input2<float>("constant");
+        auto expr1 = get_input_expr("image1");
+        auto expr2 = get_input_expr("image2");
+        if (fusible(expr1, expr2)) {
+            std::shared_ptr<CVImageExpr> expr;
+            if (weight1 == 1 && weight2 == 1 && constant == 0) {
+                expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Add, expr1, expr2);
+            } else {
+                expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::AddWeighted, expr1, expr2);
+                expr->alpha = weight1;
+                expr->beta = weight2;
+                expr->gamma = constant;
+            }
+            set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+            return;
+        }
+        auto image1 = get_input_image("image1");
+        auto image2 = get_input_image("image2");
         auto resimage = std::make_shared<CVImageObject>();
         if (weight1 == 1 && weight2 == 1 && constant == 0) {
             cv::add(image1, image2, resimage->image);
@@ -258,8 +341,30 @@ struct CVImageAdd : CVINode {
     }
 };
 
+ZENDEFNODE(CVImageAdd, {
+    {
+        {"CVImageObject", "image1"},
+        {"CVImageObject", "image2"},
+        {"float", "weight1", "1"},
+        {"float", "weight2", "1"},
+        {"float", "constant", "0"},
+    },
+    {
+        {"CVImageObject", "resimage"},
+    },
+    {},
+    {"opencv"},
+});
+
 struct CVImageSubtract : CVINode {
     void apply() override {
+        auto expr1 = get_input_expr("image1");
+        auto expr2 = get_input_expr("image2");
+        if (fusible(expr1, expr2)) {
+            auto expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Subtract, expr1, expr2);
+            set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+            return;
+        }
         auto image1 = get_input_image("image1");
         auto image2 = get_input_image("image2");
         auto resimage = std::make_shared<CVImageObject>();
@@ -282,17 +387,26 @@ ZENDEFNODE(CVImageSubtract, {
 
 struct CVImageMultiply : CVINode {
     void apply() override {
-        auto image1 = get_input_image("image");
         auto inverse = get_input2<bool>("inverse");
         auto is255 = get_input2<bool>("is255");
         if (has_input<NumericObject>("factor")) {
             auto factor = get_input2<float>("factor");
             if (inverse) factor = 1 - factor;
             if (is255) factor = 255 * factor;
-            auto resimage = std::make_shared<CVImageObject>();
-            cv::multiply(image1, factor, resimage->image, is255 ? 1.f / 255.f : 1.f);
-            set_output("resimage", std::move(resimage));
+            auto expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::MulScalar, get_input_expr("image"));
+            expr->alpha = factor;
+            expr->scale = is255 ? 1.f / 255.f : 1.f;
+            set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
         } else {
+            auto expr1 = get_input_expr("image");
+            auto expr2 = get_input_expr("factor", inverse);
+            if (fusible(expr1, expr2)) {
+                auto expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Multiply, expr1, expr2);
+                expr->scale = is255 ? 1.f / 255.f : 1.f;
+                set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+                return;
+            }
+            auto image1 = get_input_image("image");
             auto image2 = get_input_image("factor", inverse);
             auto resimage = std::make_shared<CVImageObject>();
             cv::multiply(image1, image2, resimage->image, is255 ? 1.f / 255.f : 1.f);
@@ -317,10 +431,18 @@ ZENDEFNODE(CVImageMultiply, {
 
 struct CVImageDivide : CVINode {
     void apply() override {
-        auto image1 = get_input_image("image");
         auto inverse = get_input2<bool>("inverse");
-        auto image2 = get_input_image("factor", inverse);
         auto is255 = get_input2<bool>("is255");
+        auto expr1 = get_input_expr("image");
+        auto expr2 = get_input_expr("factor", inverse);
+        if (fusible(expr1, expr2)) {
+            auto expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Divide, expr1, expr2);
+            expr->scale = is255 ? 1.f / 255.f : 1.f;
+            set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+            return;
+        }
+        auto image1 = get_input_image("image");
+        auto image2 = get_input_image("factor", inverse);
         auto resimage = std::make_shared<CVImageObject>();
         cv::divide(image1, image2, resimage->image, is255 ? 1.f / 255.f : 1.f);
         set_output("resimage", std::move(resimage));
@@ -343,19 +465,40 @@ ZENDEFNODE(CVImageDivide, {
 
 struct CVImageBlend : CVINode {
     void apply() override {
-        auto image1 = get_input_image("image1");
-        auto image2 = get_input_image("image2");
         auto is255 = get_input2<bool>("is255");
         auto inverse = get_input2<bool>("inverse");
-        auto resimage = std::make_shared<CVImageObject>();
-        if (inverse) {
-            std::swap(image1, image2);
-        }
+        auto name1 = inverse ? "image2" : "image1";
+        auto name2 = inverse ? "image1" : "image2";
+        auto expr1 = get_input_expr(name1);
+        auto expr2 = get_input_expr(name2);
         if (has_input<NumericObject>("factor")) {
             auto factor = get_input2<float>("factor");
-            cv::addWeighted(image1, 1 - factor, image2, factor, 0, resimage->image);
+            if (fusible(expr1, expr2)) {
+                auto expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::AddWeighted, expr1, expr2);
+                expr->alpha = 1 - factor;
+                expr->beta = factor;
+                expr->gamma = 0;
+                set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+                return;
+            }
+            auto resimage = std::make_shared<CVImageObject>();
+            cv::addWeighted(get_input_image(name1), 1 - factor, get_input_image(name2), factor, 0, resimage->image);
+            set_output("resimage", std::move(resimage));
         } else {
+            auto factorExpr = get_input_expr("factor");
+            auto factorInvExpr = get_input_expr("factor", true);
+            if (fusible(expr1, expr2) && fusible(expr1, factorExpr) && factorInvExpr) {
+                auto tmp1 = std::make_shared<CVImageExpr>(CVImageExpr::Op::Multiply, expr1, factorInvExpr);
+                auto tmp2 = std::make_shared<CVImageExpr>(CVImageExpr::Op::Multiply, expr2, factorExpr);
+                tmp1->scale = tmp2->scale = is255 ? 1.f / 255.f : 1.f;
+                auto expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Add, tmp1, tmp2);
+                set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+                return;
+            }
+            auto image1 = get_input_image(name1);
+            auto image2 = get_input_image(name2);
             auto factor = get_input_image("factor");
+            auto resimage = std::make_shared<CVImageObject>();
             cv::Mat factorinv, tmp1, tmp2;
             if (is255) {
                 cv::bitwise_not(factor, factorinv);
@@ -365,8 +508,8 @@ struct CVImageBlend : CVINode {
             cv::multiply(image1, factorinv, tmp1, is255 ? 1.f / 255.f : 1.f);
             cv::multiply(image2, factor, tmp2, is255 ? 1.f / 255.f : 1.f);
             cv::add(tmp1, tmp2, resimage->image);
+            set_output("resimage", std::move(resimage));
         }
-        set_output("resimage", std::move(resimage));
     }
 };
 
@@ -387,14 +530,15 @@ ZENDEFNODE(CVImageBlend, {
 
 struct CVImageInvert : CVINode {
     void apply() override {
-        auto image = get_input_image("image");
         auto is255 = get_input2<bool>("is255");
-        auto resimage = std::make_shared<CVImageObject>();
         if (is255) {
-            cv::bitwise_not(image, resimage->image);
-        } else {
-            cv::invert(image, resimage->image);
+            auto expr = get_input_expr("image", true);
+            set_output("resimage", std::make_shared<CVImageObject>(std::move(expr)));
+            return;
         }
+        auto image = get_input_image("image");
+        auto resimage = std::make_shared<CVImageObject>();
+        cv::invert(image, resimage->image);
         set_output("resimage", std::move(resimage));
     }
 };
@@ -483,13 +627,11 @@ ZENDEFNODE(CVImageGrayscale, {
 
 struct CVImageFillColor : CVINode {
     void apply() override {
-        auto likeimage = get_input<CVImageObject>("image");
         auto is255 = get_input2<bool>("is255");
         auto color = tocvscalar<float>(get_input2<vec3f>("color"));
-        auto image = get_input2<bool>("inplace") ? likeimage
-            : std::make_shared<CVImageObject>(likeimage->image.clone());
+        auto image = get_inplace_image("image");
         if (has_input("mask")) {
-            auto mask = get_input<CVImageObject>("mask");
+            auto mask = get_input_cvimage("mask");
             if (is255) {
                 cv::Point3_<unsigned char> cval;
                 cval.x = (unsigned char)std::clamp(color[0] * 255.f, 0.f, 255.f);
@@ -531,13 +673,11 @@ ZENDEFNODE(CVImageFillColor, {
 
 struct CVImageMaskedAssign : CVINode {
     void apply() override {
-        auto likeimage = get_input<CVImageObject>("image");
-        auto srcimage = get_input<CVImageObject>("srcImage");
+        auto srcimage = get_input_cvimage("srcImage");
         auto is255 = get_input2<bool>("is255");
-        auto image = get_input2<bool>("inplace") ? likeimage
-            : std::make_shared<CVImageObject>(likeimage->image.clone());
+        auto image = get_inplace_image("image");
         if (has_input("mask")) {
-            auto mask = get_input<CVImageObject>("mask");
+            auto mask = get_input_cvimage("mask");
             image->image.setTo(srcimage->image, mask->image);
         } else {
             image->image.setTo(srcimage->image);
@@ -563,12 +703,10 @@ ZENDEFNODE(CVImageMaskedAssign, {
 
 struct CVImageBlit : CVINode {
     void apply() override {
-        auto likeimage = get_input<CVImageObject>("image");
-        auto srcimage = get_input<CVImageObject>("srcImage");
+        auto srcimage = get_input_cvimage("srcImage");
         auto is255 = get_input2<bool>("is255");
         auto centered = get_input2<bool>("centered");
-        auto image = get_input2<bool>("inplace") ? likeimage
-            : std::make_shared<CVImageObject>(likeimage->image.clone());
+        auto image = get_inplace_image("image");
         auto x0 = get_input2<int>("X0");
         auto y0 = get_input2<int>("Y0");
         auto dx = srcimage->image.cols;
@@ -610,7 +748,7 @@ struct CVImageBlit : CVINode {
             srcroi = srcroi(cv::Rect(sx0, sy0, dx, dy));
         }
         if (has_input("mask")) {
-            auto mask = get_input<CVImageObject>("mask");
+            auto mask = get_input_cvimage("mask");
             auto factor = mask->image;
             if (hasmodroi) {
                 factor = factor(cv::Rect(sx0, sy0, dx, dy));
@@ -658,7 +796,7 @@ ZENDEFNODE(CVImageBlit, {
 
 struct CVImageCrop : CVINode {
     void apply() override {
-        auto srcimage = get_input<CVImageObject>("srcimage");
+        auto srcimage = get_input_cvimage("srcimage");
         auto is255 = get_input2<bool>("is255");
         auto isDeep = get_input2<bool>("deepCopy");
         auto x0 = get_input2<int>("X0");
@@ -692,8 +830,7 @@ ZENDEFNODE(CVImageCrop, {
 
 struct CVMakeImage : CVINode {
     void apply() override {
-        auto likeimage = get_input<CVImageObject>("image");
-        auto srcimage = get_input<CVImageObject>("srcImage");
+        auto srcimage = get_input_cvimage("srcImage");
         auto mode = get_input2<std::string>("mode");
         auto isWhite = get_input2<bool>("whiteBg");
         auto is255 = get_input2<bool>("is255");
@@ -727,6 +864,12 @@ ZENDEFNODE(CVMakeImage, {
 struct CVGetImageSize : CVINode {
     void apply() override {
         auto image = get_input<CVImageObject>("image");
+        if (image->expr) {  // no need to evaluate a pending expression just for its shape
+            set_output2("width", image->expr->cols);
+            set_output2("height", image->expr->rows);
+            set_output2("channels", CV_MAT_CN(image->expr->type));
+            return;
+        }
         set_output2("width", image->image.cols);
         set_output2("height", image->image.rows);
         set_output2("channels", image->image.channels());
@@ -748,15 +891,13 @@ ZENDEFNODE(CVGetImageSize, {
 
 struct CVImageFillGrad : CVINode {
     void apply() override {
-        auto likeimage = get_input<CVImageObject>("image");
         auto angle = get_input2<float>("angle");
         auto scale = get_input2<float>("scale");
         auto offset = get_input2<float>("offset");
         auto is255 = get_input2<bool>("is255");
         auto color1 = tocvscalar<float>(get_input2<vec3f>("color1"));
         auto color2 = tocvscalar<float>(get_input2<vec3f>("color2"));
-        auto image = get_input2<bool>("inplace") ? likeimage
-            : std::make_shared<CVImageObject>(likeimage->image.clone());
+        auto image = get_inplace_image("image");
         vec2i shape(image->image.size[1], image->image.size[0]);
         vec2f invshape = 1.f / shape;
         angle *= (std::atan(1.f) * 4) / 180;
@@ -804,10 +945,8 @@ ZENDEFNODE(CVImageFillGrad, {
 
 struct CVImageDrawPoly : CVINode {
     void apply() override {
-        auto image = get_input<CVImageObject>("image");
+        auto image = get_inplace_image("image");
         auto color = tocvscalar<float>(get_input2<vec3f>("color"));
-        if (!get_input2<bool>("inplace"))
-            image = std::make_shared<CVImageObject>(*image);
         auto prim = get_input<PrimitiveObject>("prim");
         auto linewidth = get_input2<int>("linewidth");
         auto batched = get_input2<bool>("batched");
@@ -878,9 +1017,7 @@ ZENDEFNODE(CVImageDrawPoly, {
 
 struct CVImagePutText : CVINode {
     void apply() override {
-        auto likeimage = get_input<CVImageObject>("image");
-        auto image = get_input2<bool>("inplace") ? likeimage
-            : std::make_shared<CVImageObject>(likeimage->image.clone());
+        auto image = get_inplace_image("image");
         auto text = get_input2<std::string>("text");
         auto fontFace = get_input2<int>("fontFace");
         auto thickness = get_input2<int>("thickness");
@@ -916,6 +1053,139 @@ ZENDEFNODE(CVImagePutText, {
     {"opencv"},
 });
 
+// counts the bytes of every cv::Mat allocated while installed as the default
+// allocator, the benchmark reads the high water mark of each path from it
+struct CVCountingAllocator : cv::MatAllocator {
+    cv::MatAllocator *base = cv::Mat::getStdAllocator();
+    mutable std::atomic<std::size_t> current{0}, peak{0};
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, std::size_t *step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage) const override {
+        cv::UMatData *u = base->allocate(dims, sizes, type, data, step, flags, usage);
+        track(u);
+        return u;
+    }
+
+    bool allocate(cv::UMatData *u, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override {
+        return base->allocate(u, flags, usage);
+    }
+
+    void deallocate(cv::UMatData *u) const override {
+        if (u && !(u->flags & cv::UMatData::USER_ALLOCATED))
+            current -= u->size;
+        base->deallocate(u);
+    }
+
+    void reset() {
+        peak = current.load();
+    }
+
+private:
+    void track(cv::UMatData *u) const {
+        if (!u) return;
+        // route the release of this block back through us
+        u->currAllocator = u->prevAllocator = this;
+        if (u->flags & cv::UMatData::USER_ALLOCATED) return;
+        std::size_t now = current += u->size;
+        std::size_t old = peak;
+        while (now > old && !peak.compare_exchange_weak(old, now));
+    }
+};
+
+struct CVImageChainBenchmark : CVINode {
+    void apply() override {
+        auto w = get_input2<int>("width");
+        auto h = get_input2<int>("height");
+        auto is255 = get_input2<bool>("is255");
+        auto length = get_input2<int>("chainLength");
+        int ty = is255 ? CV_8UC4 : CV_32FC4;
+        cv::Mat image1(h, w, ty), image2(h, w, ty);
+        cv::randu(image1, cv::Scalar::all(0), cv::Scalar::all(is255 ? 255 : 1));
+        cv::randu(image2, cv::Scalar::all(0), cv::Scalar::all(is255 ? 255 : 1));
+        float scale = is255 ? 1.f / 255.f : 1.f;
+
+        // the counter outlives the benchmark, mats allocated through it are
+        // released through it even after the default allocator is restored
+        static CVCountingAllocator counter;
+        cv::MatAllocator *oldAllocator = cv::Mat::getDefaultAllocator();
+        cv::Mat::setDefaultAllocator(&counter);
+
+        // the eager path keeps every intermediate alive, just like node outputs in a graph
+        counter.reset();
+        std::size_t base0 = counter.current;
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<cv::Mat> temps{image1};
+        for (int i = 0; i < length; i++) {
+            cv::Mat res;
+            switch (i % 3) {
+            case 0: cv::addWeighted(temps.back(), 0.7, image2, 0.3, 0, res); break;
+            case 1: cv::multiply(temps.back(), image2, res, scale); break;
+            case 2: cv::add(temps.back(), image2, res); break;
+            }
+            temps.push_back(std::move(res));
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        std::size_t eagerPeak = counter.peak - base0;
+
+        counter.reset();
+        std::size_t base1 = counter.current;
+        auto t2 = std::chrono::steady_clock::now();
+
+        auto leaf2 = std::make_shared<CVImageExpr>(image2);
+        auto expr = std::make_shared<CVImageExpr>(image1);
+        for (int i = 0; i < length; i++) {
+            switch (i % 3) {
+            case 0:
+                expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::AddWeighted, expr, leaf2);
+                expr->alpha = 0.7;
+                expr->beta = 0.3;
+                expr->gamma = 0;
+                break;
+            case 1:
+                expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Multiply, expr, leaf2);
+                expr->scale = scale;
+                break;
+            case 2:
+                expr = std::make_shared<CVImageExpr>(CVImageExpr::Op::Add, expr, leaf2);
+                break;
+            }
+        }
+        cv::Mat lazyres = expr->evaluate();
+        auto t3 = std::chrono::steady_clock::now();
+        std::size_t lazyPeak = counter.peak - base1;
+        cv::Mat::setDefaultAllocator(oldAllocator);
+
+        float eagerTime = std::chrono::duration<float>(t1 - t0).count();
+        float lazyTime = std::chrono::duration<float>(t3 - t2).count();
+        float maxError = (float)cv::norm(temps.back(), lazyres, cv::NORM_INF);
+        zeno::log_info("CVImageChainBenchmark {}x{} x{}: eager {}s {}MB, lazy {}s {}MB, max error {}",
+                       w, h, length, eagerTime, eagerPeak >> 20, lazyTime, lazyPeak >> 20, maxError);
+        set_output2("eagerTime", eagerTime);
+        set_output2("lazyTime", lazyTime);
+        set_output2("eagerPeakMB", (float)(eagerPeak >> 20));
+        set_output2("lazyPeakMB", (float)(lazyPeak >> 20));
+        set_output2("maxError", maxError);
+    }
+};
+
+ZENDEFNODE(CVImageChainBenchmark, {
+    {
+        {"int", "width", "7680"},
+        {"int", "height", "4320"},
+        {"int", "chainLength", "10"},
+        {"bool", "is255", "1"},
+    },
+    {
+        {"float", "eagerTime"},
+        {"float", "lazyTime"},
+        {"float", "eagerPeakMB"},
+        {"float", "lazyPeakMB"},
+        {"float", "maxError"},
+    },
+    {},
+    {"opencv"},
+});
+
 }
 
 }
@@ -1,28 +1,41 @@
 #include "lsystem.h"
 #include <sstream>
+#include <algorithm>
 using namespace std;
-void LSystem::replaceAll(string& str, const string& from, const string& to) 
-{
-	if(from.empty())
-		return;
-	size_t start_pos = 0;
-	while((start_pos = str.find(from, start_pos)) != string::npos) 
-	{
-		str.replace(start_pos, from.length(), to);
-    	start_pos += to.length(); // In case 'to' contains 'from', like replacing 'x' with 'yx'
-    }
-}
 string LSystem::produce(const string axiom, const AssociativeArray rules)
 {
-	string t=axiom;
+	// one alternative per rule and generation, then all rules are applied at
+	// once in a single left to right pass, so that no rule sees the output of
+	// another one; the longest key wins where several keys match
+	vector<pair<const string *, const string *> > choice;
 	AssociativeArray::const_iterator iter;
 	for (iter=rules.begin(); iter!=rules.end();++iter)
 	{
-		string key=iter->first;
-		vector<string> value=iter->second;
+		const vector<string> &value=iter->second;
 		int index=rand()%value.size();
 		// printf("Selected %d out of %d : %s\n",index,value.size(),value[index].c_str());
-		replaceAll(t,key,value[index]);
+		if (!iter->first.empty())
+			choice.push_back(make_pair(&iter->first,&value[index]));
+	}
+	stable_sort(choice.begin(),choice.end(),[](const pair<const string *, const string *> &a, const pair<const string *, const string *> &b)
+	{
+		return a.first->size()>b.first->size();
+	});
+	string t;
+	t.reserve(axiom.size()*2);
+	for (size_t i=0;i<axiom.size();)
+	{
+		size_t j=0;
+		for (;j<choice.size();++j)
+			if (axiom.compare(i,choice[j].first->size(),*choice[j].first)==0)
+				break;
+		if (j<choice.size())
+		{
+			t+=*choice[j].second;
+			i+=choice[j].first->size();
+		}
+		else
+			t+=axiom[i++];
 	}
 	return t;
 }
@@ -11,7 +11,6 @@ class LSystem
 protected:
 	R3Mesh * mesh;
 	TurtleSystem turtle;
-	void replaceAll(string& str, const string& from, const string& to) ;
     string produce(const string axiom, const AssociativeArray rules);
 	virtual void run(const char command,const float param);
 	float defaultCoefficient;
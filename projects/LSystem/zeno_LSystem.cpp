@@ -1,10 +1,23 @@
 #include "zeno/zeno.h"
 #include "zeno/types/StringObject.h"
 #include "zeno/types/PrimitiveObject.h"
+#include "zeno/para/parallel_for.h"
+#include "zeno/para/parallel_reduce.h"
+#include "zeno/para/parallel_scan.h"
+#include "zeno/utils/log.h"
 
 #include "LSystem/R3Mesh.h"
+#include "LSystem/turtle.h"
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <random>
+#include <stack>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -300,6 +313,394 @@ namespace zeno
             },
         });
 
+    struct LSysToken
+    {
+        char cmd;
+        bool hasParam;
+        float param;
+    };
+
+    struct LSysRule
+    {
+        std::vector<LSysToken> key;
+        std::vector<std::vector<LSysToken>> alts;
+    };
+
+    // same grammar as LSystem::draw: a command char, optionally followed by
+    // "(param)" right after it; whitespace is skipped
+    static std::vector<LSysToken> tokenizeLSys(std::string_view s)
+    {
+        std::vector<LSysToken> tokens;
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            char c = s[i];
+            if (std::isspace((unsigned char)c))
+                continue;
+            LSysToken tok{c, false, 1.0f};
+            if (i + 1 < s.size() && s[i + 1] == '(')
+            {
+                size_t end = s.find(')', i + 2);
+                if (end == std::string_view::npos)
+                    end = s.size();
+                tok.hasParam = true;
+                tok.param = (float)std::atof(std::string(s.substr(i + 2, end - i - 2)).c_str());
+                i = end;
+            }
+            tokens.push_back(tok);
+        }
+        return tokens;
+    }
+
+    // rewrites all rules simultaneously, one generation at a time: every token
+    // is matched against the rule keys, the output sizes are prefix summed into
+    // offsets and then every replacement is copied to its offset in parallel
+    static std::vector<LSysToken> rewriteLSys(
+        std::vector<LSysToken> axiom,
+        std::vector<LSysRule> const &rules,
+        int iterations,
+        unsigned seed)
+    {
+        // rules by the command of their first key token, longest key first
+        std::array<std::vector<int>, 256> byCmd;
+        bool singleKeys = true;
+        for (int r = 0; r < (int)rules.size(); ++r)
+        {
+            if (rules[r].key.empty() || rules[r].alts.empty())
+                continue;
+            byCmd[(unsigned char)rules[r].key[0].cmd].push_back(r);
+            singleKeys = singleKeys && rules[r].key.size() == 1;
+        }
+        for (auto &rs : byCmd)
+        {
+            std::stable_sort(rs.begin(), rs.end(), [&](int a, int b)
+                             { return rules[a].key.size() > rules[b].key.size(); });
+        }
+
+        std::mt19937 rng(seed);
+        std::vector<LSysToken> cur = std::move(axiom);
+        for (int it = 0; it < iterations; ++it)
+        {
+            // one alternative per rule and generation, as the string rewriter does
+            std::vector<std::vector<LSysToken> const *> pick(rules.size());
+            for (size_t r = 0; r < rules.size(); ++r)
+            {
+                if (!rules[r].alts.empty())
+                    pick[r] = &rules[r].alts[rng() % rules[r].alts.size()];
+            }
+
+            size_t n = cur.size();
+            auto matchAt = [&](size_t i) -> int
+            {
+                for (int r : byCmd[(unsigned char)cur[i].cmd])
+                {
+                    auto const &key = rules[r].key;
+                    if (i + key.size() > n)
+                        continue;
+                    bool ok = true;
+                    for (size_t k = 0; k < key.size() && ok; ++k)
+                    {
+                        auto const &tok = cur[i + k];
+                        ok = tok.cmd == key[k].cmd && (!key[k].hasParam || (tok.hasParam && tok.param == key[k].param));
+                    }
+                    if (ok)
+                        return r;
+                }
+                return -1;
+            };
+
+            // match[i]: rule replacing the tokens from i, -1 if kept, -2 if
+            // swallowed by a longer key starting before i. the keys are matched
+            // at every position in parallel; with multi-token keys, matches
+            // overlapping an earlier one are then dropped by a cheap serial pass
+            std::vector<int> match(n);
+            zeno::parallel_for(n, [&](size_t i)
+                               { match[i] = matchAt(i); });
+            if (!singleKeys)
+            {
+                for (size_t i = 0; i < n;)
+                {
+                    int r = match[i++];
+                    for (size_t k = 1; r >= 0 && k < rules[r].key.size(); ++k)
+                        match[i++] = -2;
+                }
+            }
+
+            std::vector<size_t> offset(n + 1);
+            offset[n] = zeno::parallel_exclusive_scan_sum(match.begin(), match.end(), offset.begin(), [&](int r) -> size_t
+                                                          { return r >= 0 ? pick[r]->size() : r == -1 ? 1 : 0; });
+
+            std::vector<LSysToken> next(offset[n]);
+            zeno::parallel_for(n, [&](size_t i)
+                               {
+                int r = match[i];
+                if (r >= 0)
+                    std::copy(pick[r]->begin(), pick[r]->end(), next.begin() + offset[i]);
+                else if (r == -1)
+                    next[offset[i]] = cur[i]; });
+            std::swap(cur, next);
+        }
+        return cur;
+    }
+
+    struct LSysTurtle : Turtle
+    {
+        int lastVert = -1; // tip of the current branch for line output, -1 after a jump
+    };
+
+    // interprets the tokens like LPlusSystem::run, but writes the branches and
+    // leaves straight into prim; the buffers are sized from a counting pass
+    static void turtleToPrim(
+        zeno::PrimitiveObject *prim,
+        std::vector<LSysToken> const &tokens,
+        bool isPlus,
+        float defaultCoefficient,
+        float thickness,
+        bool isLines,
+        int slices)
+    {
+        size_t nbranch = zeno::parallel_reduce_sum(tokens.begin(), tokens.end(), [](LSysToken const &tok) -> size_t
+                                                   { return tok.cmd == 'F' || tok.cmd == 'f'; });
+        size_t nleaf = !isPlus ? 0 : zeno::parallel_reduce_sum(tokens.begin(), tokens.end(), [](LSysToken const &tok) -> size_t
+                                                               { return tok.cmd == '*'; });
+
+        size_t branchVerts = isLines ? 2 : 2 * slices;
+        prim->verts.resize(nbranch * branchVerts + nleaf * 8);
+        prim->tris.resize((isLines ? 0 : nbranch * 2 * slices) + nleaf * 6);
+        prim->lines.resize(isLines ? nbranch : 0);
+        auto &pos = prim->verts.values;
+        auto &uv = prim->verts.add_attr<zeno::vec3f>("uv");
+        auto &nrm = prim->verts.add_attr<zeno::vec3f>("nrm");
+        auto *rad = isLines ? &prim->verts.add_attr<float>("rad") : nullptr;
+
+        std::vector<zeno::vec2f> ring(slices);
+        for (int i = 0; i < slices; ++i)
+        {
+            float theta = i * (2.0f * 3.14159265358979f / slices);
+            ring[i] = zeno::vec2f(std::cos(theta), std::sin(theta));
+        }
+
+        auto toVec = [](R3Vector const &v)
+        {
+            return zeno::vec3f(v.X(), v.Y(), v.Z());
+        };
+
+        size_t nv = 0, nt = 0, nl = 0;
+        LSysTurtle turtle;
+        turtle.thickness = thickness;
+        std::stack<LSysTurtle> state;
+
+        // local frame of the turtle: x is right, y is heading, z completes it
+        auto frame = [&](zeno::vec3f &ex, zeno::vec3f &ey, zeno::vec3f &ez)
+        {
+            ey = zeno::normalize(toVec(turtle.direction));
+            ex = toVec(turtle.right);
+            ex -= ey * zeno::dot(ex, ey);
+            if (zeno::lengthSquared(ex) < 1e-12f)
+                ex = std::abs(ey[0]) < 0.9f ? zeno::vec3f(1, 0, 0) : zeno::vec3f(0, 0, 1);
+            ex = zeno::normalize(ex - ey * zeno::dot(ex, ey));
+            ez = zeno::cross(ex, ey);
+        };
+
+        auto drawBranch = [&](float length)
+        {
+            zeno::vec3f ex, ey, ez;
+            frame(ex, ey, ez);
+            zeno::vec3f base = toVec(turtle.position);
+            float rb = length * turtle.thickness;
+            float rt = rb * turtle.reduction;
+            if (isLines)
+            {
+                if (turtle.lastVert < 0)
+                {
+                    pos[nv] = base;
+                    uv[nv] = zeno::vec3f(0, 0, 0);
+                    nrm[nv] = ey;
+                    (*rad)[nv] = rb;
+                    turtle.lastVert = nv++;
+                }
+                pos[nv] = base + ey * length;
+                uv[nv] = zeno::vec3f(0, 1, 0);
+                nrm[nv] = ey;
+                (*rad)[nv] = rt;
+                prim->lines[nl++] = zeno::vec2i(turtle.lastVert, nv);
+                turtle.lastVert = nv++;
+                return;
+            }
+            // same layout as R3Mesh::Cylinder: top and bottom vertices interleaved
+            int b = nv;
+            int size = 2 * slices;
+            for (int i = 0; i < slices; ++i)
+            {
+                zeno::vec3f dir = ex * ring[i][0] + ez * ring[i][1];
+                pos[nv] = base + ey * length + dir * rt;
+                uv[nv] = zeno::vec3f(i * 2 / (float)slices, 1, 0);
+                nrm[nv++] = dir;
+                pos[nv] = base + dir * rb;
+                uv[nv] = zeno::vec3f(i * 2 / (float)slices, 0, 0);
+                nrm[nv++] = dir;
+            }
+            for (int i = 0; i < size; i += 2)
+            {
+                prim->tris[nt++] = zeno::vec3i(b + i, b + i + 1, b + (i + 2) % size);
+                prim->tris[nt++] = zeno::vec3i(b + i + 1, b + (i + 3) % size, b + (i + 2) % size);
+            }
+        };
+
+        auto drawLeaf = [&](float scale)
+        {
+            zeno::vec3f ex, ey, ez;
+            frame(ex, ey, ez);
+            zeno::vec3f base = toVec(turtle.position);
+            // bend towards earth, or a small pseudo random bend if level
+            float z = ey[1] / 4;
+            if (z == 0)
+            {
+                unsigned h = (unsigned)nv * 2654435761u;
+                z = ((int)((h >> 16) % 20) - 10) / 100.0f;
+            }
+            const zeno::vec3f shape[8] = {
+                {0, .01f, 0}, {.2f, .1f, 0}, {.25f, .3f, 0}, {.2f, .6f, z / 2},
+                {0, 1 - z, z}, {-.2f, .6f, z / 2}, {-.25f, .3f, 0}, {-.2f, .1f, 0}};
+            int b = nv;
+            for (auto const &p : shape)
+            {
+                pos[nv] = base + (ex * p[0] + ey * p[1] + ez * p[2]) * scale;
+                uv[nv] = zeno::vec3f(p[0] + .5f, p[1], 0);
+                nrm[nv++] = ez;
+            }
+            for (int i = 1; i < 7; ++i)
+                prim->tris[nt++] = zeno::vec3i(b, b + i, b + i + 1);
+        };
+
+        for (auto const &tok : tokens)
+        {
+            float param = tok.param;
+            float num = param == 1 ? param * defaultCoefficient : param;
+            switch (tok.cmd)
+            {
+            case '+':
+                turtle.turnLeft(num);
+                break;
+            case '-':
+                turtle.turnRight(num);
+                break;
+            case '&':
+                turtle.pitchDown(num);
+                break;
+            case '^':
+                turtle.pitchUp(num);
+                break;
+            case '<':
+                if (isPlus)
+                    turtle.thicken(num);
+                else
+                    turtle.rollLeft(num);
+                break;
+            case '\\':
+                turtle.rollLeft(num);
+                break;
+            case '/':
+                turtle.rollRight(num);
+                break;
+            case '>':
+                if (isPlus)
+                    turtle.narrow(num);
+                else
+                    turtle.rollRight(num);
+                break;
+            case '%':
+                if (isPlus)
+                    turtle.setReduction(param);
+                break;
+            case '=':
+                if (isPlus)
+                    turtle.setThickness(param);
+                break;
+            case '|':
+                turtle.turn180(param);
+                break;
+            case '*':
+                if (isPlus)
+                    drawLeaf(param);
+                break;
+            case 'F':
+            case 'f':
+                drawBranch(param);
+                turtle.move(param);
+                break;
+            case 'G':
+                if (!isPlus)
+                    break;
+                [[fallthrough]];
+            case 'g':
+                turtle.move(param);
+                turtle.lastVert = -1;
+                break;
+            case '[':
+                state.push(turtle);
+                break;
+            case ']':
+                if (!state.empty())
+                {
+                    turtle = state.top();
+                    state.pop();
+                }
+                break;
+            default:;
+            }
+        }
+
+        // line output shares the tips of connected branches, so it may use less
+        prim->verts.resize(nv);
+    }
+
+    struct ProceduralTreePrim : zeno::INode
+    {
+        virtual void apply() override
+        {
+            auto generator = get_input<zeno::LSysGenerator>("generator");
+            auto isLines = get_input2<std::string>("mode") == "lines";
+            auto slices = std::max(3, get_input2<int>("slices"));
+            auto seed = get_input2<int>("seed");
+
+            std::vector<LSysRule> rules;
+            std::map<std::string, int> ruleIds;
+            for (const auto &[ruleName, rule] : generator->_rules)
+            {
+                auto [it, isNew] = ruleIds.try_emplace(ruleName, (int)rules.size());
+                if (isNew)
+                    rules.push_back({tokenizeLSys(ruleName), {}});
+                rules[it->second].alts.push_back(tokenizeLSys(rule));
+            }
+            auto tokens = rewriteLSys(tokenizeLSys(generator->_axiom), rules, generator->_iterations, (unsigned)seed);
+
+            auto prim = std::make_shared<zeno::PrimitiveObject>();
+            turtleToPrim(prim.get(), tokens, generator->isPlus(), (float)generator->_defaultCoefficient,
+                         generator->_thickness / 100.0f, isLines, slices);
+            zeno::log_debug("ProceduralTreePrim: {} tokens, {} verts, {} lines, {} tris",
+                           tokens.size(), prim->verts.size(), prim->lines.size(), prim->tris.size());
+            set_output("prim", std::move(prim));
+        }
+    };
+
+    ZENDEFNODE(
+        ProceduralTreePrim,
+        {
+            {
+                {"LSysGenerator", "generator"},
+                {"enum tris lines", "mode", "tris"},
+                {"int", "slices", "8"},
+                {"int", "seed", "0"},
+            },
+            {
+                {"primitive", "prim"},
+            },
+            {},
+            {
+                "LSystem",
+            },
+        });
+
     /*
     struct R3MeshToPrim : zeno::INode
     {
@@ -1,5 +1,6 @@
 #include <zeno/zeno.h>
 #include <zeno/core/IObject.h>
+#include "../ZenoFX/SoaBvh.h"
 namespace zeno
 {
 
@@ -37,6 +38,7 @@ struct PBFWorld:IObject
     
     //neighborList
     std::vector<std::vector<int>> neighborList;
+    std::shared_ptr<SoaBvh> bvh; //kept across steps and refitted
 };
 
     
@@ -1,6 +1,6 @@
 #include <zeno/zeno.h>
 #include <zeno/types/PrimitiveObject.h>
-#include "../ZenoFX/LinearBvh.h" //BVH的构建和使用API
+#include "../ZenoFX/SoaBvh.h" //BVH的构建和使用API
 #include "./PBFWorld.h"
 #include "../Utils/myPrint.h"
 using namespace zeno;
@@ -9,7 +9,7 @@ namespace zeno{
 struct PBFWorld_NeighborhoodSearch: INode
 {
 
-    void buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::LBvh *lbvh, std::vector<std::vector<int>> & list)
+    void buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::SoaBvh *lbvh, std::vector<std::vector<int>> & list)
     {
         auto radius2 = searchRadius*searchRadius;
         #pragma omp parallel for
@@ -35,7 +35,9 @@ struct PBFWorld_NeighborhoodSearch: INode
         auto &pos = prim->verts;
 
         //构建BVH
-        auto lbvh = std::make_shared<zeno::LBvh>(prim,  data->neighborSearchRadius,zeno::LBvh::element_c<zeno::LBvh::element_e::point>);
+        if (!data->bvh || !data->bvh->refit(prim.get(), data->neighborSearchRadius))
+            data->bvh = std::make_shared<zeno::SoaBvh>(prim.get(), data->neighborSearchRadius, zeno::SoaBvh::element_e::point);
+        auto &lbvh = data->bvh;
 
         //清零
         data->neighborList.clear();
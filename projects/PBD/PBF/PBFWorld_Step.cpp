@@ -1,4 +1,4 @@
-#include "../ZenoFX/LinearBvh.h"
+#include "../ZenoFX/SoaBvh.h"
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/zeno.h>
 #include "./PBFWorld.h"
@@ -29,7 +29,9 @@ struct PBFWorld_Step : zeno::INode {
         auto &pos = prim->verts;
 
         //构建BVH
-        auto lbvh = std::make_shared<zeno::LBvh>(prim,  data->neighborSearchRadius,zeno::LBvh::element_c<zeno::LBvh::element_e::point>);
+        if (!data->bvh || !data->bvh->refit(prim.get(), data->neighborSearchRadius))
+            data->bvh = std::make_shared<zeno::SoaBvh>(prim.get(), data->neighborSearchRadius, zeno::SoaBvh::element_e::point);
+        auto &lbvh = data->bvh;
 
         //清零
         data->neighborList.clear();
@@ -40,7 +42,7 @@ struct PBFWorld_Step : zeno::INode {
     }
 
 
-    void buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::LBvh *lbvh, std::vector<std::vector<int>> & list)
+    void buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::SoaBvh *lbvh, std::vector<std::vector<int>> & list)
     {
         auto radius2 = searchRadius*searchRadius;
         #pragma omp parallel for
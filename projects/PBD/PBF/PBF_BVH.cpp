@@ -127,14 +127,15 @@ void PBF_BVH::neighborSearch(std::shared_ptr<PrimitiveObject> prim)
     neighborList.clear();
     neighborList.resize(pos.size());
 
-    lbvh->refit();
+    if (!lbvh->refit(prim.get(), neighborSearchRadius)) // particle count changed, rebuild from scratch
+        lbvh = std::make_shared<zeno::SoaBvh>(prim.get(), neighborSearchRadius, zeno::SoaBvh::element_e::point);
     
     //邻域搜索
     buildNeighborList(pos, neighborSearchRadius, lbvh.get(), neighborList);
 }
 
 
-void PBF_BVH::buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::LBvh *lbvh, std::vector<std::vector<int>> & list)
+void PBF_BVH::buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::SoaBvh *lbvh, std::vector<std::vector<int>> & list)
 {
     auto radius2 = searchRadius*searchRadius;
     #pragma omp parallel for
@@ -4,7 +4,7 @@
 #include <map>
 #include <zeno/types/PrimitiveObject.h>
 #include "SPHKernelFuncs.h"
-#include "../ZenoFX/LinearBvh.h"
+#include "../ZenoFX/SoaBvh.h"
 
 namespace zeno{
 struct PBF_BVH : INode{
@@ -50,9 +50,9 @@ public:
 
     //neighborList
     std::vector<std::vector<int>> neighborList;
-    std::shared_ptr<zeno::LBvh> lbvh;
+    std::shared_ptr<zeno::SoaBvh> lbvh;
     void neighborSearch(std::shared_ptr<PrimitiveObject> prim);
-    void buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::LBvh *lbvh, std::vector<std::vector<int>> & list);
+    void buildNeighborList(const std::vector<vec3f> &pos, float searchRadius, const zeno::SoaBvh *lbvh, std::vector<std::vector<int>> & list);
 
 public:
     void setParams()
@@ -91,7 +91,7 @@ public:
             dpos.resize(numParticles);
 
             //构建BVH
-            lbvh = std::make_shared<zeno::LBvh>(prim,  neighborSearchRadius,zeno::LBvh::element_c<zeno::LBvh::element_e::point>);
+            lbvh = std::make_shared<zeno::SoaBvh>(prim.get(), neighborSearchRadius, zeno::SoaBvh::element_e::point);
         }
 
         preSolve();
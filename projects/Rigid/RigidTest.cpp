@@ -235,7 +235,7 @@ struct PrimitiveConvexDecompositionV : zeno::INode {
 
         // save output
         auto listPrim = std::make_shared<zeno::ListObject>();
-        listPrim->arr.clear();
+        listPrim->arr().clear();
 
 
         unsigned int nConvexHulls = interfaceVHACD->GetNConvexHulls();
@@ -277,7 +277,7 @@ struct PrimitiveConvexDecompositionV : zeno::INode {
             }
 
             if(good_ch_flag) {
-                listPrim->arr.push_back(std::move(outprim));
+                listPrim->arr().push_back(std::move(outprim));
             }
         }
 
@@ -332,7 +332,7 @@ struct PrimitiveConvexDecomposition : zeno::INode {
         size_t nClusters = hacd.GetNClusters();
 
         auto listPrim = std::make_shared<zeno::ListObject>();
-        listPrim->arr.clear();
+        listPrim->arr().clear();
 
         printf("hacd got %d clusters\n", nClusters);
         for (size_t c = 0; c < nClusters; c++) {
@@ -364,7 +364,7 @@ struct PrimitiveConvexDecomposition : zeno::INode {
                 outprim->tris[i] = zeno::vec3i(p.X(), p.Y(), p.Z());
             }
 
-            listPrim->arr.push_back(std::move(outprim));
+            listPrim->arr().push_back(std::move(outprim));
         }
 
         set_output("listPrim", std::move(listPrim));
@@ -634,14 +634,14 @@ struct BulletMakeGlueObjectList : zeno::INode {
         auto shape = get_input<BulletGlueCompoundShape>("glueCompShape");
         auto mass = get_input<zeno::NumericObject>("mass")->get<float>();
         auto trans = get_input<BulletTransform>("trans");
-        objectList->arr.clear();
+        objectList->arr().clear();
         for (auto const &comp: shape->comps) {
             auto object = std::make_shared<BulletObject>(
                 mass, trans->trans, comp);
             object->body->setDamping(0, 0);
-            objectList->arr.push_back(std::move(object));
+            objectList->arr().push_back(std::move(object));
         }
-        log_debug("glueobjeclist length={}", objectList->arr.size());
+        log_debug("glueobjeclist length={}", objectList->arr().size());
         set_output("objectList", std::move(objectList));
     }
 };
@@ -1969,14 +1969,14 @@ struct BulletMultiBodyGetTransform : zeno::INode {
     virtual void apply() override {
         auto object = get_input<BulletMultiBodyObject>("object");
         auto transList = std::make_shared<zeno::ListObject>();
-        transList->arr.clear();
+        transList->arr().clear();
 
         for (size_t i = 0; i < object->multibody->getNumLinks(); i++) {
             auto trans = std::make_shared<BulletTransform>();
             trans->trans = object->multibody->getLink(i).m_collider->getWorldTransform();
             std::cout<< "\nlink #" << i << ": " << trans->trans.getOrigin()[0] << "," << trans->trans.getOrigin()[1] << "," << trans->trans.getOrigin()[2] << "\n";
             std::cout << trans->trans.getRotation()[0] << "," << trans->trans.getRotation()[1] << "," << trans->trans.getRotation()[2] << "," << trans->trans.getRotation()[3] << std::endl;
-            transList->arr.push_back(trans);
+            transList->arr().push_back(trans);
         }
         set_output("transList", std::move(transList));
     }
@@ -1995,10 +1995,10 @@ struct BulletMultiBodyWorldGetTransformShapes : zeno::INode {
         auto graphicsVisualMap = get_input<zeno::DictObject>("visualMap");
 
         auto transList = std::make_shared<zeno::ListObject>();
-        transList->arr.clear();
+        transList->arr().clear();
 
         auto visualList = std::make_shared<zeno::ListObject>();
-        visualList->arr.clear();
+        visualList->arr().clear();
 
         int numCollisionObjects = world->dynamicsWorld->getNumCollisionObjects();
         for (size_t i = 0; i < numCollisionObjects; i++) {
@@ -2012,8 +2012,8 @@ struct BulletMultiBodyWorldGetTransformShapes : zeno::INode {
             std::cout << linkTrans->trans.getRotation()[0] << "," << linkTrans->trans.getRotation()[1] << "," << linkTrans->trans.getRotation()[2] << "," << linkTrans->trans.getRotation()[3] << std::endl;
 
             if (graphicsIndex >= 0) {
-                transList->arr.push_back(linkTrans);
-                visualList->arr.push_back(graphicsVisualMap->lut.at(std::to_string(graphicsIndex)));
+                transList->arr().push_back(linkTrans);
+                visualList->arr().push_back(graphicsVisualMap->lut.at(std::to_string(graphicsIndex)));
             }
         }
 
@@ -2843,10 +2843,10 @@ struct BulletCalcInverseKinematics : zeno::INode {
 		    }
 	    }
         auto outputPoses = std::make_shared<ListObject>();
-        outputPoses->arr.clear();
+        outputPoses->arr().clear();
         for (size_t i = 0; i < startingPositions.size(); i++){
             auto p = std::make_shared<zeno::NumericObject>(float(startingPositions[i]));
-            outputPoses->arr.push_back(p);
+            outputPoses->arr().push_back(p);
         }
 	    set_output("poses", std::move(outputPoses));
     }
@@ -3312,18 +3312,18 @@ ZENDEFNODE(BulletMultiBodyAddLinkForce, {
 
 
         auto output_jac_linear = std::make_shared<ListObject>();
-        output_jac_linear->arr.clear();
+        output_jac_linear->arr().clear();
         for (size_t i = 0; i < jacobian_linear.size(); i++) {
             auto p = std::make_shared<zeno::NumericObject>(
                 float(jacobian_linear[i]));
-            output_jac_linear->arr.push_back(p);
+            output_jac_linear->arr().push_back(p);
         }
         auto output_jac_angular = std::make_shared<ListObject>();
-        output_jac_angular->arr.clear();
+        output_jac_angular->arr().clear();
         for (size_t i = 0; i < jacobian_angular.size(); i++) {
             auto p = std::make_shared<zeno::NumericObject>(
                 float(jacobian_angular[i]));
-            output_jac_angular->arr.push_back(p);
+            output_jac_angular->arr().push_back(p);
         }
         set_output("object", std::move(object));
         set_output("jacobian_linear", std::move(output_jac_linear));
@@ -3391,7 +3391,7 @@ struct BulletMultiBodyCalculateMassMatrix : zeno::INode {
                         int element = (totDofs)*i + j;
                         auto p = std::make_shared<zeno::NumericObject>(
                             float(massMatrix(i, j)));
-                        output_mass_matrix->arr.push_back(p);
+                        output_mass_matrix->arr().push_back(p);
                     }
                 }
             }
@@ -3477,10 +3477,10 @@ struct BulletMultiBodyGetContactPoints : zeno::INode {
                 pA->set<zeno::vec3f>(zeno::vec3f(ptA.x(), ptA.y(), ptA.z()));
                 pB->set<zeno::vec3f>(zeno::vec3f(ptB.x(), ptB.y(), ptB.z()));
 
-                contactPairsList->arr.push_back(pA);
-                contactPairsList->arr.push_back(pB);
+                contactPairsList->arr().push_back(pA);
+                contactPairsList->arr().push_back(pB);
             }
-            contactList->arr.push_back(contactPairsList);
+            contactList->arr().push_back(contactPairsList);
         }
         set_output("world", std::move(world));
         set_output("contactPointsList", std::move(contactList));
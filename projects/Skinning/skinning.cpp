@@ -9,10 +9,9 @@
 #include <igl/directed_edge_parents.h>
 #include <igl/forward_kinematics.h>
 #include <igl/deform_skeleton.h>
-#include <igl/dqs.h>
 
-
-#include <igl/lbs_matrix.h>
+#include <algorithm>
+#include <cmath>
 
 #include "skinning_iobject.h"
 
@@ -68,6 +67,141 @@ ZENDEFNODE(BlendPoses, {
     {"Skinning"},
 });
 
+// gather the weight channels <prefix>_0 ... <prefix>_{n-1} once and keep the
+// k largest (by magnitude) per vertex, rescaled to the original row sum
+static std::shared_ptr<SkinningWeightsTopK> build_topk_weights(PrimitiveObject* shape,const std::string& attr_prefix,size_t nm_handles,int topK) {
+    auto res = std::make_shared<SkinningWeightsTopK>();
+    size_t nv = shape->size();
+    int k = topK > 0 ? std::min<int>(topK,nm_handles) : (int)nm_handles;
+    res->attrPrefix = attr_prefix;
+    res->nverts = nv;
+    res->nhandles = nm_handles;
+    res->k = k;
+    res->boneIds.assign((size_t)k * nv,0);
+    res->weights.assign((size_t)k * nv,0.f);
+
+    std::vector<const float*> channels(nm_handles);
+    for(size_t i = 0;i < nm_handles;++i){
+        std::string attr_name = attr_prefix + "_" + std::to_string(i);
+        if(!shape->has_attr(attr_name)){
+            std::cout << "DO NOT HAVE " << attr_name << std::endl;
+            throw std::runtime_error("The Skinned Prim Does Not Have Weight Attr");
+        }
+        channels[i] = shape->attr<float>(attr_name).data();
+    }
+
+    bool has_nan = false;
+    #pragma omp parallel
+    {
+        std::vector<int> ids(k);
+        std::vector<float> ws(k);
+        #pragma omp for reduction(||:has_nan)
+        for(intptr_t i = 0;i < (intptr_t)nv;++i){
+            int m = 0;
+            float total = 0;
+            for(size_t j = 0;j < nm_handles;++j){
+                float w = channels[j][i];
+                has_nan = has_nan || std::isnan(w);
+                if(w == 0)
+                    continue;
+                total += w;
+                if(m == k && std::abs(w) <= std::abs(ws[k-1]))
+                    continue;
+                // insertion into the descending list, dropping the smallest when full
+                int s = m < k ? m++ : k - 1;
+                for(;s > 0 && std::abs(ws[s-1]) < std::abs(w);--s){
+                    ws[s] = ws[s-1];
+                    ids[s] = ids[s-1];
+                }
+                ws[s] = w;
+                ids[s] = (int)j;
+            }
+            float kept = 0;
+            for(int s = 0;s < m;++s)
+                kept += ws[s];
+            float scale = kept != 0 ? total / kept : 1.f;
+            for(int s = 0;s < m;++s){
+                res->boneIds[(size_t)s * nv + i] = ids[s];
+                res->weights[(size_t)s * nv + i] = ws[s] * scale;
+            }
+        }
+    }
+    if(has_nan)
+        throw std::runtime_error("NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX");
+    return res;
+}
+
+// bones as flat row major 3x4 affine matrices, x' = R x + t
+static void lbs_topk(const SkinningWeightsTopK& W,const float* mats,const zeno::vec3f* V,zeno::vec3f* U) {
+    size_t nv = W.nverts;
+    const int* ids = W.boneIds.data();
+    const float* ws = W.weights.data();
+    #pragma omp parallel for
+    for(intptr_t i = 0;i < (intptr_t)nv;++i){
+        float px = V[i][0],py = V[i][1],pz = V[i][2];
+        float ux = 0,uy = 0,uz = 0;
+        for(int s = 0;s < W.k;++s){
+            float w = ws[(size_t)s * nv + i];
+            const float* M = mats + 12 * ids[(size_t)s * nv + i];
+            ux += w * (M[0] * px + M[1] * py + M[2]  * pz + M[3]);
+            uy += w * (M[4] * px + M[5] * py + M[6]  * pz + M[7]);
+            uz += w * (M[8] * px + M[9] * py + M[10] * pz + M[11]);
+        }
+        U[i] = zeno::vec3f(ux,uy,uz);
+    }
+}
+
+// bones as flat unit dual quaternions (w,x,y,z real part, then w,x,y,z dual
+// part), blended the same way as igl::dqs
+static void dqs_topk(const SkinningWeightsTopK& W,const float* dqs,const zeno::vec3f* V,zeno::vec3f* U) {
+    size_t nv = W.nverts;
+    const int* ids = W.boneIds.data();
+    const float* ws = W.weights.data();
+    #pragma omp parallel for
+    for(intptr_t i = 0;i < (intptr_t)nv;++i){
+        float b[8] = {0,0,0,0,0,0,0,0};
+        for(int s = 0;s < W.k;++s){
+            float w = ws[(size_t)s * nv + i];
+            const float* D = dqs + 8 * ids[(size_t)s * nv + i];
+            for(int c = 0;c < 8;++c)
+                b[c] += w * D[c];
+        }
+        float inv = 1.f / std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+        for(int c = 0;c < 8;++c)
+            b[c] *= inv;
+        zeno::vec3f v = V[i];
+        float a0 = b[0],ae = b[4];
+        zeno::vec3f d0(b[1],b[2],b[3]),de(b[5],b[6],b[7]);
+        U[i] = v + 2.f * zeno::cross(d0,zeno::cross(d0,v) + a0 * v) + 2.f * (a0 * de - ae * d0 + zeno::cross(d0,de));
+    }
+}
+
+static size_t count_weight_channels(PrimitiveObject* shape,const std::string& attr_prefix) {
+    size_t nm_handles = 0;
+    while(shape->has_attr(attr_prefix + "_" + std::to_string(nm_handles)))
+        nm_handles++;
+    return nm_handles;
+}
+
+// the sparse weights only depend on the weight channels of the rest shape,
+// build them here once and feed them to every DoSkinning of the sequence
+struct BuildSkinningWeights : zeno::INode {
+    virtual void apply() override {
+        auto shape = get_input<PrimitiveObject>("shape");
+        auto attr_prefix = get_param<std::string>("attr_prefix");
+        auto topK = get_param<int>("topK");
+        size_t nm_handles = count_weight_channels(shape.get(),attr_prefix);
+        set_output("weights",build_topk_weights(shape.get(),attr_prefix,nm_handles,topK));
+    }
+};
+
+ZENDEFNODE(BuildSkinningWeights, {
+    {"shape"},
+    {"weights"},
+    {{"string","attr_prefix","sw"},{"int","topK","8"}},
+    {"Skinning"},
+});
+
 // input the forward kinematics result
 struct DoSkinning : zeno::INode {
     virtual void apply() override {
@@ -75,43 +209,26 @@ struct DoSkinning : zeno::INode {
         auto algorithm = get_param<std::string>(("algorithm"));
         auto attr_prefix = get_param<std::string>("attr_prefix");
         auto outputChannel = get_param<std::string>("out_channel");
+        auto topK = get_param<int>("topK");
 
         auto Qs_ = get_input<zeno::ListObject>("Qs")->get<NumericObject>();
         auto Ts_ = get_input<zeno::ListObject>("Ts")->get<NumericObject>();
 
         // std::cout << "GOT QS AND TS INPUT" << std::endl;
-        size_t dim = 3;
-        size_t nm_handles = 0;
-
-
-        auto& out_chan = shape->add_attr<zeno::vec3f>(outputChannel);
-        // std::cout << "CHECKOUT_1" << std::endl;
-
-        while(true){
-            std::string attr_name = attr_prefix + "_" + std::to_string(nm_handles);
-            if(shape->has_attr(attr_name)){
-                nm_handles++;
-                continue;
-            }
-            break;
+        size_t nm_handles = count_weight_channels(shape.get(),attr_prefix);
+        if(Qs_.size() < nm_handles || Ts_.size() < nm_handles){
+            std::cout << "NM_HANDLES : " << nm_handles << "\tNM_QS : " << Qs_.size() << "\tNM_TS : " << Ts_.size() << std::endl;
+            throw std::runtime_error("NOT ENOUGH RIGGING TRANSFORMATIONS FOR THE SKINNING WEIGHTS");
         }
 
-        Eigen::MatrixXd W;
-        W.resize(shape->size(),nm_handles);
-        for(size_t i = 0;i < nm_handles;++i){ 
-            std::string attr_name = attr_prefix +  "_" + std::to_string(i);
-            for(size_t j = 0;j < shape->size();++j){
-                if(!shape->has_attr(attr_name)){
-                    std::cout << "DO NOT HAVE " << attr_name << std::endl;
-                    std::cout << "NM_QS_AND_TS : " << nm_handles << std::endl;
-                    throw std::runtime_error("The Skinned Prim Does Not Have Weight Attr");
-                }
-                W(j,i) = shape->attr<float>(attr_name)[j];
-                if(std::isnan(W(j,i))){
-                    std::cout << "NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX : " << j << "\t" << i << "\t" << W(j,i) << std::endl;
-                    throw std::runtime_error("NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX");
-                }
-            }
+        // without prebuilt weights they are gathered from the channels here
+        std::shared_ptr<SkinningWeightsTopK> W;
+        if(has_input("weights")){
+            W = get_input<SkinningWeightsTopK>("weights");
+            if(W->attrPrefix != attr_prefix || W->nverts != shape->size() || W->nhandles != nm_handles)
+                throw std::runtime_error("THE SKINNING WEIGHTS DO NOT MATCH THE SKINNED PRIM");
+        }else{
+            W = build_topk_weights(shape.get(),attr_prefix,nm_handles,topK);
         }
 
         std::vector<Eigen::Vector3d> Ts;
@@ -188,43 +305,52 @@ struct DoSkinning : zeno::INode {
 
         // std::cout << "CHECKOUT_3" << std::endl;
 
-        Eigen::MatrixXd T(nm_handles*(dim+1),dim);
-        for(int e = 0;e<nm_handles;e++){
-            Eigen::Affine3d a = Eigen::Affine3d::Identity();
-            a.translate(Ts[e]);
-            a.rotate(Qs[e]);
-            T.block(e*(dim+1),0,dim+1,dim) =
-                a.matrix().transpose().block(0,0,dim+1,dim);
+        // flatten the bone transforms for the kernels
+        std::vector<float> mats(nm_handles * 12);
+        std::vector<float> dqs(nm_handles * 8);
+        for(size_t e = 0;e < nm_handles;e++){
+            Eigen::Matrix3d R = Qs[e].toRotationMatrix();
+            for(int r = 0;r < 3;++r){
+                for(int c = 0;c < 3;++c)
+                    mats[e * 12 + r * 4 + c] = R(r,c);
+                mats[e * 12 + r * 4 + 3] = Ts[e][r];
+            }
+            // dual part is (0,t) * q / 2
+            const auto& q = Qs[e];
+            const auto& t = Ts[e];
+            double dual[4] = {
+                -0.5 * (t[0] * q.x() + t[1] * q.y() + t[2] * q.z()),
+                 0.5 * (t[0] * q.w() + t[1] * q.z() - t[2] * q.y()),
+                 0.5 * (-t[0] * q.z() + t[1] * q.w() + t[2] * q.x()),
+                 0.5 * (t[0] * q.y() - t[1] * q.x() + t[2] * q.w()),
+            };
+            double real[4] = {q.w(),q.x(),q.y(),q.z()};
+            for(int c = 0;c < 4;++c){
+                dqs[e * 8 + c] = real[c];
+                dqs[e * 8 + 4 + c] = dual[c];
+            }
         }
-        // Compute deformation via LBS as matrix multiplication
-        Eigen::MatrixXd U,V;
-        V.resize(shape->size(),3);
-        for(size_t i = 0;i < V.rows();++i)
-            V.row(i) << shape->verts[i][0],shape->verts[i][1],shape->verts[i][2];
-
-
-        if(std::isnan(V.norm()) || std::isnan(W.norm()) || std::isnan(T.norm())){
-            std::cout << V.norm() << "\t" << W.norm() << std::endl;
-            throw std::runtime_error("IN SKINNING NAN VW DETECTED");
+        for(size_t i = 0;i < mats.size();++i){
+            if(std::isnan(mats[i]))
+                throw std::runtime_error("IN SKINNING NAN VW DETECTED");
         }
 
+        auto deformed_shape = std::make_shared<zeno::PrimitiveObject>(*shape);// automatic copy all the attributes
+        auto& out_chan = deformed_shape->add_attr<zeno::vec3f>(outputChannel);
+
         if(algorithm == "DQS"){
             // std::cout << "DQS SKINNING " << std::endl;
-            igl::dqs(V,W,Qs,Ts,U);
+            dqs_topk(*W,dqs.data(),shape->verts.data(),out_chan.data());
         }else if(algorithm == "LBS"){
-            Eigen::MatrixXd M;
-            igl::lbs_matrix(V,W,M);
-            U = M*T;
-        }        
-
-        auto deformed_shape = std::make_shared<zeno::PrimitiveObject>(*shape);// automatic copy all the attributes
-        // deformed_shape->resize(shape->size());
-        // deformed_shape->tris.resize(shape->tris.size());
-        // deformed_shape->quads.resize(shape->quads.size());
+            lbs_topk(*W,mats.data(),shape->verts.data(),out_chan.data());
+        }
 
-        if(std::isnan(U.norm())){
-            std::cout << "W : \n" << W << std::endl;
-            std::cout << "NAN DEFORMED SHAPE DETECTED: " << U.norm() << std::endl;
+        bool has_nan = false;
+        #pragma omp parallel for reduction(||:has_nan)
+        for(intptr_t i = 0;i < (intptr_t)out_chan.size();++i)
+            has_nan = has_nan || std::isnan(zeno::length(out_chan[i]));
+        if(has_nan){
+            std::cout << "NAN DEFORMED SHAPE DETECTED" << std::endl;
             std::cout << "AFFINE : " << std::endl;
             for(size_t i = 0;i < nm_handles;++i){
                 std::cout << Qs[i].x() << "\t" 
@@ -236,18 +362,16 @@ struct DoSkinning : zeno::INode {
 
             throw std::runtime_error("NAN DEFORMED SHAPE DETECTED");
         }
-        // std::cout << "CHECKOUT_4" << std::endl;
-        for(size_t i = 0;i < deformed_shape->size();++i)
-            out_chan[i] = zeno::vec3f(U.row(i)[0],U.row(i)[1],U.row(i)[2]);
 
         set_output("dshape",std::move(deformed_shape));
     }
 };
 
 ZENDEFNODE(DoSkinning, {
-    {"shape","Qs","Ts","restBones"},
+    {"shape","Qs","Ts","restBones","weights"},
     {"dshape"},
-    {{"enum LBS DQS","algorithm","DQS"},{"string","attr_prefix","sw"},{"string","out_channel","curPos"},{"int","FK","0"}},
+    {{"enum LBS DQS","algorithm","DQS"},{"string","attr_prefix","sw"},{"string","out_channel","curPos"},{"int","FK","0"},
+        {"int","topK","8"}},
     {"Skinning"},
 });
 
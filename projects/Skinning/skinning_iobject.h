@@ -28,4 +28,17 @@ struct SkinningWeight : zeno::IObject {
     Eigen::MatrixXd weight;
 };
 
+// the k largest influences of every vertex, stored slot major: influence s of
+// vertex i is (boneIds[s * nverts + i], weights[s * nverts + i]), unused slots
+// have weight 0 and point at bone 0
+struct SkinningWeightsTopK : zeno::IObject {
+    SkinningWeightsTopK() = default;
+    std::string attrPrefix;
+    size_t nverts = 0;
+    size_t nhandles = 0;
+    int k = 0;
+    std::vector<int> boneIds;
+    std::vector<float> weights;
+};
+
 };
\ No newline at end of file
@@ -122,7 +122,7 @@ struct USDSimpleTraverse : zeno::INode {
                     }
                 }
 
-                prims->arr.emplace_back(prim);
+                prims->arr().emplace_back(prim);
             }
 
         set_output("prims", std::move(prims));
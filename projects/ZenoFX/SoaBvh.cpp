@@ -0,0 +1,250 @@
+#include "SoaBvh.h"
+#include <algorithm>
+#include <cmath>
+#include <zeno/zeno.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace zeno {
+
+typename SoaBvh::Ti SoaBvh::numElements(PrimitiveObject const *prim,
+                                        element_e et) {
+  if (et == element_e::tet)
+    return prim->quads.size();
+  else if (et == element_e::tri)
+    return prim->tris.size();
+  else if (et == element_e::line)
+    return prim->lines.size();
+  else if (prim->points.size() > 0)
+    return prim->points.size();
+  else // points default to all the vertices, without writing prim->points
+    return prim->verts.size();
+}
+
+template <class F>
+static void foreach_element_vert(PrimitiveObject const *prim,
+                                 SoaBvh::element_e et, SoaBvh::Ti eid, F &&f) {
+  using element_e = SoaBvh::element_e;
+  if (et == element_e::tet) {
+    auto quad = prim->quads[eid];
+    for (int j = 0; j != 4; ++j)
+      f(quad[j]);
+  } else if (et == element_e::tri) {
+    auto tri = prim->tris[eid];
+    for (int j = 0; j != 3; ++j)
+      f(tri[j]);
+  } else if (et == element_e::line) {
+    auto line = prim->lines[eid];
+    for (int j = 0; j != 2; ++j)
+      f(line[j]);
+  } else {
+    f(prim->points.size() > 0 ? prim->points[eid] : eid);
+  }
+}
+
+void SoaBvh::build(PrimitiveObject const *prim, float thickness,
+                   element_e et) {
+  this->thickness = thickness;
+  this->eleCategory = et;
+
+  const Ti numLeaves = numElements(prim, et);
+  const auto &refpos = prim->verts.values;
+
+  /// morton order of the element centers
+  TV centerMin{std::numeric_limits<float>::max()};
+  TV centerMax{std::numeric_limits<float>::lowest()};
+  std::vector<TV> centers(numLeaves);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for (Ti i = 0; i < numLeaves; ++i) {
+    TV c{0, 0, 0};
+    int n = 0;
+    foreach_element_vert(prim, et, i, [&](Ti v) {
+      c += refpos[v];
+      ++n;
+    });
+    centers[i] = c / (float)n;
+  }
+  for (Ti i = 0; i < numLeaves; ++i) {
+    centerMin = zeno::min(centerMin, centers[i]);
+    centerMax = zeno::max(centerMax, centers[i]);
+  }
+
+  auto expand_bits = [](Tu v) -> Tu { // expands lower 10-bits to 30 bits
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+  };
+  const auto lengths = centerMax - centerMin;
+  std::vector<std::pair<Tu, Ti>> records(numLeaves); // <mc, id>
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for (Ti i = 0; i < numLeaves; ++i) {
+    Tu code = 0;
+    for (int d = 0; d != 3; ++d) {
+      float uc = lengths[d] > 0 ? (centers[i][d] - centerMin[d]) / lengths[d] : 0.f;
+      code |= expand_bits((Tu)std::clamp(uc * 1024.f, 0.f, 1023.f)) << (Tu)(2 - d);
+    }
+    records[i] = std::make_pair(code, i);
+  }
+  std::sort(std::begin(records), std::end(records));
+
+  leafIds.resize(numLeaves);
+  for (int d = 0; d != 3; ++d) {
+    leafMin[d].resize(numLeaves);
+    leafMax[d].resize(numLeaves);
+  }
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for (Ti i = 0; i < numLeaves; ++i)
+    leafIds[i] = records[i].second;
+
+  /// implicit 4-ary tree, level by level from the leaves up to the root
+  nodes.clear();
+  Ti numChildren = numLeaves, firstChild = 0, level = 0;
+  while (numChildren > 0) {
+    Ti numNodes = (numChildren + width - 1) / width;
+    Ti base = nodes.size();
+    nodes.resize(base + numNodes);
+    for (Ti i = 0; i < numNodes; ++i) {
+      auto &node = nodes[base + i];
+      node.firstChild = firstChild + i * width;
+      node.level = level;
+      node.numChildren = std::min<Ti>(width, numChildren - i * width);
+    }
+    if (numNodes == 1)
+      break;
+    numChildren = numNodes;
+    firstChild = base;
+    ++level;
+  }
+
+  refit(prim);
+}
+
+bool SoaBvh::refit(PrimitiveObject const *prim) {
+  const Ti numLeaves = numElements(prim, eleCategory);
+  if (numLeaves != (Ti)leafIds.size())
+    return false;
+
+  const auto &refpos = prim->verts.values;
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for (Ti i = 0; i < numLeaves; ++i) {
+    TV bmin{std::numeric_limits<float>::max()};
+    TV bmax{std::numeric_limits<float>::lowest()};
+    foreach_element_vert(prim, eleCategory, leafIds[i], [&](Ti v) {
+      bmin = zeno::min(bmin, refpos[v]);
+      bmax = zeno::max(bmax, refpos[v]);
+    });
+    for (int d = 0; d != 3; ++d) {
+      leafMin[d][i] = bmin[d] - thickness;
+      leafMax[d][i] = bmax[d] + thickness;
+    }
+  }
+  refitNodes();
+  return true;
+}
+
+bool SoaBvh::refit(PrimitiveObject const *prim, float thickness) {
+  if (numElements(prim, eleCategory) != (Ti)leafIds.size())
+    return false;
+  this->thickness = thickness;
+  return refit(prim);
+}
+
+std::shared_ptr<SoaBvh> SoaBvh::refitted(PrimitiveObject const *prim) const {
+  if (numElements(prim, eleCategory) != (Ti)leafIds.size())
+    return nullptr;
+  auto bvh = std::make_shared<SoaBvh>();
+  bvh->thickness = thickness;
+  bvh->eleCategory = eleCategory;
+  bvh->leafIds = leafIds;
+  bvh->nodes = nodes;
+  for (int d = 0; d != 3; ++d) {
+    bvh->leafMin[d].resize(leafIds.size());
+    bvh->leafMax[d].resize(leafIds.size());
+  }
+  bvh->refit(prim);
+  return bvh;
+}
+
+void SoaBvh::refitNodes() {
+  // float bounds of every node, only needed while quantizing its parent
+  std::array<std::vector<float>, 3> nodeMin, nodeMax;
+  for (int d = 0; d != 3; ++d) {
+    nodeMin[d].resize(nodes.size());
+    nodeMax[d].resize(nodes.size());
+  }
+
+  Ti begin = 0;
+  while (begin < (Ti)nodes.size()) {
+    Ti level = nodes[begin].level, end = begin;
+    while (end < (Ti)nodes.size() && nodes[end].level == level)
+      ++end;
+    auto const &childMin = level == 0 ? leafMin : nodeMin;
+    auto const &childMax = level == 0 ? leafMax : nodeMax;
+
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+    for (Ti i = begin; i < end; ++i) {
+      auto &node = nodes[i];
+      for (int d = 0; d != 3; ++d) {
+        float lo = std::numeric_limits<float>::max();
+        float hi = std::numeric_limits<float>::lowest();
+        for (Ti k = 0; k != node.numChildren; ++k) {
+          lo = std::min(lo, childMin[d][node.firstChild + k]);
+          hi = std::max(hi, childMax[d][node.firstChild + k]);
+        }
+        nodeMin[d][i] = lo;
+        nodeMax[d][i] = hi;
+
+        // round the scale up a little so that 255 never falls short of hi
+        float extent = std::nextafter((hi - lo) * (1.f / 255.f),
+                                      std::numeric_limits<float>::max());
+        float invExtent = hi > lo ? 1.f / extent : 0.f;
+        node.origin[d] = lo;
+        node.extent[d] = hi > lo ? extent : 0.f;
+        for (Ti k = 0; k != width; ++k) {
+          if (k >= node.numChildren) {
+            node.lo[d][k] = 255;
+            node.hi[d][k] = 0;
+            continue;
+          }
+          float cmin = childMin[d][node.firstChild + k];
+          float cmax = childMax[d][node.firstChild + k];
+          int qlo = (int)std::floor((cmin - lo) * invExtent);
+          int qhi = (int)std::ceil((cmax - lo) * invExtent);
+          qlo = std::clamp(qlo, 0, 255);
+          qhi = std::clamp(qhi, 0, 255);
+          // the decoded box must stay conservative under float rounding
+          while (qlo > 0 && lo + qlo * node.extent[d] > cmin)
+            --qlo;
+          while (qhi < 255 && lo + qhi * node.extent[d] < cmax)
+            ++qhi;
+          node.lo[d][k] = (std::uint8_t)qlo;
+          node.hi[d][k] = (std::uint8_t)qhi;
+        }
+      }
+    }
+    begin = end;
+  }
+
+  if (!nodes.empty()) {
+    Ti root = nodes.size() - 1;
+    for (int d = 0; d != 3; ++d) {
+      rootMin[d] = nodeMin[d][root];
+      rootMax[d] = nodeMax[d][root];
+    }
+  }
+}
+
+} // namespace zeno
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "LinearBvh.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace zeno {
+
+/// 4-wide bvh over morton-sorted leaves. child bounds of a node are stored
+/// SoA and quantized to 8 bits relative to the node box, so one node fits a
+/// cache line and the 4 children are tested with one vector op per axis.
+/// the topology only depends on the element count and the morton order of
+/// the build, so a SoaBvh can be kept across frames and refitted as long as
+/// the connectivity of the primitive does not change.
+struct SoaBvh : IObjectClone<SoaBvh> {
+  using element_e = LBvh::element_e;
+  using TV = vec3f;
+  using Ti = int;
+  using Tu = std::make_unsigned_t<Ti>;
+  static constexpr int width = 4;
+
+  struct alignas(64) Node {
+    float origin[3];            // node box min corner
+    float extent[3];            // node box size / 255
+    std::uint8_t lo[3][width];  // quantized child min, floor-rounded
+    std::uint8_t hi[3][width];  // quantized child max, ceil-rounded
+    Ti firstChild;              // first child node, or first leaf slot at level 0
+    Ti level;                   // 0 if the children are leaves
+    Ti numChildren;
+  };
+
+  std::vector<Node> nodes;  // bottom-up by level, root is the last one
+  std::array<std::vector<float>, 3> leafMin, leafMax;  // exact leaf bounds, SoA
+  std::vector<Ti> leafIds;  // element index of each (sorted) leaf slot
+  TV rootMin{0}, rootMax{0};
+  float thickness{0};
+  element_e eleCategory{element_e::point};
+
+  SoaBvh() noexcept = default;
+  SoaBvh(PrimitiveObject const *prim, float thickness, element_e et) {
+    build(prim, thickness, et);
+  }
+
+  std::size_t getNumLeaves() const noexcept { return leafIds.size(); }
+  static Ti numElements(PrimitiveObject const *prim, element_e et);
+
+  void build(PrimitiveObject const *prim, float thickness, element_e et);
+  /// recompute all bounds with the leaf order of the last build, returns false
+  /// (and leaves the tree untouched) if the element count has changed
+  bool refit(PrimitiveObject const *prim);
+  bool refit(PrimitiveObject const *prim, float thickness);
+  /// a new tree with the leaf order and nodes of this one, refitted to prim,
+  /// or null if the element count has changed. this tree is left untouched
+  std::shared_ptr<SoaBvh> refitted(PrimitiveObject const *prim) const;
+
+  /// call f(eid) for every element whose box contains pos
+  template <class F> void iter_neighbors(TV const &pos, F &&f) const {
+    iter_box(pos, pos, [&](Ti slot) {
+      for (int d = 0; d != 3; ++d)
+        if (pos[d] < leafMin[d][slot] || pos[d] > leafMax[d][slot])
+          return;
+      f(leafIds[slot]);
+    });
+  }
+
+  /// call f(eid) for every element whose box is within radius of pos
+  template <class F> void iter_radius(TV const &pos, float radius, F &&f) const {
+    float radius2 = radius * radius;
+    iter_box(pos - radius, pos + radius, [&](Ti slot) {
+      if (leafDistance2(slot, pos) <= radius2)
+        f(leafIds[slot]);
+    });
+  }
+
+  /// the k elements nearest to pos within radius, nearest first, ties broken
+  /// by element id. dist2(eid) is the exact squared distance to an element,
+  /// the boxes only prune the traversal so they must not be farther than it.
+  /// returns the number found, ids and dist2s must hold at least k entries
+  template <class F>
+  int knn(TV const &pos, int k, float radius, Ti *ids, float *dist2s,
+          F &&dist2) const {
+    if (nodes.empty() || k <= 0)
+      return 0;
+    // ids/dist2s are kept as a sorted list, the k-th entry is the pruning bound
+    int found = 0;
+    float bound = radius * radius;
+    auto closer = [](float d2a, Ti a, float d2b, Ti b) {
+      return d2a < d2b || (d2a == d2b && a < b);
+    };
+    auto insert = [&](Ti eid, float d2) {
+      int j = found < k ? found++ : k - 1;
+      while (j > 0 && closer(d2, eid, dist2s[j - 1], ids[j - 1])) {
+        dist2s[j] = dist2s[j - 1];
+        ids[j] = ids[j - 1];
+        --j;
+      }
+      dist2s[j] = d2;
+      ids[j] = eid;
+      if (found == k)
+        bound = std::min(bound, dist2s[k - 1]);
+    };
+
+    std::pair<float, Ti> stack[64];
+    int top = 0;
+    stack[top++] = {0.f, (Ti)nodes.size() - 1};
+    while (top) {
+      auto [nd2, nid] = stack[--top];
+      if (nd2 > bound) // early-out, the bound has shrunk since this was pushed
+        continue;
+      auto const &node = nodes[nid];
+      float d2[width];
+      boxDistance2(node, pos, d2);
+      if (node.level == 0) {
+        for (int c = 0; c != node.numChildren; ++c) {
+          if (d2[c] > bound)
+            continue;
+          Ti eid = leafIds[node.firstChild + c];
+          float ed2 = dist2(eid);
+          if (ed2 <= bound &&
+              (found < k || closer(ed2, eid, dist2s[k - 1], ids[k - 1])))
+            insert(eid, ed2);
+        }
+        continue;
+      }
+      // push the farthest child first so that the nearest one is visited first
+      int order[width] = {0, 1, 2, 3};
+      std::sort(order, order + width,
+                [&](int a, int b) { return d2[a] > d2[b]; });
+      for (int c : order)
+        if (d2[c] <= bound)
+          stack[top++] = {d2[c], node.firstChild + c};
+    }
+    return found;
+  }
+
+private:
+  float leafDistance2(Ti slot, TV const &p) const noexcept {
+    float d2 = 0;
+    for (int d = 0; d != 3; ++d) {
+      float v = std::max(std::max(leafMin[d][slot] - p[d], p[d] - leafMax[d][slot]), 0.f);
+      d2 += v * v;
+    }
+    return d2;
+  }
+
+  static int overlapMask(Node const &node, TV const &qmin, TV const &qmax) noexcept {
+    bool hit[width] = {true, true, true, true};
+    for (int d = 0; d != 3; ++d)
+      for (int k = 0; k != width; ++k) {
+        float lo = node.origin[d] + node.lo[d][k] * node.extent[d];
+        float hi = node.origin[d] + node.hi[d][k] * node.extent[d];
+        hit[k] &= (lo <= qmax[d]) & (hi >= qmin[d]);
+      }
+    int mask = 0;
+    for (int k = 0; k != width; ++k)
+      mask |= hit[k] << k;
+    return mask & ((1 << node.numChildren) - 1);
+  }
+
+  static void boxDistance2(Node const &node, TV const &p, float *d2) noexcept {
+    for (int k = 0; k != width; ++k)
+      d2[k] = 0;
+    for (int d = 0; d != 3; ++d)
+      for (int k = 0; k != width; ++k) {
+        float lo = node.origin[d] + node.lo[d][k] * node.extent[d];
+        float hi = node.origin[d] + node.hi[d][k] * node.extent[d];
+        float v = std::max(std::max(lo - p[d], p[d] - hi), 0.f);
+        d2[k] += v * v;
+      }
+    for (int k = node.numChildren; k < width; ++k)
+      d2[k] = std::numeric_limits<float>::infinity();
+  }
+
+  template <class F> void iter_box(TV const &qmin, TV const &qmax, F &&f) const {
+    if (nodes.empty())
+      return;
+    for (int d = 0; d != 3; ++d)
+      if (qmax[d] < rootMin[d] || qmin[d] > rootMax[d])
+        return;
+    Ti stack[64];
+    int top = 0;
+    stack[top++] = (Ti)nodes.size() - 1;
+    while (top) {
+      auto const &node = nodes[stack[--top]];
+      int mask = overlapMask(node, qmin, qmax);
+      for (int k = 0; mask; ++k, mask >>= 1) {
+        if (!(mask & 1))
+          continue;
+        if (node.level == 0)
+          f(node.firstChild + k);
+        else
+          stack[top++] = node.firstChild + k;
+      }
+    }
+  }
+
+  void refitNodes();
+};
+
+} // namespace zeno
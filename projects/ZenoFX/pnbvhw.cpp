@@ -1,4 +1,5 @@
 #include "LinearBvh.h"
+#include "SoaBvh.h"
 #include <limits>
 #include <zeno/zeno.h>
 #include <zeno/types/StringObject.h>
@@ -7,6 +8,8 @@
 #include <zeno/types/DictObject.h>
 #include <zeno/extra/GlobalState.h>
 #include <zeno/core/Graph.h>
+#include <zeno/utils/safe_dynamic_cast.h>
+#include <zeno/utils/log.h>
 #include <zfx/zfx.h>
 #include <zfx/x64.h>
 #include <cassert>
@@ -14,6 +17,7 @@
 #include <cmath>
 #include <atomic>
 #include <algorithm>
+#include <chrono>
 #if defined(_OPENMP)
 #include <omp.h>
 #endif
@@ -30,37 +34,59 @@ struct Buffer {
   int which = 0;
 };
 
+template <class Bvh>
 static void sorted_bvh_vectors_wrangle(zfx::x64::Executable *exec,
                                 std::vector<Buffer> const &chs,
                                 std::vector<Buffer> const &chs2,
                                 std::vector<zeno::vec3f> const &pos,
                                 std::vector<zeno::vec3f> const &opos,
                                 bool isBox, float radius2, int upper,
-                                zeno::LBvh *lbvh) {
+                                Bvh const *lbvh) {
   if (chs.size() == 0)
     return;
 
   if (upper < 0)
     upper = std::numeric_limits<int>::max();
 
-#pragma omp parallel for
+  using pair = std::pair<float, int>;
+#pragma omp parallel
+  {
+  // scratch buffers of this thread, reused by all of its particles
+  std::vector<pair> neighbors;
+  std::vector<int> ids;
+  std::vector<float> dist2s;
+#pragma omp for
   for (int i = 0; i < pos.size(); i++) {
-    using pair = std::pair<float, int>;
-    std::vector<pair> neighbors;
+    neighbors.clear();
     auto ctx = exec->make_context();
     for (int k = 0; k < chs.size(); k++) {
       if (!chs[k].which)
         ctx.channel(k)[0] = chs[k].base[chs[k].stride * i];
     }
     /// count
-    lbvh->iter_neighbors(pos[i], [&](int pid) {
-      auto dist2 = lengthSquared(pos[i] - opos[pid]);
-      if (!isBox)
-        if (dist2 > radius2)
-          return;
-      neighbors.push_back(std::make_pair(dist2, pid));
-    });
-    std::sort(std::begin(neighbors), std::end(neighbors));
+    bool counted = false;
+    if constexpr (std::is_same_v<Bvh, zeno::SoaBvh>) {
+      if (!isBox && upper != std::numeric_limits<int>::max()) {
+        // k-nearest traversal stops descending once the k-th best is closer
+        ids.resize(upper);
+        dist2s.resize(upper);
+        int n = lbvh->knn(pos[i], upper, std::sqrt(radius2), ids.data(), dist2s.data(),
+                          [&](int pid) { return lengthSquared(pos[i] - opos[pid]); });
+        for (int j = 0; j < n; j++)
+          neighbors.emplace_back(dist2s[j], ids[j]);
+        counted = true;
+      }
+    }
+    if (!counted) {
+      lbvh->iter_neighbors(pos[i], [&](int pid) {
+        auto dist2 = lengthSquared(pos[i] - opos[pid]);
+        if (!isBox)
+          if (dist2 > radius2)
+            return;
+        neighbors.push_back(std::make_pair(dist2, pid));
+      });
+      std::sort(std::begin(neighbors), std::end(neighbors));
+    }
     int id = 0;
     for (const auto &neighbor : neighbors) {
       if (id++ >= upper) break;
@@ -75,15 +101,17 @@ static void sorted_bvh_vectors_wrangle(zfx::x64::Executable *exec,
         chs[k].base[chs[k].stride * i] = ctx.channel(k)[0];
     }
   }
+  }
 }
 
+template <class Bvh>
 static void bvh_vectors_wrangle(zfx::x64::Executable *exec,
                                 std::vector<Buffer> const &chs,
                                 std::vector<Buffer> const &chs2,
                                 std::vector<zeno::vec3f> const &pos,
                                 std::vector<zeno::vec3f> const &opos,
                                 bool isBox, float radius2,
-                                zeno::LBvh *lbvh) {
+                                Bvh const *lbvh) {
   if (chs.size() == 0)
     return;
 
@@ -188,6 +216,137 @@ ZENDEFNODE(RefitPrimitiveBvh, {
                                   {"zenofx"},
                               });
 
+/// the neighbor wrangles accept both the binary LBvh and the 4-wide SoaBvh
+template <class F>
+static void visit_bvh(std::shared_ptr<zeno::IObject> const &obj, F &&f) {
+  if (auto soa = std::dynamic_pointer_cast<zeno::SoaBvh>(obj))
+    f(static_cast<zeno::SoaBvh const *>(soa.get()));
+  else
+    f(static_cast<zeno::LBvh const *>(
+        zeno::safe_dynamic_cast<zeno::LBvh>(obj, "lbvh").get()));
+}
+
+static zeno::SoaBvh::element_e soa_bvh_element(zeno::PrimitiveObject const *prim,
+                                               std::string const &primType) {
+  using element_e = zeno::SoaBvh::element_e;
+  if (primType == "point")
+    return element_e::point;
+  else if (primType == "line")
+    return element_e::line;
+  else if (primType == "tri")
+    return element_e::tri;
+  else if (primType == "quad")
+    return element_e::tet;
+  // auto, same priority as LBvh::build
+  if (prim->quads.size() > 0)
+    return element_e::tet;
+  else if (prim->tris.size() > 0)
+    return element_e::tri;
+  else if (prim->lines.size() > 0)
+    return element_e::line;
+  return element_e::point;
+}
+
+struct BuildPrimitiveSoaBvh : zeno::INode {
+  // the tree output last frame, only read for its leaf order and nodes: it
+  // may still be held downstream, so every frame outputs a new tree
+  std::shared_ptr<zeno::SoaBvh> m_cache;
+  int m_numRefits = 0;
+
+  virtual void apply() override {
+    auto prim = get_input<zeno::PrimitiveObject>("prim");
+    auto thickness = get_input2<float>("thickness");
+    auto rebuildInterval = get_input2<int>("rebuildInterval");
+    auto et = soa_bvh_element(prim.get(), get_param<std::string>("prim_type"));
+    // refit the tree of the last frame while the element count is unchanged,
+    // the morton order gets rebuilt every rebuildInterval frames to keep it tight
+    bool reuse = m_cache && m_cache->eleCategory == et &&
+                 m_cache->thickness == thickness &&
+                 (rebuildInterval <= 0 || m_numRefits < rebuildInterval);
+    auto bvh = reuse ? m_cache->refitted(prim.get()) : nullptr;
+    if (bvh) {
+      m_numRefits++;
+    } else {
+      bvh = std::make_shared<zeno::SoaBvh>(prim.get(), thickness, et);
+      m_numRefits = 0;
+    }
+    m_cache = bvh;
+    set_output("lbvh", std::move(bvh));
+  }
+};
+
+ZENDEFNODE(BuildPrimitiveSoaBvh,
+           {
+               {{"PrimitiveObject", "prim"},
+                {"float", "thickness", "0"},
+                {"int", "rebuildInterval", "16"}},
+               {{"SoaBvh", "lbvh"}},
+               {{"enum auto point line tri quad", "prim_type", "auto"}},
+               {"zenofx"},
+           });
+
+struct BenchmarkPrimitiveBvh : zeno::INode {
+  virtual void apply() override {
+    auto prim = get_input<zeno::PrimitiveObject>("prim");
+    auto primQuery = get_input<zeno::PrimitiveObject>("primQuery");
+    auto thickness = get_input2<float>("thickness");
+    auto const &qpos = primQuery->attr<zeno::vec3f>("pos");
+    using clock = std::chrono::steady_clock;
+    auto seconds = [](clock::time_point t0, clock::time_point t1) {
+      return std::chrono::duration<float>(t1 - t0).count();
+    };
+
+    auto t0 = clock::now();
+    auto lbvh = std::make_shared<zeno::LBvh>(prim, thickness);
+    auto t1 = clock::now();
+    lbvh->refit();
+    auto t2 = clock::now();
+    std::atomic<long> lbvhHits{0};
+#pragma omp parallel for
+    for (int i = 0; i < qpos.size(); i++) {
+      long n = 0;
+      lbvh->iter_neighbors(qpos[i], [&](int) { n++; });
+      lbvhHits += n;
+    }
+    auto t3 = clock::now();
+
+    auto et = soa_bvh_element(prim.get(), "auto");
+    auto soa = std::make_shared<zeno::SoaBvh>(prim.get(), thickness, et);
+    auto t4 = clock::now();
+    soa->refit(prim.get());
+    auto t5 = clock::now();
+    std::atomic<long> soaHits{0};
+#pragma omp parallel for
+    for (int i = 0; i < qpos.size(); i++) {
+      long n = 0;
+      soa->iter_neighbors(qpos[i], [&](int) { n++; });
+      soaHits += n;
+    }
+    auto t6 = clock::now();
+
+    float lbvhQps = qpos.size() / std::max(seconds(t2, t3), 1e-9f);
+    float soaQps = qpos.size() / std::max(seconds(t5, t6), 1e-9f);
+    zeno::log_info("BenchmarkPrimitiveBvh {} leaves, {} queries", soa->getNumLeaves(), qpos.size());
+    zeno::log_info("  LBvh:   build {}s refit {}s {} queries/s ({} hits)",
+                   seconds(t0, t1), seconds(t1, t2), lbvhQps, lbvhHits.load());
+    zeno::log_info("  SoaBvh: build {}s refit {}s {} queries/s ({} hits)",
+                   seconds(t3, t4), seconds(t4, t5), soaQps, soaHits.load());
+    set_output2("lbvhQueriesPerSecond", lbvhQps);
+    set_output2("soaBvhQueriesPerSecond", soaQps);
+  }
+};
+
+ZENDEFNODE(BenchmarkPrimitiveBvh,
+           {
+               {{"PrimitiveObject", "prim"},
+                {"PrimitiveObject", "primQuery"},
+                {"float", "thickness", "0"}},
+               {{"float", "lbvhQueriesPerSecond"},
+                {"float", "soaBvhQueriesPerSecond"}},
+               {},
+               {"zenofx"},
+           });
+
 struct QueryNearestPrimitive : zeno::INode {
   struct KVPair {
     zeno::vec3f w;
@@ -299,7 +458,7 @@ struct ParticlesNeighborBvhWrangle : zeno::INode {
   virtual void apply() override {
     auto prim = get_input<zeno::PrimitiveObject>("prim");
     auto primNei = get_input<zeno::PrimitiveObject>("primNei");
-    auto lbvh = get_input<zeno::LBvh>("lbvh");
+    auto lbvh = get_input("lbvh");
     auto code = get_input<zeno::StringObject>("zfxCode")->get();
 
         // BEGIN张心欣快乐自动加@IND
@@ -495,9 +654,11 @@ struct ParticlesNeighborBvhWrangle : zeno::INode {
       chs2[i] = iob;
     }
 
-    bvh_vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
-                        primNei->attr<zeno::vec3f>("pos"), get_input2<bool>("is_box"),
-                        lbvh.get()->thickness * lbvh.get()->thickness, lbvh.get());
+    visit_bvh(lbvh, [&](auto const *bvh) {
+      bvh_vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
+                          primNei->attr<zeno::vec3f>("pos"), get_input2<bool>("is_box"),
+                          bvh->thickness * bvh->thickness, bvh);
+    });
 
     set_output("prim", std::move(prim));
   }
@@ -507,7 +668,7 @@ ZENDEFNODE(ParticlesNeighborBvhWrangle,
            {
                {{"PrimitiveObject", "prim"},
                 {"PrimitiveObject", "primNei"},
-                {"LBvh", "lbvh"},
+                {"LBvh"/*or SoaBvh*/, "lbvh"},
                 {"bool", "is_box", "1"},
                 {"string", "zfxCode"},
                 {"DictObject:NumericObject", "params"}},
@@ -520,7 +681,7 @@ struct ParticlesNeighborBvhWrangleSorted : zeno::INode {
   virtual void apply() override {
     auto prim = get_input<zeno::PrimitiveObject>("prim");
     auto primNei = get_input<zeno::PrimitiveObject>("primNei");
-    auto lbvh = get_input<zeno::LBvh>("lbvh");
+    auto lbvh = get_input("lbvh");
     auto code = get_input<zeno::StringObject>("zfxCode")->get();
 
         // BEGIN张心欣快乐自动加@IND
@@ -716,9 +877,11 @@ struct ParticlesNeighborBvhWrangleSorted : zeno::INode {
       chs2[i] = iob;
     }
 
-    sorted_bvh_vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
-                        primNei->attr<zeno::vec3f>("pos"), get_input2<bool>("is_box"),
-                        lbvh.get()->thickness * lbvh.get()->thickness, get_input2<int>("limit"), lbvh.get());
+    visit_bvh(lbvh, [&](auto const *bvh) {
+      sorted_bvh_vectors_wrangle(exec, chs, chs2, prim->attr<zeno::vec3f>("pos"),
+                          primNei->attr<zeno::vec3f>("pos"), get_input2<bool>("is_box"),
+                          bvh->thickness * bvh->thickness, get_input2<int>("limit"), bvh);
+    });
 
     set_output("prim", std::move(prim));
   }
@@ -728,7 +891,7 @@ ZENDEFNODE(ParticlesNeighborBvhWrangleSorted,
            {
                {{"PrimitiveObject", "prim"},
                 {"PrimitiveObject", "primNei"},
-                {"LBvh", "lbvh"},
+                {"LBvh"/*or SoaBvh*/, "lbvh"},
                 {"bool", "is_box", "1"},
                 {"int", "limit", "-1"},
                 {"string", "zfxCode"},
@@ -11,8 +11,68 @@
 #include <zeno/extra/GlobalState.h>
 #include <zeno/utils/logger.h>
 #include <zeno/core/Graph.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
 
-static int offline_start(const char *progJson) {
+// node classes which carry state from one frame to the next, matched by exact
+// name. a graph using any of them has to be stepped serially in one session
+static bool isStatefulNode(std::string const &cls) {
+    static const std::set<std::string> stateful = {
+        // objects or counters kept by the node itself
+        "CacheLastFrameBegin", "CacheLastFrameEnd", "CachedOnce", "CachedIf",
+        "HelperOnce", "NumericCounter", "ObjTimeShift", "CachePrimitive",
+        "CacheVDBGrid", "PrimitiveCalcVelocity", "PrimitiveInterpSubframe",
+        "PrimitiveTraceTrail", "AudioBeats", "AudioEnergy", "AudioPowerVariation",
+        // writers accumulating every frame into one file
+        "WriteAlembic", "WriteAlembic2", "WriteCustomVAT",
+        // static first-frame initialization
+        "PBD", "PBDCloth", "PBDSoftBody", "PBF", "PBF_BVH",
+        // steppers advancing a world or system object kept across frames
+        "BulletStepWorld", "BulletStepMultiBodyWorld", "RigidStepWorld",
+        "StepFLIPWorld", "SubstepFLIPWorld", "GenericFLIPSolver", "FLIPSimTemplate",
+        "StepClothSystem", "StepIPCSystem", "StepUnifiedIPCSystem",
+        "StepPBDSystem", "StepRapidClothSystem", "StepZSBoundary",
+        "FleshDynamicStepping", "TendonDynamicStepping", "ExplicitTimeStepping",
+        "SpringSystemTimeStepping", "CVDoOneStep", "CVDoOneStepFast",
+        "TraceOneStep", "TracePositionOneStep",
+    };
+    return stateful.count(cls) != 0;
+}
+
+static bool isFrameIndependent(const char *progJson) {
+    rapidjson::Document doc;
+    doc.Parse(progJson);
+    if (!doc.IsArray())
+        return false;
+    auto const &nodeClasses = zeno::getSession().nodeClasses;
+    for (auto const &cmd : doc.GetArray()) {
+        if (!cmd.IsArray() || cmd.Size() < 2 || !cmd[0].IsString() || !cmd[1].IsString())
+            continue;
+        // addSubnetNode names a subgraph, not a node class, its nodes are added on their own
+        std::string action = cmd[0].GetString();
+        if (action != "addNode")
+            continue;
+        std::string cls = cmd[1].GetString();
+        if (isStatefulNode(cls)) {
+            zeno::log_info("node class {} keeps state across frames", cls);
+            return false;
+        }
+        // nothing is known about classes this build doesn't provide
+        if (!nodeClasses.count(cls)) {
+            zeno::log_info("unknown node class {}, assuming it keeps state across frames", cls);
+            return false;
+        }
+    }
+    return true;
+}
+
+static int offline_start(const char *progJson, const char *cachedir) {
     zeno::log_trace("program JSON: {}", progJson);
 
     auto session = &zeno::getSession();
@@ -34,9 +94,13 @@ static int offline_start(const char *progJson) {
 
     if (chkfail()) return 1;
 
+    bool bZenCache = cachedir && *cachedir;
+    session->globalComm->frameCache(bZenCache ? cachedir : "", bZenCache ? 1 : 0);
+
     session->globalComm->frameRange(graph->beginFrameNumber, graph->endFrameNumber);
     for (int frame = graph->beginFrameNumber; frame <= graph->endFrameNumber; frame++) {
         zeno::log_info("begin frame {}", frame);
+        session->globalState->frameid = frame;
         session->globalComm->newFrame();
         session->globalState->frameBegin();
         while (session->globalState->substepBegin())
@@ -47,6 +111,8 @@ static int offline_start(const char *progJson) {
         }
         session->globalState->frameEnd();
         session->globalComm->finishFrame();
+        if (bZenCache)
+            session->globalComm->dumpFrameCache(frame);
         zeno::log_debug("end frame {}", frame);
         if (chkfail()) return 1;
     }
@@ -56,8 +122,58 @@ static int offline_start(const char *progJson) {
     return 0;
 }
 
-int offline_main(const char *zsgfile, int beginFrame, int endFrame);
-int offline_main(const char *zsgfile, int beginFrame, int endFrame) {
+// split [beginFrame, endFrame] into contiguous chunks, one offline process
+// (and thus one Session) per chunk, every process writing its own frames
+static int offline_parallel(const char *zsgfile, int beginFrame, int endFrame, int jobs, const char *cachedir) {
+    int nframes = endFrame - beginFrame + 1;
+    jobs = std::min(jobs, nframes);
+    zeno::log_info("frame independent graph, running {} frames in {} processes", nframes, jobs);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<std::unique_ptr<QProcess>> procs;
+    for (int i = 0; i < jobs; i++) {
+        int begin = beginFrame + (int)((long long)nframes * i / jobs);
+        int end = beginFrame + (int)((long long)nframes * (i + 1) / jobs) - 1;
+        QStringList args = {
+            "-offline", QString::fromLocal8Bit(zsgfile),
+            "-begin", QString::number(begin),
+            "-end", QString::number(end),
+            "-jobs", "1",
+        };
+        if (cachedir && *cachedir)
+            args << "-cachedir" << QString::fromLocal8Bit(cachedir);
+        auto proc = std::make_unique<QProcess>();
+        proc->setProcessChannelMode(QProcess::ForwardedChannels);
+        proc->start(QCoreApplication::applicationFilePath(), args);
+        if (!proc->waitForStarted()) {
+            zeno::log_error("failed to start worker for frames {} to {}", begin, end);
+            return 1;
+        }
+        zeno::log_debug("worker {} runs frames {} to {}", i, begin, end);
+        procs.push_back(std::move(proc));
+    }
+
+    int ret = 0;
+    for (auto &proc : procs) {
+        proc->waitForFinished(-1);
+        if (proc->exitStatus() != QProcess::NormalExit || proc->exitCode() != 0)
+            ret = 1;
+    }
+    if (ret) {
+        zeno::log_error("some workers failed");
+        return ret;
+    }
+
+    double secs = timer.elapsed() * 1e-3;
+    zeno::log_info("program finished, {} frames in {} s, {} frames/s", nframes, secs,
+                   secs > 0 ? nframes / secs : 0.0);
+    return 0;
+}
+
+int offline_main(const char *zsgfile, int beginFrame, int endFrame, int jobs, const char *cachedir);
+int offline_main(const char *zsgfile, int beginFrame, int endFrame, int jobs, const char *cachedir) {
     zeno::log_info("running in offline mode, file=[{}], begin={}, end={}", zsgfile, beginFrame, endFrame);
 
     GraphsManagment& gman = GraphsManagment::instance();
@@ -73,5 +189,11 @@ int offline_main(const char *zsgfile, int beginFrame, int endFrame) {
         JsonHelper::AddVariantList({"setEndFrameNumber", endFrame}, "int", writer);
         serializeScene(pModel, writer);
     }
-    return offline_start(s.GetString());
+
+    // jobs <= 0 means one worker per hardware thread
+    if (jobs <= 0)
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    if (jobs > 1 && endFrame > beginFrame && isFrameIndependent(s.GetString()))
+        return offline_parallel(zsgfile, beginFrame, endFrame, jobs, cachedir);
+    return offline_start(s.GetString(), cachedir);
 }
@@ -33,17 +33,20 @@ int main(int argc, char *argv[])
     }
 
     if (argc >= 3 && !strcmp(argv[1], "-offline")) {
-        extern int offline_main(const char *zsgfile, int beginFrame, int endFrame);
-        int begin = 0, end = 0;
-        if (argc >= 5 && !strcmp(argv[3], "-begin"))
-            begin = atoi(argv[4]);
-        if (argc >= 5 && !strcmp(argv[3], "-end"))
-            end = atoi(argv[4]);
-        if (argc >= 7 && !strcmp(argv[5], "-begin"))
-            begin = atoi(argv[6]);
-        if (argc >= 7 && !strcmp(argv[5], "-end"))
-            end = atoi(argv[6]);
-        return offline_main(argv[2], begin, end);
+        extern int offline_main(const char *zsgfile, int beginFrame, int endFrame, int jobs, const char *cachedir);
+        int begin = 0, end = 0, jobs = 1;
+        const char *cachedir = nullptr;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "-begin"))
+                begin = atoi(argv[i + 1]);
+            else if (!strcmp(argv[i], "-end"))
+                end = atoi(argv[i + 1]);
+            else if (!strcmp(argv[i], "-jobs"))
+                jobs = atoi(argv[i + 1]);
+            else if (!strcmp(argv[i], "-cachedir"))
+                cachedir = argv[i + 1];
+        }
+        return offline_main(argv[2], begin, end, jobs, cachedir);
     }
 
     //entrance for the zenoedit-player.
@@ -18,4 +18,10 @@ namespace zeno {
 #define ZENO_POL(...) /* nothing */
 #endif
 
+// the algorithms in zeno/para run on the built-in work-stealing pool
+// (zeno/para/thread_pool.h) unless parallel STL is explicitly enabled
+#if defined(ZENO_PARALLEL_NATIVE) && !defined(ZENO_PARALLEL_STL)
+#define ZENO_PARA_NATIVE 1
+#endif
+
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <zeno/para/parallel_for.h>
+#include <zeno/utils/type_traits.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace zeno {
+
+// stream compaction: the indices i in [0, count) for which pred(i) holds, in
+// ascending order. fixed size blocks are flagged and counted, the counts are
+// scanned into output offsets, then every block scatters its indices there
+template <class Index = int, class Pred>
+std::vector<Index> parallel_compact_indices(std::size_t count, Pred pred) {
+    constexpr std::size_t blockSize = 4096;
+    std::size_t nblocks = (count + blockSize - 1) / blockSize;
+    std::vector<uint8_t> flags(count);
+    std::vector<std::size_t> offsets(nblocks + 1);
+    parallel_for(nblocks, [&] (std::size_t k) {
+        std::size_t b = k * blockSize, e = std::min(count, b + blockSize);
+        std::size_t n = 0;
+        for (std::size_t i = b; i < e; i++) {
+            bool f = pred((Index)i);
+            flags[i] = f;
+            n += f;
+        }
+        offsets[k + 1] = n;
+    });
+    for (std::size_t k = 0; k < nblocks; k++)
+        offsets[k + 1] += offsets[k];
+    std::vector<Index> ret(offsets[nblocks]);
+    parallel_for(nblocks, [&] (std::size_t k) {
+        std::size_t b = k * blockSize, e = std::min(count, b + blockSize);
+        std::size_t o = offsets[k];
+        for (std::size_t i = b; i < e; i++) {
+            if (flags[i])
+                ret[o++] = (Index)i;
+        }
+    });
+    return ret;
+}
+
+// arr[i] = func(arr[revamp[i]]) for all i in revamp, arr shrinks to revamp.size()
+template <class T, class Index, class Func = identity>
+void parallel_gather(std::vector<T> &arr, std::vector<Index> const &revamp, Func func = {}) {
+    std::vector<T> newarr(revamp.size());
+    parallel_for(revamp.size(), [&] (std::size_t i) {
+        newarr[i] = func(arr[revamp[i]]);
+    });
+    std::swap(arr, newarr);
+}
+
+}
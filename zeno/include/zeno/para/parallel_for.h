@@ -2,23 +2,60 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <algorithm>
+#include <iterator>
 
 namespace zeno {
 
+// grain is the max number of indices run by one task, 0 picks it from the pool size
+
 template <class Index, class Func>
-void parallel_for(Index first, Index last, Func func) {
+void parallel_for(Index first, Index last, Func func, std::size_t grain = 0) {
+#ifdef ZENO_PARA_NATIVE
+    if (!(first < last)) return;
+    parallel_chunks((std::size_t)(last - first), grain, [&] (std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            func((Index)(first + i));
+    });
+#else
     std::for_each(ZENO_PAR counter_iterator<Index>(first), counter_iterator<Index>(last), func);
+#endif
+}
+
+template <class Index, class Func>
+void parallel_for(Index count, Func func, std::size_t grain = 0) {
+    parallel_for(Index{}, count, std::move(func), grain);
 }
 
+// func(b, e) is called once per chunk [b, e), for loops with per-chunk setup
 template <class Index, class Func>
-void parallel_for(Index count, Func func) {
-    std::for_each(ZENO_PAR counter_iterator<Index>(Index{}), counter_iterator<Index>(count), func);
+void parallel_for_chunked(Index first, Index last, Func func, std::size_t grain = 0) {
+#ifdef ZENO_PARA_NATIVE
+    if (!(first < last)) return;
+    parallel_chunks((std::size_t)(last - first), grain, [&] (std::size_t b, std::size_t e) {
+        func((Index)(first + b), (Index)(first + e));
+    });
+#else
+    if (first < last)
+        func(first, last);
+#endif
 }
 
 template <class It, class Func>
 void parallel_for_each(It first, It last, Func func) {
+#ifdef ZENO_PARA_NATIVE
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                  typename std::iterator_traits<It>::iterator_category>) {
+        parallel_chunks((std::size_t)(last - first), 0, [&] (std::size_t b, std::size_t e) {
+            std::for_each(first + b, first + e, func);
+        });
+    } else {
+        std::for_each(first, last, func);
+    }
+#else
     std::for_each(ZENO_PAR_UNSEQ first, last, func);
+#endif
 }
 
 }
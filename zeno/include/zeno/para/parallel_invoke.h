@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zeno/para/execution.h>
+#include <zeno/para/thread_pool.h>
 #include <functional>
 #include <algorithm>
 #include <array>
@@ -10,7 +11,14 @@ namespace zeno {
 template <class ...Tasks>
 void parallel_invoke(Tasks &&...tasks) {
     std::array<std::function<void()>, sizeof...(Tasks)> tmp{std::forward<Tasks>(tasks)...};
+#ifdef ZENO_PARA_NATIVE
+    parallel_chunks(tmp.size(), 1, [&] (std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            std::move(tmp[i])();
+    });
+#else
     std::for_each(ZENO_PAR tmp.begin(), tmp.end(), [] (auto &&f) { std::move(f)(); });
+#endif
 }
 
 //inline void parallel_invoke(std::initializer_list<std::function<void()> tasks) {
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/thread_pool.h>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace zeno {
+
+// stable LSD radix sort of arr by the unsigned integer keyFn(elem), 8 bits per
+// pass; passes where all keys share the same digit are skipped, so small key
+// ranges only cost one histogram each
+template <class T, class KeyFn>
+void parallel_radix_sort(std::vector<T> &arr, KeyFn keyFn) {
+    using Key = std::decay_t<decltype(keyFn(arr[0]))>;
+    static_assert(std::is_unsigned_v<Key>, "radix sort key must be unsigned");
+    constexpr std::size_t radix = 256;
+
+    std::size_t count = arr.size();
+    if (count < 2) return;
+    if (count < 4096) {
+        std::stable_sort(arr.begin(), arr.end(), [&] (T const &a, T const &b) {
+            return keyFn(a) < keyFn(b);
+        });
+        return;
+    }
+
+    std::size_t nblocks = std::min(count / 2048, thread_pool_size() * 4);
+    nblocks = std::max<std::size_t>(nblocks, 1);
+    auto blockBegin = [&] (std::size_t k) {
+        return count * k / nblocks;
+    };
+    std::vector<std::size_t> hist(nblocks * radix);
+    std::vector<T> tmp(count);
+
+    for (unsigned shift = 0; shift < sizeof(Key) * 8; shift += 8) {
+        auto digit = [&] (T const &x) {
+            return (std::size_t)(keyFn(x) >> shift) & (radix - 1);
+        };
+        parallel_for((std::size_t)0, nblocks, [&] (std::size_t k) {
+            std::size_t *h = hist.data() + k * radix;
+            std::fill(h, h + radix, 0);
+            for (std::size_t i = blockBegin(k); i < blockBegin(k + 1); i++)
+                h[digit(arr[i])]++;
+        }, 1);
+
+        // digit major, block minor: keeps equal digits in block (thus input) order
+        std::size_t offset = 0;
+        bool trivial = false;
+        for (std::size_t d = 0; d < radix && !trivial; d++) {
+            std::size_t total = 0;
+            for (std::size_t k = 0; k < nblocks; k++) {
+                std::size_t n = hist[k * radix + d];
+                hist[k * radix + d] = offset;
+                offset += n;
+                total += n;
+            }
+            trivial = total == count;
+        }
+        if (trivial)
+            continue;
+
+        parallel_for((std::size_t)0, nblocks, [&] (std::size_t k) {
+            std::size_t *h = hist.data() + k * radix;
+            for (std::size_t i = blockBegin(k); i < blockBegin(k + 1); i++)
+                tmp[h[digit(arr[i])]++] = std::move(arr[i]);
+        }, 1);
+        std::swap(arr, tmp);
+    }
+}
+
+}
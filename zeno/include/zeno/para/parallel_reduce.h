@@ -2,6 +2,7 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <zeno/utils/type_traits.h>
 #include <zeno/utils/vec.h>
 #include <numeric>
@@ -10,6 +11,64 @@
 
 namespace zeno {
 
+#ifdef ZENO_PARA_NATIVE
+
+template <class Index, class Value, class Reduce, class Transform>
+Value parallel_reduce(Index first, Index last, Value initVal, Reduce reduceFn, Transform transformFn) {
+    if (!(first < last)) return initVal;
+    return parallel_reduce_chunks((std::size_t)(last - first), initVal, reduceFn, [&] (std::size_t i) -> Value {
+        return transformFn((Index)(first + i));
+    });
+}
+
+template <class It, class Transform = identity>
+auto parallel_reduce_min(It first, It last, Transform transformFn = {}) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    if (first == last) return T();
+    return parallel_reduce_chunks((std::size_t)(last - first), T(transformFn(*first)), [] (auto &&x, auto &&y) -> T {
+        return zeno::min(x, y);
+    }, [&] (std::size_t i) -> T {
+        return transformFn(first[i]);
+    });
+}
+
+template <class It, class Transform = identity>
+auto parallel_reduce_max(It first, It last, Transform transformFn = {}) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    if (first == last) return T();
+    return parallel_reduce_chunks((std::size_t)(last - first), T(transformFn(*first)), [] (auto &&x, auto &&y) -> T {
+        return zeno::max(x, y);
+    }, [&] (std::size_t i) -> T {
+        return transformFn(first[i]);
+    });
+}
+
+template <class It, class Transform = identity>
+auto parallel_reduce_minmax(It first, It last, Transform transformFn = {}) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    using P = std::pair<T, T>;
+    if (first == last) return P();
+    T init = transformFn(*first);
+    return parallel_reduce_chunks((std::size_t)(last - first), P(init, init), [] (P const &x, P const &y) -> P {
+        return P(zeno::min(x.first, y.first), zeno::max(x.second, y.second));
+    }, [&] (std::size_t i) -> P {
+        T val = transformFn(first[i]);
+        return P(val, val);
+    });
+}
+
+template <class It, class Transform = identity>
+auto parallel_reduce_sum(It first, It last, Transform transformFn = {}) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    return parallel_reduce_chunks((std::size_t)(last - first), T(), [] (auto &&x, auto &&y) -> T {
+        return x + y;
+    }, [&] (std::size_t i) -> T {
+        return transformFn(first[i]);
+    });
+}
+
+#else
+
 template <class Index, class Value, class Reduce, class Transform>
 Value parallel_reduce(Index first, Index last, Value initVal, Reduce reduceFn, Transform transformFn) {
     return std::transform_reduce(ZENO_PAR counter_iterator<Index>(first), counter_iterator<Index>(last),
@@ -18,27 +77,33 @@ Value parallel_reduce(Index first, Index last, Value initVal, Reduce reduceFn, T
 
 template <class It, class Transform = identity>
 auto parallel_reduce_min(It first, It last, Transform transformFn = {}) {
-    if (first == last) return std::decay_t<decltype(*first)>();
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, *first, [] (auto &&x, auto &&y) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    if (first == last) return T();
+    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, T(transformFn(*first)), [] (auto &&x, auto &&y) -> T {
         return zeno::min(x, y);
     }, transformFn);
 }
 
 template <class It, class Transform = identity>
 auto parallel_reduce_max(It first, It last, Transform transformFn = {}) {
-    if (first == last) return std::decay_t<decltype(*first)>();
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, *first, [] (auto &&x, auto &&y) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    if (first == last) return T();
+    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, T(transformFn(*first)), [] (auto &&x, auto &&y) -> T {
         return zeno::max(x, y);
     }, transformFn);
 }
 
 template <class It, class Transform = identity>
 auto parallel_reduce_minmax(It first, It last, Transform transformFn = {}) {
-    if (first == last) return std::make_pair(std::decay_t<decltype(*first)>(), std::decay_t<decltype(*first)>());
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, std::make_pair(*first, *first), [] (auto &&x, auto &&y) {
-        return std::make_pair(zeno::min(x.first, y.first), zeno::max(x.second, y.second));
-    }, [transformFn] (auto const &val) {
-        return std::make_pair(val, val);
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    using P = std::pair<T, T>;
+    if (first == last) return P();
+    T init = transformFn(*first);
+    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, P(init, init), [] (P const &x, P const &y) -> P {
+        return P(zeno::min(x.first, y.first), zeno::max(x.second, y.second));
+    }, [transformFn] (auto const &val) -> P {
+        T t = transformFn(val);
+        return P(t, t);
     });
 }
 
@@ -49,6 +114,8 @@ auto parallel_reduce_sum(It first, It last, Transform transformFn = {}) {
     }, transformFn);
 }
 
+#endif
+
 template <class It, class Transform = identity>
 auto parallel_reduce_average(It first, It last, Transform transformFn = {}) {
     return parallel_reduce_sum(first, last, transformFn) / (last - first);
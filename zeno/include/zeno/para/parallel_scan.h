@@ -2,6 +2,7 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <zeno/utils/type_traits.h>
 #include <zeno/utils/vec.h>
 #include <numeric>
@@ -10,6 +11,52 @@
 
 namespace zeno {
 
+#ifdef ZENO_PARA_NATIVE
+
+template <class Index, class OutputIt, class Value, class Reduce, class Transform>
+OutputIt parallel_inclusive_scan(Index first, Index last, OutputIt dest,
+                    Value initVal, Reduce reduceFn, Transform transformFn) {
+    if (!(first < last)) return dest;
+    std::size_t count = last - first;
+    parallel_scan_chunks(count, dest, initVal, reduceFn, [&] (std::size_t i) -> Value {
+        return transformFn((Index)(first + i));
+    }, true);
+    return dest + count;
+}
+
+template <class It, class OutputIt, class Transform = identity>
+OutputIt parallel_inclusive_scan_sum(It first, It last, OutputIt dest, Transform transformFn = {}) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    std::size_t count = last - first;
+    parallel_scan_chunks(count, dest, T(), [] (auto &&x, auto &&y) -> T {
+        return x + y;
+    }, [&] (std::size_t i) -> T {
+        return transformFn(first[i]);
+    }, true);
+    return dest + count;
+}
+
+template <class Index, class OutputIt, class Value, class Reduce, class Transform>
+Value parallel_exclusive_scan(Index first, Index last, OutputIt dest,
+                    Value initVal, Reduce reduceFn, Transform transformFn) {
+    if (!(first < last)) return initVal;
+    return parallel_scan_chunks((std::size_t)(last - first), dest, initVal, reduceFn, [&] (std::size_t i) -> Value {
+        return transformFn((Index)(first + i));
+    }, false);
+}
+
+template <class It, class OutputIt, class Transform = identity>
+auto parallel_exclusive_scan_sum(It first, It last, OutputIt dest, Transform transformFn = {}) {
+    using T = std::decay_t<decltype(transformFn(*first))>;
+    return parallel_scan_chunks((std::size_t)(last - first), dest, T(), [] (auto &&x, auto &&y) -> T {
+        return x + y;
+    }, [&] (std::size_t i) -> T {
+        return transformFn(first[i]);
+    }, false);
+}
+
+#else
+
 template <class Index, class OutputIt, class Value, class Reduce, class Transform>
 OutputIt parallel_inclusive_scan(Index first, Index last, OutputIt dest,
                     Value initVal, Reduce reduceFn, Transform transformFn) {
@@ -48,4 +95,6 @@ auto parallel_exclusive_scan_sum(It first, It last, OutputIt dest, Transform tra
         return std::decay_t<decltype(transformFn(*first))>();
 }
 
+#endif
+
 }
@@ -2,13 +2,18 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <algorithm>
 
 namespace zeno {
 
 template <class It, class Func>
 void parallel_sort(It first, It last, Func func) {
+#ifdef ZENO_PARA_NATIVE
+    parallel_sort_chunks(first, last, func);
+#else
     std::sort(ZENO_PAR_UNSEQ first, last, func);
+#endif
 }
 
 }
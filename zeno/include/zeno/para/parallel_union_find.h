@@ -0,0 +1,50 @@
+#pragma once
+
+#include <zeno/para/parallel_for.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace zeno {
+
+// concurrent union-find over [0, n), find and unite may be called from many
+// threads at once. roots always link to the smaller index, so the root of a
+// set is its smallest member whatever the order of the unions or the thread
+// count
+struct parallel_union_find {
+    std::unique_ptr<std::atomic<int>[]> m_parent;
+
+    explicit parallel_union_find(std::size_t n) : m_parent(new std::atomic<int>[n]) {
+        parallel_for(n, [&] (std::size_t i) {
+            m_parent[i].store((int)i, std::memory_order_relaxed);
+        });
+    }
+
+    int find(int i) const {
+        while (true) {
+            int p = m_parent[i].load(std::memory_order_relaxed);
+            if (p == i)
+                return i;
+            int gp = m_parent[p].load(std::memory_order_relaxed);
+            if (p != gp) // path halving
+                m_parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+        }
+    }
+
+    void unite(int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            if (m_parent[a].compare_exchange_strong(a, b, std::memory_order_relaxed))
+                return;
+        }
+    }
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zeno/para/execution.h>
+#include <zeno/para/thread_pool.h>
 #include <functional>
 #include <algorithm>
 #include <vector>
@@ -19,9 +20,16 @@ struct task_group {
     }
 
     void run() {
+#ifdef ZENO_PARA_NATIVE
+        parallel_chunks(m_tasks.size(), 1, [&] (std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; i++)
+                std::move(m_tasks[i])();
+        });
+#else
         std::for_each(ZENO_PAR m_tasks.begin(), m_tasks.end(), [&] (auto &&f) {
             std::move(f)();
         });
+#endif
     }
 };
 
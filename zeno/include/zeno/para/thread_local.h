@@ -1,8 +1,9 @@
 #pragma once
 
-#ifdef ZENO_PARALLEL_STL
-
 #include <zeno/para/execution.h>
+
+#if defined(ZENO_PARALLEL_STL) || defined(ZENO_PARA_NATIVE)
+
 #include <thread>
 #include <mutex>
 #include <map>
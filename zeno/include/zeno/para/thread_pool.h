@@ -0,0 +1,158 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace zeno {
+
+// number of threads taking part in a parallel call, including the caller
+ZENO_API std::size_t thread_pool_size();
+
+// run fn(ctx, b, e) over [0, count) in chunks of at most grain elements,
+// chunks are split recursively and balanced by work stealing between the
+// pool threads; may be called from inside a chunk (nested parallelism), the
+// caller executes pending chunks while it waits for the others to finish.
+// an exception thrown by a chunk is rethrown to the caller after all chunks
+// have finished
+ZENO_API void thread_pool_run(std::size_t count, std::size_t grain,
+                              void (*fn)(void *ctx, std::size_t b, std::size_t e), void *ctx);
+
+namespace _thread_pool_details {
+
+inline std::size_t auto_grain(std::size_t count, std::size_t grain) {
+    if (grain)
+        return grain;
+    // ~8 chunks per thread leave enough room for stealing to balance the load
+    return std::max<std::size_t>(1, count / (thread_pool_size() * 8));
+}
+
+// blocks for reductions and scans, independent of the grain and of the thread
+// count so that the order of combining (and thus the result for float sums)
+// only depends on count
+inline std::size_t num_blocks(std::size_t count) {
+    return std::min<std::size_t>(256, (count + 1023) / 1024);
+}
+
+inline std::size_t block_begin(std::size_t count, std::size_t nblocks, std::size_t k) {
+    return count * k / nblocks;
+}
+
+}
+
+template <class Func>
+void parallel_chunks(std::size_t count, std::size_t grain, Func &&func) {
+    if (!count)
+        return;
+    grain = _thread_pool_details::auto_grain(count, grain);
+    if (count <= grain || thread_pool_size() == 1) {
+        func(std::size_t{0}, count);
+        return;
+    }
+    thread_pool_run(count, grain, [] (void *ctx, std::size_t b, std::size_t e) {
+        (*static_cast<std::remove_reference_t<Func> *>(ctx))(b, e);
+    }, (void *)std::addressof(func));
+}
+
+// reduce get(i) for i in [0, count) with reduceFn, starting from initVal;
+// only associativity of reduceFn is required, the combining order is fixed
+template <class Value, class Reduce, class Get>
+Value parallel_reduce_chunks(std::size_t count, Value initVal, Reduce reduceFn, Get get) {
+    using namespace _thread_pool_details;
+    if (!count)
+        return initVal;
+    std::size_t nblocks = num_blocks(count);
+    std::vector<Value> partial(nblocks, initVal);
+    parallel_chunks(nblocks, 1, [&] (std::size_t kb, std::size_t ke) {
+        for (std::size_t k = kb; k < ke; k++) {
+            std::size_t b = block_begin(count, nblocks, k), e = block_begin(count, nblocks, k + 1);
+            Value val = get(b);
+            for (std::size_t i = b + 1; i < e; i++)
+                val = reduceFn(val, get(i));
+            partial[k] = val;
+        }
+    });
+    Value ret = initVal;
+    for (std::size_t k = 0; k < nblocks; k++)
+        ret = reduceFn(ret, partial[k]);
+    return ret;
+}
+
+// sort equal blocks in parallel, then merge neighbouring runs pairwise
+template <class It, class Compare>
+void parallel_sort_chunks(It first, It last, Compare comp) {
+    using namespace _thread_pool_details;
+    std::size_t count = last - first;
+    std::size_t nblocks = num_blocks(count);
+    if (count < 8192 || nblocks < 2) {
+        std::sort(first, last, comp);
+        return;
+    }
+    parallel_chunks(nblocks, 1, [&] (std::size_t kb, std::size_t ke) {
+        for (std::size_t k = kb; k < ke; k++)
+            std::sort(first + block_begin(count, nblocks, k), first + block_begin(count, nblocks, k + 1), comp);
+    });
+    for (std::size_t width = 1; width < nblocks; width *= 2) {
+        std::size_t npairs = (nblocks + 2 * width - 1) / (2 * width);
+        parallel_chunks(npairs, 1, [&] (std::size_t pb, std::size_t pe) {
+            for (std::size_t p = pb; p < pe; p++) {
+                std::size_t k = p * 2 * width;
+                if (k + width >= nblocks) continue;
+                std::size_t b = block_begin(count, nblocks, k);
+                std::size_t m = block_begin(count, nblocks, k + width);
+                std::size_t e = block_begin(count, nblocks, std::min(nblocks, k + 2 * width));
+                std::inplace_merge(first + b, first + m, first + e, comp);
+            }
+        });
+    }
+}
+
+// three pass blocked scan: local inclusive scans written to dest, a serial
+// scan of the block totals, then every block is offset by its prefix.
+// returns the reduction of initVal and all the elements
+template <class Value, class OutputIt, class Reduce, class Get>
+Value parallel_scan_chunks(std::size_t count, OutputIt dest, Value initVal, Reduce reduceFn, Get get, bool inclusive) {
+    using namespace _thread_pool_details;
+    if (!count)
+        return initVal;
+    std::size_t nblocks = num_blocks(count);
+    std::vector<Value> offsets(nblocks, initVal);
+    parallel_chunks(nblocks, 1, [&] (std::size_t kb, std::size_t ke) {
+        for (std::size_t k = kb; k < ke; k++) {
+            std::size_t b = block_begin(count, nblocks, k), e = block_begin(count, nblocks, k + 1);
+            Value acc = get(b);
+            dest[b] = acc;
+            for (std::size_t i = b + 1; i < e; i++) {
+                acc = reduceFn(acc, get(i));
+                dest[i] = acc;
+            }
+            offsets[k] = acc;
+        }
+    });
+    Value total = initVal;
+    for (std::size_t k = 0; k < nblocks; k++) {
+        Value blockTotal = offsets[k];
+        offsets[k] = total;
+        total = reduceFn(total, blockTotal);
+    }
+    parallel_chunks(nblocks, 1, [&] (std::size_t kb, std::size_t ke) {
+        for (std::size_t k = kb; k < ke; k++) {
+            std::size_t b = block_begin(count, nblocks, k), e = block_begin(count, nblocks, k + 1);
+            Value const &offset = offsets[k];
+            if (inclusive) {
+                for (std::size_t i = b; i < e; i++)
+                    dest[i] = reduceFn(offset, Value(dest[i]));
+            } else {
+                for (std::size_t i = e - 1; i > b; i--)
+                    dest[i] = reduceFn(offset, Value(dest[i - 1]));
+                dest[b] = offset;
+            }
+        }
+    });
+    return total;
+}
+
+}
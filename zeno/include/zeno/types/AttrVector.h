@@ -3,6 +3,10 @@
 #include <zeno/utils/vec.h>
 #include <zeno/utils/Error.h>
 #include <zeno/utils/type_traits.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <variant>
 #include <vector>
 #include <map>
@@ -44,16 +48,95 @@ struct AttrVector {
     using iterator = typename BaseVector::iterator;
     using const_iterator = typename BaseVector::const_iterator;
 
+    // an attribute not yet expanded into an array: either uniform (only value)
+    // or computed (fill writes all elements of an array sized size())
+    template <class T>
+    struct LazyAttr {
+        T value{};
+        std::function<void(AttrVector const &, std::vector<T> &)> fill;
+    };
+
+    using LazyAttrVariant = std::variant
+        < LazyAttr<vec3f>
+        , LazyAttr<float>
+        , LazyAttr<vec3i>
+        , LazyAttr<int>
+        , LazyAttr<vec2f>
+        , LazyAttr<vec2i>
+        , LazyAttr<vec4f>
+        , LazyAttr<vec4i>
+        >;
+
     inline static const std::string kpos = "pos"; 
 
     BaseVector values;
     std::map<std::string, AttrVectorVariant> attrs;
+    // expanded into attrs on the first array access, an array assigned to
+    // attrs directly takes precedence over the lazy one of the same name
+    std::map<std::string, LazyAttrVariant> lazy_attrs;
+
+private:
+    // const accessors may expand lazy attributes, so while any is left they
+    // touch the two maps under lazy_mtx only; once all are expanded (or if
+    // there never were any) readers skip the lock
+    mutable std::recursive_mutex lazy_mtx;
+    std::atomic<bool> lazy_pending{false};
+
+    void update_lazy_pending() {
+        lazy_pending.store(!lazy_attrs.empty(), std::memory_order_release);
+    }
+
+    template <class F>
+    decltype(auto) locked_if_lazy(F &&f) const {
+        if (!lazy_pending.load(std::memory_order_acquire))
+            return f();
+        std::lock_guard<std::recursive_mutex> lck(lazy_mtx);
+        return f();
+    }
 
+public:
     AttrVector() = default;
     AttrVector(std::vector<ValT> const &values_) : values(values_) {}
     AttrVector(std::vector<ValT> &&values_) : values(std::move(values_)) {}
     explicit AttrVector(size_t size) : values(size) {}
 
+    AttrVector(AttrVector const &other) : values(other.values) {
+        other.locked_if_lazy([&] {
+            attrs = other.attrs;
+            lazy_attrs = other.lazy_attrs;
+        });
+        update_lazy_pending();
+    }
+
+    AttrVector(AttrVector &&other)
+        : values(std::move(other.values)), attrs(std::move(other.attrs)), lazy_attrs(std::move(other.lazy_attrs)) {
+        update_lazy_pending();
+        other.update_lazy_pending();
+    }
+
+    AttrVector &operator=(AttrVector const &other) {
+        if (this != &other) {
+            values = other.values;
+            other.locked_if_lazy([&] {
+                attrs = other.attrs;
+                lazy_attrs = other.lazy_attrs;
+            });
+            update_lazy_pending();
+        }
+        return *this;
+    }
+
+    AttrVector &operator=(AttrVector &&other) {
+        if (this != &other) {
+            values = std::move(other.values);
+            attrs = std::move(other.attrs);
+            lazy_attrs = std::move(other.lazy_attrs);
+            update_lazy_pending();
+            other.update_lazy_pending();
+        }
+        return *this;
+    }
+
     decltype(auto) begin() const {
         return values.begin();
     }
@@ -136,7 +219,8 @@ struct AttrVector {
             f(values);
             return;
         }
-        auto it = attrs.find(name);
+        expand_attr(name);
+        auto it = locked_if_lazy([&] { return attrs.find(name); });
         if (it == attrs.end())
             throw makeError<KeyError>(name, "attribute name of primitive");
         std::visit([&] (auto &arr) {
@@ -155,7 +239,8 @@ struct AttrVector {
                 return;
             }
         }
-        auto it = attrs.find(name);
+        expand_attr(name);
+        auto it = locked_if_lazy([&] { return attrs.find(name); });
         if (it == attrs.end())
             throw makeError<KeyError>(name, "attribute name of primitive");
         std::visit([&] (auto &arr) {
@@ -168,6 +253,7 @@ struct AttrVector {
 
     template <class Accept = std::variant<vec3f, float>, class F>
     void foreach_attr(F &&f) const {
+        expand_attrs();
         for (auto const &[key, arr]: attrs) {
             auto const &k = key;
             std::visit([&] (auto &arr) {
@@ -181,6 +267,7 @@ struct AttrVector {
 
     template <class Accept = std::variant<vec3f, float>, class F>
     void foreach_attr(F &&f) {
+        expand_attrs();
         for (auto &[key, arr]: attrs) {
             auto const &k = key;
             std::visit([&] (auto &arr) {
@@ -194,6 +281,7 @@ struct AttrVector {
 
     template <class Accept = std::variant<vec3f, float>, class F>
     void forall_attr(F &&f) const {
+        expand_attrs();
         f(kpos, values);
         for (auto const &[key, arr]: attrs) {
             auto const &k = key;
@@ -208,6 +296,7 @@ struct AttrVector {
 
     template <class Accept = std::variant<vec3f, float>, class F>
     void forall_attr(F &&f) {
+        expand_attrs();
         f(kpos, values);
         for (auto &[key, arr]: attrs) {
             auto const &k = key;
@@ -284,25 +373,83 @@ struct AttrVector {
 #endif
     */
 
+    // visits the arrays as fa(key, arr) and the uniform attributes which are
+    // not expanded yet as fu(key, value), so that they can be handled by their
+    // value; computed attributes are expanded first and visited as arrays.
+    // the lazy lock is held during the visit, fa and fu must not expand
+    template <class Accept = std::variant<vec3f, float>, class FA, class FU>
+    void foreach_attr_or_uniform(FA &&fa, FU &&fu) const {
+        locked_if_lazy([&] {
+            std::vector<std::string> computed;
+            for (auto const &[key, lazy]: lazy_attrs) {
+                if (std::visit([] (auto &lazy) { return (bool)lazy.fill; }, lazy))
+                    computed.push_back(key);
+            }
+            for (auto const &key: computed)
+                expand_attr(key);
+            for (auto const &[key, arr]: attrs) {
+                std::visit([&] (auto &arr) {
+                    using T = std::decay_t<decltype(arr[0])>;
+                    if constexpr (variant_contains<T, Accept>::value) {
+                        fa(key, arr);
+                    }
+                }, arr);
+            }
+            for (auto const &[key, lazy]: lazy_attrs) {
+                if (attrs.find(key) != attrs.end())
+                    continue;
+                std::visit([&] (auto &lazy) {
+                    using T = decltype(lazy.value);
+                    if constexpr (variant_contains<T, Accept>::value) {
+                        fu(key, lazy.value);
+                    }
+                }, lazy);
+            }
+        });
+    }
+
+    // visits the name of every attribute the Accept types, without expanding
+    // the lazy ones
+    template <class Accept = std::variant<vec3f, float>, class F>
+    void foreach_attr_key(F &&f) const {
+        locked_if_lazy([&] {
+            for (auto const &[key, arr]: attrs) {
+                std::visit([&] (auto &arr) {
+                    using T = std::decay_t<decltype(arr[0])>;
+                    if constexpr (variant_contains<T, Accept>::value) {
+                        f(key);
+                    }
+                }, arr);
+            }
+            for (auto const &[key, lazy]: lazy_attrs) {
+                if (attrs.find(key) != attrs.end())
+                    continue;
+                std::visit([&] (auto &lazy) {
+                    using T = decltype(lazy.value);
+                    if constexpr (variant_contains<T, Accept>::value) {
+                        f(key);
+                    }
+                }, lazy);
+            }
+        });
+    }
+
     template <class Accept = std::variant<vec3f, float>>
     size_t num_attrs() const {
-        if constexpr (std::is_same_v<Accept, AttrAcceptAll>) {
-            return attrs.size();
-        } else {
-            size_t count = 0;
-            foreach_attr<Accept>([&] (auto const &key, auto const &arr) {
-                count++;
-            });
-            return count;
-        }
+        size_t count = 0;
+        foreach_attr_key<Accept>([&] (auto const &key) {
+            count++;
+        });
+        return count;
     }
 
     template <class Accept = std::variant<vec3f, float>>
     auto attr_keys() const {
         std::vector<std::string> keys;
-        foreach_attr<Accept>([&] (auto const &key, auto const &arr) {
+        foreach_attr_key<Accept>([&] (auto const &key) {
             keys.push_back(key);
         });
+        std::sort(keys.begin(), keys.end());
         return keys;
     }
 
@@ -313,19 +460,86 @@ struct AttrVector {
 
     template <class T>
     auto &add_attr(std::string const &name) {
-        if (!attr_is<T>(name))
+        if (!attr_is<T>(name)) {
+            lazy_attrs.erase(name);
+            update_lazy_pending();
             attrs[name] = std::vector<T>(size());
+        }
         return attr<T>(name);
     }
 
     // deprecated:
     template <class T>
     auto &add_attr(std::string const &name, T const &val) {
-        if (!attr_is<T>(name))
+        if (!attr_is<T>(name)) {
+            lazy_attrs.erase(name);
+            update_lazy_pending();
             attrs[name] = std::vector<T>(size(), val);
+        }
         return attr<T>(name);
     }
 
+    // sets the attribute to value everywhere, taking no memory until an array
+    // of it is asked for; it keeps the value for elements added by resize
+    template <class T>
+    void set_uniform_attr(std::string const &name, T const &value) {
+        if (name == "pos") {
+            auto &arr = attr<T>(name);
+            std::fill(arr.begin(), arr.end(), value);
+            return;
+        }
+        attrs.erase(name);
+        lazy_attrs[name] = LazyAttr<T>{value, {}};
+        update_lazy_pending();
+    }
+
+    // fill(*this, arr) is called on the first access to the attribute, with
+    // arr sized to the element count of that time; it runs under the lazy
+    // lock and may read other attributes of this AttrVector
+    template <class T, class F>
+    void set_computed_attr(std::string const &name, F &&fill) {
+        if (name == "pos") {
+            if constexpr (!std::is_same_v<T, ValT>) {
+                throw makeError<TypeError>(typeid(T), typeid(ValT), "type of primitive attribute pos");
+            } else {
+                fill(*this, values);
+                return;
+            }
+        }
+        attrs.erase(name);
+        lazy_attrs[name] = LazyAttr<T>{T{}, std::forward<F>(fill)};
+        update_lazy_pending();
+    }
+
+    // lazy attributes are expanded in const accessors too, under the lazy lock
+    void expand_attr(std::string const &name) const {
+        if (!lazy_pending.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::recursive_mutex> lck(lazy_mtx);
+        auto self = const_cast<AttrVector *>(this);
+        auto node = self->lazy_attrs.extract(name);
+        if (!node.empty() && attrs.find(node.key()) == attrs.end()) {
+            std::visit([&] (auto &lazy) {
+                using T = decltype(lazy.value);
+                std::vector<T> arr(size(), lazy.value);
+                if (lazy.fill)
+                    lazy.fill(*this, arr);
+                self->attrs[node.key()] = std::move(arr);
+            }, node.mapped());
+        }
+        self->update_lazy_pending();
+    }
+
+    void expand_attrs() const {
+        if (!lazy_pending.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::recursive_mutex> lck(lazy_mtx);
+        while (!lazy_attrs.empty()) {
+            std::string name = lazy_attrs.begin()->first;
+            expand_attr(name);
+        }
+    }
+
     //template <class T>
     //auto &add_attr(std::string const &name, T const &value) {
         //if (!attr_is<T>(name))
@@ -373,7 +587,8 @@ struct AttrVector {
         //attr<vec3f>("clr").emplace_back(val)
         //attr<vec3f>("pos").emplace_back(val)<---this will resize "clr" to zero first and then push_back to "pos"
         //_ensure_update();
-        auto it = attrs.find(name);
+        expand_attr(name);
+        auto it = locked_if_lazy([&] { return attrs.find(name); });
         if (it == attrs.end())
             throw makeError<KeyError>(name, "attribute name of primitive");
         return it->second;
@@ -382,7 +597,8 @@ struct AttrVector {
     // deprecated:
     auto &attr(std::string const &name) {
         //_ensure_update();
-        auto it = attrs.find(name);
+        expand_attr(name);
+        auto it = locked_if_lazy([&] { return attrs.find(name); });
         if (it == attrs.end())
             throw makeError<KeyError>(name, "attribute name of primitive");
         return it->second;
@@ -390,22 +606,33 @@ struct AttrVector {
 
     bool has_attr(std::string const &name) const {
         if (name == "pos") return true;
-        return attrs.find(name) != attrs.end();
+        return locked_if_lazy([&] {
+            return attrs.find(name) != attrs.end() || lazy_attrs.find(name) != lazy_attrs.end();
+        });
     }
 
     void erase_attr(std::string const &name) {
         attrs.erase(name);
+        lazy_attrs.erase(name);
+        update_lazy_pending();
     }
 
     template <class T>
     bool attr_is(std::string const &name) const {
         if (name == "pos") return std::is_same_v<T, ValT>;
-        auto it = attrs.find(name);
-        return it != attrs.end() && std::holds_alternative<std::vector<T>>(it->second);
+        return locked_if_lazy([&] {
+            auto it = attrs.find(name);
+            if (it != attrs.end())
+                return std::holds_alternative<std::vector<T>>(it->second);
+            auto lit = lazy_attrs.find(name);
+            return lit != lazy_attrs.end() && std::holds_alternative<LazyAttr<T>>(lit->second);
+        });
     }
 
     void clear_attrs() {
         attrs.clear();
+        lazy_attrs.clear();
+        update_lazy_pending();
     }
 
     size_t size() const {
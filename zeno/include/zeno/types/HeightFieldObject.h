@@ -0,0 +1,50 @@
+#pragma once
+
+#include <zeno/core/IObject.h>
+#include <zeno/utils/Error.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace zeno {
+
+// dense nx * nz grid of float layers, cell (x, z) at index z * nx + x, the
+// same layout as the verts of a 2D grid PrimitiveObject, so that layers can
+// be swapped with its vertex attributes without copying
+struct HeightFieldObject : IObjectClone<HeightFieldObject> {
+    int nx = 0;
+    int nz = 0;
+    float cellSize = 1.0f;
+    std::map<std::string, std::vector<float>> layers;
+
+    size_t size() const {
+        return (size_t)nx * nz;
+    }
+
+    bool has_layer(std::string const &name) const {
+        return layers.find(name) != layers.end();
+    }
+
+    std::vector<float> &layer(std::string const &name) {
+        auto it = layers.find(name);
+        if (it == layers.end())
+            throw makeError<KeyError>(name, "layer name of height field");
+        return it->second;
+    }
+
+    std::vector<float> const &layer(std::string const &name) const {
+        auto it = layers.find(name);
+        if (it == layers.end())
+            throw makeError<KeyError>(name, "layer name of height field");
+        return it->second;
+    }
+
+    std::vector<float> &add_layer(std::string const &name, float value = 0.0f) {
+        auto &arr = layers[name];
+        if (arr.size() != size())
+            arr.assign(size(), value);
+        return arr;
+    }
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zeno/core/IObject.h>
+#include <zeno/types/AttrVector.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -21,6 +22,10 @@ namespace zeno
         float deltaTime{0.0f};
         std::vector<std::vector<zeno::vec3f>> vertexFrameBuffer;
 
+        // optional per-instance attributes, e.g. the particles an instanced
+        // PrimDuplicate was made from; values hold the instance origins
+        AttrVector<zeno::vec3f> instAttrs;
+
         std::size_t serializeSize()
         {
             std::size_t size{0};
@@ -2,42 +2,145 @@
 
 #include <zeno/core/IObject.h>
 #include <zeno/funcs/LiterialConverter.h>
+#include <type_traits>
+#include <variant>
 #include <vector>
 #include <memory>
 
 namespace zeno {
 
 struct ListObject : IObjectClone<ListObject> {
-  std::vector<zany> arr;
+  // a list of plain numbers may be stored as one contiguous array instead of
+  // a NumericObject per element; size(), at() and get2() read it as is, while
+  // arr(), get() and getRaw() box it into element objects first
+  using ColumnVariant = std::variant<std::monostate,
+        std::vector<float>, std::vector<int>, std::vector<vec3f>>;
+
+  template <class T>
+  static constexpr bool is_column_type = std::is_same_v<T, float>
+      || std::is_same_v<T, int> || std::is_same_v<T, vec3f>;
 
   ListObject() = default;
 
-  explicit ListObject(std::vector<zany> arrin) : arr(std::move(arrin)) {
+  explicit ListObject(std::vector<zany> arrin) : m_arr(std::move(arrin)) {
+  }
+
+  template <class T, std::enable_if_t<is_column_type<T>, int> = 0>
+  explicit ListObject(std::vector<T> colin) : m_column(std::move(colin)) {
+  }
+
+  bool is_column() const {
+      return m_column.index() != 0;
+  }
+
+  template <class T>
+  std::vector<T> *get_column() {
+      return std::get_if<std::vector<T>>(&m_column);
+  }
+
+  template <class T>
+  std::vector<T> const *get_column() const {
+      return std::get_if<std::vector<T>>(&m_column);
+  }
+
+  template <class T, std::enable_if_t<is_column_type<T>, int> = 0>
+  void set_column(std::vector<T> col) {
+      m_arr.clear();
+      m_column = std::move(col);
+  }
+
+  ColumnVariant const &column() const {
+      return m_column;
+  }
+
+  // the element objects, to modify the list or edit its elements in place
+  std::vector<zany> &arr() {
+      expand();
+      return m_arr;
+  }
+
+  // boxes a numeric column into element objects, so that the elements handed
+  // out by at() are the stored ones and edits to them are kept
+  void expand() {
+      if (!is_column())
+          return;
+      std::visit([&] (auto &col) {
+          if constexpr (!std::is_same_v<std::decay_t<decltype(col)>, std::monostate>) {
+              m_arr.resize(col.size());
+              for (std::size_t i = 0; i < col.size(); i++)
+                  m_arr[i] = std::make_shared<NumericObject>(col[i]);
+          }
+      }, m_column);
+      m_column = std::monostate{};
+  }
+
+  std::size_t size() const {
+      return std::visit([&] (auto const &col) -> std::size_t {
+          if constexpr (std::is_same_v<std::decay_t<decltype(col)>, std::monostate>)
+              return m_arr.size();
+          else
+              return col.size();
+      }, m_column);
+  }
+
+  // element i, a column element is boxed into a fresh NumericObject, which is
+  // a copy: expand() first to edit the elements in place
+  zany at(std::size_t i) const {
+      return std::visit([&] (auto const &col) -> zany {
+          if constexpr (std::is_same_v<std::decay_t<decltype(col)>, std::monostate>)
+              return m_arr[i];
+          else
+              return std::make_shared<NumericObject>(col[i]);
+      }, m_column);
   }
 
   template <class T = IObject>
-  std::vector<std::shared_ptr<T>> get() const {
+  std::vector<std::shared_ptr<T>> get() {
+      expand();
       std::vector<std::shared_ptr<T>> res;
-      for (auto const &val: arr) {
+      for (auto const &val: m_arr) {
           res.push_back(safe_dynamic_cast<T>(val));
       }
       return res;
   }
 
   template <class T = IObject>
-  std::vector<T *> getRaw() const {
+  std::vector<T *> getRaw() {
+      expand();
       std::vector<T *> res;
-      for (auto const &val: arr) {
+      for (auto const &val: m_arr) {
           res.push_back(safe_dynamic_cast<T>(val.get()));
       }
       return res;
   }
 
+  template <class T>
+  T get2(std::size_t i) const {
+      return std::visit([&] (auto const &col) -> T {
+          using C = std::decay_t<decltype(col)>;
+          if constexpr (std::is_same_v<C, std::monostate>) {
+              return objectToLiterial<T>(m_arr[i]);
+          } else {
+              using T1 = typename C::value_type;
+              if constexpr (std::is_constructible_v<T, T1>) {
+                  return T(col[i]);
+              } else {
+                  throw makeError<TypeError>(typeid(T), typeid(T1), "ListObject::get2<T>");
+              }
+          }
+      }, m_column);
+  }
+
   template <class T>
   std::vector<T> get2() const {
+      if constexpr (is_column_type<T>) {
+          if (auto col = get_column<T>())
+              return *col;
+      }
       std::vector<T> res;
-      for (auto const &val: arr) {
-          res.push_back(objectToLiterial<T>(val));
+      res.reserve(size());
+      for (std::size_t i = 0; i < size(); i++) {
+          res.push_back(get2<T>(i));
       }
       return res;
   }
@@ -47,6 +150,10 @@ struct ListObject : IObjectClone<ListObject> {
   std::vector<T> getLiterial() const {
       return get2<T>();
   }
+
+private:
+  std::vector<zany> m_arr;
+  ColumnVariant m_column;
 };
 
 }
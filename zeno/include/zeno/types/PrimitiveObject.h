@@ -15,6 +15,7 @@ namespace zeno {
 
 struct MaterialObject;
 struct InstancingObject;
+struct PrimitiveVertexCorners;
 /*
     Assuming points {p_i}, 0<=i<n, forms a counterclockwise polygon,
     compute the sum of the cross product of every triangle of a triangle
@@ -143,6 +144,10 @@ struct PrimitiveObject : IObjectClone<PrimitiveObject> {
     std::shared_ptr<MaterialObject> mtl;
     std::shared_ptr<InstancingObject> inst;
 
+    // vertex -> face corner adjacency left by primCalcNormal for the next
+    // call, checked against the topology before reuse and never serialized
+    std::shared_ptr<PrimitiveVertexCorners const> vertCorners;
+
     // deprecated:
     template <class Accept = std::variant<vec3f, float>, class F>
     void foreach_attr(F &&f) {
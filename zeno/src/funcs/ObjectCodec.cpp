@@ -24,9 +24,17 @@ enum class ObjectType : int32_t {
 #undef _PER_OBJECT_TYPE
 
 struct ObjectHeader {
-    constexpr static uint32_t kMagicNumber = 0xc0febabe;
+    // 0xc0febabe was the unversioned layout, any data with it is rejected
+    constexpr static uint32_t kMagicNumber = 0xc0febabf;
+    // bump whenever the encoding of any object type changes
+    //   1: PrimitiveObject arrays encoded into one preallocated buffer
+    //   2: uniform PrimitiveObject attributes stored by their value
+    //   3: ListObject numeric columns, tagged in the top byte of the size
+    //   4: instance table of PrimitiveObject after its material
+    constexpr static uint32_t kVersion = 4;
 
     uint32_t magicNumber;
+    uint32_t version;
     ObjectType type;
     size_t numUserData;
     size_t beginUserData;
@@ -39,7 +47,7 @@ namespace _implObjectCodec {
 
 #define _PER_OBJECT_TYPE(TypeName, ...) \
 std::shared_ptr<TypeName> decode##TypeName(const char *it); \
-bool encode##TypeName(TypeName const *obj, std::back_insert_iterator<std::vector<char>> it);
+bool encode##TypeName(TypeName const *obj, std::vector<char> &buf);
 ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
 #undef _PER_OBJECT_TYPE
 
@@ -70,11 +78,19 @@ ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
 }
 
 std::shared_ptr<IObject> decodeObject(const char *buf, size_t len) {
+    if (len < sizeof(ObjectHeader)) {
+        log_error("data too short, giving up");
+        return nullptr;
+    }
     auto &header = *(ObjectHeader *)buf;
     if (header.magicNumber != ObjectHeader::kMagicNumber) {
         log_error("object header magic number mismatch");
         return nullptr;
     }
+    if (header.version != ObjectHeader::kVersion) {
+        log_error("object encoded with version {}, expected version {}", header.version, ObjectHeader::kVersion);
+        return nullptr;
+    }
 
     auto object = _decodeObjectImpl(buf, len);
 
@@ -104,6 +120,7 @@ static bool _encodeObjectImpl(IObject const *object, std::vector<char> &buf) {
     auto it = std::back_inserter(buf);
     ObjectHeader header;
     header.magicNumber = ObjectHeader::kMagicNumber;
+    header.version = ObjectHeader::kVersion;
 
     if (0) {
 
@@ -111,7 +128,7 @@ static bool _encodeObjectImpl(IObject const *object, std::vector<char> &buf) {
     } else if (auto obj = dynamic_cast<TypeName const *>(object)) { \
         header.type = ObjectType::TypeName; \
         it = std::copy_n((char *)&header, sizeof(ObjectHeader), it); \
-        return encode##TypeName(obj, it);
+        return encode##TypeName(obj, buf);
 ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
 #undef _PER_OBJECT_TYPE
 
@@ -8,48 +8,90 @@ namespace zeno {
 
 namespace _implObjectCodec {
 
+// the element count of a list takes the low bits of its size field, a
+// non-zero value above them marks a numeric column: 1 float, 2 int, 3 vec3f
+// (since ObjectHeader::kVersion 3, older data never has these bits set)
+static constexpr int kColumnShift = 56;
+
 std::shared_ptr<ListObject> decodeListObject(const char *it);
 std::shared_ptr<ListObject> decodeListObject(const char *it) {
     auto obj = std::make_shared<ListObject>();
 
-    size_t size = *(int *)it;
+    size_t size = *(size_t *)it;
     it += sizeof(size);
 
+    if (size_t kind = size >> kColumnShift) {
+        size &= ((size_t)1 << kColumnShift) - 1;
+        auto decodeColumn = [&] (auto &&col) {
+            col.resize(size);
+            std::memcpy(col.data(), it, sizeof(col[0]) * size);
+            obj->set_column(std::move(col));
+        };
+        if (kind == 1) {
+            decodeColumn(std::vector<float>());
+        } else if (kind == 2) {
+            decodeColumn(std::vector<int>());
+        } else if (kind == 3) {
+            decodeColumn(std::vector<vec3f>());
+        } else {
+            log_error("invalid list column kind {}", kind);
+            return nullptr;
+        }
+        return obj;
+    }
+
     std::vector<size_t> tab(size * 2);
     std::memcpy(tab.data(), it, sizeof(size_t) * tab.size()); 
     it += sizeof(size_t) * tab.size();
 
-    obj->arr.resize(size);
+    auto &objs = obj->arr();
+    objs.resize(size);
     for (size_t i = 0; i < size; i++) {
         auto elm = decodeObject(it + tab[i * 2], tab[i * 2 + 1]);
         if (!elm) return nullptr;
-        obj->arr[i] = std::move(elm);
+        objs[i] = std::move(elm);
     }
 
     return obj;
 }
 
-bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
-    size_t size = obj->arr.size();
+bool encodeListObject(ListObject const *obj, std::vector<char> &buf);
+bool encodeListObject(ListObject const *obj, std::vector<char> &buf) {
+    auto it = std::back_inserter(buf);
+    if (obj->is_column()) {
+        // a numeric column is written as is, its kind in the top bits of size
+        std::visit([&] (auto const &col) {
+            using C = std::decay_t<decltype(col)>;
+            if constexpr (!std::is_same_v<C, std::monostate>) {
+                size_t kind = std::is_same_v<C, std::vector<float>> ? 1
+                    : std::is_same_v<C, std::vector<int>> ? 2 : 3;
+                size_t head = col.size() | kind << kColumnShift;
+                std::copy_n((char const *)&head, sizeof(head), it);
+                std::copy_n((char const *)col.data(), sizeof(col[0]) * col.size(), it);
+            }
+        }, obj->column());
+        return true;
+    }
+
+    size_t size = obj->size();
     std::copy_n((char const *)&size, sizeof(size), it);
 
-    std::vector<char> buf;
+    std::vector<char> elmbuf;
     std::vector<char> fin;
     std::vector<size_t> tab(size * 2);
     size_t base = 0;
     for (size_t i = 0; i < size; i++) {
-        auto const *elm = obj->arr[i].get();
-        if (!encodeObject(elm, buf))
+        auto elm = obj->at(i);
+        if (!encodeObject(elm.get(), elmbuf))
             return false;
-        size_t len = buf.size();
-        fin.insert(fin.end(), buf.begin(), buf.end());
-        buf.clear();
+        size_t len = elmbuf.size();
+        fin.insert(fin.end(), elmbuf.begin(), elmbuf.end());
+        elmbuf.clear();
         tab[i * 2] = base;
         tab[i * 2 + 1] = len;
         base += len;
     }
-    std::copy_n(tab.data(), tab.size() * sizeof(size_t), it);
+    std::copy_n((char const *)tab.data(), tab.size() * sizeof(size_t), it);
     std::copy(fin.begin(), fin.end(), it);
 
     return true;
@@ -1,10 +1,12 @@
 #include <zeno/funcs/ObjectCodec.h>
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/types/MaterialObject.h>
+#include <zeno/types/InstancingObject.h>
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/log.h>
 //#include <zeno/utils/zeno_p.h>
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 namespace zeno {
 
@@ -12,62 +14,133 @@ namespace _implObjectCodec {
 
 namespace {
 
+// every array and name is padded to 8 bytes, so that the encoded size can be
+// computed up front and all arrays are written / read with one memcpy each
+constexpr size_t padded(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
 struct AttributeHeader {
-    size_t type;
+    uint32_t type;
+    uint32_t namelen;
     size_t size;
-    size_t namelen;
-    char name[128];
 };
 
+// set in AttributeHeader::type for a uniform attribute, which is stored as a
+// single value and decoded without being expanded
+constexpr uint32_t kUniformAttr = 0x80000000u;
+
 struct AttrVectorHeader {
     size_t size;
     size_t nattrs;
 };
 
-template <class T0, class It>
-void decodeAttrVector(AttrVector<T0> &arr, It &it) {
+// what is encoded for one attribute, gathered once so that the arrays and
+// uniform values sized up front are exactly the ones written afterwards
+struct EncodedAttr {
+    std::string key;
+    uint32_t type;
+    size_t size;
+    size_t nbytes;
+    const void *data;
+    alignas(16) char value[16];
+};
+
+template <class T>
+void decodeArray(std::vector<T> &arr, size_t size, const char *&it) {
+    arr.resize(size);
+    std::memcpy(arr.data(), it, sizeof(T) * size);
+    it += padded(sizeof(T) * size);
+}
+
+template <class T>
+void encodeArray(std::vector<T> const &arr, char *&it) {
+    std::memcpy(it, arr.data(), sizeof(T) * arr.size());
+    it += padded(sizeof(T) * arr.size());
+}
+
+template <class T0>
+std::vector<EncodedAttr> gatherAttrVector(AttrVector<T0> const &arr) {
+    std::vector<EncodedAttr> attrs;
+    arr.template foreach_attr_or_uniform<AttrAcceptAll>([&] (auto const &key, auto const &attr) {
+        using T = std::decay_t<decltype(attr[0])>;
+        auto &a = attrs.emplace_back();
+        a.key = key;
+        a.type = variant_index<AttrAcceptAll, T>::value;
+        a.size = attr.size();
+        a.nbytes = sizeof(T) * attr.size();
+        a.data = attr.data();
+    }, [&] (auto const &key, auto const &value) {
+        using T = std::decay_t<decltype(value)>;
+        static_assert(sizeof(T) <= sizeof(EncodedAttr::value));
+        auto &a = attrs.emplace_back();
+        a.key = key;
+        a.type = variant_index<AttrAcceptAll, T>::value | kUniformAttr;
+        a.size = 1;
+        a.nbytes = sizeof(T);
+        a.data = nullptr;
+        std::memcpy(a.value, &value, sizeof(T));
+    });
+    return attrs;
+}
+
+template <class T0>
+size_t encodedSizeAttrVector(AttrVector<T0> const &arr, std::vector<EncodedAttr> const &attrs) {
+    size_t n = sizeof(AttrVectorHeader) + padded(sizeof(T0) * arr.size());
+    for (auto const &a: attrs)
+        n += sizeof(AttributeHeader) + padded(a.key.size()) + padded(a.nbytes);
+    return n;
+}
+
+template <class T0>
+void decodeAttrVector(AttrVector<T0> &arr, const char *&it) {
     AttrVectorHeader header;
-    std::copy_n(it, sizeof(header), (char *)&header);
+    std::memcpy(&header, it, sizeof(header));
     it += sizeof(header);
-    arr.values.reserve(header.size);
-    std::copy_n((T0 const *)it, header.size, std::back_inserter(arr.values));
-    it += sizeof(T0) * header.size;
+    decodeArray(arr.values, header.size, it);
 
-    for (int a = 0; a < header.nattrs; a++) {
+    for (size_t a = 0; a < header.nattrs; a++) {
         AttributeHeader h;
-        std::copy_n(it, sizeof(h), (char *)&h);
+        std::memcpy(&h, it, sizeof(h));
         it += sizeof(h);
-        std::string key{h.name, h.namelen};
-        index_switch<std::variant_size_v<AttrAcceptAll>>((size_t)h.type, [&] (auto type) {
+        std::string key{it, h.namelen};
+        it += padded(h.namelen);
+        index_switch<std::variant_size_v<AttrAcceptAll>>((size_t)(h.type & ~kUniformAttr), [&] (auto type) {
             using T = std::variant_alternative_t<type.value, AttrAcceptAll>;
-            auto &attr = arr.template add_attr<T>(key);
-            attr.clear();
-            attr.reserve(h.size);
-            std::copy_n((T const *)it, h.size, std::back_inserter(attr));
-            it += sizeof(T) * h.size;
+            if (h.type & kUniformAttr) {
+                T value;
+                std::memcpy(&value, it, sizeof(T));
+                it += padded(sizeof(T));
+                arr.set_uniform_attr(key, value);
+            } else {
+                decodeArray(arr.template add_attr<T>(key), h.size, it);
+            }
         });
     }
     arr.update();
 }
 
-template <class T0, class It>
-void encodeAttrVector(AttrVector<T0> const &arr, It &it) {
+template <class T0>
+void encodeAttrVector(AttrVector<T0> const &arr, std::vector<EncodedAttr> const &attrs, char *&it) {
     AttrVectorHeader header;
     header.size = arr.size();
-    header.nattrs = arr.template num_attrs<AttrAcceptAll>();
-    it = std::copy_n((char const *)&header, sizeof(header), it);
-    it = std::copy_n((char const *)arr.data(), sizeof(T0) * arr.size(), it);
+    header.nattrs = attrs.size();
+    std::memcpy(it, &header, sizeof(header));
+    it += sizeof(header);
+    encodeArray(arr.values, it);
 
-    arr.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &attr) {
+    for (auto const &a: attrs) {
         AttributeHeader h;
-        using T = std::decay_t<decltype(attr[0])>;
-        h.type = variant_index<AttrAcceptAll, T>::value;
-        h.size = attr.size();
-        h.namelen = key.size();
-        std::strncpy(h.name, key.c_str(), sizeof(h.name));
-        it = std::copy_n((char const *)&h, sizeof(h), it);
-        it = std::copy_n((char const *)attr.data(), sizeof(T) * attr.size(), it);
-    });
+        h.type = a.type;
+        h.namelen = a.key.size();
+        h.size = a.size;
+        std::memcpy(it, &h, sizeof(h));
+        it += sizeof(h);
+        std::memcpy(it, a.key.data(), a.key.size());
+        it += padded(a.key.size());
+        std::memcpy(it, a.data ? a.data : a.value, a.nbytes);
+        it += padded(a.nbytes);
+    }
 }
 
 }
@@ -84,30 +157,85 @@ std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it) {
     decodeAttrVector(obj->polys, it);
     decodeAttrVector(obj->edges, it);
     decodeAttrVector(obj->uvs, it);
-    if (*it++ == '1') {
+    size_t mtlsize;
+    std::memcpy(&mtlsize, it, sizeof(mtlsize));
+    it += sizeof(mtlsize);
+    if (mtlsize) {
         obj->mtl = std::make_shared<MaterialObject>();
         obj->mtl->deserialize(it);
+        it += mtlsize;
+    }
+    size_t instsize;
+    std::memcpy(&instsize, it, sizeof(instsize));
+    it += sizeof(instsize);
+    if (instsize) {
+        obj->inst = std::make_shared<InstancingObject>(
+            InstancingObject::deserialize(std::vector<char>(it, it + instsize)));
+        it += padded(instsize);
+        decodeAttrVector(obj->inst->instAttrs, it);
     }
     return obj;
 }
 
-bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
-    encodeAttrVector(obj->verts, it);
-    encodeAttrVector(obj->points, it);
-    encodeAttrVector(obj->lines, it);
-    encodeAttrVector(obj->tris, it);
-    encodeAttrVector(obj->quads, it);
-    encodeAttrVector(obj->loops, it);
-    encodeAttrVector(obj->polys, it);
-    encodeAttrVector(obj->edges, it);
-    encodeAttrVector(obj->uvs, it);
+bool encodePrimitiveObject(PrimitiveObject const *obj, std::vector<char> &buf);
+bool encodePrimitiveObject(PrimitiveObject const *obj, std::vector<char> &buf) {
+    auto verts = gatherAttrVector(obj->verts);
+    auto points = gatherAttrVector(obj->points);
+    auto lines = gatherAttrVector(obj->lines);
+    auto tris = gatherAttrVector(obj->tris);
+    auto quads = gatherAttrVector(obj->quads);
+    auto loops = gatherAttrVector(obj->loops);
+    auto polys = gatherAttrVector(obj->polys);
+    auto edges = gatherAttrVector(obj->edges);
+    auto uvs = gatherAttrVector(obj->uvs);
+    size_t mtlsize = obj->mtl ? obj->mtl->serializeSize() : 0;
+    // the instance table of an instanced prim, its matrices in the layout of
+    // InstancingObject::serialize and the per-instance attributes after them
+    std::vector<char> instdata;
+    std::vector<EncodedAttr> instAttrs;
+    if (obj->inst) {
+        instdata = obj->inst->serialize();
+        instAttrs = gatherAttrVector(obj->inst->instAttrs);
+    }
+    size_t instsize = instdata.size();
+    size_t size = encodedSizeAttrVector(obj->verts, verts)
+        + encodedSizeAttrVector(obj->points, points)
+        + encodedSizeAttrVector(obj->lines, lines)
+        + encodedSizeAttrVector(obj->tris, tris)
+        + encodedSizeAttrVector(obj->quads, quads)
+        + encodedSizeAttrVector(obj->loops, loops)
+        + encodedSizeAttrVector(obj->polys, polys)
+        + encodedSizeAttrVector(obj->edges, edges)
+        + encodedSizeAttrVector(obj->uvs, uvs)
+        + sizeof(mtlsize) + mtlsize
+        + sizeof(instsize);
+    if (obj->inst)
+        size += padded(instsize) + encodedSizeAttrVector(obj->inst->instAttrs, instAttrs);
+
+    size_t base = buf.size();
+    buf.resize(base + size);
+    char *it = buf.data() + base;
+    encodeAttrVector(obj->verts, verts, it);
+    encodeAttrVector(obj->points, points, it);
+    encodeAttrVector(obj->lines, lines, it);
+    encodeAttrVector(obj->tris, tris, it);
+    encodeAttrVector(obj->quads, quads, it);
+    encodeAttrVector(obj->loops, loops, it);
+    encodeAttrVector(obj->polys, polys, it);
+    encodeAttrVector(obj->edges, edges, it);
+    encodeAttrVector(obj->uvs, uvs, it);
+    std::memcpy(it, &mtlsize, sizeof(mtlsize));
+    it += sizeof(mtlsize);
     if (obj->mtl) {
-        *it++ = '1';
-        for (char c: obj->mtl->serialize())
-            *it++ = c;
-    } else {
-        *it++ = '0';
+        obj->mtl->serialize(it);
+        it += mtlsize;
+    }
+    std::memcpy(it, &instsize, sizeof(instsize));
+    it += sizeof(instsize);
+    if (obj->inst) {
+        std::memcpy(it, instdata.data(), instsize);
+        it += padded(instsize);
+        encodeAttrVector(obj->inst->instAttrs, instAttrs, it);
     }
     return true;
 }
@@ -16,8 +16,9 @@ std::shared_ptr<MaterialObject> decodeMaterialObject(const char *it) {
     return mtl;
 }
 
-bool encodeMaterialObject(MaterialObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodeMaterialObject(MaterialObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
+bool encodeMaterialObject(MaterialObject const *obj, std::vector<char> &buf);
+bool encodeMaterialObject(MaterialObject const *obj, std::vector<char> &buf) {
+    auto it = std::back_inserter(buf);
     auto v = obj->serialize();
     std::copy(v.begin(), v.end(), it);
     return true;
@@ -28,8 +29,8 @@ std::shared_ptr<DummyObject> decodeDummyObject(const char *it) {
     return std::make_shared<DummyObject>();
 }
 
-bool encodeDummyObject(DummyObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodeDummyObject(DummyObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
+bool encodeDummyObject(DummyObject const *obj, std::vector<char> &buf);
+bool encodeDummyObject(DummyObject const *obj, std::vector<char> &buf) {
     return true;
 }
 
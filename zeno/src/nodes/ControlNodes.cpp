@@ -137,12 +137,15 @@ struct BeginForEach : IBeginFor {
     zany m_accumate;
 
     virtual bool isContinue() const override final {
-        return m_index < m_list->arr.size();
+        return m_index < m_list->size();
     }
 
     virtual void execute() override final {
         m_index = 0;
         m_list = get_input<zeno::ListObject>("list");
+        // the loop body may edit the elements in place, so a numeric column
+        // is boxed once here instead of handing out a fresh copy per element
+        m_list->expand();
         if (has_input("accumate"))
             m_accumate = get_input("accumate");
         set_output("FOR", std::make_shared<zeno::DummyObject>());
@@ -152,7 +155,7 @@ struct BeginForEach : IBeginFor {
         auto ret = std::make_shared<zeno::NumericObject>();
         ret->set(m_index);
         set_output("index", std::move(ret));
-        auto obj = m_list->arr[m_index];
+        auto obj = m_list->at(m_index);
         set_output("object", std::move(obj));
         m_index++;
         if (m_accumate)
@@ -186,13 +189,13 @@ struct EndForEach : EndFor {
         if (requireInput("list")) {
             if (accept) {
                 auto listObj = get_input<zeno::ListObject>("list");
-                for(auto obj : listObj->arr)
-                    result.push_back(std::move(obj));
+                for (size_t i = 0; i < listObj->size(); i++)
+                    result.push_back(listObj->at(i));
             }
             else{
                 auto listObj = get_input<zeno::ListObject>("list");
-                for(auto obj : listObj->arr)
-                    dropped_result.push_back(std::move(obj));
+                for (size_t i = 0; i < listObj->size(); i++)
+                    dropped_result.push_back(listObj->at(i));
             }
         }
         if (requireInput("accumate")) {
@@ -211,22 +214,22 @@ struct EndForEach : EndFor {
         if (get_param<bool>("doConcat")) {
             decltype(result) newres;
             for (auto &xs: result) {
-                for (auto &x: safe_dynamic_cast<ListObject>(xs, "do concat ")->arr)
-                    newres.push_back(std::move(x));
+                auto lst = safe_dynamic_cast<ListObject>(xs, "do concat ");
+                for (size_t i = 0; i < lst->size(); i++)
+                    newres.push_back(lst->at(i));
             }
             result = std::move(newres);
             decltype(dropped_result) dropped_newres;
             for (auto &xs: dropped_result) {
-                for (auto &x: safe_dynamic_cast<ListObject>(xs, "do concat ")->arr)
-                    dropped_newres.push_back(std::move(x));
+                auto lst = safe_dynamic_cast<ListObject>(xs, "do concat ");
+                for (size_t i = 0; i < lst->size(); i++)
+                    dropped_newres.push_back(lst->at(i));
             }
             dropped_result = std::move(dropped_newres);
         }
-        auto list = std::make_shared<ListObject>();
-        list->arr = std::move(result);
+        auto list = std::make_shared<ListObject>(std::move(result));
         set_output("list", std::move(list));
-        auto dropped_list = std::make_shared<ListObject>();
-        dropped_list->arr = std::move(dropped_result);
+        auto dropped_list = std::make_shared<ListObject>(std::move(dropped_result));
         set_output("droppedList", std::move(dropped_list));
 
         auto [sn, ss] = safe_at(inputBounds, "FOR", "input socket of EndForEach");
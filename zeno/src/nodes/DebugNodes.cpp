@@ -2,7 +2,18 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/utils/logger.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_reduce.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_sort.h>
+#include <zeno/para/thread_pool.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
 
 namespace {
 
@@ -196,6 +207,110 @@ ZENDEFNODE(TriggerViewportFault, {
     {"debug"},
 });
 
+// times the serial algorithms, the built-in pool and, when zeno is built with
+// ZENO_PARALLEL_STL, the standard parallel algorithms on the same input
+struct BenchmarkParallel : zeno::INode {
+    virtual void apply() override {
+        auto count = (size_t)std::max(1, get_input2<int>("count"));
+        using clock = std::chrono::steady_clock;
+        auto seconds = [] (clock::time_point t0, clock::time_point t1) {
+            return std::chrono::duration<float>(t1 - t0).count();
+        };
+        auto timeit = [&] (auto &&fn) {
+            auto t0 = clock::now();
+            fn();
+            return seconds(t0, clock::now());
+        };
+#ifdef ZENO_PARALLEL_STL
+        auto pstl = [&] (auto &&fn) {
+            return std::to_string(timeit(fn)) + "s";
+        };
+#else
+        auto pstl = [&] (auto &&) {
+            return std::string("n/a");
+        };
+#endif
+
+        std::vector<float> arr(count), out(count);
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<float> unif;
+        for (auto &x: arr)
+            x = unif(gen);
+        auto kernel = [] (float x) {
+            return std::sqrt(x) * std::sin(x);
+        };
+
+        zeno::log_info("BenchmarkParallel {} elements, {} threads", count, zeno::thread_pool_size());
+#ifndef ZENO_PARALLEL_STL
+        zeno::log_info("  pstl columns need a build with ZENO_PARALLEL_STL");
+#endif
+
+        auto seqFor = timeit([&] {
+            for (size_t i = 0; i < count; i++)
+                out[i] = kernel(arr[i]);
+        });
+        auto poolFor = timeit([&] {
+            zeno::parallel_chunks(count, 0, [&] (size_t b, size_t e) {
+                for (size_t i = b; i < e; i++)
+                    out[i] = kernel(arr[i]);
+            });
+        });
+        auto pstlFor = pstl([&] {
+            ZENO_POL(std::transform(std::execution::par_unseq, arr.begin(), arr.end(), out.begin(), kernel));
+        });
+        zeno::log_info("  for:    seq {}s pool {}s pstl {}", seqFor, poolFor, pstlFor);
+
+        double seqSum = 0, poolSum = 0;
+        auto seqReduce = timeit([&] {
+            seqSum = std::accumulate(arr.begin(), arr.end(), 0.0);
+        });
+        auto poolReduce = timeit([&] {
+            poolSum = zeno::parallel_reduce_chunks(count, 0.0, std::plus<double>(), [&] (size_t i) {
+                return (double)arr[i];
+            });
+        });
+        auto pstlReduce = pstl([&] {
+            ZENO_POL(std::transform_reduce(std::execution::par_unseq, arr.begin(), arr.end(), 0.0,
+                                           std::plus<double>(), [] (float x) { return (double)x; }));
+        });
+        zeno::log_info("  reduce: seq {}s pool {}s pstl {} (sum {} vs {})", seqReduce, poolReduce, pstlReduce,
+                       seqSum, poolSum);
+
+        auto seqScan = timeit([&] {
+            std::partial_sum(arr.begin(), arr.end(), out.begin());
+        });
+        auto poolScan = timeit([&] {
+            zeno::parallel_scan_chunks(count, out.begin(), 0.f, std::plus<float>(), [&] (size_t i) {
+                return arr[i];
+            }, true);
+        });
+        auto pstlScan = pstl([&] {
+            ZENO_POL(std::inclusive_scan(std::execution::par_unseq, arr.begin(), arr.end(), out.begin()));
+        });
+        zeno::log_info("  scan:   seq {}s pool {}s pstl {}", seqScan, poolScan, pstlScan);
+
+        auto seqSorted = arr, poolSorted = arr, pstlSorted = arr;
+        auto seqSort = timeit([&] {
+            std::sort(seqSorted.begin(), seqSorted.end(), std::less<float>());
+        });
+        auto poolSort = timeit([&] {
+            zeno::parallel_sort_chunks(poolSorted.begin(), poolSorted.end(), std::less<float>());
+        });
+        auto pstlSort = pstl([&] {
+            ZENO_POL(std::sort(std::execution::par_unseq, pstlSorted.begin(), pstlSorted.end(), std::less<float>()));
+        });
+        zeno::log_info("  sort:   seq {}s pool {}s pstl {} (same result: {})", seqSort, poolSort, pstlSort,
+                       seqSorted == poolSorted);
+    }
+};
+
+ZENDEFNODE(BenchmarkParallel, {
+    {{"int", "count", "10000000"}},
+    {},
+    {},
+    {"debug"},
+});
+
 struct Blackboard : zeno::INode {
     virtual void apply() override {
     }
@@ -11,7 +11,7 @@ struct ListLength : zeno::INode {
     virtual void apply() override {
         auto list = get_input<zeno::ListObject>("list");
         auto ret = std::make_shared<zeno::NumericObject>();
-        ret->set<int>(list->arr.size());
+        ret->set<int>(list->size());
         set_output("length", std::move(ret));
     }
 };
@@ -35,9 +35,9 @@ struct ListGetItem : zeno::INode {
             set_output("object", std::move(obj));
         } else {
             auto list = get_input<zeno::ListObject>("list");
-            if (index < 0 || index >= list->arr.size())
-                throw makeError<IndexError>(index, list->arr.size(), "ListGetItem");
-            auto obj = list->arr[index];
+            if (index < 0 || index >= list->size())
+                throw makeError<IndexError>(index, list->size(), "ListGetItem");
+            auto obj = list->at(index);
             set_output("object", std::move(obj));
         }
     }
@@ -57,8 +57,8 @@ struct ExtractList : zeno::INode {
         auto list = get_input<zeno::ListObject>("list");
         for (auto const& key : keys) {
             int index = std::stoi(key);
-            if (list->arr.size() > index) {
-                auto obj = list->arr[index];
+            if (list->size() > index) {
+                auto obj = list->at(index);
                 set_output(key, std::move(obj));
             }
         }
@@ -91,7 +91,7 @@ struct AppendList : zeno::INode {
     virtual void apply() override {
         auto list = get_input<zeno::ListObject>("list");
         auto obj = get_input("object");
-        list->arr.push_back(std::move(obj));
+        list->arr().push_back(std::move(obj));
         set_output("list", get_input("list"));
     }
 };
@@ -107,8 +107,8 @@ struct ExtendList : zeno::INode {
     virtual void apply() override {
         auto list1 = get_input<zeno::ListObject>("list1");
         auto list2 = get_input<zeno::ListObject>("list2");
-        for (auto const &ptr: list2->arr) {
-            list1->arr.push_back(ptr);
+        for (size_t i = 0; i < list2->size(); i++) {
+            list1->arr().push_back(list2->at(i));
         }
         set_output("list1", std::move(list1));
     }
@@ -126,7 +126,7 @@ struct ResizeList : zeno::INode {
     virtual void apply() override {
         auto list = get_input<zeno::ListObject>("list");
         auto newSize = get_input<zeno::NumericObject>("newSize")->get<int>();
-        list->arr.resize(newSize);
+        list->arr().resize(newSize);
         set_output("list", std::move(list));
     }
 };
@@ -150,12 +150,12 @@ struct MakeSmallList : zeno::INode {
             if (!has_input(name)) break;
             if (doConcat && has_input<ListObject>(name)) {
                 auto objlist = get_input<ListObject>(name);
-                for (auto const &obj: objlist->arr) {
-                    list->arr.push_back(std::move(obj));
+                for (size_t i = 0; i < objlist->size(); i++) {
+                    list->arr().push_back(objlist->at(i));
                 }
             } else {
                 auto obj = get_input(name);
-                list->arr.push_back(std::move(obj));
+                list->arr().push_back(std::move(obj));
             }
         }
         set_output("list", std::move(list));
@@ -185,7 +185,7 @@ struct MakeList : zeno::INode {
             auto name = namess.str();
             if (!has_input(name)) continue;
             auto obj = get_input(name);
-            list->arr.push_back(std::move(obj));
+            list->arr().push_back(std::move(obj));
         }
         set_output("list", std::move(list));
     }
@@ -201,13 +201,14 @@ ZENDEFNODE(MakeList, {
 
 struct NumericRangeList : zeno::INode {
     virtual void apply() override {
-        auto list = std::make_shared<zeno::ListObject>();
         auto start = get_input2<int>("start");
         auto end = get_input2<int>("end");
         auto skip = get_input2<int>("skip");
+        std::vector<int> range;
         for (int i = start; i < end; i += skip) {
-            list->arr.emplace_back(std::make_shared<NumericObject>(i));
+            range.push_back(i);
         }
+        auto list = std::make_shared<zeno::ListObject>(std::move(range));
         set_output("list", std::move(list));
     }
 };
@@ -241,8 +242,8 @@ struct ToVisualize_ListObject : zeno::INode {
     virtual void apply() override {
         auto list = get_input<ListObject>("list");
         auto path = get_param<std::string>("path");
-        for (int i = 0; i < list->arr.size(); i++) {
-            auto const &obj = list->arr[i];
+        for (int i = 0; i < list->arr().size(); i++) {
+            auto const &obj = list->arr()[i];
             std::stringstream ss;
             ss << path << "." << i;
             if (auto o = silent_any_cast<std::shared_ptr<IObject>>(obj); o.has_value()) {
@@ -25,9 +25,9 @@ struct ToView : zeno::INode {
         //auto pp = isStatic && hasViewed ? std::make_shared<DummyObject>() : p->clone();
         auto addtoview = [&] (auto const &addtoview, zany const &p, std::string const &postfix) -> void {
             if (auto *lst = dynamic_cast<ListObject *>(p.get())) {
-                log_info("ToView got ListObject (size={}), expanding", lst->arr.size());
-                for (size_t i = 0; i < lst->arr.size(); i++) {
-                    zany const &lp = lst->arr[i];
+                log_info("ToView got ListObject (size={}), expanding", lst->size());
+                for (size_t i = 0; i < lst->size(); i++) {
+                    zany lp = lst->at(i);
                     addtoview(addtoview, lp, postfix + ":LIST" + std::to_string(i));
                 }
                 return;
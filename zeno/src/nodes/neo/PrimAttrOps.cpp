@@ -18,11 +18,7 @@ struct PrimFillAttr : INode {
         auto type = get_input2<std::string>("type");
         std::visit([&] (auto ty) {
             using T = decltype(ty);
-            auto &arr = prim->verts.add_attr<T>(attr);
-            auto val = value->get<T>();
-            for (size_t i = 0; i < arr.size(); i++) {
-                arr[i] = val;
-            }
+            prim->verts.set_uniform_attr(attr, value->get<T>());
         }, enum_variant<std::variant<
             float, vec3f, int
         >>(array_index({
@@ -80,7 +76,7 @@ struct PrimFloatAttrToInt : INode {
             parallel_for(inArr.size(), [&] (size_t i) {
                 outArr[i] = std::rint(inArr[i] * factor);
             });
-            prim->verts.attrs.erase(attrOut);
+            prim->verts.erase_attr(attrOut);
             prim->verts.add_attr<int>(attrOut) = std::move(outArr);
         } else {
             auto &outArr = prim->verts.add_attr<int>(attrOut);
@@ -120,7 +116,7 @@ struct PrimIntAttrToFloat : INode {
             parallel_for(inArr.size(), [&] (size_t i) {
                 outArr[i] = float(inArr[i]) * factor;
             });
-            prim->verts.attrs.erase(attrOut);
+            prim->verts.erase_attr(attrOut);
             prim->verts.add_attr<float>(attrOut) = std::move(outArr);
         } else {
             auto &outArr = prim->verts.add_attr<float>(attrOut);
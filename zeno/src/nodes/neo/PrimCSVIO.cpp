@@ -2,66 +2,131 @@
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
+#include <zeno/para/parallel_for.h>
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/arrayindex.h>
 #include <zeno/utils/string.h>
+#include <zeno/utils/Error.h>
 #include <zeno/utils/log.h>
 #include <zeno/utils/vec.h>
-#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 
 namespace zeno {
 namespace {
 
-static void dump(int const &v, std::ostream &fout) {
-    fout << v;
+// shortest text that reads back to the same value, at most 15 chars for a
+// float and 11 for an int
+static char *dump(int const &v, char *p) {
+    return std::to_chars(p, p + 11, v).ptr;
 }
 
-static void dump(float const &v, std::ostream &fout) {
-    fout << v;
+static char *dump(float const &v, char *p) {
+    return std::to_chars(p, p + 15, v).ptr;
 }
 
 template <size_t N, class T>
-static void dump(vec<N, T> const &v, std::ostream &fout) {
-    fout << v[0];
-    for (int i = 1; i < N; i++)
-        fout << ' ' << v[i];
+static char *dump(vec<N, T> const &v, char *p) {
+    p = dump(v[0], p);
+    for (int i = 1; i < N; i++) {
+        *p++ = ' ';
+        p = dump(v[i], p);
+    }
+    return p;
+}
+
+template <class T>
+static constexpr size_t max_dump_size() {
+    if constexpr (std::is_same_v<T, int>) {
+        return 11;
+    } else if constexpr (std::is_same_v<T, float>) {
+        return 15;
+    } else {
+        return std::tuple_size_v<T> * (max_dump_size<typename T::value_type>() + 1);
+    }
 }
 
+// rows are formatted in parallel, chunkRows rows per buffer, and the buffers
+// of up to chunkBytes are written in order with one fwrite each
 template <class T>
-void dump_csv(AttrVector<T> avec, std::ostream &fout) {
-    fout << "pos";
-    avec.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-        fout << ',' << key;
+void dump_csv(AttrVector<T> const &avec, FILE *fp, size_t chunkBytes) {
+    std::string header = "pos";
+    size_t rowSize = max_dump_size<T>() + 1;
+    std::vector<std::function<char *(size_t, char *)>> cols;
+    cols.push_back([&] (size_t i, char *p) {
+        return dump(avec[i], p);
     });
-    fout << '\n';
-    for (int i = 0; i < avec.size(); i++) {
-        dump(avec[i], fout);
-        avec.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-            fout << ',';
-            dump(arr[i], fout);
+    avec.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using V = std::decay_t<decltype(arr[0])>;
+        header += ',';
+        header += key;
+        rowSize += max_dump_size<V>() + 1;
+        cols.push_back([&arr] (size_t i, char *p) {
+            return dump(arr[i], p);
         });
-        fout << '\n';
+    });
+    header += '\n';
+    fwrite(header.data(), 1, header.size(), fp);
+
+    constexpr size_t chunkRows = 4096;
+    size_t n = avec.size();
+    size_t chunksPerBatch = std::max<size_t>(1, chunkBytes / (rowSize * chunkRows));
+    std::vector<std::vector<char>> chunks(std::min(chunksPerBatch, (n + chunkRows - 1) / chunkRows));
+    for (size_t b = 0; b < n; b += chunksPerBatch * chunkRows) {
+        size_t nchunks = std::min(chunks.size(), (n - b + chunkRows - 1) / chunkRows);
+        parallel_for(nchunks, [&] (size_t k) {
+            size_t rb = b + k * chunkRows, re = std::min(n, rb + chunkRows);
+            auto &buf = chunks[k];
+            buf.resize((re - rb) * rowSize);
+            char *p = buf.data();
+            for (size_t i = rb; i < re; i++) {
+                p = cols[0](i, p);
+                for (size_t c = 1; c < cols.size(); c++) {
+                    *p++ = ',';
+                    p = cols[c](i, p);
+                }
+                *p++ = '\n';
+            }
+            buf.resize(p - buf.data());
+        });
+        for (size_t k = 0; k < nchunks; k++)
+            fwrite(chunks[k].data(), 1, chunks[k].size(), fp);
     }
 }
 
+static auto prim_member(std::string const &type) {
+    return invoker_variant(array_index(
+            {"verts", "points", "lines", "tris", "quads", "loops", "polys"}, type),
+        &PrimitiveObject::verts,
+        &PrimitiveObject::points,
+        &PrimitiveObject::lines,
+        &PrimitiveObject::tris,
+        &PrimitiveObject::quads,
+        &PrimitiveObject::loops,
+        &PrimitiveObject::polys);
+}
+
 struct WritePrimToCSV : INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = primExpandInstances(prim.get());
         auto path = get_input<StringObject>("path")->get();
-        std::ofstream fout(path);
-        auto memb = invoker_variant(array_index(
-                {"verts", "points", "lines", "tris", "quads", "loops", "polys"},
-                get_input2<std::string>("type")),
-            &PrimitiveObject::verts,
-            &PrimitiveObject::points,
-            &PrimitiveObject::lines,
-            &PrimitiveObject::tris,
-            &PrimitiveObject::quads,
-            &PrimitiveObject::loops,
-            &PrimitiveObject::polys);
+        auto chunkMB = std::max(1, get_input2<int>("chunkMB"));
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (!fp)
+            throw makeError("failed to open " + path);
         std::visit([&] (auto const &memb) {
-            dump_csv(memb(*prim), fout);
-        }, memb);
+            dump_csv(memb(*prim), fp, (size_t)chunkMB << 20);
+        }, prim_member(get_input2<std::string>("type")));
+        bool failed = ferror(fp);
+        fclose(fp);
+        if (failed)
+            throw makeError("failed to write " + path);
         set_output("prim", std::move(prim));
     }
 };
@@ -71,6 +136,234 @@ ZENDEFNODE(WritePrimToCSV,
         {"primitive", "prim"},
         {"writepath", "path"},
         {"enum verts points lines tris quads loops polys", "type", "verts"},
+        {"int", "chunkMB", "64"},
+        }, /* outputs: */ {
+        {"primitive", "prim"},
+        }, /* params: */ {
+        }, /* category: */ {
+        "primitive",
+        }});
+
+// columnar layout, little endian:
+//   "ZCOL" u32 version
+//   column data, each array as in memory, starting at a 64 byte boundary
+//   footer: u64 rows, u32 columns, per column: u32 type, u32 name length,
+//   name, u64 offset; then u64 footer size and "ZCOL"
+// the first column is pos, type is a ColumnarType
+static constexpr char kColumnarMagic[4] = {'Z', 'C', 'O', 'L'};
+static constexpr uint32_t kColumnarVersion = 1;
+
+// type tags as stored on disk, never renumber them
+enum class ColumnarType : uint32_t {
+    Vec3f = 0,
+    Float = 1,
+    Vec3i = 2,
+    Int = 3,
+    Vec2f = 4,
+    Vec2i = 5,
+    Vec4f = 6,
+    Vec4i = 7,
+};
+
+template <class T>
+static constexpr ColumnarType columnar_type() {
+    if constexpr (std::is_same_v<T, vec3f>) return ColumnarType::Vec3f;
+    else if constexpr (std::is_same_v<T, float>) return ColumnarType::Float;
+    else if constexpr (std::is_same_v<T, vec3i>) return ColumnarType::Vec3i;
+    else if constexpr (std::is_same_v<T, int>) return ColumnarType::Int;
+    else if constexpr (std::is_same_v<T, vec2f>) return ColumnarType::Vec2f;
+    else if constexpr (std::is_same_v<T, vec2i>) return ColumnarType::Vec2i;
+    else if constexpr (std::is_same_v<T, vec4f>) return ColumnarType::Vec4f;
+    else {
+        static_assert(std::is_same_v<T, vec4i>, "attribute type without a columnar type tag");
+        return ColumnarType::Vec4i;
+    }
+}
+
+// f(T{}) for the attribute type of the tag, false for an unknown tag
+template <class F>
+static bool visit_columnar_type(uint32_t type, F &&f) {
+    switch ((ColumnarType)type) {
+    case ColumnarType::Vec3f: f(vec3f{}); return true;
+    case ColumnarType::Float: f(float{}); return true;
+    case ColumnarType::Vec3i: f(vec3i{}); return true;
+    case ColumnarType::Int: f(int{}); return true;
+    case ColumnarType::Vec2f: f(vec2f{}); return true;
+    case ColumnarType::Vec2i: f(vec2i{}); return true;
+    case ColumnarType::Vec4f: f(vec4f{}); return true;
+    case ColumnarType::Vec4i: f(vec4i{}); return true;
+    }
+    return false;
+}
+
+static int seek_file(FILE *fp, int64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(fp, offset, whence);
+#else
+    return fseeko(fp, offset, whence);
+#endif
+}
+
+template <class T>
+void write_columnar(AttrVector<T> const &avec, FILE *fp) {
+    std::string footer;
+    auto put = [&] (auto const &val) {
+        footer.append((const char *)&val, sizeof(val));
+    };
+    uint64_t offset = 0;
+    auto write = [&] (const void *data, size_t size) {
+        fwrite(data, 1, size, fp);
+        offset += size;
+    };
+    write(kColumnarMagic, 4);
+    write(&kColumnarVersion, 4);
+    uint32_t ncols = 0;
+    std::string cols;
+    // arrays go straight from the attribute storage into the file
+    auto addColumn = [&] (std::string const &key, auto const &arr) {
+        using V = std::decay_t<decltype(arr[0])>;
+        static const char zeros[64] = {};
+        write(zeros, (64 - offset % 64) % 64);
+        uint32_t type = (uint32_t)columnar_type<V>();
+        uint32_t namelen = key.size();
+        cols.append((const char *)&type, 4);
+        cols.append((const char *)&namelen, 4);
+        cols.append(key);
+        cols.append((const char *)&offset, 8);
+        write(arr.data(), arr.size() * sizeof(V));
+        ncols++;
+    };
+    addColumn("pos", avec.values);
+    avec.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        addColumn(key, arr);
+    });
+    put((uint64_t)avec.size());
+    put(ncols);
+    footer += cols;
+    put((uint64_t)(footer.size() + 8));
+    footer.append(kColumnarMagic, 4);
+    write(footer.data(), footer.size());
+}
+
+template <class T>
+void read_columnar(AttrVector<T> &avec, FILE *fp, std::string const &path) {
+    auto fail = [&] (std::string const &what) {
+        throw makeError("invalid columnar file " + path + ": " + what);
+    };
+    char head[8], tail[12];
+    if (fread(head, 1, 8, fp) != 8 || std::memcmp(head, kColumnarMagic, 4))
+        fail("bad magic");
+    uint32_t version;
+    std::memcpy(&version, head + 4, 4);
+    if (version != kColumnarVersion)
+        fail("unsupported version " + std::to_string(version));
+    if (seek_file(fp, -12, SEEK_END) || fread(tail, 1, 12, fp) != 12 || std::memcmp(tail + 8, kColumnarMagic, 4))
+        fail("bad footer");
+    uint64_t footerSize;
+    std::memcpy(&footerSize, tail, 8);
+    std::string footer(footerSize, '\0');
+    if (seek_file(fp, -(int64_t)(footerSize + 4), SEEK_END) || fread(footer.data(), 1, footerSize, fp) != footerSize)
+        fail("truncated footer");
+
+    const char *it = footer.data(), *end = footer.data() + footerSize - 8;
+    auto get = [&] (auto &val) {
+        if (it + sizeof(val) > end)
+            fail("truncated footer");
+        std::memcpy(&val, it, sizeof(val));
+        it += sizeof(val);
+    };
+    uint64_t rows;
+    uint32_t ncols;
+    get(rows);
+    get(ncols);
+    avec.resize(rows);
+    for (uint32_t c = 0; c < ncols; c++) {
+        uint32_t type, namelen;
+        uint64_t offset;
+        get(type);
+        get(namelen);
+        if (it + namelen > end)
+            fail("truncated footer");
+        std::string key(it, namelen);
+        it += namelen;
+        get(offset);
+        // read straight into the attribute array
+        bool known = visit_columnar_type(type, [&] (auto ty) {
+            using V = decltype(ty);
+            std::vector<V> *arr;
+            if (c == 0) {
+                if constexpr (!std::is_same_v<V, T>)
+                    throw makeError<TypeError>(typeid(T), typeid(V), "type of pos column in " + path);
+                else
+                    arr = &avec.values;
+            } else {
+                arr = &avec.template add_attr<V>(key);
+            }
+            if (seek_file(fp, (int64_t)offset, SEEK_SET) || fread(arr->data(), sizeof(V), rows, fp) != rows)
+                fail("truncated column " + key);
+        });
+        if (!known)
+            fail("unknown type of column " + key);
+    }
+}
+
+struct WritePrimToColumnar : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = primExpandInstances(prim.get());
+        auto path = get_input<StringObject>("path")->get();
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (!fp)
+            throw makeError("failed to open " + path);
+        std::visit([&] (auto const &memb) {
+            write_columnar(memb(*prim), fp);
+        }, prim_member(get_input2<std::string>("type")));
+        bool failed = ferror(fp);
+        fclose(fp);
+        if (failed)
+            throw makeError("failed to write " + path);
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(WritePrimToColumnar,
+        { /* inputs: */ {
+        {"primitive", "prim"},
+        {"writepath", "path"},
+        {"enum verts points lines tris quads loops polys", "type", "verts"},
+        }, /* outputs: */ {
+        {"primitive", "prim"},
+        }, /* params: */ {
+        }, /* category: */ {
+        "primitive",
+        }});
+
+struct ReadPrimFromColumnar : INode {
+    virtual void apply() override {
+        auto prim = has_input("prim") ? get_input<PrimitiveObject>("prim") : std::make_shared<PrimitiveObject>();
+        auto path = get_input<StringObject>("path")->get();
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (!fp)
+            throw makeError("failed to open " + path);
+        try {
+            std::visit([&] (auto const &memb) {
+                read_columnar(memb(*prim), fp, path);
+            }, prim_member(get_input2<std::string>("type")));
+        } catch (...) {
+            fclose(fp);
+            throw;
+        }
+        fclose(fp);
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(ReadPrimFromColumnar,
+        { /* inputs: */ {
+        {"primitive", "prim"},
+        {"readpath", "path"},
+        {"enum verts points lines tris quads loops polys", "type", "verts"},
         }, /* outputs: */ {
         {"primitive", "prim"},
         }, /* params: */ {
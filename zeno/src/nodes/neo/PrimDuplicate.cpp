@@ -1,6 +1,7 @@
 #include <zeno/zeno.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/InstancingObject.h>
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/utils/wangsrng.h>
@@ -20,6 +21,90 @@
 
 namespace zeno {
 
+namespace {
+
+// replicates the faces and attributes of meshPrim once per entry of parsVerts,
+// prim->verts must already be sized, their positions are left to the caller
+void duplicate_topology(PrimitiveObject *prim, PrimitiveObject *meshPrim, AttrVector<vec3f> const &parsVerts, bool copyParsAttr, bool copyMeshAttr) {
+    immediate_task_group tg;
+
+    prim->points.resize(parsVerts.size() * meshPrim->points.size());
+    prim->lines.resize(parsVerts.size() * meshPrim->lines.size());
+    prim->tris.resize(parsVerts.size() * meshPrim->tris.size());
+    prim->quads.resize(parsVerts.size() * meshPrim->quads.size());
+    prim->loops.resize(parsVerts.size() * meshPrim->loops.size());
+    prim->polys.resize(parsVerts.size() * meshPrim->polys.size());
+
+    auto copyattr = [&] (auto &primAttrs, auto &meshAttrs, auto &parsAttrs) {
+        if (copyMeshAttr) {
+            meshAttrs.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arrMesh) {
+                using T = std::decay_t<decltype(arrMesh[0])>;
+                primAttrs.template add_attr<T>(key);
+                tg.add([&] {
+                    auto &arrOut = primAttrs.template attr<T>(key);
+                    parallel_for((size_t)0, parsAttrs.size(), [&] (size_t i) {
+                        for (size_t j = 0; j < meshAttrs.size(); j++) {
+                            arrOut[i * meshAttrs.size() + j] = arrMesh[j];
+                        }
+                    });
+                });
+            });
+        }
+        if (copyParsAttr) {
+            parsAttrs.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arrPars) {
+                if (meshAttrs.has_attr(key)) return;
+                using T = std::decay_t<decltype(arrPars[0])>;
+                primAttrs.template add_attr<T>(key);
+                tg.add([&] {
+                    auto &arrOut = primAttrs.template attr<T>(key);
+                    parallel_for((size_t)0, arrPars.size(), [&] (size_t i) {
+                        auto value = arrPars[i];
+                        for (size_t j = 0; j < meshAttrs.size(); j++) {
+                            arrOut[i * meshAttrs.size() + j] = value;
+                        }
+                    });
+                });
+            });
+        }
+    };
+    copyattr(prim->verts, meshPrim->verts, parsVerts);
+    auto advanceinds = [&] (auto &primAttrs, auto &meshAttrs, auto &parsAttrs, size_t parsVertsSize, size_t meshVertsSize) {
+        copyattr(primAttrs, meshAttrs, parsAttrs);
+        tg.add([&] {
+            parallel_for((size_t)0, parsVertsSize, [&] (size_t i) {
+                overloaded fixpairadd{
+                    [] (auto &x, size_t y) {
+                        x += y;
+                    },
+                    [] (std::pair<int, int> &x, size_t y) {
+                        x.first += y;
+                        x.second += y;
+                    },
+                };
+                for (size_t j = 0; j < meshAttrs.size(); j++) {
+                    auto index = meshAttrs[j];
+                    fixpairadd(index, i * meshVertsSize);
+                    primAttrs[i * meshAttrs.size() + j] = index;
+                }
+            });
+        });
+    };
+    AttrVector<vec3f> dummyVec;
+    advanceinds(prim->points, meshPrim->points, parsVerts, parsVerts.size(), meshPrim->verts.size());
+    advanceinds(prim->lines, meshPrim->lines, dummyVec, parsVerts.size(), meshPrim->verts.size());
+    advanceinds(prim->tris, meshPrim->tris, dummyVec, parsVerts.size(), meshPrim->verts.size());
+    advanceinds(prim->quads, meshPrim->quads, dummyVec, parsVerts.size(), meshPrim->verts.size());
+    advanceinds(prim->polys, meshPrim->polys, dummyVec, parsVerts.size(), meshPrim->loops.size());
+    advanceinds(prim->loops, meshPrim->loops, dummyVec, parsVerts.size(), meshPrim->verts.size());
+    tg.add([&] {
+        prim->uvs = meshPrim->uvs;
+    });
+
+    tg.run();
+}
+
+}
+
 ZENO_API std::shared_ptr<PrimitiveObject> primDuplicate(PrimitiveObject *parsPrim, PrimitiveObject *meshPrim, std::string dirAttr, std::string tanAttr, std::string radAttr, std::string onbType, float radius, bool copyParsAttr, bool copyMeshAttr) {
     auto prim = std::make_shared<PrimitiveObject>();
     auto hasDirAttr = boolean_variant(!dirAttr.empty());
@@ -31,12 +116,6 @@ ZENO_API std::shared_ptr<PrimitiveObject> primDuplicate(PrimitiveObject *parsPri
     immediate_task_group tg;
 
     prim->verts.resize(parsPrim->verts.size() * meshPrim->verts.size());
-    prim->points.resize(parsPrim->verts.size() * meshPrim->points.size());
-    prim->lines.resize(parsPrim->verts.size() * meshPrim->lines.size());
-    prim->tris.resize(parsPrim->verts.size() * meshPrim->tris.size());
-    prim->quads.resize(parsPrim->verts.size() * meshPrim->quads.size());
-    prim->loops.resize(parsPrim->verts.size() * meshPrim->loops.size());
-    prim->polys.resize(parsPrim->verts.size() * meshPrim->polys.size());
 
     std::visit([&] (auto hasDirAttr, auto hasRadius, auto hasRadAttr, auto hasOnbType) {
         auto func = [&] (auto const &accRad) {
@@ -96,76 +175,107 @@ ZENO_API std::shared_ptr<PrimitiveObject> primDuplicate(PrimitiveObject *parsPri
             func(std::array<int, 0>{});
     }, hasDirAttr, hasRadius, hasRadAttr, hasOnbType);
 
-    auto copyattr = [&] (auto &primAttrs, auto &meshAttrs, auto &parsAttrs) {
-        if (copyMeshAttr) {
-            meshAttrs.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arrMesh) {
-                using T = std::decay_t<decltype(arrMesh[0])>;
-                primAttrs.template add_attr<T>(key);
-                tg.add([&] {
-                    auto &arrOut = primAttrs.template attr<T>(key);
-                    parallel_for((size_t)0, parsAttrs.size(), [&] (size_t i) {
-                        for (size_t j = 0; j < meshAttrs.size(); j++) {
-                            arrOut[i * meshAttrs.size() + j] = arrMesh[j];
-                        }
-                    });
-                });
-            });
-        }
-        if (copyParsAttr) {
-            parsAttrs.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arrPars) {
-                if (meshAttrs.has_attr(key)) return;
-                using T = std::decay_t<decltype(arrPars[0])>;
-                primAttrs.template add_attr<T>(key);
-                tg.add([&] {
-                    auto &arrOut = primAttrs.template attr<T>(key);
-                    parallel_for((size_t)0, arrPars.size(), [&] (size_t i) {
-                        auto value = arrPars[i];
-                        for (size_t j = 0; j < meshAttrs.size(); j++) {
-                            arrOut[i * meshAttrs.size() + j] = value;
-                        }
-                    });
-                });
-            });
-        }
-    };
-    copyattr(prim->verts, meshPrim->verts, parsPrim->verts);
-    auto advanceinds = [&] (auto &primAttrs, auto &meshAttrs, auto &parsAttrs, size_t parsVertsSize, size_t meshVertsSize) {
-        copyattr(primAttrs, meshAttrs, parsAttrs);
-        tg.add([&] {
-            parallel_for((size_t)0, parsVertsSize, [&] (size_t i) {
-                overloaded fixpairadd{
-                    [] (auto &x, size_t y) {
-                        x += y;
-                    },
-                    [] (std::pair<int, int> &x, size_t y) {
-                        x.first += y;
-                        x.second += y;
-                    },
-                };
-                for (size_t j = 0; j < meshAttrs.size(); j++) {
-                    auto index = meshAttrs[j];
-                    fixpairadd(index, i * meshVertsSize);
-                    primAttrs[i * meshAttrs.size() + j] = index;
+    duplicate_topology(prim.get(), meshPrim, parsPrim->verts, copyParsAttr, copyMeshAttr);
+
+    tg.run();
+
+    return prim;
+}
+
+// same transform as primDuplicate, but only the mesh is kept (once) and every
+// particle becomes an instance matrix in prim->inst, to be drawn instanced by
+// the viewport or baked into geometry by primExpandInstances when needed
+ZENO_API std::shared_ptr<PrimitiveObject> primDuplicateInstanced(PrimitiveObject *parsPrim, PrimitiveObject *meshPrim, std::string dirAttr, std::string tanAttr, std::string radAttr, std::string onbType, float radius, bool copyParsAttr) {
+    auto prim = std::make_shared<PrimitiveObject>(*meshPrim);
+    auto inst = std::make_shared<InstancingObject>();
+    auto indOnbType = array_index({"XYZ", "YXZ", "YZX", "ZYX", "ZXY", "XZY"}, onbType);
+    size_t amount = parsPrim->verts.size();
+
+    // onb permutation as a matrix, row k picks component a[k] of the mesh pos
+    const std::array<std::size_t, 6> a0{0, 1, 1, 2, 2, 0};
+    const std::array<std::size_t, 6> a1{1, 0, 2, 1, 0, 2};
+    const std::array<std::size_t, 6> a2{2, 2, 0, 0, 1, 1};
+    glm::mat3 perm(0.0f);
+    perm[a0[indOnbType]][0] = 1.0f;
+    perm[a1[indOnbType]][1] = 1.0f;
+    perm[a2[indOnbType]][2] = 1.0f;
+
+    inst->amount = (int)amount;
+    inst->modelMatrices.resize(amount);
+    inst->timeList.resize(amount);
+    // looked up (and expanded if lazy) once here, not from the worker threads
+    vec3f const *accDir = dirAttr.empty() ? nullptr : parsPrim->attr<vec3f>(dirAttr).data();
+    vec3f const *accTan = tanAttr.empty() ? nullptr : parsPrim->attr<vec3f>(tanAttr).data();
+    auto func = [&] (auto const &accRad) {
+        parallel_for(amount, [&] (size_t i) {
+            vec3f scale(radius);
+            if constexpr (!std::is_same_v<std::decay_t<decltype(accRad)>, std::array<int, 0>>) {
+                scale *= accRad[i];
+            }
+            glm::mat3 basis(1.0f);
+            if (accDir) {
+                auto t0 = normalizeSafe(accDir[i]);
+                vec3f t1, t2;
+                if (accTan) {
+                    t1 = normalizeSafe(accTan[i]);
+                    t2 = normalizeSafe(cross(t0, t1));
+                } else {
+                    pixarONB(t0, t1, t2);
                 }
-            });
+                basis = glm::mat3(glm::vec3(t2[0], t2[1], t2[2]),
+                                  glm::vec3(t1[0], t1[1], t1[2]),
+                                  glm::vec3(t0[0], t0[1], t0[2]));
+            }
+            glm::mat3 m = basis * perm * glm::mat3(glm::vec3(scale[0], 0, 0), glm::vec3(0, scale[1], 0), glm::vec3(0, 0, scale[2]));
+            auto base = parsPrim->verts[i];
+            glm::mat4 model(m);
+            model[3] = glm::vec4(base[0], base[1], base[2], 1.0f);
+            inst->modelMatrices[i] = model;
         });
     };
-    AttrVector<vec3f> dummyVec;
-    advanceinds(prim->points, meshPrim->points, parsPrim->verts, parsPrim->verts.size(), meshPrim->verts.size());
-    advanceinds(prim->lines, meshPrim->lines, dummyVec, parsPrim->verts.size(), meshPrim->verts.size());
-    advanceinds(prim->tris, meshPrim->tris, dummyVec, parsPrim->verts.size(), meshPrim->verts.size());
-    advanceinds(prim->quads, meshPrim->quads, dummyVec, parsPrim->verts.size(), meshPrim->verts.size());
-    advanceinds(prim->polys, meshPrim->polys, dummyVec, parsPrim->verts.size(), meshPrim->loops.size());
-    advanceinds(prim->loops, meshPrim->loops, dummyVec, parsPrim->verts.size(), meshPrim->verts.size());
-    tg.add([&] {
-        prim->uvs = meshPrim->uvs;
-    });
-
-    tg.run();
+    if (!radAttr.empty())
+        parsPrim->verts.attr_visit(radAttr, func);
+    else
+        func(std::array<int, 0>{});
 
+    if (copyParsAttr) {
+        inst->instAttrs = parsPrim->verts;
+    } else {
+        inst->instAttrs.values = parsPrim->verts.values;
+    }
+    prim->inst = std::move(inst);
     return prim;
 }
 
+// bakes the instances of prim->inst into plain geometry, one copy of the mesh
+// per model matrix, with the per-instance attributes spread over its verts
+ZENO_API std::shared_ptr<PrimitiveObject> primExpandInstances(PrimitiveObject *prim) {
+    if (!prim->inst)
+        return std::make_shared<PrimitiveObject>(*prim);
+    auto const &inst = *prim->inst;
+    size_t amount = inst.modelMatrices.size();
+    auto outprim = std::make_shared<PrimitiveObject>();
+    outprim->mtl = prim->mtl;
+
+    // instancing made by MakeInstancing comes without per-instance attributes
+    AttrVector<vec3f> emptyInstAttrs;
+    emptyInstAttrs.resize(amount);
+    auto const &instAttrs = inst.instAttrs.size() == amount ? inst.instAttrs : emptyInstAttrs;
+
+    size_t nverts = prim->verts.size();
+    outprim->verts.resize(amount * nverts);
+    parallel_for(amount, [&] (size_t i) {
+        auto const &model = inst.modelMatrices[i];
+        for (size_t j = 0; j < nverts; j++) {
+            auto p = prim->verts[j];
+            auto q = model * glm::vec4(p[0], p[1], p[2], 1.0f);
+            outprim->verts[i * nverts + j] = vec3f(q[0], q[1], q[2]);
+        }
+    });
+    duplicate_topology(outprim.get(), prim, instAttrs, true, true);
+    return outprim;
+}
+
 namespace {
 
 struct PrimDuplicate : INode {
@@ -179,9 +289,14 @@ struct PrimDuplicate : INode {
         auto radius = get_input2<float>("radius");
         auto copyParsAttr = get_input2<bool>("copyParsAttr");
         auto copyMeshAttr = get_input2<bool>("copyMeshAttr");
-        auto prim = primDuplicate(parsPrim.get(), meshPrim.get(),
-                                  dirAttr, tanAttr, radAttr, onbType,
-                                  radius, copyParsAttr, copyMeshAttr);
+        auto instancing = get_input2<bool>("instancing");
+        auto prim = instancing
+            ? primDuplicateInstanced(parsPrim.get(), meshPrim.get(),
+                                     dirAttr, tanAttr, radAttr, onbType,
+                                     radius, copyParsAttr)
+            : primDuplicate(parsPrim.get(), meshPrim.get(),
+                            dirAttr, tanAttr, radAttr, onbType,
+                            radius, copyParsAttr, copyMeshAttr);
         set_output("prim", prim);
     }
 };
@@ -197,6 +312,28 @@ ZENDEFNODE(PrimDuplicate, {
     {"float", "radius", "1"},
     {"bool", "copyParsAttr", "1"},
     {"bool", "copyMeshAttr", "1"},
+    {"bool", "instancing", "0"},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+struct PrimExpandInstances : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = primExpandInstances(prim.get());
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(PrimExpandInstances, {
+    {
+    {"PrimitiveObject", "prim"},
     },
     {
     {"PrimitiveObject", "prim"},
@@ -4,405 +4,219 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/vec.h>
-#include <zeno/utils/zeno_p.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_compact.h>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
 
 namespace zeno {
 
-static void primRevampVerts(PrimitiveObject *prim, std::vector<int> const &revamp);
-static void primRevampFaces(PrimitiveObject *prim, std::vector<uint8_t> const &unrevamp);
+namespace {
 
-ZENO_API void primFilterVerts(PrimitiveObject *prim, std::string tagAttr, int tagValue, bool isInversed, std::string revampAttrO, std::string method) {
-    if (method == "faces") {
-        std::vector<uint8_t> unrevamp(prim->size());
-        auto const &tagArr = prim->verts.attr<int>(tagAttr);
-        if (!isInversed) {
-            for (int i = 0; i < prim->size(); i++) {
-                unrevamp[i] = tagArr[i] == tagValue;
-            }
-        } else {
-            for (int i = 0; i < prim->size(); i++) {
-                unrevamp[i] = tagArr[i] != tagValue;
-            }
-        }
-        primRevampFaces(prim, unrevamp);
-        if (!revampAttrO.empty()) {
-            auto &revamp = prim->add_attr<int>(revampAttrO);
-            if (!isInversed) {
-                for (int i = 0; i < prim->size(); i++) {
-                    revamp[i] = tagArr[i] == tagValue ? i : -1;
-                }
-            } else {
-                for (int i = 0; i < prim->size(); i++) {
-                    revamp[i] = tagArr[i] != tagValue ? i : -1;
-                }
-            }
-        }
-    } else {
-        std::vector<int> revamp;
-        revamp.reserve(prim->size());
-        auto const &tagArr = prim->verts.attr<int>(tagAttr);
-        if (!isInversed) {
-            for (int i = 0; i < prim->size(); i++) {
-                if (tagArr[i] == tagValue)
-                    revamp.emplace_back(i);
-            }
-        } else {
-            for (int i = 0; i < prim->size(); i++) {
-                if (tagArr[i] != tagValue)
-                    revamp.emplace_back(i);
-            }
-        }
-        primRevampVerts(prim, revamp);
-        if (!revampAttrO.empty()) {
-            prim->add_attr<int>(revampAttrO) = std::move(revamp);
-        }
-    }
+// keeps the elements i for which keep(i) holds, with all their attributes;
+// keep may modify element i in place, e.g. to remap its indices
+template <class ValT, class Keep>
+void compact_elements(AttrVector<ValT> &elms, Keep keep) {
+    if (!elms.size())
+        return;
+    auto revamp = parallel_compact_indices(elms.size(), keep);
+    if (revamp.size() == elms.size())
+        return;
+    parallel_gather(elms.values, revamp);
+    elms.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        parallel_gather(arr, revamp);
+    });
 }
 
-template <class T>
-static void revamp_vector(std::vector<T> &arr, std::vector<int> const &revamp) {
-    std::vector<T> newarr(arr.size());
-    for (int i = 0; i < revamp.size(); i++) {
-        newarr[i] = arr[revamp[i]];
-    }
-    std::swap(arr, newarr);
+// polys are compacted together with their loops, so that loops of removed
+// polys are gone too and the kept ones stay contiguous
+template <class Keep>
+void compact_polys(PrimitiveObject *prim, Keep keep) {
+    if (!prim->polys.size())
+        return;
+    auto revamp = parallel_compact_indices(prim->polys.size(), keep);
+    if (revamp.size() == prim->polys.size())
+        return;
+    std::vector<int> starts(revamp.size());
+    int nloops = parallel_exclusive_scan_sum(revamp.begin(), revamp.end(), starts.begin(), [&] (int i) {
+        return prim->polys[i][1];
+    });
+    std::vector<int> looprevamp(nloops);
+    parallel_for(revamp.size(), [&] (size_t k) {
+        auto [base, len] = prim->polys[revamp[k]];
+        for (int j = 0; j < len; j++)
+            looprevamp[starts[k] + j] = base + j;
+    });
+    parallel_gather(prim->loops.values, looprevamp);
+    prim->loops.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        parallel_gather(arr, looprevamp);
+    });
+    parallel_gather(prim->polys.values, revamp);
+    parallel_for(revamp.size(), [&] (size_t k) {
+        prim->polys[k][0] = starts[k];
+    });
+    prim->polys.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        parallel_gather(arr, revamp);
+    });
 }
 
-ZENO_API void primKillDeadVerts(PrimitiveObject *prim) {
-    std::set<int> reached(prim->points.begin(), prim->points.end());
-    for (auto const &ind: prim->lines) {
-        reached.insert(ind[0]);
-        reached.insert(ind[1]);
-    }
-    for (auto const &ind: prim->tris) {
-        reached.insert(ind[0]);
-        reached.insert(ind[1]);
-        reached.insert(ind[2]);
-    }
-    for (auto const &ind: prim->quads) {
-        reached.insert(ind[0]);
-        reached.insert(ind[1]);
-        reached.insert(ind[2]);
-        reached.insert(ind[3]);
-    }
-    for (auto const &[start, len]: prim->polys) {
-        for (int i = start; i < start + len; i++) {
-            reached.insert(prim->loops[i]);
-        }
-    }
-    std::vector<int> revamp(reached.begin(), reached.end());
-    auto old_prim_size = prim->verts.size();
-    prim->verts.forall_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-        revamp_vector(arr, revamp);
+// keep verts of revamp (ascending), faces referring to removed verts are
+// dropped and the rest remapped in the same compaction, degenerated lines,
+// tris and quads (less than 3 distinct corners) are dropped as well
+void primRevampVerts(PrimitiveObject *prim, std::vector<int> const &revamp) {
+    size_t old_prim_size = prim->verts.size();
+    prim->foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        parallel_gather(arr, revamp);
     });
     prim->verts.resize(revamp.size());
 
-    std::vector<int> unrevamp(old_prim_size);
-    for (int i = 0; i < revamp.size(); i++) {
-        unrevamp[revamp[i]] = i;
-    }
-
-    auto mock = [&] (int &ind) {
-        ind = unrevamp[ind];
+    std::vector<int> unrevamp(old_prim_size, -1);
+    parallel_for(revamp.size(), [&] (size_t i) {
+        unrevamp[revamp[i]] = (int)i;
+    });
+    // remapped in place while testing, dropped elements don't care
+    auto mock = [&] (int &x) -> bool {
+        if (x < 0 || x >= (int)old_prim_size)
+            return false;
+        x = unrevamp[x];
+        return x != -1;
     };
-    for (auto &ind: prim->points) {
-        mock(ind);
-    }
-    for (auto &ind: prim->lines) {
-        mock(ind[0]);
-        mock(ind[1]);
-    }
-    for (auto &ind: prim->tris) {
-        mock(ind[0]);
-        mock(ind[1]);
-        mock(ind[2]);
-    }
-    for (auto &ind: prim->quads) {
-        mock(ind[0]);
-        mock(ind[1]);
-        mock(ind[2]);
-        mock(ind[3]);
-    }
-    for (auto const &[start, len]: prim->polys) {
-        for (int i = start; i < start + len; i++) {
-            mock(prim->loops[i]);
-        }
-    }
-}
 
-static void primRevampVerts(PrimitiveObject *prim, std::vector<int> const &revamp) {
-    prim->foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-        revamp_vector(arr, revamp);
+    compact_elements(prim->points, [&] (int i) {
+        return mock(prim->points[i]);
     });
-    auto old_prim_size = prim->size();
-    prim->resize(revamp.size());
-
-    if ((0
-            || prim->tris.size()
-            || prim->quads.size()
-            || prim->lines.size()
-            || prim->edges.size()
-            || prim->polys.size()
-            || prim->points.size()
-         )) {
-
-        std::vector<int> unrevamp(old_prim_size, -1);
-        for (int i = 0; i < revamp.size(); i++) {
-            unrevamp[revamp[i]] = i;
-        }
-
-        auto mock = [&] (int &x) -> bool {
-            int loc = unrevamp[x];
-            if (loc == -1)
+    compact_elements(prim->lines, [&] (int i) {
+        auto &ind = prim->lines[i];
+        return mock(ind[0]) && mock(ind[1]) && ind[0] != ind[1];
+    });
+    compact_elements(prim->edges, [&] (int i) {
+        auto &ind = prim->edges[i];
+        return mock(ind[0]) && mock(ind[1]);
+    });
+    compact_elements(prim->tris, [&] (int i) {
+        auto &ind = prim->tris[i];
+        return mock(ind[0]) && mock(ind[1]) && mock(ind[2])
+            && ind[0] != ind[1] && ind[1] != ind[2] && ind[2] != ind[0];
+    });
+    compact_elements(prim->quads, [&] (int i) {
+        auto &ind = prim->quads[i];
+        if (!(mock(ind[0]) && mock(ind[1]) && mock(ind[2]) && mock(ind[3])))
+            return false;
+        int ndistinct = 1 + (ind[1] != ind[0]) + (ind[2] != ind[0] && ind[2] != ind[1])
+            + (ind[3] != ind[0] && ind[3] != ind[1] && ind[3] != ind[2]);
+        return ndistinct >= 3;
+    });
+    compact_polys(prim, [&] (int i) {
+        auto [base, len] = prim->polys[i];
+        for (int p = base; p < base + len; p++)
+            if (!mock(prim->loops[p]))
                 return false;
-            x = loc;
-            return true;
-        };
-
-        if (prim->tris.size()) {
-            std::vector<int> trisrevamp;
-            trisrevamp.reserve(prim->tris.size());
-            for (int i = 0; i < prim->tris.size(); i++) {
-                auto &tri = prim->tris[i];
-                //ZENO_P(tri);
-                //ZENO_P(unrevamp[tri[0]]);
-                //ZENO_P(unrevamp[tri[1]]);
-                //ZENO_P(unrevamp[tri[2]]);
-                if (mock(tri[0]) && mock(tri[1]) && mock(tri[2]))
-                    trisrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < trisrevamp.size(); i++) {
-                prim->tris[i] = prim->tris[trisrevamp[i]];
-            }
-            prim->tris.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, trisrevamp);
-            });
-            prim->tris.resize(trisrevamp.size());
-        }
-
-        if (prim->quads.size()) {
-            std::vector<int> quadsrevamp;
-            quadsrevamp.reserve(prim->quads.size());
-            for (int i = 0; i < prim->quads.size(); i++) {
-                auto &quad = prim->quads[i];
-                if (mock(quad[0]) && mock(quad[1]) && mock(quad[2]) && mock(quad[3]))
-                    quadsrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < quadsrevamp.size(); i++) {
-                prim->quads[i] = prim->quads[quadsrevamp[i]];
-            }
-            prim->quads.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, quadsrevamp);
-            });
-            prim->quads.resize(quadsrevamp.size());
-        }
+        return true;
+    });
+}
 
-        if (prim->lines.size()) {
-            std::vector<int> linesrevamp;
-            linesrevamp.reserve(prim->lines.size());
-            for (int i = 0; i < prim->lines.size(); i++) {
-                auto &line = prim->lines[i];
-                if (mock(line[0]) && mock(line[1]))
-                    linesrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < linesrevamp.size(); i++) {
-                prim->lines[i] = prim->lines[linesrevamp[i]];
-            }
-            prim->lines.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, linesrevamp);
-            });
-            prim->lines.resize(linesrevamp.size());
-        }
+// keep faces touching at least one of the flagged verts, verts are untouched
+void primRevampFaces(PrimitiveObject *prim, std::vector<uint8_t> const &unrevamp) {
+    auto mock = [&] (int x) -> bool {
+        return unrevamp[x];
+    };
+    compact_elements(prim->points, [&] (int i) {
+        return mock(prim->points[i]);
+    });
+    compact_elements(prim->lines, [&] (int i) {
+        auto ind = prim->lines[i];
+        return mock(ind[0]) || mock(ind[1]);
+    });
+    compact_elements(prim->edges, [&] (int i) {
+        auto ind = prim->edges[i];
+        return mock(ind[0]) || mock(ind[1]);
+    });
+    compact_elements(prim->tris, [&] (int i) {
+        auto ind = prim->tris[i];
+        return mock(ind[0]) || mock(ind[1]) || mock(ind[2]);
+    });
+    compact_elements(prim->quads, [&] (int i) {
+        auto ind = prim->quads[i];
+        return mock(ind[0]) || mock(ind[1]) || mock(ind[2]) || mock(ind[3]);
+    });
+    compact_polys(prim, [&] (int i) {
+        auto [base, len] = prim->polys[i];
+        for (int p = base; p < base + len; p++)
+            if (mock(prim->loops[p]))
+                return true;
+        return false;
+    });
+}
 
-        if (prim->edges.size()) {
-            std::vector<int> edgesrevamp;
-            edgesrevamp.reserve(prim->edges.size());
-            for (int i = 0; i < prim->edges.size(); i++) {
-                auto &edge = prim->edges[i];
-                if (mock(edge[0]) && mock(edge[1]))
-                    edgesrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < edgesrevamp.size(); i++) {
-                prim->edges[i] = prim->edges[edgesrevamp[i]];
-            }
-            prim->edges.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, edgesrevamp);
-            });
-            prim->edges.resize(edgesrevamp.size());
-        }
+}
 
-        if (prim->polys.size()) {
-            std::vector<int> polysrevamp;
-            polysrevamp.reserve(prim->polys.size());
-            for (int i = 0; i < prim->polys.size(); i++) {
-                auto &poly = prim->polys[i];
-                bool succ = [&] {
-                    for (int p = poly[0]; p < poly[0] + poly[1]; p++)
-                        if (!mock(prim->loops[p]))
-                            return false;
-                    return true;
-                }();
-                if (succ)
-                    polysrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < polysrevamp.size(); i++) {
-                prim->polys[i] = prim->polys[polysrevamp[i]];
-            }
-            prim->polys.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, polysrevamp);
+ZENO_API void primFilterVerts(PrimitiveObject *prim, std::string tagAttr, int tagValue, bool isInversed, std::string revampAttrO, std::string method) {
+    auto const &tagArr = prim->verts.attr<int>(tagAttr);
+    auto match = [&] (int i) {
+        return (tagArr[i] == tagValue) != isInversed;
+    };
+    if (method == "faces") {
+        std::vector<uint8_t> unrevamp(prim->size());
+        parallel_for(prim->size(), [&] (size_t i) {
+            unrevamp[i] = match(i);
+        });
+        primRevampFaces(prim, unrevamp);
+        if (!revampAttrO.empty()) {
+            auto &revamp = prim->add_attr<int>(revampAttrO);
+            parallel_for(prim->size(), [&] (size_t i) {
+                revamp[i] = unrevamp[i] ? (int)i : -1;
             });
-            prim->polys.resize(polysrevamp.size());
         }
-
-        if (prim->points.size()) {
-            std::vector<int> pointsrevamp;
-            pointsrevamp.reserve(prim->points.size());
-            for (int i = 0; i < prim->points.size(); i++) {
-                auto &point = prim->points[i];
-                if (mock(point))
-                    pointsrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < pointsrevamp.size(); i++) {
-                prim->points[i] = prim->points[pointsrevamp[i]];
-            }
-            prim->points.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, pointsrevamp);
-            });
-            prim->points.resize(pointsrevamp.size());
+    } else {
+        auto revamp = parallel_compact_indices(prim->size(), match);
+        primRevampVerts(prim, revamp);
+        if (!revampAttrO.empty()) {
+            prim->add_attr<int>(revampAttrO) = std::move(revamp);
         }
-
     }
 }
 
-static void primRevampFaces(PrimitiveObject *prim, std::vector<uint8_t> const &unrevamp) {
-    if ((0
-            || prim->tris.size()
-            || prim->quads.size()
-            || prim->lines.size()
-            || prim->edges.size()
-            || prim->polys.size()
-            || prim->points.size()
-         )) {
-
-        auto mock = [&] (int const &x) -> bool {
-            return unrevamp[x];
-        };
-
-        if (prim->tris.size()) {
-            std::vector<int> trisrevamp;
-            trisrevamp.reserve(prim->tris.size());
-            for (int i = 0; i < prim->tris.size(); i++) {
-                auto &tri = prim->tris[i];
-                //ZENO_P(tri);
-                //ZENO_P(unrevamp[tri[0]]);
-                //ZENO_P(unrevamp[tri[1]]);
-                //ZENO_P(unrevamp[tri[2]]);
-                if (mock(tri[0]) || mock(tri[1]) || mock(tri[2]))
-                    trisrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < trisrevamp.size(); i++) {
-                prim->tris[i] = prim->tris[trisrevamp[i]];
-            }
-            prim->tris.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, trisrevamp);
-            });
-            prim->tris.resize(trisrevamp.size());
-        }
-
-        if (prim->quads.size()) {
-            std::vector<int> quadsrevamp;
-            quadsrevamp.reserve(prim->quads.size());
-            for (int i = 0; i < prim->quads.size(); i++) {
-                auto &quad = prim->quads[i];
-                if (mock(quad[0]) || mock(quad[1]) || mock(quad[2]) || mock(quad[3]))
-                    quadsrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < quadsrevamp.size(); i++) {
-                prim->quads[i] = prim->quads[quadsrevamp[i]];
-            }
-            prim->quads.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, quadsrevamp);
-            });
-            prim->quads.resize(quadsrevamp.size());
-        }
-
-        if (prim->lines.size()) {
-            std::vector<int> linesrevamp;
-            linesrevamp.reserve(prim->lines.size());
-            for (int i = 0; i < prim->lines.size(); i++) {
-                auto &line = prim->lines[i];
-                if (mock(line[0]) || mock(line[1]))
-                    linesrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < linesrevamp.size(); i++) {
-                prim->lines[i] = prim->lines[linesrevamp[i]];
-            }
-            prim->lines.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, linesrevamp);
-            });
-            prim->lines.resize(linesrevamp.size());
-        }
-
-        if (prim->edges.size()) {
-            std::vector<int> edgesrevamp;
-            edgesrevamp.reserve(prim->edges.size());
-            for (int i = 0; i < prim->edges.size(); i++) {
-                auto &edge = prim->edges[i];
-                if (mock(edge[0]) || mock(edge[1]))
-                    edgesrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < edgesrevamp.size(); i++) {
-                prim->edges[i] = prim->edges[edgesrevamp[i]];
-            }
-            prim->edges.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, edgesrevamp);
-            });
-            prim->edges.resize(edgesrevamp.size());
-        }
-
-        if (prim->polys.size()) {
-            std::vector<int> polysrevamp;
-            polysrevamp.reserve(prim->polys.size());
-            for (int i = 0; i < prim->polys.size(); i++) {
-                auto &poly = prim->polys[i];
-                bool succ = [&] {
-                    for (int p = poly[0]; p < poly[0] + poly[1]; p++)
-                        if (mock(prim->loops[p]))
-                            return true;
-                    return false;
-                }();
-                if (succ)
-                    polysrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < polysrevamp.size(); i++) {
-                prim->polys[i] = prim->polys[polysrevamp[i]];
-            }
-            prim->polys.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, polysrevamp);
-            });
-            prim->polys.resize(polysrevamp.size());
-        }
-
-        if (prim->points.size()) {
-            std::vector<int> pointsrevamp;
-            pointsrevamp.reserve(prim->points.size());
-            for (int i = 0; i < prim->points.size(); i++) {
-                auto &point = prim->points[i];
-                if (mock(point))
-                    pointsrevamp.emplace_back(i);
-            }
-            for (int i = 0; i < pointsrevamp.size(); i++) {
-                prim->points[i] = prim->points[pointsrevamp[i]];
-            }
-            prim->points.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, pointsrevamp);
-            });
-            prim->points.resize(pointsrevamp.size());
-        }
-
-    }
+ZENO_API void primKillDeadVerts(PrimitiveObject *prim) {
+    size_t nverts = prim->verts.size();
+    std::vector<std::atomic<uint8_t>> reached(nverts);
+    auto mark = [&] (int x) {
+        if (x >= 0 && x < (int)nverts)
+            reached[x].store(1, std::memory_order_relaxed);
+    };
+    parallel_for(prim->points.size(), [&] (size_t i) {
+        mark(prim->points[i]);
+    });
+    parallel_for(prim->lines.size(), [&] (size_t i) {
+        mark(prim->lines[i][0]);
+        mark(prim->lines[i][1]);
+    });
+    parallel_for(prim->edges.size(), [&] (size_t i) {
+        mark(prim->edges[i][0]);
+        mark(prim->edges[i][1]);
+    });
+    parallel_for(prim->tris.size(), [&] (size_t i) {
+        mark(prim->tris[i][0]);
+        mark(prim->tris[i][1]);
+        mark(prim->tris[i][2]);
+    });
+    parallel_for(prim->quads.size(), [&] (size_t i) {
+        mark(prim->quads[i][0]);
+        mark(prim->quads[i][1]);
+        mark(prim->quads[i][2]);
+        mark(prim->quads[i][3]);
+    });
+    parallel_for(prim->polys.size(), [&] (size_t i) {
+        auto [start, len] = prim->polys[i];
+        for (int p = start; p < start + len; p++)
+            mark(prim->loops[p]);
+    });
+    auto revamp = parallel_compact_indices(nverts, [&] (int i) {
+        return reached[i].load(std::memory_order_relaxed) != 0;
+    });
+    primRevampVerts(prim, revamp);
 }
 
 namespace {
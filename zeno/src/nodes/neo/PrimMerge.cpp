@@ -5,466 +5,152 @@
 #include <zeno/types/ListObject.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/para/parallel_for.h>
+#include <zeno/utils/type_traits.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
 
 namespace zeno {
 
-ZENO_API std::shared_ptr<zeno::PrimitiveObject> primMerge(std::vector<zeno::PrimitiveObject *> const &primList, std::string const &tagAttr) {
-    //zeno::log_critical("asdfjhl {}", primList.size());
-    //throw;
-
-    auto outprim = std::make_shared<PrimitiveObject>();
-
-    if (primList.size()) {
-        std::vector<size_t> bases(primList.size() + 1);
-        std::vector<size_t> pointbases(primList.size() + 1);
-        std::vector<size_t> linebases(primList.size() + 1);
-        std::vector<size_t> tribases(primList.size() + 1);
-        std::vector<size_t> quadbases(primList.size() + 1);
-        std::vector<size_t> loopbases(primList.size() + 1);
-        std::vector<size_t> uvbases(primList.size() + 1);
-        std::vector<size_t> polybases(primList.size() + 1);
-        size_t total = 0;
-        size_t pointtotal = 0;
-        size_t linetotal = 0;
-        size_t tritotal = 0;
-        size_t quadtotal = 0;
-        size_t looptotal = 0;
-        size_t uvtotal = 0;
-        size_t polytotal = 0;
-        for (size_t primIdx = 0; primIdx < primList.size(); primIdx++) {
-            auto prim = primList[primIdx];
-            total += prim->verts.size();
-            pointtotal += prim->points.size();
-            linetotal += prim->lines.size();
-            tritotal += prim->tris.size();
-            quadtotal += prim->quads.size();
-            looptotal += prim->loops.size();
-            uvtotal += prim->uvs.size();
-            polytotal += prim->polys.size();
-            bases[primIdx + 1] = total;
-            pointbases[primIdx + 1] = pointtotal;
-            linebases[primIdx + 1] = linetotal;
-            tribases[primIdx + 1] = tritotal;
-            quadbases[primIdx + 1] = quadtotal;
-            loopbases[primIdx + 1] = looptotal;
-            uvbases[primIdx + 1] = uvtotal;
-            polybases[primIdx + 1] = polytotal;
-        }
-        outprim->verts.resize(total);
-        outprim->points.resize(pointtotal);
-        outprim->lines.resize(linetotal);
-        outprim->tris.resize(tritotal);
-        outprim->quads.resize(quadtotal);
-        outprim->loops.resize(looptotal);
-        outprim->uvs.resize(uvtotal);
-        outprim->polys.resize(polytotal);
-
-        if (tagAttr.size()) {
-            outprim->verts.add_attr<int>(tagAttr);
-            outprim->points.add_attr<int>(tagAttr);
-            outprim->lines.add_attr<int>(tagAttr);
-            outprim->tris.add_attr<int>(tagAttr);
-            outprim->quads.add_attr<int>(tagAttr);
-            outprim->loops.add_attr<int>(tagAttr);
-            outprim->uvs.add_attr<int>(tagAttr);
-            outprim->polys.add_attr<int>(tagAttr);
-        }
-        for (size_t primIdx = 0; primIdx < primList.size(); primIdx++) {
-            auto const &prim = primList[primIdx];
-            prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->verts.add_attr<T>(key);
-            });
-            prim->points.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->points.add_attr<T>(key);
-            });
-            prim->lines.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->lines.add_attr<T>(key);
-            });
-            prim->tris.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->tris.add_attr<T>(key);
-            });
-            prim->quads.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->quads.add_attr<T>(key);
-            });
-            prim->loops.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->loops.add_attr<T>(key);
-            });
-            prim->uvs.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->uvs.add_attr<T>(key);
-            });
-            prim->polys.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                outprim->polys.add_attr<T>(key);
-            });
-        }
-
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto base = bases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->verts.values;
-                    } else {
-                        return outprim->verts.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->verts.size());
-                for (size_t i = 0; i < n; i++) {
-                    outarr[base + i] = arr[i];
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->verts.values;
-                    size_t n = std::min(arr.size(), prim->verts.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->verts.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->verts.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->verts.values);
-            prim->verts.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->verts.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->verts.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
-        });
-
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto vbase = bases[primIdx];
-            auto base = linebases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->points.values;
-                    } else {
-                        return outprim->points.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->points.size());
-                for (size_t i = 0; i < n; i++) {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        outarr[base + i] = vbase + arr[i];
-                    } else {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->points.values;
-                    size_t n = std::min(arr.size(), prim->points.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = vbase + arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->points.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->points.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->points.values);
-            prim->points.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->points.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->points.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
-        });
+namespace {
 
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto vbase = bases[primIdx];
-            auto base = linebases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->lines.values;
-                    } else {
-                        return outprim->lines.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->lines.size());
-                for (size_t i = 0; i < n; i++) {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        outarr[base + i] = vbase + arr[i];
-                    } else {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->lines.values;
-                    size_t n = std::min(arr.size(), prim->lines.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = vbase + arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->lines.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->lines.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->lines.values);
-            prim->lines.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->lines.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->lines.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
-        });
+template <class T>
+struct merge_scalar {
+    using type = T;
+};
 
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto vbase = bases[primIdx];
-            auto base = tribases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->tris.values;
-                    } else {
-                        return outprim->tris.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->tris.size());
-                for (size_t i = 0; i < n; i++) {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        outarr[base + i] = vbase + arr[i];
-                    } else {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->tris.values;
-                    size_t n = std::min(arr.size(), prim->tris.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = vbase + arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->tris.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->tris.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->tris.values);
-            prim->tris.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->tris.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->tris.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
-        });
+template <size_t N, class T>
+struct merge_scalar<vec<N, T>> {
+    using type = T;
+};
 
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto vbase = bases[primIdx];
-            auto base = quadbases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->quads.values;
-                    } else {
-                        return outprim->quads.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->quads.size());
-                for (size_t i = 0; i < n; i++) {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        outarr[base + i] = vbase + arr[i];
-                    } else {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->quads.values;
-                    size_t n = std::min(arr.size(), prim->quads.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = vbase + arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->quads.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->quads.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->quads.values);
-            prim->quads.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->quads.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->quads.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
+// copy n elements adding offset to all their integer components, on the flat
+// scalars so that the loop vectorizes; big blocks are split between threads
+template <class T>
+void merge_block(T *dst, T const *src, size_t n, int offset) {
+    using S = typename merge_scalar<T>::type;
+    parallel_for_chunked((size_t)0, n, [&] (size_t b, size_t e) {
+        if constexpr (std::is_integral_v<S>) {
+            if (offset) {
+                S *d = reinterpret_cast<S *>(dst + b);
+                S const *s = reinterpret_cast<S const *>(src + b);
+                size_t m = (e - b) * (sizeof(T) / sizeof(S));
+                for (size_t k = 0; k < m; k++)
+                    d[k] = s[k] + (S)offset;
+                return;
             }
-        });
+        }
+        std::copy(src + b, src + e, dst + b);
+    }, (size_t)1 << 16);
+}
 
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto vbase = bases[primIdx];
-            auto base = loopbases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->loops.values;
-                    } else {
-                        return outprim->loops.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->loops.size());
-                for (size_t i = 0; i < n; i++) {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        outarr[base + i] = vbase + arr[i];
-                    } else {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->loops.values;
-                    size_t n = std::min(arr.size(), prim->loops.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = vbase + arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->loops.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->loops.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->loops.values);
-            prim->loops.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->loops.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->loops.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
-        });
+// the element arrays of a prim, all merged the same way
+constexpr auto mergeElms = std::make_tuple(
+    &PrimitiveObject::verts, &PrimitiveObject::points, &PrimitiveObject::lines,
+    &PrimitiveObject::tris, &PrimitiveObject::quads, &PrimitiveObject::loops,
+    &PrimitiveObject::uvs, &PrimitiveObject::polys, &PrimitiveObject::edges);
+constexpr size_t mergeNumElms = std::tuple_size_v<decltype(mergeElms)>;
+
+// copy the elements of one prim into their slot of the merged prim, indices
+// are rebased by offset, attribute key by attrOffset(key)
+template <class ValT, class AttrOffset>
+void merge_copy(AttrVector<ValT> const &in, AttrVector<ValT> &out, size_t primIdx, size_t base, int offset, std::string const &tagAttr, AttrOffset attrOffset) {
+    size_t n = in.size();
+    if (!n)
+        return;
+    merge_block(out.values.data() + base, in.values.data(), n, offset);
+    in.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using T = std::decay_t<decltype(arr[0])>;
+        if (key == tagAttr)
+            return;
+        auto &outarr = out.template attr<T>(key);
+        merge_block(outarr.data() + base, arr.data(), std::min(arr.size(), n), attrOffset(key));
+    });
+    if (tagAttr.size()) {
+        auto &outarr = out.template attr<int>(tagAttr);
+        std::fill_n(outarr.begin() + base, n, (int)primIdx);
+    }
+}
 
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto base = uvbases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->uvs.values;
-                    size_t n = std::min(arr.size(), prim->uvs.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = base + arr[i];
-                    }
-                } else {
-                    auto &outarr = outprim->uvs.attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->uvs.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-            };
-            core(std::true_type{}, prim->uvs.values);
-            prim->uvs.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->uvs.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->uvs.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
-        });
+}
 
-        parallel_for(primList.size(), [&] (size_t primIdx) {
-            auto prim = primList[primIdx];
-            auto lbase = loopbases[primIdx];
-            auto base = polybases[primIdx];
-            auto core = [&] (auto key, auto const &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-#if 0
-                auto &outarr = [&] () -> auto & {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        return outprim->polys.values;
-                    } else {
-                        return outprim->polys.attr<T>(key);
-                    }
-                }();
-                size_t n = std::min(arr.size(), prim->polys.size());
-                for (size_t i = 0; i < n; i++) {
-                    if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                        outarr[base + i] = {arr[i].first + lbase, arr[i].second};
-                    } else {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#else
-                if constexpr (std::is_same_v<decltype(key), std::true_type>) {
-                    auto &outarr = outprim->polys.values;
-                    size_t n = std::min(arr.size(), prim->polys.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = {arr[i][0] + (int)lbase, arr[i][1]};
-                    }
-                } else {
-                    auto &outarr = outprim->polys.add_attr<T>(key);
-                    size_t n = std::min(arr.size(), prim->polys.size());
-                    for (size_t i = 0; i < n; i++) {
-                        outarr[base + i] = arr[i];
-                    }
-                }
-#endif
-            };
-            core(std::true_type{}, prim->polys.values);
-            prim->polys.foreach_attr<AttrAcceptAll>(core);
-            if (tagAttr.size()) {
-                auto &outarr = outprim->polys.attr<int>(tagAttr);
-                for (size_t i = 0; i < prim->polys.size(); i++) {
-                    outarr[base + i] = primIdx;
-                }
-            }
+ZENO_API std::shared_ptr<zeno::PrimitiveObject> primMerge(std::vector<zeno::PrimitiveObject *> const &primList, std::string const &tagAttr) {
+    auto outprim = std::make_shared<PrimitiveObject>();
+    size_t nprims = primList.size();
+    if (!nprims)
+        return outprim;
+
+    // plan: sizes and attribute presence of all prims in one parallel pass
+    // (touching each prim once), offsets by a scan, then the attribute union
+    // visiting only the prims that do have attributes
+    std::vector<std::array<size_t, mergeNumElms>> bases(nprims + 1);
+    std::vector<uint16_t> hasAttrs(nprims);
+    parallel_for(nprims, [&] (size_t primIdx) {
+        auto prim = primList[primIdx];
+        static_for<0, mergeNumElms>([&] (auto k) {
+            auto const &elms = prim->*std::get<k.value>(mergeElms);
+            bases[primIdx][k.value] = elms.size();
+            if (elms.template num_attrs<AttrAcceptAll>())
+                hasAttrs[primIdx] |= 1 << k.value;
         });
+    });
+    std::array<size_t, mergeNumElms> total{};
+    for (size_t primIdx = 0; primIdx <= nprims; primIdx++) {
+        for (size_t k = 0; k < mergeNumElms; k++) {
+            size_t n = bases[primIdx][k];
+            bases[primIdx][k] = total[k];
+            total[k] += n;
+        }
     }
+    static_for<0, mergeNumElms>([&] (auto k) {
+        auto &out = outprim.get()->*std::get<k.value>(mergeElms);
+        out.resize(total[k.value]);
+        for (size_t primIdx = 0; primIdx < nprims; primIdx++) {
+            if (!(hasAttrs[primIdx] & 1 << k.value))
+                continue;
+            (primList[primIdx]->*std::get<k.value>(mergeElms)).template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+                using T = std::decay_t<decltype(arr[0])>;
+                if (key == tagAttr)
+                    return;
+                if (!out.has_attr(key))
+                    out.template add_attr<T>(key);
+                else
+                    (void)out.template attr<T>(key); // throws on conflicting types
+            });
+        }
+        // value initialized, so prims lacking an attribute leave its default
+        if (tagAttr.size())
+            out.template add_attr<int>(tagAttr);
+    });
+
+    auto noOffset = [] (std::string const &key) {
+        return 0;
+    };
+    parallel_for(nprims, [&] (size_t primIdx) {
+        auto prim = primList[primIdx];
+        auto const &base = bases[primIdx];
+        int vbase = (int)base[0];
+        int lbase = (int)base[5];
+        int uvbase = (int)base[6];
+        merge_copy(prim->verts, outprim->verts, primIdx, base[0], 0, tagAttr, noOffset);
+        merge_copy(prim->points, outprim->points, primIdx, base[1], vbase, tagAttr, noOffset);
+        merge_copy(prim->lines, outprim->lines, primIdx, base[2], vbase, tagAttr, noOffset);
+        merge_copy(prim->tris, outprim->tris, primIdx, base[3], vbase, tagAttr, noOffset);
+        merge_copy(prim->quads, outprim->quads, primIdx, base[4], vbase, tagAttr, noOffset);
+        merge_copy(prim->loops, outprim->loops, primIdx, base[5], vbase, tagAttr, [&] (std::string const &key) {
+            return key == "uvs" ? uvbase : 0;
+        });
+        merge_copy(prim->uvs, outprim->uvs, primIdx, base[6], 0, tagAttr, noOffset);
+        // polys are (loop base, count) pairs, only the base is rebased
+        merge_copy(prim->polys, outprim->polys, primIdx, base[7], 0, tagAttr, noOffset);
+        if (lbase) {
+            for (size_t i = 0; i < prim->polys.size(); i++)
+                outprim->polys[base[7] + i][0] += lbase;
+        }
+        merge_copy(prim->edges, outprim->edges, primIdx, base[8], vbase, tagAttr, noOffset);
+    });
 
     return outprim;
 }
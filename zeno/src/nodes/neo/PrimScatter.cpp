@@ -5,13 +5,16 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/para/parallel_for.h>
 #include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_reduce.h>
+#include <zeno/para/parallel_radix_sort.h>
+#include <zeno/para/parallel_compact.h>
 #define ZENO_NOTICKTOCK
 #include <zeno/utils/ticktock.h>
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/wangsrng.h>
-#include <zeno/utils/tuple_hash.h>
 #include <zeno/utils/log.h>
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
 #include <random>
 #include <cmath>
 #ifndef M_PI
@@ -20,64 +23,132 @@
 
 namespace zeno {
 
-template <class T>
-static void revamp_vector(std::vector<T> &arr, std::vector<int> const &revamp) {
-    std::vector<T> newarr(arr.size());
-    for (int i = 0; i < revamp.size(); i++) {
-        newarr[i] = arr[revamp[i]];
-    }
-    std::swap(arr, newarr);
-}
-
+// greedy poisson disk thinning: a point is kept if no kept point lies within
+// minRadius. points are bucketed into cells of size minRadius by a counting
+// sort, so that only the 27 neighbor cells need to be tested; cells are then
+// colored by the parity of their coordinates, cells of the same color never
+// neighbor each other and can be swept in parallel, 8 colors one after another.
+// each cell visits its points by ascending index, so the result only depends
+// on the input (thus the seed), not on the thread count
 static void primPossionFilter(PrimitiveObject *prim, float minRadius) {
     if (minRadius <= 0) return;
+    size_t n = prim->verts.size();
+    if (!n) return;
 
     TICK(possion);
-    float invRadius = 1.f / minRadius;
-    std::unordered_map<vec3i, std::vector<int>, tuple_hash, tuple_equal> lut;
-    for (int i = 0; i < prim->verts.size(); i++) {
-        vec3i ipos(prim->verts[i] * invRadius);
-        lut[ipos].push_back(i);
+    auto const &pos = prim->verts.values;
+    double invRadius = 1.0 / minRadius;
+    float radius2 = minRadius * minRadius;
+
+    auto bmin = parallel_reduce_min(pos.begin(), pos.end());
+    // 21 bits per axis, only the neighbors of the border cells wrap around,
+    // which costs some more distance tests; the parity coloring survives it
+    auto cellKey = [] (vec3i c) {
+        return (uint64_t)(c[0] & 0x1fffff) << 42 | (uint64_t)(c[1] & 0x1fffff) << 21 | (uint64_t)(c[2] & 0x1fffff);
+    };
+    auto keyCell = [] (uint64_t key) {
+        return vec3i(key >> 42 & 0x1fffff, key >> 21 & 0x1fffff, key & 0x1fffff);
+    };
+    // cell coordinates are clamped to the 21 bits before the int conversion, a
+    // tiny minRadius would overflow it otherwise; clamping never moves two
+    // points farther apart in cells, so neighbors stay within the 27 cells
+    auto posCell = [&] (vec3f const &p) {
+        vec3i c;
+        for (int d = 0; d < 3; d++) {
+            double x = std::floor((double)(p[d] - bmin[d]) * invRadius);
+            c[d] = x >= 0 ? (int)std::min(x, (double)0x1fffff) : 0;
+        }
+        return c;
+    };
+    // sort (key, index) pairs so that the radix passes stream through memory
+    std::vector<std::pair<uint64_t, int>> sorted(n);
+    parallel_for(n, [&] (size_t i) {
+        sorted[i] = {cellKey(posCell(pos[i])), (int)i};
+    });
+    parallel_radix_sort(sorted, [] (std::pair<uint64_t, int> const &p) {
+        return p.first;
+    });
+
+    // cells as runs of the sorted points, cellBegin[c]..cellBegin[c + 1]
+    std::vector<uint8_t> isHead(n);
+    parallel_for(n, [&] (size_t j) {
+        isHead[j] = j == 0 || sorted[j].first != sorted[j - 1].first;
+    });
+    std::vector<int> cellId(n);
+    int ncells = parallel_exclusive_scan_sum(isHead.begin(), isHead.end(), cellId.begin(), [] (uint8_t x) {
+        return (int)x;
+    });
+    std::vector<int> cellBegin(ncells + 1);
+    std::vector<uint64_t> keys(ncells);
+    parallel_for(n, [&] (size_t j) {
+        if (isHead[j]) {
+            cellBegin[cellId[j]] = (int)j;
+            keys[cellId[j]] = sorted[j].first;
+        }
+    });
+    cellBegin[ncells] = (int)n;
+
+    // positions in sorted order for cache friendly neighbor scans
+    std::vector<vec3f> spos(n);
+    parallel_for(n, [&] (size_t j) {
+        spos[j] = pos[sorted[j].second];
+    });
+
+    std::vector<int> colorCells[8];
+    for (int c = 0; c < ncells; c++) {
+        vec3i ic = keyCell(keys[c]);
+        colorCells[(ic[0] & 1) | (ic[1] & 1) << 1 | (ic[2] & 1) << 2].push_back(c);
     }
 
-    std::vector<uint8_t> erased(prim->verts.size());
-    for (int i = 0; i < prim->verts.size(); i++) {
-        if (erased[i])
-            continue;
-        vec3i ipos(prim->verts[i] * invRadius);
-        erased[i] = [&] {
-            for (int dz = -1; dz <= 1; dz++) {
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        auto it = lut.find(ipos + vec3i(dx, dy, dz));
-                        if (it != lut.end()) {
-                            for (int j: it->second) {
-                                if (j == i || erased[j])
-                                    continue;
-                                auto dis = prim->verts[i] - prim->verts[j];
-                                if (length(dis) < minRadius)
-                                    return true;
-                            }
+    // kept points of a cell are packed at its front, in keptPos[cellBegin[c]..
+    // cellBegin[c] + nkept[c]], so neighbor scans skip the rejected candidates
+    std::vector<vec3f> keptPos(n);
+    std::vector<int> nkept(ncells);
+    std::vector<uint8_t> kept(n);
+    for (int color = 0; color < 8; color++) {
+        auto const &cells = colorCells[color];
+        parallel_for(cells.size(), [&] (size_t k) {
+            int c = cells[k];
+            vec3i ic = keyCell(keys[c]);
+            int nbrs[27];
+            int nnbrs = 0;
+            for (int dz = -1; dz <= 1; dz++) for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++) {
+                uint64_t key = cellKey(ic + vec3i(dx, dy, dz));
+                auto it = std::lower_bound(keys.begin(), keys.end(), key);
+                if (it != keys.end() && *it == key)
+                    nbrs[nnbrs++] = it - keys.begin();
+            }
+            for (int j = cellBegin[c]; j < cellBegin[c + 1]; j++) {
+                bool ok = true;
+                for (int m = 0; m < nnbrs && ok; m++) {
+                    int b = cellBegin[nbrs[m]], e = b + nkept[nbrs[m]];
+                    for (int l = b; l < e; l++) {
+                        if (lengthSquared(keptPos[l] - spos[j]) < radius2) {
+                            ok = false;
+                            break;
                         }
                     }
                 }
+                if (ok) {
+                    keptPos[cellBegin[c] + nkept[c]++] = spos[j];
+                    kept[j] = 1;
+                }
             }
-            return false;
-        }();
+        });
     }
 
-    std::vector<int> revamp(prim->verts.size());
-    int nrevamp = 0;
-    for (int i = 0; i < erased.size(); i++) {
-        if (!erased[i])
-            revamp[nrevamp++] = i;
-    }
-    revamp.resize(nrevamp);
+    std::vector<uint8_t> keep(n);
+    parallel_for(n, [&] (size_t j) {
+        keep[sorted[j].second] = kept[j];
+    });
+    auto revamp = parallel_compact_indices(n, [&] (int i) {
+        return keep[i] != 0;
+    });
 
-    prim->verts.forall_attr([&] (auto const &key, auto &arr) {
-        revamp_vector(arr, revamp);
+    prim->verts.forall_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        parallel_gather(arr, revamp);
     });
-    prim->verts.resize(nrevamp);
+    prim->verts.resize(revamp.size());
     TOCK(possion);
 }
 
@@ -3,19 +3,175 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/NumericObject.h>
-#include <unordered_map>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_radix_sort.h>
+#include <zeno/para/parallel_compact.h>
+#include <zeno/para/parallel_union_find.h>
+#include <zeno/utils/log.h>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 
 namespace zeno {
 namespace {
 
-template <class T>
-static void revamp_vector(std::vector<T> &arr, std::vector<int> const &revamp) {
-    std::vector<T> newarr(arr.size());
-    for (int i = 0; i < revamp.size(); i++) {
-        newarr[i] = arr[revamp[i]];
+// welds the vertices sharing the same group id, group[i] <= i is not required.
+// vertices are sorted by (group, index) with a radix sort so that every group
+// becomes a contiguous run, new vertices keep the order of their first member
+static int weld_by_group(PrimitiveObject *prim, std::vector<int> const &group, bool isAverage) {
+    size_t n = prim->verts.size();
+    std::vector<int> sorted(n);
+    parallel_for(n, [&] (size_t i) {
+        sorted[i] = (int)i;
+    });
+    parallel_radix_sort(sorted, [&] (int i) {
+        return (uint32_t)group[i] ^ 0x80000000u;
+    });
+
+    // head of run: first (thus smallest index) vertex of its group
+    std::vector<int> headPos(n);
+    parallel_inclusive_scan((size_t)0, n, headPos.begin(), 0, [] (int x, int y) {
+        return std::max(x, y);
+    }, [&] (size_t j) {
+        return j == 0 || group[sorted[j]] != group[sorted[j - 1]] ? (int)j : 0;
+    });
+
+    std::vector<uint8_t> isRep(n);
+    parallel_for(n, [&] (size_t j) {
+        if (headPos[j] == (int)j)
+            isRep[sorted[j]] = 1;
+    });
+    std::vector<int> newId(n);
+    int nrevamp = parallel_exclusive_scan_sum(isRep.begin(), isRep.end(), newId.begin(), [] (uint8_t x) {
+        return (int)x;
+    });
+
+    // unrevamp[old_coor] = new_coor, revamp[new_coor] = old_coor of the head
+    std::vector<int> unrevamp(n);
+    std::vector<int> revamp(nrevamp);
+    std::vector<int> runBegin(nrevamp), runEnd(nrevamp);
+    parallel_for(n, [&] (size_t j) {
+        int head = sorted[headPos[j]];
+        int id = newId[head];
+        unrevamp[sorted[j]] = id;
+        if (headPos[j] == (int)j) {
+            revamp[id] = head;
+            runBegin[id] = (int)j;
+        }
+        if (j + 1 == n || headPos[j + 1] == (int)(j + 1))
+            runEnd[id] = (int)(j + 1);
+    });
+
+    if (isAverage) {
+        auto average = [&] (auto &arr) {
+            using T = std::decay_t<decltype(arr[0])>;
+            std::vector<T> newarr(nrevamp);
+            parallel_for((size_t)nrevamp, [&] (size_t k) {
+                int b = runBegin[k], e = runEnd[k];
+                T sum = arr[sorted[b]];
+                for (int j = b + 1; j < e; j++)
+                    sum += arr[sorted[j]];
+                newarr[k] = e - b > 1 ? sum / (T)(e - b) : sum;
+            });
+            std::swap(arr, newarr);
+        };
+        average(prim->verts.values);
+        prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+            average(arr);
+        });
+    } else {
+        parallel_gather(prim->verts.values, revamp);
+        prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+            parallel_gather(arr, revamp);
+        });
+    }
+
+    auto repair = [&] (int &x) {
+        if (x >= 0 && x < unrevamp.size())
+            x = unrevamp[x];
+    };
+
+    parallel_for(prim->points.size(), [&] (size_t i) {
+        repair(prim->points[i]);
+    });
+
+    // degenerate elements are dropped together with their attributes
+    auto compact = [&] (auto &elems, auto const &keep) {
+        auto kept = parallel_compact_indices(elems.size(), keep);
+        if (kept.size() == elems.size())
+            return;
+        parallel_gather(elems.values, kept);
+        elems.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+            parallel_gather(arr, kept);
+        });
+    };
+
+    parallel_for(prim->lines.size(), [&] (size_t i) {
+        auto &ind = prim->lines[i];
+        repair(ind[0]);
+        repair(ind[1]);
+    });
+    compact(prim->lines, [&] (int i) {
+        auto const &ind = prim->lines[i];
+        return ind[0] != ind[1];
+    });
+
+    parallel_for(prim->tris.size(), [&] (size_t i) {
+        auto &ind = prim->tris[i];
+        repair(ind[0]);
+        repair(ind[1]);
+        repair(ind[2]);
+    });
+    compact(prim->tris, [&] (int i) {
+        auto const &ind = prim->tris[i];
+        return ind[0] != ind[1] && ind[0] != ind[2] && ind[1] != ind[2];
+    });
+
+    std::vector<uint8_t> ridquad(prim->quads.size());
+    parallel_for(prim->quads.size(), [&] (size_t i) {
+        auto ind = prim->quads[i];
+        repair(ind[0]);
+        repair(ind[1]);
+        repair(ind[2]);
+        repair(ind[3]);
+        prim->quads[i] = ind;
+        auto *bit = std::addressof(ind[0]);
+        auto *eit = bit + 4;
+        auto *mit = std::unique(bit, eit);
+        ridquad[i] = mit - bit;
+    });
+    for (size_t i = 0; i < ridquad.size(); i++) {
+        auto ind = prim->quads[i];
+        auto *bit = std::addressof(ind[0]);
+        if (ridquad[i] == 3) {
+            std::unique(bit, bit + 4);
+            prim->tris.emplace_back(ind[0], ind[1], ind[2]);
+        }
     }
-    std::swap(arr, newarr);
+    prim->tris.update();
+    compact(prim->quads, [&] (int i) {
+        return ridquad[i] > 3;
+    });
+
+    parallel_for(prim->loops.size(), [&] (size_t i) {
+        repair(prim->loops[i]);
+    });
+    parallel_for(prim->polys.size(), [&] (size_t i) {
+        auto &[base, len] = prim->polys[i];
+        auto bit = prim->loops.begin() + base;
+        auto eit = prim->loops.begin() + (base + len);
+        auto mit = std::unique(bit, eit);
+        std::fill(mit, eit, 0); // not used anyway... prune later
+        len = mit - bit;
+    });
+    compact(prim->polys, [&] (int i) {
+        return prim->polys[i][1] > 2;
+    });
+
+    prim->verts.resize(nrevamp);
+    return nrevamp;
 }
 
 struct PrimWeld : INode {
@@ -24,142 +180,100 @@ struct PrimWeld : INode {
         auto tagAttr = get_input<StringObject>("tagAttr")->get();
         auto isAverage = get_input<StringObject>("method")->get() == "average";
 
-        std::unordered_multimap<int, int> lut;
-        auto &tag = prim->verts.attr<int>(tagAttr);
-        for (int i = 0; i < prim->size(); i++) {
-            lut.insert({tag[i], i});
-        }
-        std::vector<int> revamp;
-        std::vector<int> unrevamp(prim->size());
-        revamp.resize(lut.size());
-        int nrevamp = 0;
-        for (auto it = lut.begin(); it != lut.end();) {
-            auto nit = std::find_if(std::next(it), lut.end(), [val = it->first] (auto const &p) {
-                return p.first != val;
-            });
-            auto start = it->second;
-            if (isAverage) {
-                vec3f average = prim->verts[start];
-                int count = 1;
-                for (++it; it != nit; ++it) {
-                    unrevamp[it->second] = nrevamp;
-                    auto pos = prim->verts[it->second];
-                    average += pos;
-                    ++count;
-                }
-                average *= 1 / (float)count;
-                prim->verts[start] = average;
-            } else {
-                for (; it != nit; ++it) {
-                    //printf("(%d) %d -> %d\n", it->first, it->second, nrevamp);
-                    unrevamp[it->second] = nrevamp;
-                    // unrevamp[old_coor] = new_coor
-                }
-            }
-            revamp[nrevamp] = start;
-            ++nrevamp;
-        }
-        revamp.resize(nrevamp);
-        //primRevampVerts(prim.get(), revamp, &unrevamp);
-
-        revamp_vector(prim->verts.values, revamp);
-        if (isAverage) {
-            prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                std::vector<T> new_arr(nrevamp);
-                for (size_t i = 0; i < arr.size(); i++) {
-                    new_arr[unrevamp[i]] += arr[i] / (T)lut.count(i);
-                }
-                arr = std::move(new_arr);
-            });
-        } else {
-            prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
-                revamp_vector(arr, revamp);
-            });
-        }
+        auto const &tag = prim->verts.attr<int>(tagAttr);
+        weld_by_group(prim.get(), tag, isAverage);
 
-        auto repair = [&] (int &x) {
-            //printf("%d -> %d\n", x, unrevamp[x]);
-            if (x >= 0 && x < unrevamp.size())
-                x = unrevamp[x];
-        };
+        set_output("prim", std::move(prim));
+    }
+};
 
-        for (size_t i = 0; i < prim->points.size(); i++) {
-            auto &ind = prim->points[i];
-            repair(ind);
-        }
+ZENDEFNODE(PrimWeld, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"string", "tagAttr", "weld"},
+    {"enum oneof average", "method", "oneof"},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
 
-        for (size_t i = 0; i < prim->lines.size(); i++) {
-            auto &ind = prim->lines[i];
-            repair(ind[0]);
-            repair(ind[1]);
-        }
-        prim->lines->erase(std::remove_if(prim->lines.begin(), prim->lines.end(), [&] (auto const &ind) {
-            return ind[0] == ind[1];
-        }), prim->lines.end());
-        prim->lines.update();
-
-        for (size_t i = 0; i < prim->tris.size(); i++) {
-            auto &ind = prim->tris[i];
-            repair(ind[0]);
-            repair(ind[1]);
-            repair(ind[2]);
-        }
-        prim->tris->erase(std::remove_if(prim->tris.begin(), prim->tris.end(), [&] (auto const &ind) {
-            return ind[0] == ind[1] || ind[0] == ind[2] || ind[1] == ind[2];
-        }), prim->tris.end());
-
-        for (size_t i = 0; i < prim->quads.size(); i++) {
-            auto &ind = prim->quads[i];
-            repair(ind[0]);
-            repair(ind[1]);
-            repair(ind[2]);
-            repair(ind[3]);
-        }
-        std::vector<uint8_t> ridquad(prim->quads.size());
-        auto ridquadit = ridquad.begin();
-        for (auto ind: prim->quads) {
-            auto *bit = std::addressof(ind[0]);
-            auto *eit = bit + 4;
-            auto *mit = std::unique(bit, eit);
-            auto len = mit - bit;
-            //if (len != 4) printf("%d\n", len);
-            if (len == 3)
-                prim->tris.emplace_back(ind[0], ind[1], ind[2]);
-            *ridquadit++ = (len <= 3);
-        }
-        prim->tris.update();
-        prim->quads->erase(std::remove_if(prim->quads.begin(), prim->quads.end(), [&] (auto const &ind) {
-            return ridquad[std::addressof(ind) - prim->quads.data()];
-        }), prim->quads.end());
-        prim->quads.update();
-
-        for (size_t i = 0; i < prim->loops.size(); i++) {
-            auto &ind = prim->loops[i];
-            repair(ind);
-        }
-        for (auto &[base, len]: prim->polys) {
-            auto bit = prim->loops.begin() + base;
-            auto eit = prim->loops.begin() + (base + len);
-            auto mit = std::unique(bit, eit);
-            std::fill(mit, eit, 0); // not used anyway... prune later
-            len = mit - bit;
-        }
-        prim->polys->erase(std::remove_if(prim->polys.begin(), prim->polys.end(), [&] (auto const &ply) {
-            return ply[1] <= 2;
-        }), prim->polys.end());
-        prim->polys.update();
+struct PrimFuse : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto distance = get_input2<float>("distance");
+        auto isAverage = get_input2<std::string>("method") == "average";
 
-        prim->resize(nrevamp);
+        size_t n = prim->verts.size();
+        double factor = 1.0 / std::max((double)distance, 1e-30);
+        float dist2 = distance * distance;
+        auto const &pos = prim->verts.values;
+
+        // spatial hash of cells as large as the tolerance. cell coordinates are
+        // 64-bit and clamped so that far vertices or a tiny tolerance can't
+        // overflow, cells aliasing in the hash only cost a few more distance tests
+        std::vector<vec3l> cell(n);
+        parallel_for(n, [&] (size_t i) {
+            for (int d = 0; d < 3; d++) {
+                double c = std::floor(pos[i][d] * factor);
+                c = c == c ? std::clamp(c, -0x1p52, 0x1p52) : 0.0;
+                cell[i][d] = (intptr_t)c;
+            }
+        });
+        auto cellKey = [] (vec3l c) {
+            uint64_t h = (uint64_t)c[0] * 0x9e3779b97f4a7c15ull;
+            h = (h ^ (uint64_t)c[1]) * 0xbf58476d1ce4e5b9ull;
+            h = (h ^ (uint64_t)c[2]) * 0x94d049bb133111ebull;
+            return h ^ h >> 31;
+        };
+        std::vector<uint64_t> keys(n);
+        parallel_for(n, [&] (size_t i) {
+            keys[i] = cellKey(cell[i]);
+        });
+        std::vector<int> sorted(n);
+        parallel_for(n, [&] (size_t i) {
+            sorted[i] = (int)i;
+        });
+        parallel_radix_sort(sorted, [&] (int i) {
+            return keys[i];
+        });
+
+        // union-find over all pairs within the tolerance, roots always link to
+        // the smaller index, so the groups are the transitive closure and don't
+        // depend on the vertex order or on the thread count
+        parallel_union_find uf(n);
+        parallel_for(n, [&] (size_t i) {
+            for (int dz = -1; dz <= 1; dz++) for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++) {
+                uint64_t key = cellKey(cell[i] + vec3l(dx, dy, dz));
+                auto it = std::lower_bound(sorted.begin(), sorted.end(), key, [&] (int j, uint64_t k) {
+                    return keys[j] < k;
+                });
+                // indices are ascending inside a cell, each pair is tested once
+                for (; it != sorted.end() && keys[*it] == key && *it < (int)i; ++it) {
+                    if (lengthSquared(pos[*it] - pos[i]) <= dist2)
+                        uf.unite(*it, (int)i);
+                }
+            }
+        });
+        std::vector<int> group(n);
+        parallel_for(n, [&] (size_t i) {
+            group[i] = uf.find((int)i);
+        });
+
+        int nrevamp = weld_by_group(prim.get(), group, isAverage);
+        zeno::log_info("PrimFuse: collapse from {} to {}", n, nrevamp);
 
         set_output("prim", std::move(prim));
     }
 };
 
-ZENDEFNODE(PrimWeld, {
+ZENDEFNODE(PrimFuse, {
     {
     {"PrimitiveObject", "prim"},
-    {"string", "tagAttr", "weld"},
+    {"float", "distance", "0.00001"},
     {"enum oneof average", "method", "oneof"},
     },
     {
@@ -46,14 +46,14 @@ ZENO_API void primEdgeBound(PrimitiveObject *prim, bool removeFaces, bool toEdge
         append(prim->loops[start + len - 1], prim->loops[start]);
     }
     if (toEdges) {
-        prim->edges.attrs.clear();
+        prim->edges.clear_attrs();
         prim->edges.clear();
         for (auto const &[k, v]: segments) {
             if (!v) prim->edges.push_back(k);
         }
         prim->edges.update();
     } else {
-        prim->lines.attrs.clear();
+        prim->lines.clear_attrs();
         for (auto const &[k, v]: segments) {
             if (!v) prim->lines.push_back(k);
         }
@@ -108,11 +108,11 @@ ZENO_API void primWireframe(PrimitiveObject *prim, bool removeFaces, bool toEdge
         //prim->lines.update();
     //} else {
     if (toEdges) {
-        prim->edges.attrs.clear();
+        prim->edges.clear_attrs();
         prim->edges.values.assign(segments.begin(), segments.end());
         prim->edges.update();
     } else {
-        prim->lines.attrs.clear();
+        prim->lines.clear_attrs();
         prim->lines.values.assign(segments.begin(), segments.end());
         prim->lines.update();
     }
@@ -51,6 +51,8 @@ void dump_obj(PrimitiveObject *prim, std::ostream &fout) {
 struct WriteObjPrim : INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = primExpandInstances(prim.get());
         auto path = get_input<StringObject>("path")->get();
         if (get_param<bool>("polygonate")) {
             primPolygonate(prim.get());
@@ -53,7 +53,7 @@ struct PrimitiveDelAttr : zeno::INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         auto name = get_param<std::string>("name");
-        prim->verts.attrs.erase(name);
+        prim->verts.erase_attr(name);
 
         set_output("prim", get_input("prim"));
     }
@@ -1,5 +1,6 @@
 #include <zeno/zeno.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/PrimitiveIO.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/vec.h>
@@ -15,6 +16,8 @@ struct ExportZpmPrimitive : zeno::INode {
   virtual void apply() override {
     auto path = get_input<StringObject>("path")->get();
     auto prim = get_input<PrimitiveObject>("prim");
+    if (prim->inst)
+        prim = primExpandInstances(prim.get());
     writezpm(prim.get(), path.c_str());
   }
 };
@@ -4,139 +4,256 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/vec.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_radix_sort.h>
 #include <cstring>
 #include <cstdlib>
 #include <cassert>
-#if defined(_OPENMP) && defined(__GNUG__)
-#include <omp.h>
+#include <cmath>
+#include <atomic>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
 #endif
 
 namespace zeno {
-// for parallel atomic float add
-template <typename DstT, typename SrcT> constexpr auto reinterpret_bits(SrcT &&val) {
-    using Src = std::remove_cv_t<std::remove_reference_t<SrcT>>;
-    using Dst = std::remove_cv_t<std::remove_reference_t<DstT>>;
-    static_assert(sizeof(Src) == sizeof(Dst),
-                  "Source Type and Destination Type must be of the same size");
-    static_assert(std::is_trivially_copyable_v<Src> && std::is_trivially_copyable_v<Dst>,
-                  "Both types should be trivially copyable.");
-    static_assert(std::alignment_of_v<Src> % std::alignment_of_v<Dst> == 0,
-                  "The original type should at least have an alignment as strict.");
-    Dst dst{};
-    std::memcpy(&dst, const_cast<const Src *>(&val), sizeof(Dst));
-    return dst;
-  }
-ZENO_API void primCalcNormal(zeno::PrimitiveObject* prim, float flip, std::string nrmAttr)
-{
-    auto &nrm = prim->add_attr<zeno::vec3f>(nrmAttr);
-    auto &pos = prim->verts.values;
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < nrm.size(); i++) {
-        nrm[i] = zeno::vec3f(0);
-    }
+// vertex -> face corner adjacency in CSR form. corners are numbered tris
+// first (3 per tri), then quads (4 per quad), then one per loop
+struct PrimitiveVertexCorners {
+    size_t ntris = 0, nquads = 0, nloops = 0;
+    std::vector<int> offsets; // nverts + 1
+    std::vector<int> corners;
+};
 
-#if defined(_OPENMP) && defined(__GNUG__)
-    auto atomicCas = [](int* dest, int expected, int desired) {
-        __atomic_compare_exchange_n(const_cast<int volatile *>(dest), &expected,
-                                    desired, false, __ATOMIC_ACQ_REL,
-                                    __ATOMIC_RELAXED);
-        return expected;
-    };
-    auto atomicFloatAdd = [&](float*dst, float val) {
-        static_assert(sizeof(float) == sizeof(int), "sizeof float != sizeof int");
-        int oldVal = reinterpret_bits<int>(*dst);
-        int newVal = reinterpret_bits<int>(reinterpret_bits<float>(oldVal) + val), readVal{};
-        while ((readVal = atomicCas((int*)dst, oldVal, newVal)) != oldVal) {
-            oldVal = readVal;
-            newVal = reinterpret_bits<int>(reinterpret_bits<float>(readVal) + val);
-        }
-        return reinterpret_bits<float>(oldVal);
+namespace {
+
+using VertexCorners = PrimitiveVertexCorners;
+
+static std::shared_ptr<VertexCorners const> buildVertexCorners(PrimitiveObject const *prim) {
+    auto adj = std::make_shared<VertexCorners>();
+    size_t nverts = prim->verts.size();
+    adj->ntris = prim->tris.size();
+    adj->nquads = prim->quads.size();
+    adj->nloops = prim->loops.size();
+    size_t quadBase = adj->ntris * 3, loopBase = quadBase + adj->nquads * 4;
+    size_t ncorners = loopBase + adj->nloops;
+
+    // out of range indices are keyed past the last vertex and dropped
+    std::vector<uint32_t> cornerVert(ncorners);
+    auto checked = [&] (int v) {
+        return v >= 0 && (size_t)v < nverts ? (uint32_t)v : (uint32_t)nverts;
     };
-#endif
+    parallel_for(adj->ntris, [&] (size_t i) {
+        for (int j = 0; j < 3; j++)
+            cornerVert[i * 3 + j] = checked(prim->tris[i][j]);
+    });
+    parallel_for(adj->nquads, [&] (size_t i) {
+        for (int j = 0; j < 4; j++)
+            cornerVert[quadBase + i * 4 + j] = checked(prim->quads[i][j]);
+    });
+    parallel_for(adj->nloops, [&] (size_t i) {
+        cornerVert[loopBase + i] = checked(prim->loops[i]);
+    });
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < prim->tris.size(); i++) {
-        auto ind = prim->tris[i];
-        auto n = cross(pos[ind[1]] - pos[ind[0]], pos[ind[2]] - pos[ind[0]]);
+    auto &corners = adj->corners;
+    corners.resize(ncorners);
+    parallel_for(ncorners, [&] (size_t c) {
+        corners[c] = (int)c;
+    });
+    parallel_radix_sort(corners, [&] (int c) {
+        return cornerVert[c];
+    });
+
+    // every run boundary fills the offsets of the vertices in between
+    auto &offsets = adj->offsets;
+    offsets.resize(nverts + 1);
+    parallel_for(ncorners + 1, [&] (size_t j) {
+        size_t prev = j == 0 ? 0 : cornerVert[corners[j - 1]] + 1;
+        size_t curr = j == ncorners ? nverts : std::min<size_t>(cornerVert[corners[j]], nverts);
+        for (size_t v = prev; v <= curr; v++)
+            offsets[v] = (int)j;
+    });
+    corners.resize(offsets[nverts]);
+    return adj;
+}
 
-#if defined(_OPENMP) && defined(__GNUG__)
-        for (int j = 0; j != 3; ++j) {
-            auto &n_i = nrm[ind[j]];
-            for (int d = 0; d != 3; ++d)
-                atomicFloatAdd(&n_i[d], n[d]);
+static int cornerVertex(PrimitiveObject const *prim, size_t c) {
+    size_t quadBase = prim->tris.size() * 3, loopBase = quadBase + prim->quads.size() * 4;
+    if (c < quadBase)
+        return prim->tris[c / 3][c % 3];
+    else if (c < loopBase)
+        return prim->quads[(c - quadBase) / 4][(c - quadBase) % 4];
+    else
+        return prim->loops[c - loopBase];
+}
+
+// a complete adjacency lists every corner exactly once, so it matches the
+// topology iff each listed corner still refers to the vertex it is under
+static bool matchesTopology(VertexCorners const &adj, PrimitiveObject const *prim) {
+    size_t nverts = prim->verts.size();
+    if (adj.ntris != prim->tris.size() || adj.nquads != prim->quads.size() ||
+        adj.nloops != prim->loops.size() || adj.offsets.size() != nverts + 1)
+        return false;
+    std::atomic<bool> same{true};
+    parallel_for(nverts, [&] (size_t v) {
+        if (!same.load(std::memory_order_relaxed))
+            return;
+        for (int k = adj.offsets[v]; k < adj.offsets[v + 1]; k++) {
+            if (cornerVertex(prim, adj.corners[k]) != (int)v) {
+                same.store(false, std::memory_order_relaxed);
+                return;
+            }
         }
-#else
-        nrm[ind[0]] += n;
-        nrm[ind[1]] += n;
-        nrm[ind[2]] += n;
-#endif
-    }
+    });
+    return same.load();
+}
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < prim->quads.size(); i++) {
+// the adjacency only depends on the topology and is kept on the prim, so
+// deforming meshes only pay for checking it and for the gather every frame
+static std::shared_ptr<VertexCorners const> getVertexCorners(PrimitiveObject *prim) {
+    if (prim->vertCorners && matchesTopology(*prim->vertCorners, prim))
+        return prim->vertCorners;
+    auto adj = buildVertexCorners(prim);
+    // out of range indices were dropped, such an adjacency can't be checked
+    size_t ncorners = adj->ntris * 3 + adj->nquads * 4 + adj->nloops;
+    prim->vertCorners = adj->corners.size() == ncorners ? adj : nullptr;
+    return adj;
+}
+}
+
+ZENO_API void primCalcNormal(zeno::PrimitiveObject* prim, float flip, std::string nrmAttr,
+                             std::string weighting, float cuspAngle)
+{
+    auto adj = getVertexCorners(prim);
+    auto const &pos = prim->verts.values;
+    size_t nverts = prim->verts.size();
+    size_t quadBase = adj->ntris * 3, loopBase = quadBase + adj->nquads * 4;
+    bool byAngle = weighting == "angle";
+
+    // weighted normal of every face corner, from its next and next-next
+    // vertices like before; angle weighting uses the two adjacent edges
+    std::vector<vec3f> cornerNrm(loopBase + adj->nloops);
+    auto calcCorner = [&] (int prev, int curr, int next, int nnext) {
+        if (byAngle) {
+            auto e1 = pos[next] - pos[curr], e2 = pos[prev] - pos[curr];
+            auto n = cross(e1, e2);
+            float angle = std::atan2(length(n), dot(e1, e2));
+            return normalizeSafe(n) * angle;
+        }
+        return cross(pos[next] - pos[curr], pos[nnext] - pos[curr]);
+    };
+    parallel_for(adj->ntris, [&] (size_t i) {
+        auto ind = prim->tris[i];
+        for (int j = 0; j < 3; j++)
+            cornerNrm[i * 3 + j] = calcCorner(ind[(j + 2) % 3], ind[j], ind[(j + 1) % 3], ind[(j + 2) % 3]);
+    });
+    parallel_for(adj->nquads, [&] (size_t i) {
         auto ind = prim->quads[i];
-        std::array<vec3f, 4> ns = {
-            cross(pos[ind[1]] - pos[ind[0]], pos[ind[2]] - pos[ind[0]]),
-            cross(pos[ind[2]] - pos[ind[1]], pos[ind[3]] - pos[ind[1]]),
-            cross(pos[ind[3]] - pos[ind[2]], pos[ind[0]] - pos[ind[2]]),
-            cross(pos[ind[0]] - pos[ind[3]], pos[ind[1]] - pos[ind[3]]),
+        for (int j = 0; j < 4; j++)
+            cornerNrm[quadBase + i * 4 + j] = calcCorner(ind[(j + 3) % 4], ind[j], ind[(j + 1) % 4], ind[(j + 2) % 4]);
+    });
+    parallel_for(prim->polys.size(), [&] (size_t i) {
+        auto [beg, len] = prim->polys[i];
+        auto ind = [loops = prim->loops.data(), beg = beg, len = len] (int t) -> int {
+            return loops[beg + t % len];
         };
+        for (int j = 0; j < len; ++j)
+            cornerNrm[loopBase + beg + j] = calcCorner(ind(j + len - 1), ind(j), ind(j + 1), ind(j + 2));
+    });
 
-#if defined(_OPENMP) && defined(__GNUG__)
-        for (int j = 0; j != 4; ++j) {
-            auto &n_i = nrm[ind[j]];
-            for (int d = 0; d != 3; ++d)
-                atomicFloatAdd(&n_i[d], ns[j][d]);
-        }
-#else
-        for (int j = 0; j != 4; ++j) {
-            nrm[ind[j]] += ns[j];
-        }
-#endif
+    if (cuspAngle <= 0) {
+        auto &nrm = prim->verts.add_attr<zeno::vec3f>(nrmAttr);
+        parallel_for(nverts, [&] (size_t v) {
+            vec3f sum(0);
+            for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++)
+                sum += cornerNrm[adj->corners[k]];
+            nrm[v] = flip * normalizeSafe(sum);
+        });
+        return;
     }
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < prim->polys.size(); i++) {
-        auto [beg, len] = prim->polys[i];
+    // hard edges: the corners around a vertex are grouped greedily by the
+    // angle to the first corner of each group, every group but the first
+    // one gets a copy of the vertex
+    float cosCusp = std::cos(cuspAngle * (float)(M_PI / 180));
+    std::vector<int> cornerGroup(adj->corners.size());
+    std::vector<int> numExtra(nverts);
+    parallel_for(nverts, [&] (size_t v) {
+        int b = adj->offsets[v], e = adj->offsets[v + 1];
+        int ngroups = 1;
+        for (int k = b; k < e; k++) {
+            auto n = normalizeSafe(cornerNrm[adj->corners[k]]);
+            int g = 0;
+            if (k != b && lengthSquared(n) != 0) {
+                for (g = 0; g < ngroups; g++) {
+                    int seed = b;
+                    while (cornerGroup[seed] != g) seed++;
+                    if (dot(normalizeSafe(cornerNrm[adj->corners[seed]]), n) >= cosCusp)
+                        break;
+                }
+                if (g == ngroups)
+                    ngroups++;
+            }
+            cornerGroup[k] = g;
+        }
+        numExtra[v] = ngroups - 1;
+    });
+    std::vector<int> extraBase(nverts);
+    size_t nextra = parallel_exclusive_scan_sum(numExtra.begin(), numExtra.end(), extraBase.begin());
 
-        auto ind = [loops = prim->loops.data(), beg = beg, len = len] (int t) -> int {
-            if (t >= len) t -= len;
-            return loops[beg + t];
+    std::vector<vec3f> nrmOut(nverts + nextra);
+    std::vector<int> srcVert(nextra);
+    parallel_for(nverts, [&] (size_t v) {
+        int b = adj->offsets[v], e = adj->offsets[v + 1];
+        auto vertOf = [&] (int g) {
+            return g == 0 ? (int)v : (int)(nverts + extraBase[v] + g - 1);
         };
-        for (int j = 0; j < len; ++j) {
-            auto nsj = cross(pos[ind(j + 1)] - pos[ind(j)], pos[ind(j + 2)] - pos[ind(j)]);
-#if defined(_OPENMP) && defined(__GNUG__)
-            auto &n_i = nrm[ind(j)];
-            for (int d = 0; d != 3; ++d)
-                atomicFloatAdd(&n_i[d], nsj[d]);
-#else
-            nrm[ind(j)] += nsj;
-#endif
+        for (int g = 0; g <= numExtra[v]; g++) {
+            vec3f sum(0);
+            for (int k = b; k < e; k++)
+                if (cornerGroup[k] == g)
+                    sum += cornerNrm[adj->corners[k]];
+            nrmOut[vertOf(g)] = flip * normalizeSafe(sum);
+            if (g != 0)
+                srcVert[extraBase[v] + g - 1] = (int)v;
         }
-    }
+        for (int k = b; k < e; k++) {
+            if (cornerGroup[k] == 0) continue;
+            size_t c = adj->corners[k];
+            int nv = vertOf(cornerGroup[k]);
+            if (c < quadBase)
+                prim->tris[c / 3][c % 3] = nv;
+            else if (c < loopBase)
+                prim->quads[(c - quadBase) / 4][(c - quadBase) % 4] = nv;
+            else
+                prim->loops[c - loopBase] = nv;
+        }
+    });
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < nrm.size(); i++) {
-        nrm[i] = flip * normalizeSafe(nrm[i]);
-    }
+    // the split vertices changed the topology under the kept adjacency
+    prim->vertCorners = nullptr;
+    prim->verts.resize(nverts + nextra);
+    parallel_for(nextra, [&] (size_t i) {
+        prim->verts.values[nverts + i] = prim->verts.values[srcVert[i]];
+    });
+    prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        parallel_for(nextra, [&] (size_t i) {
+            arr[nverts + i] = arr[srcVert[i]];
+        });
+    });
+    auto &nrm = prim->verts.add_attr<zeno::vec3f>(nrmAttr);
+    nrm = std::move(nrmOut);
 }
+
 struct PrimitiveCalcNormal : zeno::INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         auto nrmAttr = get_input<StringObject>("nrmAttr")->get();
         auto flip = get_input<NumericObject>("flip")->get<bool>();
-        primCalcNormal(prim.get(), flip ? -1 : 1, nrmAttr);
+        auto weighting = get_input2<std::string>("weighting");
+        auto cuspAngle = get_input2<float>("cuspAngle");
+        primCalcNormal(prim.get(), flip ? -1 : 1, nrmAttr, weighting, cuspAngle);
         set_output("prim", get_input("prim"));
     }
 };
@@ -146,6 +263,8 @@ ZENDEFNODE(PrimitiveCalcNormal, {
     {"prim"},
     {"string", "nrmAttr", "nrm"},
     {"bool", "flip", "0"},
+    {"enum area angle", "weighting", "area"},
+    {"float", "cuspAngle", "0"},
     },
     {"prim"},
     {},
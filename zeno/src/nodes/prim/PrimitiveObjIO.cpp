@@ -1,5 +1,6 @@
 #include <zeno/zeno.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/DictObject.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/PrimitiveTools.h>
@@ -175,6 +176,8 @@ struct WriteObjPrimitive : zeno::INode {
     virtual void apply() override {
         auto path = get_input<zeno::StringObject>("path")->get();
         auto prim = get_input<zeno::PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = zeno::primExpandInstances(prim.get());
         auto &pos = prim->attr<zeno::vec3f>("pos");
         writeobj(prim, path.c_str());
     }
@@ -194,6 +197,8 @@ struct ExportObjPrimitive : WriteObjPrimitive {
     virtual void apply() override {
         auto path = get_input<zeno::StringObject>("path")->get();
         auto prim = get_input<zeno::PrimitiveObject>("prim");
+        if (prim->inst)
+            prim = zeno::primExpandInstances(prim.get());
         auto &pos = prim->attr<zeno::vec3f>("pos");
         writeobj(prim, path.c_str());
     }
@@ -1,41 +1,155 @@
 #include <zeno/zeno.h>
+#include <zeno/core/Graph.h>
+#include <zeno/extra/GraphException.h>
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/types/NumericObject.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/utils/log.h>
+#include <zeno/utils/scope_exit.h>
 #include <zeno/utils/vec.h>
+#include <algorithm>
+#include <functional>
+#include <utility>
 #include <cstring>
 #include <cstdlib>
 
 namespace zeno {
 
+// the elementwise op of one node, func(b, e) handles the elements [b, e)
+struct AttrOpKernel {
+    size_t n = 0;
+    std::function<void(size_t, size_t)> func;
+    std::string nodeName;
+};
+
+// same result as one full pass per kernel in order, since every element
+// only depends on itself, but done block by block so that a block stays in
+// cache across all the kernels of a chain. a failing kernel is reported as
+// an error of the node it came from
+static void run_attr_op_kernels(std::vector<AttrOpKernel> const &kernels) {
+    constexpr size_t blockSize = 2048;
+    size_t n = 0;
+    for (auto const &kernel: kernels)
+        n = std::max(n, kernel.n);
+    parallel_for((n + blockSize - 1) / blockSize, [&] (size_t blk) {
+        size_t b = blk * blockSize;
+        for (auto const &kernel: kernels) {
+            size_t e = std::min(kernel.n, b + blockSize);
+            if (b < e) {
+                GraphException::translated([&] {
+                    kernel.func(b, e);
+                }, kernel.nodeName);
+            }
+        }
+    });
+}
+
+// nodes writing an attribute of primOut elementwise. when primOut comes
+// straight from the primOut of another such node, the chain up to there is
+// fused: every node of it is still applied by the graph, but the upstream
+// ones only build their kernel and hand it down, the last node then runs
+// all of them in one pass
+struct AttrOpNode : INode {
+    virtual AttrOpKernel make_kernel(std::shared_ptr<PrimitiveObject> const &primOut) = 0;
+
+    virtual std::shared_ptr<PrimitiveObject> get_prim_out() {
+        return get_input<PrimitiveObject>("primOut");
+    }
+
+    virtual void apply() override {
+        auto primOut = get_prim_out();
+        auto kernel = make_kernel(primOut);
+        kernel.nodeName = myname;
+        if (fusedInto) {
+            fusedInto->fusedKernels.push_back(std::move(kernel));
+        } else {
+            auto kernels = std::exchange(fusedKernels, {});
+            kernels.push_back(std::move(kernel));
+            if (kernels.size() > 1)
+                log_debug("==> {} fused with {} upstream nodes", myname, kernels.size() - 1);
+            run_attr_op_kernels(kernels);
+        }
+        set_output("primOut", std::move(primOut));
+    }
+
+    virtual void preApply() override {
+        if (fusedInto)
+            return INode::preApply();
+
+        std::vector<AttrOpNode *> chain{this};
+        while (true) {
+            auto it = chain.back()->inputBounds.find("primOut");
+            if (it == chain.back()->inputBounds.end())
+                break;
+            auto const &[sn, ss] = it->second;
+            if (ss != "primOut")
+                break;
+            auto up = dynamic_cast<AttrOpNode *>(graph->nodes.at(sn).get());
+            if (!up || up->fusedInto || std::find(chain.begin(), chain.end(), up) != chain.end())
+                break;
+            chain.push_back(up);
+        }
+        if (chain.size() == 1)
+            return INode::preApply();
+
+        auto isChainOut = [&] (std::pair<std::string, std::string> const &bound) {
+            return bound.second == "primOut" && std::any_of(chain.begin(), chain.end(),
+                [&] (AttrOpNode *node) { return node->myname == bound.first; });
+        };
+        // other inputs first, since they may read primOut of the chain; the
+        // chain nodes they apply run on their own and are not fused anymore
+        for (auto *node: chain) {
+            for (auto const &[ds, bound]: node->inputBounds) {
+                if (ds != "primOut" && !isChainOut(bound))
+                    node->requireInput(ds);
+            }
+        }
+
+        scope_exit _{[&] {
+            for (auto *node: chain)
+                node->fusedInto = nullptr;
+            fusedKernels.clear();
+        }};
+        for (size_t i = 1; i < chain.size(); i++)
+            chain[i]->fusedInto = this;
+        INode::preApply();
+    }
+
+private:
+    AttrOpNode *fusedInto = nullptr;
+    std::vector<AttrOpKernel> fusedKernels;
+};
+
 template <class FuncT>
 struct UnaryOperator {
     FuncT func;
     UnaryOperator(FuncT const &func) : func(func) {}
 
     template <class TOut, class TA>
-    void operator()(std::vector<TOut> &arrOut, std::vector<TA> const &arrA) {
+    AttrOpKernel operator()(std::vector<TOut> &arrOut, std::vector<TA> const &arrA) {
         size_t n = std::min(arrOut.size(), arrA.size());
-        #pragma omp parallel for
-        for (int i = 0; i < n; i++) {
-            auto val = func(arrA[i]);
-            arrOut[i] = (decltype(arrOut[0]))val;
-        }
+        return {n, [func = func, &arrOut, &arrA] (size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) {
+                auto val = func(arrA[i]);
+                arrOut[i] = (decltype(arrOut[0]))val;
+            }
+        }};
     }
 };
 
-struct PrimitiveUnaryOp : INode {
-  virtual void apply() override {
+struct PrimitiveUnaryOp : AttrOpNode {
+  virtual AttrOpKernel make_kernel(std::shared_ptr<PrimitiveObject> const &primOut) override {
     auto primA = get_input<PrimitiveObject>("primA");
-    auto primOut = get_input<PrimitiveObject>("primOut");
     auto attrA = get_param<std::string>(("attrA"));
     auto attrOut = get_param<std::string>(("attrOut"));
     auto op = get_param<std::string>(("op"));
+    AttrOpKernel kernel;
     primOut->attr_visit(attrOut, [&] (auto &arrOut) { primA->attr_visit(attrA, [&] (auto &arrA) {
         if constexpr (is_vec_castable_v<decltype(arrOut[0]), decltype(arrA[0])>) {
             if (0) {
 #define _PER_OP(opname, expr) \
             } else if (op == opname) { \
-                UnaryOperator([](auto const &a) { return expr; })(arrOut, arrA);
+                kernel = UnaryOperator([](auto const &a) { return expr; })(arrOut, arrA);
             _PER_OP("copy", a)
             _PER_OP("neg", -a)
             _PER_OP("sqrt", sqrt(a))
@@ -55,8 +169,7 @@ struct PrimitiveUnaryOp : INode {
             throw Exception("Failed to promote variant type");
         }
     }); });
-
-    set_output("primOut", get_input("primOut"));
+    return kernel;
   }
 };
 
@@ -81,26 +194,27 @@ struct BinaryOperator {
     BinaryOperator(FuncT const &func) : func(func) {}
 
     template <class TOut, class TA, class TB>
-    void operator()(std::vector<TOut> &arrOut,
+    AttrOpKernel operator()(std::vector<TOut> &arrOut,
         std::vector<TA> const &arrA, std::vector<TB> const &arrB) {
         size_t n = std::min(arrOut.size(), std::min(arrA.size(), arrB.size()));
-        #pragma omp parallel for
-        for (int i = 0; i < n; i++) {
-            auto val = func(arrA[i], arrB[i]);
-            arrOut[i] = (decltype(arrOut[0]))val;
-        }
+        return {n, [func = func, &arrOut, &arrA, &arrB] (size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) {
+                auto val = func(arrA[i], arrB[i]);
+                arrOut[i] = (decltype(arrOut[0]))val;
+            }
+        }};
     }
 };
 
-struct PrimitiveBinaryOp : INode {
-  virtual void apply() override {
+struct PrimitiveBinaryOp : AttrOpNode {
+  virtual AttrOpKernel make_kernel(std::shared_ptr<PrimitiveObject> const &primOut) override {
     auto primA = get_input<PrimitiveObject>("primA");
     auto primB = get_input<PrimitiveObject>("primB");
-    auto primOut = get_input<PrimitiveObject>("primOut");
     auto attrA = get_param<std::string>(("attrA"));
     auto attrB = get_param<std::string>(("attrB"));
     auto attrOut = get_param<std::string>(("attrOut"));
     auto op = get_param<std::string>(("op"));
+    AttrOpKernel kernel;
     primOut->attr_visit(attrOut, [&](auto &arrOut) {
         using TarrOut = std::remove_cv_t<std::remove_reference_t<decltype(arrOut[0])>>;
         ;
@@ -110,14 +224,14 @@ struct PrimitiveBinaryOp : INode {
                 using TarrB = std::remove_cv_t<std::remove_reference_t<decltype(arrB[0])>>;
                 if constexpr (is_decay_same_v<TarrOut, is_vec_promotable_t<TarrA, TarrB>>) {
                     if constexpr (0) {
-#define _PER_OP(opname, expr)                               \
-    }                                                       \
-    else if (op == opname) {                                \
-        BinaryOperator([](auto const &a_, auto const &b_) { \
-            using PromotedType = decltype(a_ + b_);         \
-            auto a = PromotedType(a_);                      \
-            auto b = PromotedType(b_);                      \
-            return expr;                                    \
+#define _PER_OP(opname, expr)                                        \
+    }                                                                \
+    else if (op == opname) {                                         \
+        kernel = BinaryOperator([](auto const &a_, auto const &b_) { \
+            using PromotedType = decltype(a_ + b_);                  \
+            auto a = PromotedType(a_);                               \
+            auto b = PromotedType(b_);                               \
+            return expr;                                             \
         })(arrOut, arrA, arrB);
                         _PER_OP("copyA", a)
                         _PER_OP("copyB", b)
@@ -141,8 +255,7 @@ struct PrimitiveBinaryOp : INode {
             });
         });
     });
-
-    set_output("primOut", get_input("primOut"));
+    return kernel;
   }
 };
 
@@ -163,21 +276,23 @@ ZENDEFNODE(PrimitiveBinaryOp,
     }});
 
 
-struct PrimitiveMix : INode {
-  virtual void apply() override {
-    auto primA = get_input<PrimitiveObject>("primA");
-    auto primB = get_input<PrimitiveObject>("primB");
-
-    std::shared_ptr<zeno::PrimitiveObject> primOut;
+struct PrimitiveMix : AttrOpNode {
+  virtual std::shared_ptr<PrimitiveObject> get_prim_out() override {
     if (has_input("primOut")) {
-            primOut = get_input<PrimitiveObject>("primOut");
+            return get_input<PrimitiveObject>("primOut");
     } else {
-            primOut = std::make_shared<zeno::PrimitiveObject>(*primA);
+            return std::make_shared<zeno::PrimitiveObject>(*get_input<PrimitiveObject>("primA"));
     }
+  }
+
+  virtual AttrOpKernel make_kernel(std::shared_ptr<PrimitiveObject> const &primOut) override {
+    auto primA = get_input<PrimitiveObject>("primA");
+    auto primB = get_input<PrimitiveObject>("primB");
     auto attrA = get_param<std::string>(("attrA"));
     auto attrB = get_param<std::string>(("attrB"));
     auto attrOut = get_param<std::string>(("attrOut"));
     auto coef = get_input<NumericObject>("coef")->get<float>();
+    AttrOpKernel kernel;
     primOut->attr_visit(attrOut, [&](auto &arrOut) {
         using TarrOut = std::remove_cv_t<std::remove_reference_t<decltype(arrOut)>>;
         primA->attr_visit(attrA, [&](auto &arrA) {
@@ -186,15 +301,16 @@ struct PrimitiveMix : INode {
                 primB->attr_visit(attrB, [&, &arrA = arrA](auto &arrB) {
                     using TarrB = std::remove_cv_t<std::remove_reference_t<decltype(arrB)>>;
                     if constexpr (std::is_same_v<TarrA, TarrB>) {
-#pragma omp parallel for
-                        for (int i = 0; i < arrOut.size(); i++) {
-                            arrOut[i] = (1.0f - coef) * arrA[i] + coef * arrB[i];
-                        }
+                        kernel = {arrOut.size(), [coef, &arrOut, &arrA = arrA, &arrB] (size_t b, size_t e) {
+                            for (size_t i = b; i < e; i++) {
+                                arrOut[i] = (1.0f - coef) * arrA[i] + coef * arrB[i];
+                            }
+                        }};
                     }
                 });
         });
     });
-    set_output("primOut", primOut);
+    return kernel;
   }
 };
 ZENDEFNODE(PrimitiveMix,
@@ -220,25 +336,26 @@ struct HalfBinaryOperator {
     HalfBinaryOperator(FuncT const &func) : func(func) {}
 
     template <class TOut, class TA, class TB>
-    void operator()(std::vector<TOut> &arrOut,
+    AttrOpKernel operator()(std::vector<TOut> &arrOut,
         std::vector<TA> const &arrA, TB const &valB) {
         size_t n = std::min(arrOut.size(), arrA.size());
-        #pragma omp parallel for
-        for (int i = 0; i < n; i++) {
-            auto val = func(arrA[i], valB);
-            arrOut[i] = (decltype(arrOut[0]))val;
-        }
+        return {n, [func = func, &arrOut, &arrA, valB] (size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) {
+                auto val = func(arrA[i], valB);
+                arrOut[i] = (decltype(arrOut[0]))val;
+            }
+        }};
     }
 };
 
-struct PrimitiveHalfBinaryOp : INode {
-  virtual void apply() override {
+struct PrimitiveHalfBinaryOp : AttrOpNode {
+  virtual AttrOpKernel make_kernel(std::shared_ptr<PrimitiveObject> const &primOut) override {
     auto primA = get_input<PrimitiveObject>("primA");
-    auto primOut = get_input<PrimitiveObject>("primOut");
     auto attrA = get_param<std::string>(("attrA"));
     auto attrOut = get_param<std::string>(("attrOut"));
     auto op = get_param<std::string>(("op"));
     auto const &valB = get_input<NumericObject>("valueB")->value;
+    AttrOpKernel kernel;
     primOut->attr_visit(attrOut, [&](auto &arrOut) {
         using TarrOut = std::remove_cv_t<std::remove_reference_t<decltype(arrOut[0])>>;
         primA->attr_visit(attrA, [&](auto &arrA) {
@@ -248,14 +365,14 @@ struct PrimitiveHalfBinaryOp : INode {
                     using TvalB = std::remove_cv_t<std::remove_reference_t<decltype(valB)>>;
                     if constexpr (is_decay_same_v<TarrOut, is_vec_promotable_t<TarrA, TvalB>>) {
                         if constexpr (0) {
-#define _PER_OP(opname, expr)                                   \
-    }                                                           \
-    else if (op == opname) {                                    \
-        HalfBinaryOperator([](auto const &a_, auto const &b_) { \
-            using PromotedType = decltype(a_ + b_);             \
-            auto a = PromotedType(a_);                          \
-            auto b = PromotedType(b_);                          \
-            return expr;                                        \
+#define _PER_OP(opname, expr)                                            \
+    }                                                                    \
+    else if (op == opname) {                                             \
+        kernel = HalfBinaryOperator([](auto const &a_, auto const &b_) { \
+            using PromotedType = decltype(a_ + b_);                      \
+            auto a = PromotedType(a_);                                   \
+            auto b = PromotedType(b_);                                   \
+            return expr;                                                 \
         })(arrOut, arrA, valB);
                             _PER_OP("copyA", a)
                             _PER_OP("copyB", b)
@@ -280,8 +397,7 @@ struct PrimitiveHalfBinaryOp : INode {
                 valB);
         });
     });
-
-    set_output("primOut", get_input("primOut"));
+    return kernel;
   }
 };
 
@@ -4,6 +4,8 @@
 #include <zeno/para/parallel_for.h>
 #include <zeno/para/parallel_scan.h>
 #include <zeno/utils/variantswitch.h>
+#include <cmath>
+#include <vector>
 
 namespace zeno {
 
@@ -19,7 +21,157 @@ ZENO_API void primTriangulateQuads(PrimitiveObject *prim) {
     prim->quads.clear();
 }
 
-ZENO_API void primTriangulate(PrimitiveObject *prim, bool with_uv, bool has_lines) {
+namespace {
+
+// ear clipping on a doubly linked list of the polygon corners, projected on
+// the plane of the dominant axis of its newell normal. only reflex (and
+// collinear) corners can fall inside an ear, so those are the only ones
+// tested against it, and the ear flags are only updated for the two
+// neighbors of each clipped ear. collinear corners are convex ears which get
+// dropped as zero area triangles, keeping the len - 2 triangles the caller
+// has reserved. emit(a, b, c) receives corner indices local to the polygon,
+// in the winding of the polygon; returns false for convex polygons, which
+// are left to the fan triangulation
+template <class Emit>
+bool earClipPolygon(vec3f const *pos, int const *loop, int len, Emit &&emit) {
+    static thread_local std::vector<vec2f> p;
+    static thread_local std::vector<int> prev, next, reflexList, reflexAt;
+    static thread_local std::vector<char> ear;
+
+    vec3f nrm(0);
+    for (int i = 0; i < len; i++) {
+        auto a = pos[loop[i]], b = pos[loop[i + 1 == len ? 0 : i + 1]];
+        nrm += cross(a, b);
+    }
+    int ax = 0;
+    if (std::abs(nrm[1]) > std::abs(nrm[ax])) ax = 1;
+    if (std::abs(nrm[2]) > std::abs(nrm[ax])) ax = 2;
+    int u = (ax + 1) % 3, v = (ax + 2) % 3;
+    float sign = nrm[ax] < 0 ? -1.f : 1.f;
+    p.resize(len);
+    for (int i = 0; i < len; i++) {
+        auto q = pos[loop[i]];
+        p[i] = vec2f(q[u], q[v] * sign);
+    }
+
+    auto area = [&] (int a, int b, int c) {
+        return (p[b][0] - p[a][0]) * (p[c][1] - p[a][1]) - (p[b][1] - p[a][1]) * (p[c][0] - p[a][0]);
+    };
+    auto cornerArea = [&] (int i) {
+        return area(prev[i], i, next[i]);
+    };
+    prev.resize(len);
+    next.resize(len);
+    ear.resize(len);
+    // reflexAt[i] is the position of i in reflexList, or -1 if i is strictly
+    // convex. collinear corners are kept in the list as they may block ears
+    reflexAt.assign(len, -1);
+    reflexList.clear();
+    for (int i = 0; i < len; i++) {
+        prev[i] = i == 0 ? len - 1 : i - 1;
+        next[i] = i + 1 == len ? 0 : i + 1;
+    }
+    auto makeConvex = [&] (int i) {
+        int k = reflexAt[i];
+        reflexAt[reflexList.back()] = k;
+        reflexList[k] = reflexList.back();
+        reflexList.pop_back();
+        reflexAt[i] = -1;
+    };
+    auto makeReflex = [&] (int i) {
+        reflexAt[i] = reflexList.size();
+        reflexList.push_back(i);
+    };
+
+    // the number of reflex corners inside the triangle of corner i
+    auto countInside = [&] (int i, int stop) {
+        int a = prev[i], c = next[i], count = 0;
+        for (int r: reflexList) {
+            if (r == a || r == i || r == c)
+                continue;
+            if (alltrue(p[r] == p[a]) || alltrue(p[r] == p[i]) || alltrue(p[r] == p[c]))
+                continue;
+            if (area(a, i, r) >= 0 && area(i, c, r) >= 0 && area(c, a, r) >= 0)
+                if (++count >= stop)
+                    break;
+        }
+        return count;
+    };
+    bool anyStrict = false;
+    for (int i = 0; i < len; i++) {
+        float ar = cornerArea(i);
+        if (ar <= 0)
+            makeReflex(i);
+        anyStrict |= ar < 0;
+    }
+    if (!anyStrict)
+        return false;
+
+    auto updateEar = [&] (int i) {
+        float ar = cornerArea(i);
+        ear[i] = ar == 0 || (ar > 0 && !countInside(i, 1));
+    };
+    for (int i = 0; i < len; i++)
+        updateEar(i);
+
+    int remain = len, cur = 0, stall = 0;
+    while (remain > 3) {
+        if (!ear[cur] && stall < remain) {
+            cur = next[cur];
+            ++stall;
+            continue;
+        }
+        if (!ear[cur]) {
+            // no ear in a whole round: self intersecting or degenerate. clip
+            // the convex corner covering the fewest reflex ones, or the least
+            // reflex corner if none is convex
+            int best = -1, bestInside = 0;
+            float bestArea = 0;
+            int i = cur;
+            do {
+                float ar = cornerArea(i);
+                if (ar > 0) {
+                    int inside = countInside(i, best >= 0 && bestArea > 0 ? bestInside : remain);
+                    if (best < 0 || bestArea <= 0 || inside < bestInside) {
+                        best = i;
+                        bestInside = inside;
+                        bestArea = ar;
+                    }
+                } else if (best < 0 || (bestArea <= 0 && ar > bestArea)) {
+                    best = i;
+                    bestArea = ar;
+                }
+                i = next[i];
+            } while (i != cur);
+            cur = best;
+        }
+        int a = prev[cur], c = next[cur];
+        emit(a, cur, c);
+        next[a] = c;
+        prev[c] = a;
+        if (reflexAt[cur] >= 0)
+            makeConvex(cur);
+        --remain;
+        stall = 0;
+        // self intersecting polygons can also turn a convex corner reflex
+        for (int k: {a, c}) {
+            bool isReflex = cornerArea(k) <= 0;
+            if (isReflex && reflexAt[k] < 0)
+                makeReflex(k);
+            else if (!isReflex && reflexAt[k] >= 0)
+                makeConvex(k);
+        }
+        updateEar(a);
+        updateEar(c);
+        cur = c;
+    }
+    emit(prev[cur], cur, next[cur]);
+    return true;
+}
+
+}
+
+ZENO_API void primTriangulate(PrimitiveObject *prim, bool with_uv, bool has_lines, bool ear_clip) {
     //prim->tris.reserve(prim->tris.size() + prim->polys.size());
 
   boolean_switch(has_lines, [&] (auto has_lines) {
@@ -41,81 +193,49 @@ ZENO_API void primTriangulate(PrimitiveObject *prim, bool with_uv, bool has_line
         prim->tris.resize(tribase + redsum);
     }
 
-    if (!prim->loops.has_attr("uvs") || !with_uv) {
-        parallel_for(prim->polys.size(), [&] (size_t i) {
-            auto [start, len] = prim->polys[i];
-            if (len >= 3) {
-                int scanbase;
-                if constexpr (has_lines.value) {
-                    scanbase = scansum[i][0] + tribase;
-                } else {
-                    scanbase = scansum[i] + tribase;
-                }
-                prim->tris[scanbase++] = vec3f(
-                        prim->loops[start],
-                        prim->loops[start + 1],
-                        prim->loops[start + 2]);
-                for (int j = 3; j < len; j++) {
-                    prim->tris[scanbase++] = vec3f(
-                            prim->loops[start],
-                            prim->loops[start + j - 1],
-                            prim->loops[start + j]);
-                }
-            }
+    bool has_uv = prim->loops.has_attr("uvs") && with_uv;
+    int const *loop_uv = has_uv ? prim->loops.attr<int>("uvs").data() : nullptr;
+    auto &uvs = prim->uvs;
+    vec3f *uv0 = has_uv ? prim->tris.add_attr<vec3f>("uv0").data() : nullptr;
+    vec3f *uv1 = has_uv ? prim->tris.add_attr<vec3f>("uv1").data() : nullptr;
+    vec3f *uv2 = has_uv ? prim->tris.add_attr<vec3f>("uv2").data() : nullptr;
+
+    parallel_for(prim->polys.size(), [&] (size_t i) {
+        auto [start, len] = prim->polys[i];
+        if (len >= 3) {
+            int scanbase;
             if constexpr (has_lines.value) {
-                if (len == 2) {
-                    int scanbase = scansum[i][1] + linebase;
-                    prim->lines[scanbase] = vec2f(
-                        prim->loops[start],
-                        prim->loops[start + 1]);
-                }
+                scanbase = scansum[i][0] + tribase;
+            } else {
+                scanbase = scansum[i] + tribase;
             }
-        });
-
-    } else {
-        auto &loop_uv = prim->loops.attr<int>("uvs");
-        auto &uvs = prim->uvs;
-        auto &uv0 = prim->tris.add_attr<vec3f>("uv0");
-        auto &uv1 = prim->tris.add_attr<vec3f>("uv1");
-        auto &uv2 = prim->tris.add_attr<vec3f>("uv2");
-
-        parallel_for(prim->polys.size(), [&] (size_t i) {
-            auto [start, len] = prim->polys[i];
-            if (len >= 3) {
-                int scanbase;
-                if constexpr (has_lines.value) {
-                    scanbase = scansum[i][0] + tribase;
-                } else {
-                    scanbase = scansum[i] + tribase;
+            auto emit = [&] (int a, int b, int c) {
+                if (has_uv) {
+                    uv0[scanbase] = {uvs[loop_uv[start + a]][0], uvs[loop_uv[start + a]][1], 0};
+                    uv1[scanbase] = {uvs[loop_uv[start + b]][0], uvs[loop_uv[start + b]][1], 0};
+                    uv2[scanbase] = {uvs[loop_uv[start + c]][0], uvs[loop_uv[start + c]][1], 0};
                 }
-                uv0[scanbase] = {uvs[loop_uv[start]][0], uvs[loop_uv[start]][1], 0};
-                uv1[scanbase] = {uvs[loop_uv[start + 1]][0], uvs[loop_uv[start + 1]][1], 0};
-                uv2[scanbase] = {uvs[loop_uv[start + 2]][0], uvs[loop_uv[start + 2]][1], 0};
-                prim->tris[scanbase++] = vec3f(
-                        prim->loops[start],
-                        prim->loops[start + 1],
-                        prim->loops[start + 2]);
-                for (int j = 3; j < len; j++) {
-                    uv0[scanbase] = {uvs[loop_uv[start]][0], uvs[loop_uv[start]][1], 0};
-                    uv1[scanbase] = {uvs[loop_uv[start + j - 1]][0], uvs[loop_uv[start + j - 1]][1], 0};
-                    uv2[scanbase] = {uvs[loop_uv[start + j]][0], uvs[loop_uv[start + j]][1], 0};
-                    prim->tris[scanbase++] = vec3f(
-                            prim->loops[start],
-                            prim->loops[start + j - 1],
-                            prim->loops[start + j]);
+                prim->tris[scanbase++] = vec3i(
+                        prim->loops[start + a],
+                        prim->loops[start + b],
+                        prim->loops[start + c]);
+            };
+            if (!ear_clip || len == 3 || !earClipPolygon(prim->verts.data(), prim->loops.data() + start, len, emit)) {
+                for (int j = 2; j < len; j++) {
+                    emit(0, j - 1, j);
                 }
             }
-            if constexpr (has_lines.value) {
-                if (len == 2) {
-                    int scanbase = scansum[i][1] + linebase;
-                    prim->lines[scanbase] = vec2f(
-                        prim->loops[start],
-                        prim->loops[start + 1]);
-                }
+        }
+        if constexpr (has_lines.value) {
+            if (len == 2) {
+                int scanbase = scansum[i][1] + linebase;
+                prim->lines[scanbase] = vec2i(
+                    prim->loops[start],
+                    prim->loops[start + 1]);
             }
-        });
+        }
+    });
 
-    }
     prim->loops.clear();
     prim->polys.clear();
     prim->loops.erase_attr("uvs");
@@ -129,7 +249,7 @@ struct PrimitiveTriangulate : INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         if (get_param<bool>("from_poly")) {
-            primTriangulate(prim.get(), get_param<bool>("with_uv"), get_param<bool>("has_lines"));
+            primTriangulate(prim.get(), get_param<bool>("with_uv"), get_param<bool>("has_lines"), get_param<bool>("ear_clip"));
         }
         if (get_param<bool>("from_quads")) {
             primTriangulateQuads(prim.get());
@@ -148,6 +268,7 @@ ZENDEFNODE(PrimitiveTriangulate,
         {"bool", "with_uv", "1"},
         {"bool", "from_quads", "1"},
         {"bool", "has_lines", "1"},
+        {"bool", "ear_clip", "0"},
         }, /* category: */ {
         "primitive",
         }});
@@ -55,9 +55,9 @@
     if (!get_input2<bool>("isFlipFace"))        \
         cc4::flipPrimFaceOrder(prim.get());     \
     if (!get_input2<bool>("hasNormal"))         \
-        prim->verts.attrs.erase("nrm");         \
+        prim->verts.erase_attr("nrm");          \
     if (!get_input2<bool>("hasVertUV"))         \
-        prim->verts.attrs.erase("uv");
+        prim->verts.erase_attr("uv");
 
 namespace zeno {
 namespace {
@@ -1105,7 +1105,7 @@ struct CreateSphere : zeno::INode {
         }
 
         if (!get_input2<bool>("hasNormal")){
-            prim->verts.attrs.erase("nrm");
+            prim->verts.erase_attr("nrm");
         }
 
         if (!get_input2<bool>("hasVertUV")){
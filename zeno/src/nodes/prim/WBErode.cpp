@@ -6,8 +6,12 @@
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/types/UserData.h>
 #include <zeno/types/ListObject.h>
+#include <zeno/types/HeightFieldObject.h>
+#include <zeno/para/parallel_for.h>
 #include <zeno/utils/log.h>
+#include <cstring>
 #include <random>
+#include <sstream>
 //#include <time.h>
 
 namespace zeno
@@ -65,18 +69,11 @@ struct erode_precipitation : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
         auto& attr_color = terrain->verts.attr<vec3f>("clr");
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
 
@@ -294,18 +291,11 @@ struct erode_compute_erosion : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
         auto& attr_color = terrain->verts.attr<vec3f>("clr");
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
 
@@ -716,37 +706,62 @@ ZENDEFNODE(erode_compute_erosion,
 // erode_rand_dir
 // erode_tumble_material_v0
 // 节点代替
+static void erode_rand_color_perm(int iterations, int iter, int perm[8])
+{
+    std::uniform_real_distribution<float> distr(0.0, 1.0);
+    for (int i = 0; i < 8; i++)
+        perm[i] = i + 1;
+    for (int i = 0; i < 8; i++)
+    {
+        vec2f vec;
+        std::mt19937 mt(iterations * iter * 8 * i + i);	// 梅森旋转算法
+        vec[0] = distr(mt);
+        vec[1] = distr(mt);
+
+        int idx1 = floor(vec[0] * 8);
+        int idx2 = floor(vec[1] * 8);
+        idx1 = idx1 == 8 ? 7 : idx1;
+        idx2 = idx2 == 8 ? 7 : idx2;
+
+        int temp = perm[idx1];
+        perm[idx1] = perm[idx2];
+        perm[idx2] = temp;
+    }
+}
+
+static void erode_rand_dirs(int iterations, int iter, int dirs[2])
+{
+    std::uniform_real_distribution<float> distr(0.0, 1.0);
+    for (int i = 0; i < 2; i++)
+    {
+        std::mt19937 mt(iterations * iter * 2 * i + i);
+        float rand_val = distr(mt);
+        if (rand_val > 0.5)
+        {
+            dirs[i] = 1;
+        }
+        else
+        {
+            dirs[i] = -1;
+        }
+    }
+}
+
 struct erode_rand_color : INode {
     void apply() override {
 
-        std::uniform_real_distribution<float> distr(0.0, 1.0);
         auto iterations = get_input<NumericObject>("iterations")->get<int>();
         auto iter = get_input<NumericObject>("iter")->get<int>();
 
-        int perm[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
-        for (int i = 0; i < 8; i++)
-        {
-            vec2f vec;
-            std::mt19937 mt(iterations * iter * 8 * i + i);	// 梅森旋转算法
-            vec[0] = distr(mt);
-            vec[1] = distr(mt);
-
-            int idx1 = floor(vec[0] * 8);
-            int idx2 = floor(vec[1] * 8);
-            idx1 = idx1 == 8 ? 7 : idx1;
-            idx2 = idx2 == 8 ? 7 : idx2;
-
-            int temp = perm[idx1];
-            perm[idx1] = perm[idx2];
-            perm[idx2] = temp;
-        }
+        int perm[8];
+        erode_rand_color_perm(iterations, iter, perm);
 
         auto list = std::make_shared<zeno::ListObject>();
         for (int i = 0; i < 8; i++)
         {
             auto num = std::make_shared<zeno::NumericObject>();
             num->set<int>(perm[i]);
-            list->arr.push_back(num);
+            list->arr().push_back(num);
         }
         set_output("list", std::move(list));
     }
@@ -765,31 +780,18 @@ ZENDEFNODE(erode_rand_color,
 struct erode_rand_dir : INode {
     void apply() override {
 
-        std::uniform_real_distribution<float> distr(0.0, 1.0);
         auto iterations = get_input<NumericObject>("iterations")->get<int>();
         auto iter = get_input<NumericObject>("iter")->get<int>();
 
-        int dirs[] = { -1, -1 };
-        for (int i = 0; i < 2; i++)
-        {
-            std::mt19937 mt(iterations * iter * 2 * i + i);
-            float rand_val = distr(mt);
-            if (rand_val > 0.5)
-            {
-                dirs[i] = 1;
-            }
-            else
-            {
-                dirs[i] = -1;
-            }
-        }
+        int dirs[2];
+        erode_rand_dirs(iterations, iter, dirs);
 
         auto list = std::make_shared<zeno::ListObject>();
         for (int i = 0; i < 2; i++)
         {
             auto num = std::make_shared<zeno::NumericObject>();
             num->set<int>(dirs[i]);
-            list->arr.push_back(num);
+            list->arr().push_back(num);
         }
         set_output("list", std::move(list));
     }
@@ -834,18 +836,10 @@ struct erode_tumble_material_v0 : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
-        auto& attr_color = terrain->verts.attr<vec3f>("clr");
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
         ///////////////////////////////////////////////////////////////////////
@@ -1181,18 +1175,11 @@ struct erode_slump_b2 : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
         auto& attr_color = terrain->verts.attr<vec3f>("clr");
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
 
@@ -1693,6 +1680,195 @@ ZENDEFNODE(erode_slump_b2,
 // 上面的（崩塌）节点 erode_slump_b2 可以废弃了，由下面的 
 // erode_tumble_material_v2
 // 节点代替
+// 崩塌流淌的一遍计算，从 erode_tumble_material_v2 中提取出来，供融合的多次迭代节点复用
+// 只遍历当前颜色的格子（奇偶行或奇偶列），每个格子只写自己和一个固定方向的邻格，
+// 所以可以按行并行，material 只写，temp_material 只读
+struct TumbleMaterialParams {
+    int nx = 0;
+    int nz = 0;
+    float cellSize = 1.0f;
+    float seed = 0.0f;
+    int iter = 0;
+    int openborder = 0;
+    float gridbias = 0.0f;
+    float repose_angle = 15.0f;
+    float quant_amt = 0.25f;
+    float flow_rate = 1.0f;
+};
+
+static void erode_tumble_material_pass(TumbleMaterialParams const &par, int color, int const *p_dirs, int const *x_dirs,
+                                       float const *height, float const *stabilitymask,
+                                       float const *_temp_material, float *_material)
+{
+    const int nx = par.nx, nz = par.nz;
+    const int iterseed = (int)((unsigned)par.iter * 134775813u);
+    const float flow_rate = clamp(par.flow_rate, 0.0f, 1.0f);
+    const float _gridbias = clamp(par.gridbias, -1.0f, 1.0f);
+    const float _repose_angle = clamp(par.repose_angle, 0.0f, 90.0f);
+    const float quant_amt = par.quant_amt;
+    const float seed = par.seed;
+    const int openborder = par.openborder;
+
+    // randomized direction，其实只有 4 种模式
+    int dxs[] = { 0, p_dirs[0], 0, p_dirs[0], x_dirs[0], x_dirs[1], x_dirs[0], x_dirs[1] };
+    int dzs[] = { p_dirs[1], 0, p_dirs[1], 0, x_dirs[0],-x_dirs[1], x_dirs[0],-x_dirs[1] };
+    const int dx = dxs[color - 1];
+    const int dz = dzs[color - 1];
+    const int clamp_x = nx - 1;
+    const int clamp_z = nz - 1;
+    const float delta_x = par.cellSize * (dx && dz ? 1.4142136f : 1.0f); // 用于计算斜率的底边长度
+    // repose_angle 对应的高度差，停止崩塌的高度差
+    const float static_diff = _repose_angle < 90.0f ? tan(_repose_angle * M_PI / 180.0) * delta_x : 1e10f;
+    const float bias_diag = clamp(1.0f - _gridbias, 0.0f, 1.0f) / 1.4142136f;
+    const float bias_axis = clamp(1.0f + _gridbias, 0.0f, 1.0f);
+
+    // randomized color order，6 种网格随机取半模式
+    // color 1, 3: 奇/偶 行；color 2, 4, 5~8: 奇/偶 列
+    const bool by_row = color == 1 || color == 3;
+    const int z_begin = color == 1 ? 1 : 0;
+    const int z_step = by_row ? 2 : 1;
+    const int x_begin = by_row ? 0 : (color == 2 || color == 5 || color == 6) ? 1 : 0;
+    const int x_step = by_row ? 1 : 2;
+
+    const int nrows = nz > z_begin ? (nz - z_begin + z_step - 1) / z_step : 0;
+    parallel_for(nrows, [&] (int row) {
+        const int id_z = z_begin + row * z_step;
+        for (int id_x = x_begin; id_x < nx; id_x += x_step)
+        {
+            int idx = Pos2Idx(id_x, id_z, nx);
+
+            // 读取上次计算的结果
+            float i_material = _temp_material[idx];
+            float i_height = height[idx];
+
+            // 移除 邻格 被边界 clamp 的格子
+            int samplex = clamp(id_x + dx, 0, clamp_x);
+            int samplez = clamp(id_z + dz, 0, clamp_z);
+            int validsource = (samplex == id_x + dx) && (samplez == id_z + dz);
+            if (!validsource)
+                continue;
+
+            int j_idx = Pos2Idx(samplex, samplez, nx);
+            float j_material = _temp_material[j_idx];
+            float j_height = height[j_idx];
+
+            // 包含 height 和 debris 的高度差，注意这里是 邻格 - 本格
+            float m_diff = (j_height + j_material) - (i_height + i_material);
+
+            // 邻格 跟 本格 比，高的是 中格，另一个是 邻格
+            int cidx, cidz, c_idx, n_idx, dx_check, dz_check;
+            float c_height, c_material, n_material;
+            if (m_diff > 0.0f)
+            {
+                cidx = samplex;
+                cidz = samplez;
+                c_height = j_height;
+                c_material = j_material;
+                n_material = i_material;
+                c_idx = j_idx;
+                n_idx = idx;
+                dx_check = -dx;
+                dz_check = -dz;
+            }
+            else
+            {
+                cidx = id_x;
+                cidz = id_z;
+                c_height = i_height;
+                c_material = i_material;
+                n_material = j_material;
+                c_idx = idx;
+                n_idx = j_idx;
+                dx_check = dx;
+                dz_check = dz;
+            }
+
+            float sum_diffs[] = { 0.0f, 0.0f };
+            float dir_probs[] = { 0.0f, 0.0f };
+            float dir_prob = 0.0f;
+            for (int diff_idx = 0; diff_idx < 2; diff_idx++)
+            {
+                for (int tmp_dz = -1; tmp_dz <= 1; tmp_dz++)
+                {
+                    for (int tmp_dx = -1; tmp_dx <= 1; tmp_dx++)
+                    {
+                        if (!tmp_dx && !tmp_dz)
+                            continue;
+
+                        int tmp_samplex = clamp(cidx + tmp_dx, 0, clamp_x);
+                        int tmp_samplez = clamp(cidz + tmp_dz, 0, clamp_z);
+                        int tmp_validsource = (tmp_samplex == (cidx + tmp_dx)) && (tmp_samplez == (cidz + tmp_dz));
+                        tmp_validsource = tmp_validsource || !openborder;
+                        int tmp_j_idx = Pos2Idx(tmp_samplex, tmp_samplez, nx);
+
+                        float n_material = tmp_validsource ? _temp_material[tmp_j_idx] : 0.0f;
+                        float n_height = height[tmp_j_idx];
+                        float tmp_h_diff = n_height - (c_height);
+                        float tmp_m_diff = (n_height + n_material) - (c_height + c_material);
+                        float tmp_diff = diff_idx == 0 ? tmp_h_diff : tmp_m_diff;
+
+                        if (tmp_dx && tmp_dz)
+                            tmp_diff *= bias_diag;
+                        else
+                            tmp_diff *= bias_axis;
+
+                        if (tmp_diff <= 0.0f)
+                        {
+                            if ((dx_check == tmp_dx) && (dz_check == tmp_dz))
+                                dir_probs[diff_idx] = tmp_diff;
+                            if (diff_idx && dir_prob > tmp_diff)
+                                dir_prob = tmp_diff;
+                            sum_diffs[diff_idx] += tmp_diff;
+                        }
+                    }
+                }
+
+                if (diff_idx && (dir_prob > 0.001f || dir_prob < -0.001f))
+                    dir_prob = dir_probs[diff_idx] / dir_prob;
+
+                if (sum_diffs[diff_idx] > 0.001f || sum_diffs[diff_idx] < -0.001f)
+                    dir_probs[diff_idx] = dir_probs[diff_idx] / sum_diffs[diff_idx];
+            }
+
+            // 最多可供流失的高度差
+            float movable_mat = (m_diff < 0.0f) ? -m_diff : m_diff;
+            float stability_val = stabilitymask ? clamp(stabilitymask[c_idx], 0.0f, 1.0f) : 0.0f;
+            if (stability_val > 0.01f)
+                movable_mat = clamp(movable_mat * (1.0f - stability_val) * 0.5f, 0.0f, c_material);
+            else
+                movable_mat = clamp((movable_mat - static_diff) * 0.5f, 0.0f, c_material);
+
+            float l_rat = dir_probs[1];
+            if (quant_amt > 0.001)
+                movable_mat = clamp(quant_amt * ceil((movable_mat * l_rat) / quant_amt), 0.0f, c_material);
+            else
+                movable_mat *= l_rat;
+
+            float diff = (m_diff > 0.0f) ? movable_mat : -movable_mat;
+
+            int cond = 0;
+            if (dir_prob >= 1.0f)
+                cond = 1;
+            else
+            {
+                dir_prob = dir_prob * dir_prob * dir_prob * dir_prob;
+                unsigned int cutoff = (unsigned int)(dir_prob * 4294967295.0);
+                unsigned int randval = erode_random(seed, (idx + nx * nz) * 8 + color + iterseed);
+                cond = randval < cutoff;
+            }
+            if (!cond)
+                diff = 0.0f;
+
+            diff *= flow_rate;
+            float abs_diff = (diff < 0.0f) ? -diff : diff;
+
+            // 中格失去碎屑，邻格得到碎屑
+            _material[c_idx] = c_material - abs_diff;
+            _material[n_idx] = n_material + abs_diff;
+        }
+    });
+}
+
 struct erode_tumble_material_v2 : INode {
     void apply() override {
 
@@ -1722,18 +1898,10 @@ struct erode_tumble_material_v2 : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
-        auto& attr_color = terrain->verts.attr<vec3f>("clr");
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
         ///////////////////////////////////////////////////////////////////////
@@ -1782,305 +1950,19 @@ struct erode_tumble_material_v2 : INode {
         // 计算
         ////////////////////////////////////////////////////////////////////////////////////////
         // 新的，确定的，随机方向，依据上次的计算结果进行计算
-#pragma omp parallel for
-        for (int id_z = 0; id_z < nz; id_z++)
-        {
-#pragma omp parallel for
-            for (int id_x = 0; id_x < nx; id_x++)
-            {
-                int iterseed = iter * 134775813;
-                int color = perm[i];
-
-                // randomized color order，6 种网格随机取半模式
-                int is_red = ((id_z & 1) == 1) && (color == 1);
-                int is_green = ((id_x & 1) == 1) && (color == 2);
-                int is_blue = ((id_z & 1) == 0) && (color == 3);
-                int is_yellow = ((id_x & 1) == 0) && (color == 4);
-                int is_x_turn_x = ((id_x & 1) == 1) && ((color == 5) || (color == 6));
-                int is_x_turn_y = ((id_x & 1) == 0) && ((color == 7) || (color == 8));
-                // randomized direction，其实只有 4 种模式
-                int dxs[] = { 0, p_dirs[0], 0, p_dirs[0], x_dirs[0], x_dirs[1], x_dirs[0], x_dirs[1] };
-                int dzs[] = { p_dirs[1], 0, p_dirs[1], 0, x_dirs[0],-x_dirs[1], x_dirs[0],-x_dirs[1] };
-
-                if (is_red || is_green || is_blue || is_yellow || is_x_turn_x || is_x_turn_y)
-                {
-                    int idx = Pos2Idx(id_x, id_z, nx);
-                    int dx = dxs[color - 1];
-                    int dz = dzs[color - 1];
-                    int bound_x = nx;
-                    int bound_z = nz;
-                    int clamp_x = bound_x - 1;
-                    int clamp_z = bound_z - 1;
-
-                    //if (idx == 249494)
-                    //{
-                        //printf(" 1-----> flow_rate = %f\n", flow_rate);
-                    //}
-                    //float flow_rate = clamp(flow_rate, 0.0f, 1.0f); // 严重错误 哈哈哈
-                    flow_rate = clamp(flow_rate, 0.0f, 1.0f);
-                    //if (idx == 249494)
-                    //{
-                        //printf(" 2-----> flow_rate = %f\n", flow_rate);
-                    //}
-
-                    // 读取上次计算的结果
-                    float i_material = _temp_material[idx];	// 数据来自上次的计算结果 **************************
-                    float i_height = height[idx];			// height 数据只读
-
-                    // 移除 邻格 被边界 clamp 的格子
-                    int samplex = clamp(id_x + dx, 0, clamp_x);
-                    int samplez = clamp(id_z + dz, 0, clamp_z);
-                    int validsource = (samplex == id_x + dx) && (samplez == id_z + dz);
-
-                    // If we have closed borders, pretend a valid source to create
-                    // a streak condition
-                    if (validsource)
-                    {
-                        int same_node = !validsource;	// 恒等于 0 ？？？ 干嘛？ 备份，因为后面 validsource 被修改了 ？？？
-
-                        // 移除被标记为边界的格子
-                        validsource = validsource || !openborder;
-
-                        // 邻格 的索引号
-                        int j_idx = Pos2Idx(samplex, samplez, nx);
-
-                        // 邻格 的 height 和 debris
-                        float j_material = validsource ? _temp_material[j_idx] : 0.0f;
-                        float j_height = height[j_idx];
-
-
-                        // The maximum slope at which we stop slumping
-                        float _repose_angle = repose_angle;
-                        _repose_angle = clamp(_repose_angle, 0.0f, 90.0f);
-                        float delta_x = cellSize * (dx && dz ? 1.4142136f : 1.0f); // 用于计算斜率的底边长度
-
-                        // repose_angle 对应的高度差，停止崩塌的高度差
-                        float static_diff = _repose_angle < 90.0f ? tan(_repose_angle * M_PI / 180.0) * delta_x : 1e10f;
-
-                        // 包含 height 和 debris 的高度差，注意这里是 邻格 - 本格
-                        float m_diff = (j_height + j_material) - (i_height + i_material);
-
-                        // 邻格 跟 本格 比，高的是 中格，另一个是 邻格
-                        int cidx = 0;   // 中格的 id_x
-                        int cidz = 0;   // 中格的 id_y
-
-                        float c_height = 0.0f;      // 中格
-                        float c_material = 0.0f;    // 中格
-                        float n_material = 0.0f;    // 邻格
-
-                        int c_idx = 0;  // 中格的 idx
-                        int n_idx = 0;  // 邻格的 idx
-
-                        int dx_check = 0;   // 中格 指向 邻格 的方向
-                        int dz_check = 0;
-
-                        // 如果邻格比本格高，邻格->中格，本格->邻格
-                        // 高的是 中格
-                        if (m_diff > 0.0f)
-                        {
-                            // look at j's neighbours
-                            cidx = samplex;
-                            cidz = samplez;
-
-                            c_height = j_height;
-                            c_material = j_material;
-                            n_material = i_material;
-
-                            c_idx = j_idx;
-                            n_idx = idx;
-
-                            dx_check = -dx;
-                            dz_check = -dz;
-                        }
-                        else
-                        {
-                            // look at i's neighbours
-                            cidx = id_x;
-                            cidz = id_z;
-
-                            c_height = i_height;
-                            c_material = i_material;
-                            n_material = j_material;
-
-                            c_idx = idx;
-                            n_idx = j_idx;
-
-                            dx_check = dx;
-                            dz_check = dz;
-                        }
-
-                        float sum_diffs[] = { 0.0f, 0.0f };
-                        float dir_probs[] = { 0.0f, 0.0f };
-                        float dir_prob = 0.0f;
-                        for (int diff_idx = 0; diff_idx < 2; diff_idx++)
-                        {
-                            for (int tmp_dz = -1; tmp_dz <= 1; tmp_dz++)
-                            {
-                                for (int tmp_dx = -1; tmp_dx <= 1; tmp_dx++)
-                                {
-                                    if (!tmp_dx && !tmp_dz)
-                                        continue;
-
-                                    int tmp_samplex = clamp(cidx + tmp_dx, 0, clamp_x);
-                                    int tmp_samplez = clamp(cidz + tmp_dz, 0, clamp_z);
-                                    int tmp_validsource = (tmp_samplex == (cidx + tmp_dx)) && (tmp_samplez == (cidz + tmp_dz));
-                                    // If we have closed borders, pretend a valid source to create
-                                    // a streak condition
-                                    // TODO: what is streak condition?
-                                    tmp_validsource = tmp_validsource || !openborder;
-                                    int tmp_j_idx = Pos2Idx(tmp_samplex, tmp_samplez, nx);
-
-                                    // 中格周围的邻格 碎屑 的高度
-                                    float n_material = tmp_validsource ? _temp_material[tmp_j_idx] : 0.0f;
-
-                                    // 中格周围邻格 地面 高度
-                                    float n_height = height[tmp_j_idx];
-
-                                    // 中格周围的邻格 地面 高度 - 中格 地面 高度
-                                    float tmp_h_diff = n_height - (c_height);
-
-                                    // 中格周围的邻格 高度 - 中格 高度
-                                    float tmp_m_diff = (n_height + n_material) - (c_height + c_material);
-
-                                    // 地面高度差 : 总高度差
-                                    float tmp_diff = diff_idx == 0 ? tmp_h_diff : tmp_m_diff;
-
-                                    float _gridbias = gridbias;
-
-                                    _gridbias = clamp(_gridbias, -1.0f, 1.0f);
-
-                                    // 修正高度差
-                                    if (tmp_dx && tmp_dz)
-                                        tmp_diff *= clamp(1.0f - _gridbias, 0.0f, 1.0f) / 1.4142136f;
-                                    else // !tmp_dx || !tmp_dz
-                                        tmp_diff *= clamp(1.0f + _gridbias, 0.0f, 1.0f);
-
-                                    // diff_idx = 1 的时候，前面比较过格子的总高度差，此时
-                                    // 如果周边格子 不比我高，因为前面有过交换，所以至少有一个格子满足这个要求
-                                    // diff_idx = 0 的时候，下面的条件不一定能满足。格子的地面有可能是最低的
-                                    if (tmp_diff <= 0.0f)	// 只统计比我低的邻格，所以 高度差 的说法改为 深度差
-                                    {
-                                        // 指定方向上，中格(我) 与 邻格 的深度差
-                                        // dir_probs[0] 可能此时 >0 不会进来，此时 dir_probs[0] 保持默认值 0
-                                        if ((dx_check == tmp_dx) && (dz_check == tmp_dz))
-                                            dir_probs[diff_idx] = tmp_diff;
-
-                                        // 按格子总高度计算的时候，记录 tmp_diff 最深的深度，作为 dir_prob
-                                        if (diff_idx && dir_prob > tmp_diff)
-                                        {
-                                            dir_prob = tmp_diff;
-                                        }
-
-                                        // 记录比 中格 低的邻格的深度和
-                                        sum_diffs[diff_idx] += tmp_diff;
-                                    }
-                                }
-                            }
-
-                            if (diff_idx && (dir_prob > 0.001f || dir_prob < -0.001f))
-                            {
-                                // 按 (地面高度差+碎屑高度差)来计算时，流动概率 = 指定方向上的深度差 / 最大深度差
-                                dir_prob = dir_probs[diff_idx] / dir_prob;
-                            }
-
-                            // 另一种计算方法：指定方向上的流动概率 = 指定方向上的深度差 / 所有比我低的邻格的深度差之和
-                            // 这种概率显然比上一种方法的计算结果要 低
-                            // diff_idx == 1 时，深度差 以 (地面高度差+碎屑高度差) 来计算时 
-                            // diff_idx == 0 时，深度差 以 (地面高度差) 来计算时，可能不存在，不过已经取默认值为 0 了
-                            if (sum_diffs[diff_idx] > 0.001f || sum_diffs[diff_idx] < -0.001f)
-                                dir_probs[diff_idx] = dir_probs[diff_idx] / sum_diffs[diff_idx];
-                        }
-
-                        // 最多可供流失的高度差
-                        float movable_mat = (m_diff < 0.0f) ? -m_diff : m_diff;
-
-                        float stability_val = 0.0f;
-
-                        /// 这里要非常注意 ！！！！！！！！！！！！！
-                        /// 大串联的时候，这里是要有输入的 ！！！！！！！！！！！！！！！！！
-                        stability_val = clamp(stabilitymask[c_idx], 0.0f, 1.0f);
-
-                        if (stability_val > 0.01f)
-                        {
-                            //if (idx == 249494)
-                            //{
-                                //printf("-=WB1=- iter = %i, i = %i, movable_mat = %f, stability_val = %f, c_material = %f\n",
-                                //    iter, i, movable_mat, stability_val, c_material);
-                            //}
-                            // movement is slowed down according to the stability mask and not the repose angle
-                            // 只要有一点点遮罩，流失量至少减半，不过默认没有遮罩
-                            movable_mat = clamp(movable_mat * (1.0f - stability_val) * 0.5f, 0.0f, c_material);
-                        }
-                        else
-                        {
-                            //if (idx == 249494)
-                            //{
-                                //printf("-=WB2=- iter = %i, i = %i, movable_mat = %f, static_diff = %f, c_material = %f\n",
-                                //    iter, i, movable_mat, static_diff, c_material);
-                            //}
-                            // 流失量根据 static_diff 修正，static_diff 是 repose angle 对应的高度差
-                            // 问题是，repose_angle 默认为 0，但可流失量仍然减半了。。。
-                            movable_mat = clamp((movable_mat - static_diff) * 0.5f, 0.0f, c_material);
-                        }
-
-                        // 以 height + debris 来计算
-                        float l_rat = dir_probs[1];
-                        // TODO: What is a good limit here?
-                        // 让水流继续保持足够的水量
-                        if (quant_amt > 0.001)	// 默认 = 1.0
-                            movable_mat = clamp(quant_amt * ceil((movable_mat * l_rat) / quant_amt), 0.0f, c_material);
-                        else
-                            movable_mat *= l_rat; // 乘上概率，这样随着水量快速减少，水流很快就消失了
-
-                        float diff = (m_diff > 0.0f) ? movable_mat : -movable_mat;
-
-                        //if (idx == 249494)
-                        //{
-                            //printf("diff = %f, m_diff = %f, movable_mat = %f\n", diff, m_diff, movable_mat);
-                        //}
-
-                        int cond = 0;
-                        if (dir_prob >= 1.0f)
-                            cond = 1;
-                        else
-                        {
-                            // Making sure all drops are moving
-                            dir_prob = dir_prob * dir_prob * dir_prob * dir_prob;
-                            unsigned int cutoff = (unsigned int)(dir_prob * 4294967295.0);   // 0 ~ 1 映射到 0 ~ 4294967295.0
-                            unsigned int randval = erode_random(seed, (idx + nx * nz) * 8 + color + iterseed);
-                            cond = randval < cutoff;
-                        }
-
-                        // 不参与计算的格子，或者没有流动概率的格子
-                        if (!cond || same_node)
-                            diff = 0.0f;
-
-                        //if (idx == 249494)
-                        //{
-                            //printf("flow_rate = %f, diff = %f, movable_mat = %f\n", flow_rate, diff, movable_mat);
-                        //}
-
-                        // TODO: Check if this one should be here or before quantization
-                        diff *= flow_rate;	// 1.0
-
-                        float abs_diff = (diff < 0.0f) ? -diff : diff;
-
-                        //if (idx == 249494)
-                        //{
-                            //printf(" flow_rate = %f, diff = %f, abs_diff = %f\n", flow_rate, diff, abs_diff);
-                        //}
-
-                        // Update the material level
-                        // 中格失去碎屑
-                        _material[c_idx] = c_material - abs_diff;
-                        // 邻格得到碎屑
-                        _material[n_idx] = n_material + abs_diff;
-
-                    }
-
-                }
-            }
-        }
+        TumbleMaterialParams par;
+        par.nx = nx;
+        par.nz = nz;
+        par.cellSize = cellSize;
+        par.seed = seed;
+        par.iter = iter;
+        par.openborder = openborder;
+        par.gridbias = gridbias;
+        par.repose_angle = repose_angle;
+        par.quant_amt = quant_amt;
+        par.flow_rate = flow_rate;
+        erode_tumble_material_pass(par, perm[i], p_dirs.data(), x_dirs.data(),
+                                   height.data(), stabilitymask.data(), _temp_material.data(), _material.data());
 
         set_output("prim_2DGrid", std::move(terrain));
     }
@@ -2146,18 +2028,11 @@ struct erode_slump_b4 : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
         auto& attr_color = terrain->verts.attr<vec3f>("clr");
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
 
@@ -2945,18 +2820,10 @@ struct erode_tumble_material_v4 : INode {
         auto visualEnable = get_input<NumericObject>("visualEnable")->get<int>();
         //  if (visualEnable) {
         if (!terrain->verts.has_attr("clr"))
-        {
-            auto& _clr = terrain->verts.add_attr<vec3f>("clr");
-            std::fill(_clr.begin(), _clr.end(), vec3f(1.0, 1.0, 1.0));
-        }
-        auto& attr_color = terrain->verts.attr<vec3f>("clr");
+            terrain->verts.set_uniform_attr("clr", vec3f(1.0, 1.0, 1.0));
 
         if (!terrain->verts.has_attr("debug"))
-        {
-            auto& _debug = terrain->verts.add_attr<float>("debug");
-            std::fill(_debug.begin(), _debug.end(), 0);
-        }
-        auto& attr_debug = terrain->verts.attr<float>("debug");
+            terrain->verts.set_uniform_attr("debug", 0.0f);
         //  }
 
         ///////////////////////////////////////////////////////////////////////
@@ -3621,5 +3488,148 @@ ZENDEFNODE(erode_terrainHiMeLo,
 
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HeightFieldObject：连续存放的 float 图层，多次迭代在一个节点内完成，
+// 不再每次迭代按名字查找属性、拷贝临时属性
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// 把网格上的 float 属性移动（不拷贝）到高度场的图层里
+struct erode_prim_to_heightfield : INode {
+    void apply() override {
+        auto terrain = get_input<PrimitiveObject>("prim_2DGrid");
+        auto& ud = terrain->userData();
+        if ((!ud.has<int>("nx")) || (!ud.has<int>("nz")))
+        {
+            zeno::log_error("no such UserData named '{}' and '{}'.", "nx", "nz");
+        }
+
+        auto hf = std::make_shared<HeightFieldObject>();
+        hf->nx = ud.get2<int>("nx");
+        hf->nz = ud.get2<int>("nz");
+        auto& pos = terrain->verts;
+        hf->cellSize = pos.size() > 1 ? std::abs(pos[0][0] - pos[1][0]) : 1.0f;
+        if (hf->size() != terrain->verts.size())
+            throw makeError("nx * nz does not match the number of vertices");
+
+        std::istringstream ss(get_input2<std::string>("layers"));
+        std::string name;
+        while (ss >> name)
+        {
+            auto& layer = hf->add_layer(name);
+            if (terrain->verts.attr_is<float>(name))
+            {
+                std::swap(layer, terrain->verts.attr<float>(name));
+                terrain->verts.erase_attr(name);
+            }
+        }
+
+        set_output("heightField", std::move(hf));
+        set_output("prim_2DGrid", std::move(terrain));
+    }
+};
+ZENDEFNODE(erode_prim_to_heightfield,
+    { /* inputs: */ {
+            "prim_2DGrid",
+            {"string", "layers", "height debris _stability"},
+        }, /* outputs: */ {
+            "heightField",
+            "prim_2DGrid",
+        }, /* params: */ {
+        }, /* category: */ {
+            "erode",
+        } });
+
+// 把高度场的所有图层移动（不拷贝）回网格的 float 属性，用于显示和后续的 prim 节点
+struct erode_heightfield_to_prim : INode {
+    void apply() override {
+        auto hf = get_input<HeightFieldObject>("heightField");
+        auto terrain = get_input<PrimitiveObject>("prim_2DGrid");
+        if (hf->size() != terrain->verts.size())
+            throw makeError("height field size does not match the number of vertices");
+
+        for (auto& [name, layer] : hf->layers)
+        {
+            terrain->verts.erase_attr(name);
+            std::swap(terrain->verts.add_attr<float>(name), layer);
+        }
+        hf->layers.clear();
+
+        set_output("prim_2DGrid", std::move(terrain));
+    }
+};
+ZENDEFNODE(erode_heightfield_to_prim,
+    { /* inputs: */ {
+            "heightField",
+            "prim_2DGrid",
+        }, /* outputs: */ {
+            "prim_2DGrid",
+        }, /* params: */ {
+        }, /* category: */ {
+            "erode",
+        } });
+
+// 等价于 erode_HeightField_slump_b2 子图（erode_rand_color + erode_rand_dir + 8 遍
+// erode_tumble_material_v2），所有迭代融合在一个节点内：
+// debris 直接作为 _material，每遍之前用 memcpy 刷新只读的双缓冲 temp
+struct erode_heightfield_slump_b2 : INode {
+    void apply() override {
+        auto hf = get_input<HeightFieldObject>("heightField");
+        auto& height = hf->layer("height");
+        auto& debris = hf->layer("debris");
+        float const* stabilitymask = hf->has_layer("_stability") ? hf->layer("_stability").data() : nullptr;
+
+        TumbleMaterialParams par;
+        par.nx = hf->nx;
+        par.nz = hf->nz;
+        par.cellSize = hf->cellSize;
+        par.seed = get_input2<float>("seed");
+        par.openborder = get_input2<int>("openborder");
+        par.gridbias = get_input2<float>("gridbias");
+        par.repose_angle = get_input2<float>("repose_angle");
+        par.quant_amt = get_input2<float>("quant_amt");
+        par.flow_rate = get_input2<float>("flow_rate");
+        auto iterations = get_input2<int>("iterations");
+
+        const int nx = hf->nx;
+        std::vector<float> temp(hf->size());
+        for (int iter_idx = 0; iter_idx < iterations; iter_idx++)
+        {
+            int iter = iter_idx + 1;
+            int perm[8], p_dirs[2], x_dirs[2];
+            erode_rand_color_perm(iterations, iter, perm);
+            erode_rand_dirs(iterations, iter, p_dirs);
+            erode_rand_dirs(iterations * 10, iter, x_dirs);
+            par.iter = iter;
+
+            for (int i = 0; i < 8; i++)
+            {
+                parallel_for(hf->nz, [&] (int z) {
+                    std::memcpy(temp.data() + (size_t)z * nx, debris.data() + (size_t)z * nx, nx * sizeof(float));
+                });
+                erode_tumble_material_pass(par, perm[i], p_dirs, x_dirs,
+                                           height.data(), stabilitymask, temp.data(), debris.data());
+            }
+        }
+
+        set_output("heightField", std::move(hf));
+    }
+};
+ZENDEFNODE(erode_heightfield_slump_b2,
+    { /* inputs: */ {
+            "heightField",
+            {"int", "iterations", "10"},
+            {"float", "seed", "15231.3"},
+            {"int", "openborder", "0"},
+            {"float", "gridbias", "0.0"},
+            {"float", "repose_angle", "15.0"},
+            {"float", "quant_amt", "0.25"},
+            {"float", "flow_rate", "1.0"},
+        }, /* outputs: */ {
+            "heightField",
+        }, /* params: */ {
+        }, /* category: */ {
+            "erode",
+        } });
+
 } // namespace
 } // namespace zeno
\ No newline at end of file
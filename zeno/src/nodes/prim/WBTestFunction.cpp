@@ -283,7 +283,7 @@ struct PrimPointTris : INode {
                 x[2] = ind[2];
                 x[3] = i;
                 num->set<vec4i>(x);
-                list->arr.push_back(num);
+                list->arr().push_back(num);
             }
         }
         set_output("list", std::move(list));
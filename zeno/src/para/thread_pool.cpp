@@ -0,0 +1,190 @@
+#include <zeno/para/thread_pool.h>
+#include <zeno/utils/envconfig.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace zeno {
+
+namespace {
+
+struct Job {
+    void (*fn)(void *ctx, std::size_t b, std::size_t e);
+    void *ctx;
+    std::size_t grain;
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool> failed{false};
+    std::mutex errorMtx;
+    std::exception_ptr error;
+};
+
+struct Task {
+    Job *job;
+    std::size_t b, e;
+};
+
+struct TaskDeque {
+    std::mutex mtx;
+    std::deque<Task> tasks;
+};
+
+struct ThreadPool {
+    std::size_t nthreads;
+    // one deque per worker, the last one is shared by all non-pool threads
+    std::vector<std::unique_ptr<TaskDeque>> deques;
+
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> sleeping{0};
+    std::mutex sleepMtx;
+    std::condition_variable sleepCv;
+
+    static inline thread_local std::size_t self = (std::size_t)-1;
+
+    ThreadPool() {
+        nthreads = envconfig::getInt("NUM_THREADS", 0);
+        if (!nthreads)
+            nthreads = std::max(1u, std::thread::hardware_concurrency());
+        deques.resize(nthreads);
+        for (auto &dq: deques)
+            dq = std::make_unique<TaskDeque>();
+        // the calling thread takes part in every job, so one less worker
+        for (std::size_t i = 0; i + 1 < nthreads; i++) {
+            std::thread([this, i] { worker(i); }).detach();
+        }
+    }
+
+    TaskDeque &localDeque() {
+        return *deques[self < nthreads - 1 ? self : nthreads - 1];
+    }
+
+    void push(Task task) {
+        // count the task before it becomes visible, so that a thread taking
+        // it right away never decrements the counter below zero
+        queued.fetch_add(1);
+        {
+            auto &dq = localDeque();
+            std::lock_guard lck(dq.mtx);
+            dq.tasks.push_back(task);
+        }
+        if (sleeping.load()) {
+            std::lock_guard lck(sleepMtx);
+            sleepCv.notify_one();
+        }
+    }
+
+    // newest task of our own deque first, for locality
+    std::optional<Task> pop() {
+        auto &dq = localDeque();
+        std::lock_guard lck(dq.mtx);
+        if (dq.tasks.empty())
+            return std::nullopt;
+        Task task = dq.tasks.back();
+        dq.tasks.pop_back();
+        queued.fetch_sub(1);
+        return task;
+    }
+
+    // oldest (thus biggest) task of another deque
+    std::optional<Task> steal() {
+        std::size_t start = self < nthreads ? self + 1 : 0;
+        for (std::size_t k = 0; k < nthreads; k++) {
+            auto &dq = *deques[(start + k) % nthreads];
+            std::lock_guard lck(dq.mtx);
+            if (dq.tasks.empty())
+                continue;
+            Task task = dq.tasks.front();
+            dq.tasks.pop_front();
+            queued.fetch_sub(1);
+            return task;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Task> find() {
+        if (auto task = pop())
+            return task;
+        return steal();
+    }
+
+    // keep the left half, leave the right halves to be stolen
+    void split(Task task) {
+        Job &job = *task.job;
+        while (task.e - task.b > job.grain) {
+            std::size_t mid = task.b + (task.e - task.b) / 2;
+            job.pending.fetch_add(1);
+            push(Task{&job, mid, task.e});
+            task.e = mid;
+        }
+        if (job.failed.load(std::memory_order_relaxed))
+            return;
+        try {
+            job.fn(job.ctx, task.b, task.e);
+        } catch (...) {
+            std::lock_guard lck(job.errorMtx);
+            if (!job.error)
+                job.error = std::current_exception();
+            job.failed.store(true);
+        }
+    }
+
+    void execute(Task task) {
+        Job &job = *task.job;
+        split(task);
+        job.pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    void worker(std::size_t i) {
+        self = i;
+        while (true) {
+            if (auto task = find()) {
+                execute(*task);
+                continue;
+            }
+            std::unique_lock lck(sleepMtx);
+            sleeping.fetch_add(1);
+            sleepCv.wait(lck, [&] { return queued.load() != 0; });
+            sleeping.fetch_sub(1);
+        }
+    }
+
+    void run(Job &job, std::size_t count) {
+        job.pending.store(1);
+        execute(Task{&job, 0, count});
+        // help with any pending task (of this job or another) until ours are done
+        while (job.pending.load(std::memory_order_acquire)) {
+            if (auto task = find())
+                execute(*task);
+            else
+                std::this_thread::yield();
+        }
+        if (job.error)
+            std::rethrow_exception(job.error);
+    }
+};
+
+ThreadPool &getPool() {
+    // never destroyed: detached workers may still be parked when statics die
+    static ThreadPool *pool = new ThreadPool;
+    return *pool;
+}
+
+}
+
+ZENO_API std::size_t thread_pool_size() {
+    return getPool().nthreads;
+}
+
+ZENO_API void thread_pool_run(std::size_t count, std::size_t grain,
+                              void (*fn)(void *ctx, std::size_t b, std::size_t e), void *ctx) {
+    Job job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.grain = std::max<std::size_t>(1, grain);
+    getPool().run(job, count);
+}
+
+}
@@ -18,6 +18,9 @@ struct ShaderManager;
 struct GraphicsManager;
 struct ObjectsManager;
 struct RenderManager;
+namespace opengl {
+struct BufferCache;
+}
 
 struct Scene : zeno::disable_copy {
     std::optional<zeno::vec4f> select_box = {};
@@ -27,6 +30,7 @@ struct Scene : zeno::disable_copy {
     std::unique_ptr<Camera> camera;
     std::unique_ptr<DrawOptions> drawOptions;
     std::unique_ptr<ShaderManager> shaderMan;
+    std::unique_ptr<opengl::BufferCache> bufferCache;
     std::unique_ptr<ObjectsManager> objectsMan;
     std::unique_ptr<RenderManager> renderMan;
 
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <zeno/utils/disable_copy.h>
+#include <zenovis/opengl/buffer.h>
+
+namespace zenovis::opengl {
+
+// GPU buffers shared between frames of one scene (GL context), so that streams
+// whose inputs did not change since the last upload (e.g. topology and uv while
+// only pos animates) are neither gathered nor uploaded again.
+//
+// a buffer is keyed on the CPU arrays it was built from, not on its own bytes:
+// each input array is interned as a Source (a copy compared byte by byte), and
+// a buffer is reused only when its kind and its exact sources match. unchanged
+// inputs thus cost one memcmp, and there are no hash collisions to worry about
+struct BufferCache : zeno::disable_copy {
+    struct Source {
+        std::vector<unsigned char> bytes;
+    };
+    using SourcePtr = std::shared_ptr<Source const>;
+
+    struct Entry {
+        unsigned kind;
+        GLuint target;
+        size_t size;
+        std::vector<SourcePtr> inputs;
+        std::shared_ptr<Buffer> buf;
+        size_t lastUse;
+    };
+    std::vector<std::shared_ptr<Source>> sources;
+    std::vector<Entry> entries;
+    size_t tick = 0;
+    // bytes kept alive for buffers which no graphic references any more, the
+    // sources are released together with the last entry using them
+    size_t unusedBudget = size_t(512) << 20;
+    // streams gathered on the CPU are staged here right before their upload,
+    // the memory is only kept for the next upload up to stagingBudget bytes
+    std::vector<unsigned char> staging;
+    size_t stagingBudget = size_t(64) << 20;
+
+    template <class T>
+    T *stage(size_t count) {
+        if (staging.size() < count * sizeof(T))
+            staging.resize(count * sizeof(T));
+        return reinterpret_cast<T *>(staging.data());
+    }
+
+    void releaseStaging() {
+        if (staging.size() > stagingBudget) {
+            staging.clear();
+            staging.shrink_to_fit();
+        }
+    }
+
+    // the interned copy of data, shared by every entry built from equal bytes
+    SourcePtr source(const void *data, size_t size) {
+        for (auto const &s : sources)
+            if (s->bytes.size() == size && !std::memcmp(s->bytes.data(), data, size))
+                return s;
+        auto s = std::make_shared<Source>();
+        s->bytes.assign((const unsigned char *)data, (const unsigned char *)data + size);
+        sources.push_back(s);
+        return s;
+    }
+
+    template <class T>
+    SourcePtr source(std::vector<T> const &arr) {
+        return source(arr.data(), arr.size() * sizeof(T));
+    }
+
+    // kind tells apart buffers built differently from the same inputs (e.g.
+    // a per-vertex stream and its per-corner gather), upload(buf) is only
+    // called when no buffer of this kind was built from these sources yet
+    template <class F>
+    std::shared_ptr<Buffer> fetch(GLuint target, unsigned kind, std::initializer_list<SourcePtr> inputs,
+                                  size_t size, F const &upload) {
+        ++tick;
+        for (auto &e : entries) {
+            if (e.kind == kind && e.target == target && e.size == size &&
+                std::equal(e.inputs.begin(), e.inputs.end(), inputs.begin(), inputs.end())) {
+                e.lastUse = tick;
+                return e.buf;
+            }
+        }
+        auto buf = std::make_shared<Buffer>(target);
+        upload(*buf);
+        entries.push_back({kind, target, size, inputs, buf, tick});
+        evict();
+        return buf;
+    }
+
+    // a buffer holding exactly the bytes of src
+    std::shared_ptr<Buffer> fetch(GLuint target, unsigned kind, SourcePtr const &src) {
+        auto const &bytes = src->bytes;
+        return fetch(target, kind, {src}, bytes.size(), [&] (Buffer &buf) {
+            buf.bind_data(bytes.data(), bytes.size());
+        });
+    }
+
+    void evict() {
+        size_t unused = 0;
+        for (auto const &e : entries)
+            if (e.buf.use_count() == 1)
+                unused += e.size;
+        while (unused > unusedBudget) {
+            auto lru = entries.end();
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+                if (it->buf.use_count() == 1 && (lru == entries.end() || it->lastUse < lru->lastUse))
+                    lru = it;
+            if (lru == entries.end())
+                break;
+            unused -= lru->size;
+            entries.erase(lru);
+        }
+        sources.erase(std::remove_if(sources.begin(), sources.end(), [] (auto const &s) {
+            return s.use_count() == 1;
+        }), sources.end());
+    }
+};
+
+} // namespace zenovis::opengl
@@ -10,6 +10,7 @@
 #include <zenovis/ShaderManager.h>
 #include <zenovis/ObjectsManager.h>
 #include <zenovis/opengl/buffer.h>
+#include <zenovis/opengl/buffercache.h>
 #include <zenovis/opengl/common.h>
 #include <zenovis/opengl/scope.h>
 #include <cstdlib>
@@ -29,6 +30,7 @@ Scene::Scene()
     : camera(std::make_unique<Camera>()),
       drawOptions(std::make_unique<DrawOptions>()),
       shaderMan(std::make_unique<ShaderManager>()),
+      bufferCache(std::make_unique<opengl::BufferCache>()),
       objectsMan(std::make_unique<ObjectsManager>()),
       renderMan(std::make_unique<RenderManager>(this)) {
 
@@ -16,6 +16,7 @@
 #include <zenovis/bate/IGraphic.h>
 #include <zenovis/ShaderManager.h>
 #include <zenovis/opengl/buffer.h>
+#include <zenovis/opengl/buffercache.h>
 #include <zenovis/opengl/shader.h>
 #include <zenovis/opengl/texture.h>
 
@@ -24,41 +25,61 @@ namespace {
 
 using namespace opengl;
 
+// pos, clr, nrm, uv, tang: one GL buffer per stream instead of an interleaved
+// one, so that each stream can be reused on its own
+struct VertexStreams {
+    std::shared_ptr<Buffer> bufs[5];
+
+    explicit operator bool() const {
+        return bufs[0] != nullptr;
+    }
+};
+
 struct ZhxxDrawObject {
-    std::unique_ptr<Buffer> vbo;
-    std::unique_ptr<Buffer> ebo;
+    VertexStreams vbo;
+    std::shared_ptr<Buffer> ebo;
     size_t count = 0;
     Program *prog{};
 };
 
-static void parsePointsDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
-    auto const &pos = prim->attr<zeno::vec3f>("pos");
-    auto const &clr = prim->attr<zeno::vec3f>("clr");
-    auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-    auto const &uv = prim->attr<zeno::vec3f>("uv");
-    auto const &tang = prim->attr<zeno::vec3f>("tang");
-    obj.count = prim->size();
-
-    obj.vbo = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    std::vector<zeno::vec3f> mem(obj.count * 5);
-    for (int i = 0; i < obj.count; i++) {
-        mem[5 * i + 0] = pos[i];
-        mem[5 * i + 1] = clr[i];
-        mem[5 * i + 2] = nrm[i];
-        mem[5 * i + 3] = uv[i];
-        mem[5 * i + 4] = tang[i];
+// how a cached buffer was built from its sources
+enum StreamKind : unsigned {
+    kSourceBytes,
+    kSequentialIndices,
+    kLinesGather,
+    kLinesUv,
+    kTrisGather,
+    kTrisUv,
+    kTrisTangent,
+};
+
+// 0, 1, 2, ... index buffers only depend on their length
+static std::shared_ptr<Buffer> sequentialIndexBuffer(BufferCache &cache, size_t count) {
+    size_t size = count * sizeof(int);
+    return cache.fetch(GL_ELEMENT_ARRAY_BUFFER, kSequentialIndices, {}, size, [&] (Buffer &buf) {
+        std::vector<int> data(count);
+#pragma omp parallel for
+        for (intptr_t i = 0; i < (intptr_t)count; i++)
+            data[i] = i;
+        buf.bind_data(data.data(), size);
+    });
+}
+
+static void parsePointsDrawBuffer(BufferCache &cache, zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
+    // vertex attributes are already laid out as separate streams
+    const char *names[5] = {"pos", "clr", "nrm", "uv", "tang"};
+    for (int k = 0; k < 5; k++) {
+        auto src = cache.source(prim->attr<zeno::vec3f>(names[k]));
+        obj.vbo.bufs[k] = cache.fetch(GL_ARRAY_BUFFER, kSourceBytes, src);
     }
-    obj.vbo->bind_data(mem.data(), mem.size() * sizeof(mem[0]));
 
-    size_t points_count = prim->points.size();
-    if (points_count) {
-        obj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-        obj.ebo->bind_data(prim->points.data(),
-                           points_count * sizeof(prim->points[0]));
+    obj.count = prim->points.size();
+    if (obj.count) {
+        obj.ebo = cache.fetch(GL_ELEMENT_ARRAY_BUFFER, kSourceBytes, cache.source(prim->points.values));
     }
 }
 
-static void parseLinesDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
+static void parseLinesDrawBuffer(BufferCache &cache, zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
     auto const &pos = prim->attr<zeno::vec3f>("pos");
     auto const &clr = prim->attr<zeno::vec3f>("clr");
     auto const &nrm = prim->attr<zeno::vec3f>("nrm");
@@ -66,37 +87,48 @@ static void parseLinesDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &ob
     auto const &lines = prim->lines;
     bool has_uv = lines.has_attr("uv0") && lines.has_attr("uv1");
     obj.count = prim->lines.size();
-    obj.vbo = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    std::vector<zeno::vec3f> mem(obj.count * 2 * 5);
-    std::vector<zeno::vec2i> linesdata(obj.count);
+    size_t nverts = obj.count * 2;
+    size_t size = nverts * sizeof(zeno::vec3f);
+    auto linesSrc = cache.source(lines.values);
+    zeno::vec3f const *srcs[5] = {pos.data(), clr.data(), nrm.data(), nullptr, tang.data()};
+    // each stream is gathered through the same staging memory, and only when
+    // no buffer was gathered from the same inputs yet
+    for (int k : {0, 1, 2, 4}) {
+        auto vertSrc = cache.source(srcs[k], prim->size() * sizeof(zeno::vec3f));
+        obj.vbo.bufs[k] = cache.fetch(GL_ARRAY_BUFFER, kLinesGather, {vertSrc, linesSrc}, size, [&] (Buffer &buf) {
+            auto mem = cache.stage<zeno::vec3f>(nverts);
 #pragma omp parallel for
-    for (int i = 0; i < obj.count; i++) {
-        mem[10 * i + 0] = pos[lines[i][0]];
-        mem[10 * i + 1] = clr[lines[i][0]];
-        mem[10 * i + 2] = nrm[lines[i][0]];
-        mem[10 * i + 3] =
-            has_uv ? lines.attr<zeno::vec3f>("uv0")[i] : zeno::vec3f(0, 0, 0);
-        mem[10 * i + 4] = tang[lines[i][0]];
-        mem[10 * i + 5] = pos[lines[i][1]];
-        mem[10 * i + 6] = clr[lines[i][1]];
-        mem[10 * i + 7] = nrm[lines[i][1]];
-        mem[10 * i + 8] =
-            has_uv ? lines.attr<zeno::vec3f>("uv1")[i] : zeno::vec3f(0, 0, 0);
-        mem[10 * i + 9] = tang[lines[i][1]];
-        linesdata[i] = zeno::vec2i(i * 2, i * 2 + 1);
+            for (intptr_t i = 0; i < (intptr_t)obj.count; i++) {
+                mem[2 * i + 0] = srcs[k][lines[i][0]];
+                mem[2 * i + 1] = srcs[k][lines[i][1]];
+            }
+            buf.bind_data(mem, size);
+        });
     }
-    obj.vbo->bind_data(mem.data(), mem.size() * sizeof(mem[0]));
+    auto uv0Src = has_uv ? cache.source(lines.attr<zeno::vec3f>("uv0")) : nullptr;
+    auto uv1Src = has_uv ? cache.source(lines.attr<zeno::vec3f>("uv1")) : nullptr;
+    obj.vbo.bufs[3] = cache.fetch(GL_ARRAY_BUFFER, kLinesUv, {uv0Src, uv1Src}, size, [&] (Buffer &buf) {
+        auto mem = cache.stage<zeno::vec3f>(nverts);
+        const zeno::vec3f *uv0 = has_uv ? lines.attr<zeno::vec3f>("uv0").data() : nullptr;
+        const zeno::vec3f *uv1 = has_uv ? lines.attr<zeno::vec3f>("uv1").data() : nullptr;
+#pragma omp parallel for
+        for (intptr_t i = 0; i < (intptr_t)obj.count; i++) {
+            mem[2 * i + 0] = has_uv ? uv0[i] : zeno::vec3f(0, 0, 0);
+            mem[2 * i + 1] = has_uv ? uv1[i] : zeno::vec3f(0, 0, 0);
+        }
+        buf.bind_data(mem, size);
+    });
+    cache.releaseStaging();
     if (obj.count) {
-        obj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-        obj.ebo->bind_data(&(linesdata[0]), obj.count * sizeof(linesdata[0]));
+        obj.ebo = sequentialIndexBuffer(cache, nverts);
     }
 }
 
-static void computeTrianglesTangent(zeno::PrimitiveObject *prim) {
+// tangents are only computed when their stream has to be gathered again, and
+// are written straight to the three corners instead of back as an attribute
+static void computeTrianglesTangent(zeno::PrimitiveObject *prim, zeno::vec3f *tang) {
     const auto &tris = prim->tris;
     const auto &pos = prim->attr<zeno::vec3f>("pos");
-    auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-    auto &tang = prim->tris.add_attr<zeno::vec3f>("tang");
     bool has_uv =
         tris.has_attr("uv0") && tris.has_attr("uv1") && tris.has_attr("uv2");
     //printf("!!has_uv = %d\n", has_uv);
@@ -110,7 +142,8 @@ static void computeTrianglesTangent(zeno::PrimitiveObject *prim) {
         uv2_data = tris.attr<zeno::vec3f>("uv2").data();
     }
 #pragma omp parallel for
-    for (size_t i = 0; i < prim->tris.size(); ++i) {
+    for (intptr_t i = 0; i < (intptr_t)prim->tris.size(); ++i) {
+        zeno::vec3f t;
         if (has_uv) {
             const auto &pos0 = pos[tris[i][0]];
             const auto &pos1 = pos[tris[i][1]];
@@ -140,150 +173,80 @@ static void computeTrianglesTangent(zeno::PrimitiveObject *prim) {
             } else {
                 tang[i] = tangent * (1.f / tanlen);
             }*/
-            tang[i] = tangent;
+            t = tangent;
         } else {
-            tang[i] = zeno::vec3f(0);
+            t = zeno::vec3f(0);
             //zeno::vec3f n = nrm[tris[i][0]], unused;
             //zeno::pixarONB(n, tang[i], unused);
         }
+        tang[3 * i + 0] = t;
+        tang[3 * i + 1] = t;
+        tang[3 * i + 2] = t;
     }
 }
 
-static void parseTrianglesDrawBufferCompress(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
-    //TICK(parse);
+static void parseTrianglesDrawBuffer(BufferCache &cache, zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
+    /* TICK(parse); */
     auto const &pos = prim->attr<zeno::vec3f>("pos");
     auto const &clr = prim->attr<zeno::vec3f>("clr");
     auto const &nrm = prim->attr<zeno::vec3f>("nrm");
     auto const &tris = prim->tris;
     bool has_uv =
         tris.has_attr("uv0") && tris.has_attr("uv1") && tris.has_attr("uv2");
-    auto &tang = prim->tris.attr<zeno::vec3f>("tang");
-    std::vector<zeno::vec3f> pos1(pos.size());
-    std::vector<zeno::vec3f> clr1(pos.size());
-    std::vector<zeno::vec3f> nrm1(pos.size());
-    std::vector<zeno::vec3f> uv1(pos.size());
-    std::vector<zeno::vec3f> tang1(pos.size());
-    std::vector<int> vertVisited(pos.size());
-    std::vector<zeno::vec3i> tris1(tris.size());
-    vertVisited.assign(pos.size(), 0);
-    for (int i = 0; i < tris.size(); i++) {
-        float area =
-            zeno::length(zeno::cross(pos[tris[i][1]] - pos[tris[i][0]],
-                                     pos[tris[i][2]] - pos[tris[i][0]]));
+    obj.count = tris.size();
+    size_t nverts = obj.count * 3;
+    size_t size = nverts * sizeof(zeno::vec3f);
+    const zeno::vec3f *uvs[3] = {};
+    BufferCache::SourcePtr uvSrcs[3];
+    if (has_uv) {
         for (int j = 0; j < 3; j++) {
-            tang1[tris[i][j]] += area * tang[i];
+            auto const &uv = tris.attr<zeno::vec3f>("uv" + std::to_string(j));
+            uvs[j] = uv.data();
+            uvSrcs[j] = cache.source(uv);
         }
     }
-    /* std::cout << "1111111111111111\n"; */
+    auto trisSrc = cache.source(tris.values);
+    zeno::vec3f const *srcs[3] = {pos.data(), clr.data(), nrm.data()};
+    BufferCache::SourcePtr vertSrcs[3];
+    for (int k = 0; k < 3; k++) {
+        vertSrcs[k] = cache.source(srcs[k], prim->size() * sizeof(zeno::vec3f));
+        obj.vbo.bufs[k] = cache.fetch(GL_ARRAY_BUFFER, kTrisGather, {vertSrcs[k], trisSrc}, size, [&] (Buffer &buf) {
+            auto mem = cache.stage<zeno::vec3f>(nverts);
 #pragma omp parallel for
-    for (int i = 0; i < tang1.size(); i++) {
-        tang1[i] = tang[i] / (zeno::length(tang[i]) + 0.000001);
-    }
-    /* std::cout << "2222222222222222\n"; */
-    std::vector<int> issueTris(0);
-    for (int i = 0; i < tris.size(); i++) {
-        //if all verts not visited
-        for (int j = 0; j < 3; j++) {
-            //just add verts id
-        }
-
-        //else
-        {
-            //if no uv confliction
-            //simply add verts id
-            //else
-            {
-                //add this tri to issueTris
+            for (intptr_t i = 0; i < (intptr_t)obj.count; i++) {
+                for (int j = 0; j < 3; j++)
+                    mem[3 * i + j] = srcs[k][tris[i][j]];
             }
-        }
-    }
-    //for issueTris
-    {
-        //emit new verts
+            buf.bind_data(mem, size);
+        });
     }
-    /* std::cout << "3333333333333333333\n"; */
-
-    //end compressed tri assign
-    obj.count = tris1.size();
-    obj.vbo = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    std::vector<zeno::vec3f> mem(pos1.size() * 5);
-    std::vector<zeno::vec3i> trisdata(obj.count);
+    obj.vbo.bufs[3] = cache.fetch(GL_ARRAY_BUFFER, kTrisUv, {uvSrcs[0], uvSrcs[1], uvSrcs[2]}, size, [&] (Buffer &buf) {
+        auto mem = cache.stage<zeno::vec3f>(nverts);
 #pragma omp parallel for
-    for (int i = 0; i < pos1.size(); i++) {
-        mem[5 * i + 0] = pos1[i];
-        mem[5 * i + 1] = clr1[i];
-        mem[5 * i + 2] = nrm1[i];
-        mem[5 * i + 3] = uv1[i];
-        mem[5 * i + 4] = tang1[i];
-    }
-#pragma omp parallel for
-    for (int i = 0; i < tris1.size(); i++) {
-        trisdata[i] = tris1[i];
-    }
-
-    /* TICK(bindvbo); */
-    obj.vbo->bind_data(mem.data(), mem.size() * sizeof(mem[0]));
-    /* TOCK(bindvbo); */
-    /* TICK(bindebo); */
-    if (obj.count) {
-        obj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-        obj.ebo->bind_data(&(trisdata[0]), tris1.size() * sizeof(trisdata[0]));
-    }
-    /* TOCK(bindebo); */
-}
-
-static void parseTrianglesDrawBuffer(zeno::PrimitiveObject *prim, ZhxxDrawObject &obj) {
-    /* TICK(parse); */
-    auto const &pos = prim->attr<zeno::vec3f>("pos");
-    auto const &clr = prim->attr<zeno::vec3f>("clr");
-    auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-    auto const &tris = prim->tris;
-    bool has_uv =
-        tris.has_attr("uv0") && tris.has_attr("uv1") && tris.has_attr("uv2");
-    obj.count = tris.size();
-    obj.vbo = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-    std::vector<zeno::vec3f> mem(obj.count * 3 * 5);
-    std::vector<zeno::vec3i> trisdata(obj.count);
-    auto &tang = prim->tris.attr<zeno::vec3f>("tang");
-#pragma omp parallel for
-    for (int i = 0; i < obj.count; i++) {
-        mem[15 * i + 0] = pos[tris[i][0]];
-        mem[15 * i + 1] = clr[tris[i][0]];
-        mem[15 * i + 2] = nrm[tris[i][0]];
-        mem[15 * i + 3] = has_uv ? tris.attr<zeno::vec3f>("uv0")[i]
-                                 : zeno::vec3f(0.0f, 0.0f, 0.0f);
-        mem[15 * i + 4] = tang[i];
-        mem[15 * i + 5] = pos[tris[i][1]];
-        mem[15 * i + 6] = clr[tris[i][1]];
-        mem[15 * i + 7] = nrm[tris[i][1]];
-        mem[15 * i + 8] = has_uv ? tris.attr<zeno::vec3f>("uv1")[i]
-                                 : zeno::vec3f(0.0f, 0.0f, 0.0f);
-        mem[15 * i + 9] = tang[i];
-        mem[15 * i + 10] = pos[tris[i][2]];
-        mem[15 * i + 11] = clr[tris[i][2]];
-        mem[15 * i + 12] = nrm[tris[i][2]];
-        mem[15 * i + 13] = has_uv ? tris.attr<zeno::vec3f>("uv2")[i]
-                                  : zeno::vec3f(0.0f, 0.0f, 0.0f);
-        mem[15 * i + 14] = tang[i];
-        //std::cout<<tang[i][0]<<" "<<tang[i][1]<<" "<<tang[i][2]<<std::endl;
-        trisdata[i] = zeno::vec3i(i * 3, i * 3 + 1, i * 3 + 2);
-    }
+        for (intptr_t i = 0; i < (intptr_t)obj.count; i++) {
+            for (int j = 0; j < 3; j++)
+                mem[3 * i + j] = has_uv ? uvs[j][i] : zeno::vec3f(0.0f, 0.0f, 0.0f);
+        }
+        buf.bind_data(mem, size);
+    });
+    // tangents only depend on pos, tris and the tri uvs
+    obj.vbo.bufs[4] = cache.fetch(GL_ARRAY_BUFFER, kTrisTangent,
+                                  {vertSrcs[0], trisSrc, uvSrcs[0], uvSrcs[1], uvSrcs[2]}, size, [&] (Buffer &buf) {
+        auto mem = cache.stage<zeno::vec3f>(nverts);
+        computeTrianglesTangent(prim, mem);
+        buf.bind_data(mem, size);
+    });
+    cache.releaseStaging();
     /* TOCK(parse); */
 
-    /* TICK(bindvbo); */
-    obj.vbo->bind_data(mem.data(), mem.size() * sizeof(mem[0]));
-    /* TOCK(bindvbo); */
-    /* TICK(bindebo); */
     if (obj.count) {
-        obj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-        obj.ebo->bind_data(&(trisdata[0]), obj.count * sizeof(trisdata[0]));
+        obj.ebo = sequentialIndexBuffer(cache, nverts);
     }
-    /* TOCK(bindebo); */
 }
 
 struct ZhxxGraphicPrimitive final : IGraphicDraw {
     Scene *scene;
-    std::unique_ptr<Buffer> vbo;
+    VertexStreams vbo;
     size_t vertex_count;
     bool draw_all_points;
 
@@ -299,6 +262,10 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
     //std::unique_ptr<Buffer> tris_ebo;
     size_t tris_count;
 
+    // model matrices of prim->inst, every draw is repeated once per instance
+    std::unique_ptr<Buffer> instvbo;
+    size_t instance_count = 1;
+
     ZhxxDrawObject pointObj;
     ZhxxDrawObject lineObj;
     ZhxxDrawObject triObj;
@@ -434,30 +401,15 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
         }
         bool enable_uv = false;
 
-        auto const &pos = prim->attr<zeno::vec3f>("pos");
-        auto const &clr = prim->attr<zeno::vec3f>("clr");
-        auto const &nrm = prim->attr<zeno::vec3f>("nrm");
-        auto const &uv = prim->attr<zeno::vec3f>("uv");
-        auto const &tang = prim->attr<zeno::vec3f>("tang");
         vertex_count = prim->size();
 
-        vbo = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
-        std::vector<zeno::vec3f> mem(vertex_count * 5);
-        for (int i = 0; i < vertex_count; i++) {
-            mem[5 * i + 0] = pos[i];
-            mem[5 * i + 1] = clr[i];
-            mem[5 * i + 2] = nrm[i];
-            mem[5 * i + 3] = uv[i];
-            mem[5 * i + 4] = tang[i];
-        }
-        vbo->bind_data(mem.data(), mem.size() * sizeof(mem[0]));
+        // the shared vertex streams and the points indices, both uploaded
+        // through the stream cache so unchanged streams are not re-sent
+        parsePointsDrawBuffer(*scene->bufferCache, &*prim, pointObj);
+        vbo = pointObj.vbo;
 
         points_count = prim->points.size();
         if (points_count) {
-            pointObj.count = points_count;
-            pointObj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-            pointObj.ebo->bind_data(prim->points.data(),
-                                    points_count * sizeof(prim->points[0]));
             pointObj.prog = get_points_program();
         }
 
@@ -468,12 +420,10 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
             // lines_prog = get_lines_program();
             if (!(prim->lines.has_attr("uv0") && prim->lines.has_attr("uv1"))) {
                 lineObj.count = lines_count;
-                lineObj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-                lineObj.ebo->bind_data(prim->lines.data(),
-                                       lines_count * sizeof(prim->lines[0]));
-                lineObj.vbo = nullptr;
+                lineObj.ebo = scene->bufferCache->fetch(GL_ELEMENT_ARRAY_BUFFER, kSourceBytes,
+                                                        scene->bufferCache->source(prim->lines.values));
             } else {
-                parseLinesDrawBuffer(&*prim, lineObj);
+                parseLinesDrawBuffer(*scene->bufferCache, &*prim, lineObj);
             }
             lineObj.prog = get_lines_program();
         }
@@ -483,14 +433,11 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
             if (!(prim->tris.has_attr("uv0") && prim->tris.has_attr("uv1") &&
                   prim->tris.has_attr("uv2"))) {
                 triObj.count = tris_count;
-                triObj.ebo = std::make_unique<Buffer>(GL_ELEMENT_ARRAY_BUFFER);
-                triObj.ebo->bind_data(prim->tris.data(),
-                                      tris_count * sizeof(prim->tris[0]));
-                triObj.vbo = nullptr;
+                triObj.ebo = scene->bufferCache->fetch(GL_ELEMENT_ARRAY_BUFFER, kSourceBytes,
+                                                       scene->bufferCache->source(prim->tris.values));
 
             } else {
-                computeTrianglesTangent(&*prim);
-                parseTrianglesDrawBuffer(&*prim, triObj);
+                parseTrianglesDrawBuffer(*scene->bufferCache, &*prim, triObj);
             }
 
             bool findCamera = false;
@@ -505,6 +452,13 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
         if (draw_all_points) {
             pointObj.prog = get_points_program();
         }
+
+        if (prim->inst && !prim->inst->modelMatrices.empty()) {
+            auto const &modelMatrices = prim->inst->modelMatrices;
+            instvbo = std::make_unique<Buffer>(GL_ARRAY_BUFFER);
+            instvbo->bind_data(modelMatrices.data(), modelMatrices.size() * sizeof(modelMatrices[0]));
+            instance_count = modelMatrices.size();
+        }
     }
 
     virtual void draw() override {
@@ -513,38 +467,39 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
             textures[id]->bind_to(id);
         }
 
-        auto vbobind = [&](auto &vbo) {
-            vbo->bind();
-            vbo->attribute(/*index=*/0,
-                           /*offset=*/sizeof(float) * 0,
-                           /*stride=*/sizeof(float) * 15, GL_FLOAT,
-                           /*count=*/3);
-            vbo->attribute(/*index=*/1,
-                           /*offset=*/sizeof(float) * 3,
-                           /*stride=*/sizeof(float) * 15, GL_FLOAT,
-                           /*count=*/3);
-            vbo->attribute(/*index=*/2,
-                           /*offset=*/sizeof(float) * 6,
-                           /*stride=*/sizeof(float) * 15, GL_FLOAT,
-                           /*count=*/3);
-            vbo->attribute(/*index=*/3,
-                           /*offset=*/sizeof(float) * 9,
-                           /*stride=*/sizeof(float) * 15, GL_FLOAT,
-                           /*count=*/3);
-            vbo->attribute(/*index=*/4,
-                           /*offset=*/sizeof(float) * 12,
-                           /*stride=*/sizeof(float) * 15, GL_FLOAT,
-                           /*count=*/3);
+        auto vbobind = [&](VertexStreams &vbo) {
+            for (int k = 0; k < 5; k++) {
+                vbo.bufs[k]->bind();
+                vbo.bufs[k]->attribute(/*index=*/k,
+                                       /*offset=*/0,
+                                       /*stride=*/sizeof(float) * 3, GL_FLOAT,
+                                       /*count=*/3);
+            }
         };
-        auto vbounbind = [&](auto &vbo) {
-            vbo->disable_attribute(0);
-            vbo->disable_attribute(1);
-            vbo->disable_attribute(2);
-            vbo->disable_attribute(3);
-            vbo->disable_attribute(4);
-            vbo->unbind();
+        auto vbounbind = [&](VertexStreams &vbo) {
+            for (int k = 0; k < 5; k++) {
+                vbo.bufs[k]->disable_attribute(k);
+            }
+            vbo.bufs[4]->unbind();
         };
 
+        // a mat4 attribute takes the four locations 5..8, one per column
+        if (instvbo) {
+            instvbo->bind();
+            for (int c = 0; c < 4; c++) {
+                instvbo->attribute(/*index=*/5 + c,
+                                   /*offset=*/sizeof(float) * 4 * c,
+                                   /*stride=*/sizeof(float) * 16, GL_FLOAT,
+                                   /*count=*/4);
+                instvbo->attrib_divisor(5 + c, 1);
+            }
+            instvbo->unbind();
+        } else {
+            for (int c = 0; c < 4; c++) {
+                CHECK_GL(glVertexAttrib4f(5 + c, c == 0, c == 1, c == 2, c == 3));
+            }
+        }
+
         if (draw_all_points || points_count)
             vbobind(vbo);
 
@@ -554,7 +509,8 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
             float point_scale = 21.6f / std::tan(scene->camera->m_fov * 0.5f * 3.1415926f / 180.0f);
             pointObj.prog->set_uniform("mPointScale", point_scale);
             scene->camera->set_program_uniforms(pointObj.prog);
-            CHECK_GL(glDrawArrays(GL_POINTS, /*first=*/0, /*count=*/vertex_count));
+            CHECK_GL(glDrawArraysInstanced(GL_POINTS, /*first=*/0, /*count=*/vertex_count,
+                                           instance_count));
         }
 
         if (points_count) {
@@ -562,8 +518,8 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
             pointObj.prog->use();
             scene->camera->set_program_uniforms(pointObj.prog);
             pointObj.ebo->bind();
-            CHECK_GL(glDrawElements(GL_POINTS, /*count=*/pointObj.count * 1,
-                                    GL_UNSIGNED_INT, /*first=*/0));
+            CHECK_GL(glDrawElementsInstanced(GL_POINTS, /*count=*/pointObj.count * 1,
+                                             GL_UNSIGNED_INT, /*first=*/0, instance_count));
             pointObj.ebo->unbind();
         }
 
@@ -580,8 +536,8 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
             lineObj.prog->use();
             scene->camera->set_program_uniforms(lineObj.prog);
             lineObj.ebo->bind();
-            CHECK_GL(glDrawElements(GL_LINES, /*count=*/lineObj.count * 2,
-                                    GL_UNSIGNED_INT, /*first=*/0));
+            CHECK_GL(glDrawElementsInstanced(GL_LINES, /*count=*/lineObj.count * 2,
+                                             GL_UNSIGNED_INT, /*first=*/0, instance_count));
             lineObj.ebo->unbind();
             if (lineObj.vbo) {
                 vbounbind(lineObj.vbo);
@@ -608,9 +564,9 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
 
             triObj.ebo->bind();
 
-            CHECK_GL(glDrawElements(GL_TRIANGLES,
-                                    /*count=*/triObj.count * 3,
-                                    GL_UNSIGNED_INT, /*first=*/0));
+            CHECK_GL(glDrawElementsInstanced(GL_TRIANGLES,
+                                             /*count=*/triObj.count * 3,
+                                             GL_UNSIGNED_INT, /*first=*/0, instance_count));
             bool selected = scene->selected.count(nameid) > 0;
 
             if (scene->drawOptions->render_wireframe || selected) {
@@ -618,9 +574,9 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
                 CHECK_GL(glPolygonOffset(0, 0));
                 CHECK_GL(glPolygonMode(GL_FRONT_AND_BACK, GL_LINE));
                 triObj.prog->set_uniformi("mRenderWireframe", true);
-                CHECK_GL(glDrawElements(GL_TRIANGLES,
-                                        /*count=*/triObj.count * 3,
-                                        GL_UNSIGNED_INT, /*first=*/0));
+                CHECK_GL(glDrawElementsInstanced(GL_TRIANGLES,
+                                                 /*count=*/triObj.count * 3,
+                                                 GL_UNSIGNED_INT, /*first=*/0, instance_count));
                 CHECK_GL(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
                 CHECK_GL(glDisable(GL_POLYGON_OFFSET_LINE));
             }
@@ -631,6 +587,13 @@ struct ZhxxGraphicPrimitive final : IGraphicDraw {
                 vbounbind(vbo);
             }
         }
+
+        if (instvbo) {
+            for (int c = 0; c < 4; c++) {
+                instvbo->attrib_divisor(5 + c, 0);
+                instvbo->disable_attribute(5 + c);
+            }
+        }
     }
 
     Program *get_points_program() {
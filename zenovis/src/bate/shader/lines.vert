@@ -7,15 +7,17 @@ uniform mat4 mProj;
 uniform mat4 mInvView;
 uniform mat4 mInvProj;
 
-in vec3 vPosition;
-in vec3 vColor;
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vColor;
+// per instance model matrix, identity for prims without instancing
+layout (location = 5) in mat4 vInstModel;
 
 out vec3 position;
 out vec3 color;
 
 void main()
 {
-  position = vPosition;
+  position = vec3(vInstModel * vec4(vPosition, 1.0));
   color = vColor;
 
   gl_Position = mVP * vec4(position, 1.0);
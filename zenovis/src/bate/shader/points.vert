@@ -6,11 +6,13 @@ uniform mat4 mView;
 uniform mat4 mProj;
 uniform float mPointScale;
 
-in vec3 vPosition;
-in vec3 vColor;
-in vec3 vNormal;
-in vec3 vTexCoord;
-in vec3 vTangent;
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vColor;
+layout (location = 2) in vec3 vNormal;
+layout (location = 3) in vec3 vTexCoord;
+layout (location = 4) in vec3 vTangent;
+// per instance model matrix, identity for prims without instancing
+layout (location = 5) in mat4 vInstModel;
 
 out vec3 position;
 out vec3 color;
@@ -18,7 +20,7 @@ out float radius;
 out float opacity;
 void main()
 {
-  position = vPosition;
+  position = vec3(vInstModel * vec4(vPosition, 1.0));
   color = vColor;
   radius = vNormal.x;
   opacity = vNormal.y;
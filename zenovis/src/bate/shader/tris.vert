@@ -7,11 +7,13 @@ uniform mat4 mProj;
 uniform mat4 mInvView;
 uniform mat4 mInvProj;
 
-in vec3 vPosition;
-in vec3 vColor;
-in vec3 vNormal;
-in vec3 vTexCoord;
-in vec3 vTangent;
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vColor;
+layout (location = 2) in vec3 vNormal;
+layout (location = 3) in vec3 vTexCoord;
+layout (location = 4) in vec3 vTangent;
+// per instance model matrix, identity for prims without instancing
+layout (location = 5) in mat4 vInstModel;
 
 out vec3 position;
 out vec3 iColor;
@@ -21,11 +23,11 @@ out vec3 iTangent;
 
 void main()
 {
-  position = vPosition;
+  position = vec3(vInstModel * vec4(vPosition, 1.0));
   iColor = vColor;
-  iNormal = vNormal;
+  iNormal = transpose(inverse(mat3(vInstModel))) * vNormal;
   iTexCoord = vTexCoord;
-  iTangent = vTangent;
+  iTangent = mat3(vInstModel) * vTangent;
   gl_Position = mVP * vec4(position, 1.0);
 }
 )"